@@ -1,7 +1,41 @@
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 #include <raptor2.h>
 
-/* rdfcount.c: parse any number of RDF/XML files and count the triples */
+/* rdfcount.c: parse any number of RDF/XML files and count the triples
+ *
+ * Usage: rdfcount [-j N] FILE...
+ *
+ * With -j N the files are counted by N threads.  Raptor worlds are
+ * not thread safe so each thread has its own world and parser; the
+ * counts are printed in argument order once all files are done.
+ */
+
+typedef struct
+{
+  const char* filename;
+  unsigned int count;
+  int failed;
+} count_job;
+
+typedef struct
+{
+  count_job* jobs;
+  int jobs_count;
+  int next;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t lock;
+#endif
+} count_jobs;
+
 
 static void
 count_triples(void* user_data, raptor_statement* triple)
@@ -10,41 +44,52 @@ count_triples(void* user_data, raptor_statement* triple)
   (*count_p)++;
 }
 
-int
-main(int argc, char *argv[])
+
+static count_job*
+next_job(count_jobs* jobs)
+{
+  count_job* job = NULL;
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&jobs->lock);
+#endif
+  if(jobs->next < jobs->jobs_count)
+    job = &jobs->jobs[jobs->next++];
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock(&jobs->lock);
+#endif
+
+  return job;
+}
+
+
+/* count the triples of files until there are none left */
+static void*
+count_files(void* arg)
 {
+  count_jobs* jobs = (count_jobs*)arg;
   raptor_world *world = NULL;
-  const char* program = "rdfcount";
   raptor_parser* rdf_parser = NULL;
-  unsigned int i;
-  unsigned int count;
-  unsigned int files_count = 0;
-  unsigned int total_count = 0;
+  count_job* job;
 
   world = raptor_new_world();
 
   /* just one parser is used and reused here */
   rdf_parser = raptor_new_parser(world, "rdfxml");
 
-  raptor_parser_set_statement_handler(rdf_parser, &count, count_triples);
-
-  for(i = 1; argv[i]; i++) {
-    const char* filename = argv[i];
+  while((job = next_job(jobs))) {
     unsigned char *uri_string;
     raptor_uri *uri, *base_uri;
 
-    uri_string = raptor_uri_filename_to_uri_string(filename);
+    raptor_parser_set_statement_handler(rdf_parser, &job->count,
+                                        count_triples);
+
+    uri_string = raptor_uri_filename_to_uri_string(job->filename);
     uri = raptor_new_uri(world, uri_string);
     base_uri = raptor_uri_copy(uri);
 
-    count = 0;
-    if(!raptor_parser_parse_file(rdf_parser, uri, base_uri)) {
-      fprintf(stderr, "%s: %s : %d triples\n", program, filename, count);
-      total_count += count;
-      files_count++;
-    } else {
-      fprintf(stderr, "%s: %s : failed to parse\n", program, filename);
-    }
+    job->count = 0;
+    job->failed = raptor_parser_parse_file(rdf_parser, uri, base_uri);
 
     raptor_free_uri(base_uri);
     raptor_free_uri(uri);
@@ -55,6 +100,86 @@ main(int argc, char *argv[])
 
   raptor_free_world(world);
 
+  return NULL;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  const char* program = "rdfcount";
+  count_jobs jobs;
+  int threads_count = 1;
+  int i;
+  unsigned int files_count = 0;
+  unsigned int total_count = 0;
+
+  argv++;
+  if(argv[0] && !strcmp(argv[0], "-j") && argv[1]) {
+    threads_count = atoi(argv[1]);
+    if(threads_count < 1)
+      threads_count = 1;
+    argv += 2;
+  }
+
+  memset(&jobs, 0, sizeof(jobs));
+  for(i = 0; argv[i]; i++)
+    ;
+  jobs.jobs_count = i;
+  jobs.jobs = (count_job*)calloc((size_t)i + 1, sizeof(count_job));
+  if(!jobs.jobs)
+    return 1;
+  for(i = 0; argv[i]; i++)
+    jobs.jobs[i].filename = argv[i];
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_init(&jobs.lock, NULL);
+  if(threads_count > 1) {
+    raptor_world *world;
+    pthread_t* threads;
+    int started = 0;
+
+    /* the first world opened initialises the XML library, which must
+     * happen before other threads use it */
+    world = raptor_new_world();
+    raptor_world_open(world);
+
+    threads = (pthread_t*)calloc((size_t)threads_count, sizeof(pthread_t));
+    for(i = 0; threads && i < threads_count; i++) {
+      if(pthread_create(&threads[i], NULL, count_files, &jobs))
+        break;
+      started++;
+    }
+    for(i = 0; i < started; i++)
+      pthread_join(threads[i], NULL);
+    free(threads);
+
+    if(!started)
+      count_files(&jobs);
+
+    raptor_free_world(world);
+  } else
+#endif
+    count_files(&jobs);
+#ifdef HAVE_PTHREAD
+  pthread_mutex_destroy(&jobs.lock);
+#endif
+
+  for(i = 0; i < jobs.jobs_count; i++) {
+    count_job* job = &jobs.jobs[i];
+
+    if(!job->failed) {
+      fprintf(stderr, "%s: %s : %d triples\n", program, job->filename,
+              job->count);
+      total_count += job->count;
+      files_count++;
+    } else {
+      fprintf(stderr, "%s: %s : failed to parse\n", program, job->filename);
+    }
+  }
+
+  free(jobs.jobs);
+
   fprintf(stderr, "%s: Total count: %d files  %d triples\n",
           program, files_count, total_count);
 
@@ -363,45 +363,55 @@ void rdfa_setup_initial_context(rdfacontext* context)
  */
 rdfacontext* rdfa_create_new_element_context(rdfalist* context_stack)
 {
+   rdfacontext* root_context = (rdfacontext*)context_stack->items[0]->data;
    rdfacontext* parent_context = (rdfacontext*)
       context_stack->items[context_stack->num_items - 1]->data;
-   rdfacontext* rval = rdfa_create_context(parent_context->base);
+   rdfacontext* rval = root_context->context_pool;
 
-   if(!rval)
-      return NULL;
+   /* reuse a context released by an element that has already ended, or
+    * allocate a new one if there is none */
+   if(rval != NULL)
+   {
+      root_context->context_pool = rval->pool_next;
+      rval->pool_next = NULL;
+   }
+   else
+   {
+      rval = (rdfacontext*)malloc(sizeof(rdfacontext));
+      if(!rval)
+         return NULL;
+
+      memset(rval, 0, sizeof(rdfacontext));
+   }
 
    /* * Otherwise, the values are: */
 
    /* * the [ base ] is set to the [ base ] value of the current
     *   [ evaluation context ]; */
    rval->base = rdfa_replace_string(rval->base, parent_context->base);
-   rdfa_init_context(rval);
 
    /* Set the processing depth as parent + 1 */
    rval->depth = parent_context->depth + 1;
 
-   /* copy the URI mappings */
-#ifdef LIBRDFA_IN_RAPTOR
-   /* Raptor does this automatically for URIs */
-#else
-   rdfa_free_mapping(rval->uri_mappings, (free_mapping_value_fp)free);
-#endif
-   rdfa_free_mapping(rval->term_mappings, (free_mapping_value_fp)free);
-   rdfa_free_mapping(rval->list_mappings, (free_mapping_value_fp)rdfa_free_list);
-   rdfa_free_mapping(rval->local_list_mappings, (free_mapping_value_fp)rdfa_free_list);
+   /* share the URI mappings with the parent until this element
+    * declares a prefix of its own */
 #ifdef LIBRDFA_IN_RAPTOR
    /* Raptor does this automatically for URIs */
 #else
-   rval->uri_mappings =
-      rdfa_copy_mapping((void**)parent_context->uri_mappings,
-         (copy_mapping_value_fp)rdfa_replace_string);
+   rval->uri_mappings = parent_context->uri_mappings;
+   rval->uri_mappings_borrowed = 1;
 #endif
-   rval->term_mappings =
-      rdfa_copy_mapping((void**)parent_context->term_mappings,
-         (copy_mapping_value_fp)rdfa_replace_string);
-   rval->list_mappings =
-      rdfa_copy_mapping((void**)parent_context->local_list_mappings,
-         (copy_mapping_value_fp)rdfa_replace_list);
+
+   /* the term mappings are only set up on the root context, so every
+    * element shares them */
+   rval->term_mappings = parent_context->term_mappings;
+   rval->term_mappings_borrowed = 1;
+
+   /* the list mappings are only read, so they can be shared with the
+    * parent's local list mappings; those are only replaced once this
+    * element has ended */
+   rval->list_mappings = parent_context->local_list_mappings;
+   rval->list_mappings_borrowed = 1;
    rval->local_list_mappings =
       rdfa_copy_mapping((void**)parent_context->local_list_mappings,
          (copy_mapping_value_fp)rdfa_replace_list);
@@ -496,8 +506,11 @@ rdfacontext* rdfa_create_new_element_context(rdfalist* context_stack)
 
       /* o the [ list of incomplete triples ] is set to the [ local list
        *   of incomplete triples ]; */
-      rval->incomplete_triples = rdfa_replace_list(
-         rval->incomplete_triples, parent_context->local_incomplete_triples);
+      rval->incomplete_triples = parent_context->local_incomplete_triples;
+      rval->incomplete_triples_borrowed = 1;
+
+      /* * the [local list of incomplete triples] is set to null; */
+      rval->local_incomplete_triples = rdfa_create_list(3);
    }
    else
    {
@@ -506,14 +519,14 @@ rdfacontext* rdfa_create_new_element_context(rdfalist* context_stack)
       rval->parent_object = rdfa_replace_string(
          rval->parent_object, parent_context->parent_object);
 
-      /* copy the incomplete triples */
-      rval->incomplete_triples = rdfa_replace_list(
-         rval->incomplete_triples, parent_context->incomplete_triples);
+      /* share the incomplete triples */
+      rval->incomplete_triples = parent_context->incomplete_triples;
+      rval->incomplete_triples_borrowed = 1;
 
-      /* copy the local list of incomplete triples */
-      rval->local_incomplete_triples = rdfa_replace_list(
-         rval->local_incomplete_triples,
-         parent_context->local_incomplete_triples);
+      /* share the local list of incomplete triples */
+      rval->local_incomplete_triples =
+         parent_context->local_incomplete_triples;
+      rval->local_incomplete_triples_borrowed = 1;
    }
 
 #ifdef LIBRDFA_IN_RAPTOR
@@ -526,6 +539,41 @@ rdfacontext* rdfa_create_new_element_context(rdfalist* context_stack)
    return rval;
 }
 
+/**
+ * Takes a private copy of the context's local list of incomplete
+ * triples if it is still shared with the parent context.
+ *
+ * @param context the context that is about to change the list.
+ */
+void rdfa_own_local_incomplete_triples(rdfacontext* context)
+{
+   if(context->local_incomplete_triples_borrowed)
+   {
+      context->local_incomplete_triples =
+         rdfa_copy_list(context->local_incomplete_triples);
+      context->local_incomplete_triples_borrowed = 0;
+   }
+}
+
+#ifndef LIBRDFA_IN_RAPTOR
+/**
+ * Takes a private copy of the context's URI mappings if they are
+ * still shared with the parent context.
+ *
+ * @param context the context that is about to change the mappings.
+ */
+void rdfa_own_uri_mappings(rdfacontext* context)
+{
+   if(context->uri_mappings_borrowed)
+   {
+      context->uri_mappings =
+         rdfa_copy_mapping((void**)context->uri_mappings,
+            (copy_mapping_value_fp)rdfa_replace_string);
+      context->uri_mappings_borrowed = 0;
+   }
+}
+#endif
+
 void rdfa_free_context_stack(rdfacontext* context)
 {
    /* this field is not NULL only on the rdfacontext* at the top of the stack */
@@ -547,9 +595,23 @@ void rdfa_free_context_stack(rdfacontext* context)
       free(context->context_stack);
       context->context_stack = NULL;
    }
+
+   /* the pooled contexts have already been cleared */
+   while(context->context_pool != NULL)
+   {
+      rdfacontext* pooled = context->context_pool;
+      context->context_pool = pooled->pool_next;
+      free(pooled);
+   }
 }
 
-void rdfa_free_context(rdfacontext* context)
+/**
+ * Frees everything that a context owns, leaving the context itself
+ * allocated.
+ *
+ * @param context the context to clear.
+ */
+static void rdfa_clear_context(rdfacontext* context)
 {
    free(context->base);
    free(context->default_vocabulary);
@@ -558,13 +620,17 @@ void rdfa_free_context(rdfacontext* context)
 
 #ifdef LIBRDFA_IN_RAPTOR
 #else
-   rdfa_free_mapping(context->uri_mappings, (free_mapping_value_fp)free);
+   if(!context->uri_mappings_borrowed)
+      rdfa_free_mapping(context->uri_mappings, (free_mapping_value_fp)free);
 #endif
 
-   rdfa_free_mapping(context->term_mappings, (free_mapping_value_fp)free);
-   rdfa_free_list(context->incomplete_triples);
-   rdfa_free_mapping(context->list_mappings,
-      (free_mapping_value_fp)rdfa_free_list);
+   if(!context->term_mappings_borrowed)
+      rdfa_free_mapping(context->term_mappings, (free_mapping_value_fp)free);
+   if(!context->incomplete_triples_borrowed)
+      rdfa_free_list(context->incomplete_triples);
+   if(!context->list_mappings_borrowed)
+      rdfa_free_mapping(context->list_mappings,
+         (free_mapping_value_fp)rdfa_free_list);
    rdfa_free_mapping(context->local_list_mappings,
       (free_mapping_value_fp)rdfa_free_list);
    free(context->language);
@@ -583,7 +649,31 @@ void rdfa_free_context(rdfacontext* context)
    free(context->xml_literal);
 
    /* TODO: These should be moved into their own data structure */
-   rdfa_free_list(context->local_incomplete_triples);
+   if(!context->local_incomplete_triples_borrowed)
+      rdfa_free_list(context->local_incomplete_triples);
+}
+
+/**
+ * Releases an element context once its element has ended. The context
+ * is cleared and kept on the root context so that the next element can
+ * reuse it.
+ *
+ * @param root_context the context that holds the context stack.
+ * @param context the element context to release.
+ */
+void rdfa_release_element_context(
+   rdfacontext* root_context, rdfacontext* context)
+{
+   rdfa_clear_context(context);
+   memset(context, 0, sizeof(rdfacontext));
+
+   context->pool_next = root_context->context_pool;
+   root_context->context_pool = context;
+}
+
+void rdfa_free_context(rdfacontext* context)
+{
+   rdfa_clear_context(context);
 
    rdfa_free_context_stack(context);
    free(context->working_buffer);
@@ -66,6 +66,9 @@ void rdfa_save_incomplete_list_triples(
    rdfacontext* context, const rdfalist* rel)
 {
    unsigned int i;
+
+   rdfa_own_local_incomplete_triples(context);
+
    for(i = 0; i < rel->num_items; i++)
    {
       const char* curie = (const char*)rel->items[i]->data;
@@ -66,6 +66,7 @@ void rdfa_update_uri_mappings(
                                              (const unsigned char*)value,
                                              0);
 #else
+      rdfa_own_uri_mappings(context);
       rdfa_update_mapping(
          context->uri_mappings, XMLNS_DEFAULT_MAPPING, value,
          (update_mapping_value_fp)rdfa_replace_string);
@@ -98,6 +99,7 @@ void rdfa_update_uri_mappings(
                                             0);
 #else
       rdfa_generate_namespace_triple(context, attr, value);
+      rdfa_own_uri_mappings(context);
       rdfa_update_mapping(context->uri_mappings, attr, value,
          (update_mapping_value_fp)rdfa_replace_string);
 #endif
@@ -47,7 +47,6 @@
 #  include <strings.h>
 #endif
 #include <ctype.h>
-#include <libxml/SAX2.h>
 #include "rdfa_utils.h"
 #include "rdfa.h"
 #include "strtok_r.h"
@@ -55,61 +54,137 @@
 #define READ_BUFFER_SIZE 4096
 #define RDFA_DOCTYPE_STRING_LENGTH 103
 
+/* amount of the document held back looking for the end of <head> */
+#define RDFA_MAX_PREREAD (1<<17)
+
 /**
- * Read the head of the XHTML document and determines the base IRI for
- * the document.
+ * Grows the working buffer while the head of the document is being read
+ * so that it has at least the given number of free bytes.
  *
  * @param context the current working context.
- * @param working_buffer the current working buffer.
- * @param wb_allocated the number of bytes that have been allocated to
- *                     the working buffer.
+ * @param needed the number of free bytes needed.
  *
- * @return the size of the data available in the working buffer.
+ * @return 0 on success, non-0 on failure.
  */
-static size_t rdfa_init_base(
-   rdfacontext* context, char** working_buffer, size_t* working_buffer_size,
-   char* temp_buffer, size_t bytes_read)
+static int rdfa_wb_grow(rdfacontext* context, size_t needed)
 {
-   char* head_end = NULL;
-   size_t offset = context->wb_position;
-   size_t needed_size = 0;
+   size_t new_size = context->wb_allocated;
+   char* new_buffer;
 
-   if((offset + bytes_read) > *working_buffer_size)
-   {
-      needed_size = (offset + bytes_read) - *working_buffer_size;
-   }
+   while(new_size - context->wb_position < needed)
+      new_size *= 2;
 
-   /* search for the end of <head>, stop if <head> was found */
+   if(new_size == context->wb_allocated)
+      return 0;
 
-   /* extend the working buffer size */
-   if(needed_size > 0)
-   {
-      size_t temp_buffer_size = sizeof(char) * READ_BUFFER_SIZE;
-      if((size_t)needed_size > temp_buffer_size)
-         temp_buffer_size += needed_size;
+   /* +1 for NUL at end, to allow strstr() etc. to work */
+   new_buffer = (char*)realloc(context->working_buffer, new_size + 1);
+   if(new_buffer == NULL)
+      return 1;
+
+   context->working_buffer = new_buffer;
+   context->wb_allocated = new_size;
 
-      *working_buffer_size += temp_buffer_size;
-      /* +1 for NUL at end, to allow strstr() etc. to work */
-      *working_buffer = (char*)realloc(*working_buffer, *working_buffer_size + 1);
+   return 0;
+}
+
+/**
+ * Gets the free space at the end of the working buffer while the head
+ * of the document is being read.
+ *
+ * @param context the current working context.
+ * @param blen the variable to set to the number of free bytes.
+ *
+ * @return a pointer to the free space in the working buffer or NULL
+ *         on failure.
+ */
+static char* rdfa_wb_reserve(rdfacontext* context, size_t* blen)
+{
+   if(rdfa_wb_grow(context, READ_BUFFER_SIZE))
+      return NULL;
+
+   *blen = context->wb_allocated - context->wb_position;
+   return context->working_buffer + context->wb_position;
+}
+
+/**
+ * Appends data to the working buffer while the head of the document is
+ * being read.  The data may already have been written to the free space
+ * returned by rdfa_wb_reserve().
+ *
+ * @param context the current working context.
+ * @param data the data to append.
+ * @param len the number of bytes of data.
+ *
+ * @return 0 on success, non-0 on failure.
+ */
+static int rdfa_wb_append(rdfacontext* context, const char* data, size_t len)
+{
+   if(data != context->working_buffer + context->wb_position)
+   {
+      if(rdfa_wb_grow(context, len))
+         return 1;
+      memcpy(context->working_buffer + context->wb_position, data, len);
    }
 
-   /* append to the working buffer */
-   memmove(*working_buffer + offset, temp_buffer, bytes_read);
+   context->wb_position += len;
    /* ensure the buffer is a NUL-terminated string */
-   *(*working_buffer + offset + bytes_read) = '\0';
+   context->working_buffer[context->wb_position] = '\0';
+
+   return 0;
+}
+
+/**
+ * Searches the bytes added to the working buffer since the last call for
+ * the end of the <head> element.
+ *
+ * @param context the current working context.
+ *
+ * @return a pointer to the end of the head or NULL if not found yet.
+ */
+static char* rdfa_find_head_end(rdfacontext* context)
+{
+   /* back up to find a tag split over two reads */
+   size_t start = context->wb_preread;
+   char* head_end;
+
+   if(start > 6)
+      start -= 6;
+   else
+      start = 0;
+   context->wb_preread = context->wb_position;
+
+   head_end = strstr(context->working_buffer + start, "</head>");
+   if(head_end == NULL)
+      head_end = strstr(context->working_buffer + start, "</HEAD>");
+
+   return head_end;
+}
+
+/**
+ * Sniffs the document type from the start of the document held in the
+ * working buffer and determines the base IRI from the <base> element of
+ * the XHTML head if it was seen.
+ *
+ * @param context the current working context.
+ * @param head_end the end of the head in the working buffer or NULL.
+ */
+static void rdfa_init_base(rdfacontext* context, char* head_end)
+{
+   char* working_buffer = context->working_buffer;
 
    /* Sniff the beginning of the document for any document information */
-   if(strstr(*working_buffer, "-//W3C//DTD XHTML+RDFa 1.0//EN") != NULL)
+   if(strstr(working_buffer, "-//W3C//DTD XHTML+RDFa 1.0//EN") != NULL)
    {
       context->host_language = HOST_LANGUAGE_XHTML1;
       context->rdfa_version = RDFA_VERSION_1_0;
    }
-   else if(strstr(*working_buffer, "-//W3C//DTD XHTML+RDFa 1.1//EN") != NULL)
+   else if(strstr(working_buffer, "-//W3C//DTD XHTML+RDFa 1.1//EN") != NULL)
    {
       context->host_language = HOST_LANGUAGE_XHTML1;
       context->rdfa_version = RDFA_VERSION_1_1;
    }
-   else if(strstr(*working_buffer, "<html") != NULL)
+   else if(strstr(working_buffer, "<html") != NULL)
    {
       context->host_language = HOST_LANGUAGE_HTML;
       context->rdfa_version = RDFA_VERSION_1_1;
@@ -128,23 +203,13 @@ static size_t rdfa_init_base(
      context->rdfa_version = RDFA_VERSION_1_1;
 #endif
 
-   /* search for the end of </head> in */
-   head_end = strstr(*working_buffer, "</head>");
-   if(head_end == NULL)
-      head_end = strstr(*working_buffer, "</HEAD>");
-
-   context->wb_position += bytes_read;
-
-   if(head_end == NULL)
-      return bytes_read;
-
    /* if </head> was found, search for <base and extract the base URI */
    if(head_end != NULL)
    {
-      char* base_start = strstr(*working_buffer, "<base ");
+      char* base_start = strstr(working_buffer, "<base ");
       char* href_start = NULL;
       if(base_start == NULL)
-         base_start = strstr(*working_buffer, "<BASE ");
+         base_start = strstr(working_buffer, "<BASE ");
       if(base_start != NULL)
         href_start = strstr(base_start, "href=");
       
@@ -182,8 +247,6 @@ static size_t rdfa_init_base(
          }
       }
    }
-
-   return bytes_read;
 }
 
 #ifdef LIBRDFA_IN_RAPTOR
@@ -1182,26 +1245,22 @@ static void end_element(void* parser_context, const char* name,
 
       if(parent_context != NULL)
       {
-         /* copy the current mapping to the parent mapping */
+         /* hand the current mapping over to the parent */
          rdfa_free_mapping(parent_context->local_list_mappings,
             (free_mapping_value_fp)rdfa_free_list);
-         parent_context->local_list_mappings = rdfa_copy_mapping(
-            (void**)context->local_list_mappings,
-            (copy_mapping_value_fp)rdfa_replace_list);
+         parent_context->local_list_mappings = context->local_list_mappings;
+         context->local_list_mappings = NULL;
 
 #if defined(DEBUG) && DEBUG > 0
          printf("parent_context->local_list_mappings (after copy): ");
-         rdfa_print_mapping(context->local_list_mappings,
+         rdfa_print_mapping(parent_context->local_list_mappings,
                (print_mapping_value_fp)rdfa_print_triple_list);
 #endif
-         rdfa_free_mapping(context->local_list_mappings,
-            (free_mapping_value_fp)rdfa_free_list);
-         context->local_list_mappings = NULL;
       }
    }
 
-   /* free the context */
-   rdfa_free_context(context);
+   /* release the context for reuse by the next element */
+   rdfa_release_element_context((rdfacontext*)parser_context, context);
 
 #if defined(DEBUG) && DEBUG > 0
    printf("-------------------------------------------------------------\n");
@@ -1423,15 +1482,23 @@ int rdfa_parse_chunk(rdfacontext* context, char* data, size_t wblen, int done)
 
    if(!context->preread)
    {
-      /* search for the <base> tag and use the href contained therein to
-       * set the parsing context. */
-      context->wb_preread = rdfa_init_base(context,
-         &context->working_buffer, &context->wb_allocated, data, wblen);
+      char* head_end;
+
+      /* hold back the start of the document until the end of <head> so
+       * that the <base> tag and the href in it can set the parsing
+       * context.  Only the newly added bytes are searched each time. */
+      if(rdfa_wb_append(context, data, wblen))
+         return RDFA_PARSE_FAILED;
+
+      head_end = rdfa_find_head_end(context);
 
-      /* continue looking if in first 131072 bytes of data */
-      if(!context->base && context->wb_preread < (1<<17))
+      /* continue looking if in first RDFA_MAX_PREREAD bytes of data */
+      if(head_end == NULL && !done &&
+         context->wb_position < RDFA_MAX_PREREAD)
          return RDFA_PARSE_SUCCESS;
 
+      rdfa_init_base(context, head_end);
+
 #ifdef LIBRDFA_IN_RAPTOR
       /* term mappings are needed before SAX2 parsing */
       rdfa_setup_initial_context(context);
@@ -1464,6 +1531,20 @@ int rdfa_parse_chunk(rdfacontext* context, char* data, size_t wblen, int done)
       rdfa_setup_initial_context(context);
 #endif
 
+      /* the rest of the document is passed straight through so the
+       * working buffer goes back to being just the read buffer */
+      context->wb_position = 0;
+      if(context->wb_allocated > READ_BUFFER_SIZE)
+      {
+         char* new_buffer = (char*)realloc(context->working_buffer,
+                                           READ_BUFFER_SIZE + 1);
+         if(new_buffer != NULL)
+         {
+            context->working_buffer = new_buffer;
+            context->wb_allocated = READ_BUFFER_SIZE;
+         }
+      }
+
       context->preread = 1;
 
       return RDFA_PARSE_SUCCESS;
@@ -1506,6 +1587,15 @@ void rdfa_parse_end(rdfacontext* context)
 
 char* rdfa_get_buffer(rdfacontext* context, size_t* blen)
 {
+   /* while reading the head, fill in after what is held back */
+   if(!context->preread)
+   {
+      char* buffer = rdfa_wb_reserve(context, blen);
+      if(buffer == NULL)
+         *blen = 0;
+      return buffer;
+   }
+
    *blen = context->wb_allocated;
    return context->working_buffer;
 }
@@ -1514,8 +1604,11 @@ int rdfa_parse_buffer(rdfacontext* context, size_t bytes)
 {
    int rval;
    int done;
+   char* data = context->working_buffer;
    done = (bytes == 0);
-   rval = rdfa_parse_chunk(context, context->working_buffer, bytes, done);
+   if(!context->preread)
+      data += context->wb_position;
+   rval = rdfa_parse_chunk(context, data, bytes, done);
    context->done = done;
    return rval;
 }
@@ -1534,15 +1627,19 @@ int rdfa_parse(rdfacontext* context)
   do
   {
      size_t wblen;
-     int done;
+     size_t blen;
+     char* buffer = rdfa_get_buffer(context, &blen);
+
+     if(buffer == NULL)
+     {
+        rval = RDFA_PARSE_FAILED;
+        break;
+     }
 
      wblen = context->buffer_filler_callback(
-        context->working_buffer, context->wb_allocated,
-        context->callback_data);
-     done = (wblen == 0);
+        buffer, blen, context->callback_data);
 
-     rval = rdfa_parse_chunk(context, context->working_buffer, wblen, done);
-     context->done=done;
+     rval = rdfa_parse_buffer(context, wblen);
   }
   while(!context->done && rval == RDFA_PARSE_SUCCESS);
 
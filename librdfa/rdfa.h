@@ -74,7 +74,12 @@
 #ifndef _LIBRDFA_RDFA_H_
 #define _LIBRDFA_RDFA_H_
 #include <stdlib.h>
+#if defined(LIBRDFA_IN_RAPTOR) && !defined(RAPTOR_XML_LIBXML)
+/* raptor_sax2 delivers the XML events so libxml2 is not needed */
+typedef unsigned char xmlChar;
+#else
 #include <libxml/SAX2.h>
+#endif
 
 /* Activate the stupid Windows DLL exporting mechanism if we're building for Windows */
 #ifdef WIN32
@@ -264,9 +269,24 @@ typedef struct rdfacontext
 #endif
    int done;
    rdfalist* context_stack;
+   /* bytes of the working buffer searched for the end of <head> */
    size_t wb_preread;
    int preread;
    int depth;
+   /* non-zero when the mapping or list is shared with the parent
+    * context; it is copied before this context changes it and is
+    * never freed by this context */
+#ifndef LIBRDFA_IN_RAPTOR
+   unsigned char uri_mappings_borrowed;
+#endif
+   unsigned char term_mappings_borrowed;
+   unsigned char list_mappings_borrowed;
+   unsigned char incomplete_triples_borrowed;
+   unsigned char local_incomplete_triples_borrowed;
+   /* element contexts released at element end, kept on the root
+    * context for reuse by later elements */
+   struct rdfacontext* context_pool;
+   struct rdfacontext* pool_next;
 } rdfacontext;
 
 /**
@@ -476,6 +476,12 @@ void rdfa_establish_new_inlist_triples(
    rdfresource_t object_type);
 void rdfa_complete_list_triples(rdfacontext* context);
 rdfacontext* rdfa_create_new_element_context(rdfalist* context_stack);
+void rdfa_release_element_context(
+   rdfacontext* root_context, rdfacontext* context);
+void rdfa_own_local_incomplete_triples(rdfacontext* context);
+#ifndef LIBRDFA_IN_RAPTOR
+void rdfa_own_uri_mappings(rdfacontext* context);
+#endif
 void rdfa_free_context_stack(rdfacontext* context);
 char* rdfa_strdup(const char* s);
 
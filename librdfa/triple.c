@@ -344,8 +344,19 @@ void rdfa_complete_incomplete_triples(rdfacontext* context)
                RDF_TYPE_IRI, NULL, NULL);
          context->default_graph_triple_callback(triple, context->callback_data);
       }
-      free(incomplete_triple->data);
-      free(incomplete_triple);
+      if(!context->incomplete_triples_borrowed)
+      {
+         free(incomplete_triple->data);
+         free(incomplete_triple);
+      }
+   }
+
+   /* a list shared with the parent context is left as it is for the
+    * element's siblings; this context simply stops using it */
+   if(context->incomplete_triples_borrowed)
+   {
+      context->incomplete_triples = rdfa_create_list(3);
+      context->incomplete_triples_borrowed = 0;
    }
    context->incomplete_triples->num_items = 0;
 }
@@ -478,6 +489,8 @@ void rdfa_save_incomplete_triples(
     * [incomplete triple]s, pending the discovery of a subject that
     * can be used as the object. Also, [current object resource]
     * should be set to a newly created [bnode] */
+   rdfa_own_local_incomplete_triples(context);
+
    if(context->current_object_resource == NULL)
    {
       context->current_object_resource = rdfa_create_bnode(context);
@@ -75,6 +75,10 @@ struct raptor_ntriples_parser_context_s {
   int is_nquads;
 
   int literal_graph_warning;
+
+  /* non-0 to read trusted one statement per line input
+   * (RAPTOR_OPTION_NTRIPLES_TRUSTED) */
+  int trusted;
 };
 
 
@@ -168,8 +172,12 @@ raptor_ntriples_parse_line(raptor_parser* rdf_parser,
                            int max_terms)
 {
   raptor_ntriples_parser_context *ntriples_parser = (raptor_ntriples_parser_context*)rdf_parser->context;
+  raptor_locator *locator = &rdf_parser->locator;
   int i;
   unsigned char *p;
+  /* input position that the locator column and byte have been
+   * advanced to; they are only brought up to date when used */
+  const unsigned char *mark;
   raptor_term* terms[MAX_NTRIPLES_TERMS+1] = {NULL, NULL, NULL, NULL, NULL};
   int rc = 0;
   
@@ -187,14 +195,15 @@ raptor_ntriples_parse_line(raptor_parser* rdf_parser,
 #endif
   
   p = buffer;
+  mark = p;
 
   while(len > 0 && isspace((int)*p)) {
     p++;
-    rdf_parser->locator.column++;
-    rdf_parser->locator.byte++;
     len--;
   }
 
+  RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
+
   /* Handle empty - all whitespace lines */
   if(!len)
     return 0;
@@ -257,17 +266,23 @@ raptor_ntriples_parse_line(raptor_parser* rdf_parser,
     }
 
 
-    term_len = raptor_ntriples_parse_term(rdf_parser->world, &rdf_parser->locator,
-                                          p, &len, &terms[i], 0);
+    term_len = raptor_ntriples_parse_term(rdf_parser->world, locator,
+                                          p, &len, &terms[i],
+                                          ntriples_parser->trusted ?
+                                          RAPTOR_NTRIPLES_TERM_TRUSTED : 0);
     if(!term_len) {
       rc = 1;
       goto cleanup;
     }
 
+    /* the term parser advanced the locator past the term */
     p += term_len;
+    mark = p;
     rc = 0;
 
-    if(terms[i] && terms[i]->type == RAPTOR_TERM_TYPE_URI) {
+    /* the term parser already refused relative URIs */
+    if(!ntriples_parser->trusted &&
+       terms[i] && terms[i]->type == RAPTOR_TERM_TYPE_URI) {
       unsigned const char* uri_string;
 
       /* Check for absolute URI */
@@ -282,10 +297,10 @@ raptor_ntriples_parse_line(raptor_parser* rdf_parser,
     while(len > 0 && isspace((int)*p)) {
       p++;
       len--;
-      rdf_parser->locator.column++;
-      rdf_parser->locator.byte++;
     }
 
+    RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
+
 #if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
     if(terms[i]) {
       unsigned char* c = raptor_term_to_string(terms[i]);
@@ -306,17 +321,15 @@ raptor_ntriples_parse_line(raptor_parser* rdf_parser,
     if(*p == '.') {
       p++;
       len--;
-      rdf_parser->locator.column++;
-      rdf_parser->locator.byte++;
 
       /* Skip whitespace after '.' */
       while(len > 0 && isspace((int)*p)) {
         p++;
         len--;
-        rdf_parser->locator.column++;
-        rdf_parser->locator.byte++;
       }
 
+      RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
+
       /* Only a comment is allowed here */
       if(*p && *p != '#') {
         raptor_parser_error(rdf_parser, "Junk after terminating \".\"");
@@ -442,7 +455,20 @@ raptor_ntriples_parse_chunk(raptor_parser* rdf_parser,
       start = line_start = ptr;
     }
 
-    if(1) {
+    if(ntriples_parser->trusted) {
+      /* one statement per line with no raw newlines in literals; a
+       * line split inside a literal fails to parse and is reported */
+      unsigned char *cr;
+
+      ptr = (unsigned char*)memchr(line_start, '\n',
+                                   RAPTOR_GOOD_CAST(size_t, end_ptr - line_start));
+      if(!ptr)
+        ptr = end_ptr;
+      cr = (unsigned char*)memchr(line_start, '\r',
+                                  RAPTOR_GOOD_CAST(size_t, ptr - line_start));
+      if(cr)
+        ptr = cr;
+    } else {
       int quote = '\0';
       int in_uri = '\0';
       int bq = 0;
@@ -576,16 +602,39 @@ raptor_ntriples_parse_start(raptor_parser* rdf_parser)
   locator->column = 0;
   locator->byte = 0;
 
+  /* drop any partial line left by a parse that was not finished */
+  if(ntriples_parser->line_length) {
+    RAPTOR_FREE(cdata, ntriples_parser->line);
+    ntriples_parser->line = NULL;
+    ntriples_parser->line_length = 0;
+  }
+  ntriples_parser->offset = 0;
+
   ntriples_parser->last_char = '\0';
 
+  ntriples_parser->trusted = RAPTOR_OPTIONS_GET_NUMERIC(rdf_parser,
+                                                        RAPTOR_OPTION_NTRIPLES_TRUSTED);
+
   return 0;
 }
 
 
 #if defined RAPTOR_PARSER_NTRIPLES || defined RAPTOR_PARSER_NQUADS
+/* strings looked for by raptor_ntriples_parse_recognise_syntax() */
+static const char* const ntriples_recognise_patterns[7] = {
+  "@prefix ",
+  "\n<http://",
+  "\r<http://",
+  "> <http://",
+  "> <",
+  "> \"",
+  NULL
+};
+
 static int
 raptor_ntriples_parse_recognise_syntax(raptor_parser_factory* factory, 
                                        const unsigned char *buffer, size_t len,
+                                       unsigned int patterns,
                                        const unsigned char *identifier, 
                                        const unsigned char *suffix, 
                                        const char *mime_type)
@@ -615,18 +664,18 @@ raptor_ntriples_parse_recognise_syntax(raptor_parser_factory* factory,
      * and that all URLs are absolute, and there are a lot of http:
      * URLs
      */
-#define  HAS_AT_PREFIX (raptor_memstr((const char*)buffer, len, "@prefix ") != NULL)
+#define  HAS_AT_PREFIX RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 0)
 
 #define  HAS_NTRIPLES_START_1_LEN 8
 #define  HAS_NTRIPLES_START_1 (!memcmp((const char*)buffer, "<http://", HAS_NTRIPLES_START_1_LEN))
 #define  HAS_NTRIPLES_START_2_LEN 2
 #define  HAS_NTRIPLES_START_2 (!memcmp((const char*)buffer, "_:", HAS_NTRIPLES_START_2_LEN))
 
-#define  HAS_NTRIPLES_1 (raptor_memstr((const char*)buffer, len, "\n<http://") != NULL)
-#define  HAS_NTRIPLES_2 (raptor_memstr((const char*)buffer, len, "\r<http://") != NULL)
-#define  HAS_NTRIPLES_3 (raptor_memstr((const char*)buffer, len, "> <http://") != NULL)
-#define  HAS_NTRIPLES_4 (raptor_memstr((const char*)buffer, len, "> <") != NULL)
-#define  HAS_NTRIPLES_5 (raptor_memstr((const char*)buffer, len, "> \"") != NULL)
+#define  HAS_NTRIPLES_1 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 1)
+#define  HAS_NTRIPLES_2 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 2)
+#define  HAS_NTRIPLES_3 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 3)
+#define  HAS_NTRIPLES_4 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 4)
+#define  HAS_NTRIPLES_5 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 5)
     if(HAS_AT_PREFIX)
       /* Turtle */
       return 0;
@@ -696,6 +745,7 @@ raptor_ntriples_parser_register_factory(raptor_parser_factory *factory)
   factory->start     = raptor_ntriples_parse_start;
   factory->chunk     = raptor_ntriples_parse_chunk;
   factory->recognise_syntax = raptor_ntriples_parse_recognise_syntax;
+  factory->recognise_patterns = ntriples_recognise_patterns;
 
   return rc;
 }
@@ -715,6 +765,7 @@ raptor_init_parser_ntriples(raptor_world* world)
 static int
 raptor_nquads_parse_recognise_syntax(raptor_parser_factory* factory, 
                                      const unsigned char *buffer, size_t len,
+                                     unsigned int patterns,
                                      const unsigned char *identifier, 
                                      const unsigned char *suffix, 
                                      const char *mime_type)
@@ -742,7 +793,7 @@ raptor_nquads_parse_recognise_syntax(raptor_parser_factory* factory,
   }
   
   /* ntriples is a subset of nquads, score higher than ntriples */
-  ntriples_score = raptor_ntriples_parse_recognise_syntax(factory, buffer, len, identifier, suffix, mime_type);
+  ntriples_score = raptor_ntriples_parse_recognise_syntax(factory, buffer, len, patterns, identifier, suffix, mime_type);
   if(ntriples_score > 0) {
     score += ntriples_score + 1;
   }
@@ -785,6 +836,7 @@ raptor_nquads_parser_register_factory(raptor_parser_factory *factory)
   factory->start     = raptor_ntriples_parse_start;
   factory->chunk     = raptor_ntriples_parse_chunk;
   factory->recognise_syntax = raptor_nquads_parse_recognise_syntax;
+  factory->recognise_patterns = ntriples_recognise_patterns;
 
   return rc;
 }
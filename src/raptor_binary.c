@@ -0,0 +1,1910 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_binary.c - Raptor binary RDF parser and serializer
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <sys/types.h>
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+/*
+ * The binary syntax is a stream of statements for moving RDF quickly
+ * between raptor-based tools.  Every term is written once into a
+ * dictionary and statements refer to terms by number so nothing is
+ * ever escaped or parsed as text.
+ *
+ * A stream is:
+ *   8 bytes magic RAPTOR_BINARY_MAGIC
+ *   1 byte  version RAPTOR_BINARY_VERSION
+ *   records until an END record
+ *
+ * A record is a 1 byte tag, a varint payload length and the payload:
+ *
+ *   TERMS      varint count, then count terms
+ *   STATEMENTS varint count, then count statements
+ *   RESET      empty - forget all terms defined so far
+ *   END        empty - end of this stream; another stream may follow
+ *
+ * Varints are unsigned LEB128: 7 bits per byte, low bits first, the
+ * top bit set on all bytes but the last.
+ *
+ * Terms are numbered from 1 in the order they are defined since the
+ * start of the stream or the last RESET.  A term is a kind byte then:
+ *
+ *   URI, BLANK    varint length, UTF-8 bytes
+ *   LITERAL       varint length, UTF-8 bytes
+ *   LANG_LITERAL  varint length, UTF-8 bytes, varint length, language
+ *   TYPED_LITERAL varint length, UTF-8 bytes, varint datatype URI term
+ *
+ * A statement is a flags byte, then varint term numbers for the
+ * subject, predicate, object and graph.  The subject, predicate and
+ * graph are left out if the flags say they are the same as in the
+ * previous statement and the graph is also left out if there is none.
+ */
+
+#define RAPTOR_BINARY_MAGIC "\x89RBR\r\n\x1a\n"
+#define RAPTOR_BINARY_MAGIC_LEN 8
+#define RAPTOR_BINARY_VERSION 1
+#define RAPTOR_BINARY_HEADER_LEN (RAPTOR_BINARY_MAGIC_LEN + 1)
+
+/* record tags */
+#define RAPTOR_BINARY_TERMS      'T'
+#define RAPTOR_BINARY_STATEMENTS 'S'
+#define RAPTOR_BINARY_RESET      'R'
+#define RAPTOR_BINARY_END        'E'
+
+/* term kinds */
+#define RAPTOR_BINARY_URI           1
+#define RAPTOR_BINARY_BLANK         2
+#define RAPTOR_BINARY_LITERAL       3
+#define RAPTOR_BINARY_LANG_LITERAL  4
+#define RAPTOR_BINARY_TYPED_LITERAL 5
+
+/* statement flags */
+#define RAPTOR_BINARY_SAME_SUBJECT   1
+#define RAPTOR_BINARY_SAME_PREDICATE 2
+#define RAPTOR_BINARY_SAME_GRAPH     4
+#define RAPTOR_BINARY_HAS_GRAPH      8
+
+/* longest varint for a size_t */
+#define RAPTOR_BINARY_VARINT_MAX_LEN ((sizeof(size_t) * 8 + 6) / 7)
+
+
+#ifndef STANDALONE
+
+/*
+ * raptor_binary_read_varint:
+ * @p_p: pointer to data pointer, advanced past the varint on success
+ * @end: end of data
+ * @value_p: pointer to store value
+ *
+ * INTERNAL - Decode a varint
+ *
+ * Return value: 0 on success, >0 if the data ends inside the varint,
+ * <0 if the varint is too large
+ */
+static int
+raptor_binary_read_varint(const unsigned char** p_p, const unsigned char* end,
+                          size_t* value_p)
+{
+  const unsigned char* p = *p_p;
+  size_t value = 0;
+  unsigned int shift = 0;
+
+  while(p < end) {
+    unsigned char c = *p++;
+
+    if(shift >= sizeof(size_t) * 8 ||
+       (shift && (size_t)(c & 0x7f) >> (sizeof(size_t) * 8 - shift)))
+      return -1;
+
+    value |= (size_t)(c & 0x7f) << shift;
+    if(!(c & 0x80)) {
+      *p_p = p;
+      *value_p = value;
+      return 0;
+    }
+    shift += 7;
+  }
+
+  return 1;
+}
+
+
+#ifdef RAPTOR_SERIALIZER_BINARY
+/*
+ * raptor_binary_write_varint:
+ * @buffer: buffer of at least RAPTOR_BINARY_VARINT_MAX_LEN bytes
+ * @value: value
+ *
+ * INTERNAL - Encode a varint
+ *
+ * Return value: number of bytes written
+ */
+static size_t
+raptor_binary_write_varint(unsigned char* buffer, size_t value)
+{
+  size_t len = 0;
+
+  while(value >= 0x80) {
+    buffer[len++] = RAPTOR_GOOD_CAST(unsigned char, (value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  buffer[len++] = RAPTOR_GOOD_CAST(unsigned char, value);
+
+  return len;
+}
+#endif
+
+
+
+#ifdef RAPTOR_PARSER_BINARY
+
+/*
+ * Raptor binary parser object
+ */
+typedef struct {
+  /* terms defined so far, term number N is at index N-1 */
+  raptor_term** terms;
+  size_t terms_count;
+  size_t terms_size;
+
+  /* bytes of an incomplete record kept from the last chunk */
+  unsigned char* pending;
+  size_t pending_len;
+  size_t pending_size;
+
+  /* non-0 when a stream header has been read and not yet ended */
+  int in_stream;
+
+  /* non-0 after an error; all further content is ignored */
+  int failed;
+
+  /* offset of the start of the next unread byte in the content */
+  size_t offset;
+
+  /* term numbers used by the previous statement */
+  size_t last_subject;
+  size_t last_predicate;
+  size_t last_graph;
+} raptor_binary_parser_context;
+
+
+static void
+raptor_binary_parser_reset_terms(raptor_binary_parser_context* context)
+{
+  size_t i;
+
+  for(i = 0; i < context->terms_count; i++)
+    raptor_free_term(context->terms[i]);
+  context->terms_count = 0;
+
+  context->last_subject = 0;
+  context->last_predicate = 0;
+  context->last_graph = 0;
+}
+
+
+static int
+raptor_binary_parse_init(raptor_parser* rdf_parser, const char *name)
+{
+  return 0;
+}
+
+
+static void
+raptor_binary_parse_terminate(raptor_parser* rdf_parser)
+{
+  raptor_binary_parser_context* context;
+
+  context = (raptor_binary_parser_context*)rdf_parser->context;
+
+  raptor_binary_parser_reset_terms(context);
+  if(context->terms)
+    RAPTOR_FREE(raptor_term**, context->terms);
+  if(context->pending)
+    RAPTOR_FREE(char*, context->pending);
+}
+
+
+static int
+raptor_binary_parse_start(raptor_parser* rdf_parser)
+{
+  raptor_binary_parser_context* context;
+
+  context = (raptor_binary_parser_context*)rdf_parser->context;
+
+  raptor_binary_parser_reset_terms(context);
+  context->pending_len = 0;
+  context->in_stream = 0;
+  context->failed = 0;
+  context->offset = 0;
+
+  return 0;
+}
+
+
+/*
+ * raptor_binary_parse_add_term:
+ * @rdf_parser: parser
+ * @term: new term (ownership is taken)
+ *
+ * INTERNAL - Add a term to the dictionary as the next term number
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_binary_parse_add_term(raptor_parser* rdf_parser, raptor_term* term)
+{
+  raptor_binary_parser_context* context;
+
+  context = (raptor_binary_parser_context*)rdf_parser->context;
+
+  if(!term) {
+    raptor_parser_fatal_error(rdf_parser, "Out of memory");
+    return 1;
+  }
+
+  if(context->terms_count == context->terms_size) {
+    size_t new_size = context->terms_size ? (context->terms_size << 1) : 1024;
+    raptor_term** new_terms;
+
+    new_terms = RAPTOR_REALLOC(raptor_term**, context->terms,
+                               new_size * sizeof(raptor_term*));
+    if(!new_terms) {
+      raptor_free_term(term);
+      raptor_parser_fatal_error(rdf_parser, "Out of memory");
+      return 1;
+    }
+    context->terms = new_terms;
+    context->terms_size = new_size;
+  }
+
+  context->terms[context->terms_count++] = term;
+
+  return 0;
+}
+
+
+/*
+ * raptor_binary_parse_terms:
+ * @rdf_parser: parser
+ * @p: TERMS record payload
+ * @end: end of payload
+ *
+ * INTERNAL - Add the terms in a TERMS record to the dictionary
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_binary_parse_terms(raptor_parser* rdf_parser,
+                          const unsigned char* p, const unsigned char* end)
+{
+  raptor_binary_parser_context* context;
+  size_t count;
+
+  context = (raptor_binary_parser_context*)rdf_parser->context;
+
+  if(raptor_binary_read_varint(&p, end, &count))
+    goto bad;
+
+  while(count--) {
+    unsigned char kind;
+    const unsigned char* string;
+    size_t len;
+    raptor_term* term = NULL;
+
+    if(p == end)
+      goto bad;
+    kind = *p++;
+
+    if(raptor_binary_read_varint(&p, end, &len) ||
+       len > RAPTOR_GOOD_CAST(size_t, end - p))
+      goto bad;
+    string = p;
+    p += len;
+
+    switch(kind) {
+      case RAPTOR_BINARY_URI:
+        term = raptor_new_term_from_counted_uri_string(rdf_parser->world,
+                                                       string, len);
+        break;
+
+      case RAPTOR_BINARY_BLANK:
+        term = raptor_new_term_from_counted_blank(rdf_parser->world,
+                                                  string, len);
+        break;
+
+      case RAPTOR_BINARY_LITERAL:
+        term = raptor_new_term_from_counted_literal(rdf_parser->world,
+                                                    string, len,
+                                                    NULL, NULL, 0);
+        break;
+
+      case RAPTOR_BINARY_LANG_LITERAL:
+        {
+          /* the term constructor needs a NUL terminated language */
+          unsigned char language[256];
+          size_t language_len;
+
+          if(raptor_binary_read_varint(&p, end, &language_len) ||
+             !language_len || language_len >= sizeof(language) ||
+             language_len > RAPTOR_GOOD_CAST(size_t, end - p))
+            goto bad;
+          memcpy(language, p, language_len);
+          language[language_len] = '\0';
+          p += language_len;
+
+          term = raptor_new_term_from_counted_literal(rdf_parser->world,
+                                                      string, len, NULL,
+                                                      language,
+                                                      RAPTOR_GOOD_CAST(unsigned char, language_len));
+        }
+        break;
+
+      case RAPTOR_BINARY_TYPED_LITERAL:
+        {
+          size_t datatype;
+
+          if(raptor_binary_read_varint(&p, end, &datatype) ||
+             !datatype || datatype > context->terms_count ||
+             context->terms[datatype - 1]->type != RAPTOR_TERM_TYPE_URI)
+            goto bad;
+
+          term = raptor_new_term_from_counted_literal(rdf_parser->world,
+                                                      string, len,
+                                                      context->terms[datatype - 1]->value.uri,
+                                                      NULL, 0);
+        }
+        break;
+
+      default:
+        goto bad;
+    }
+
+    if(raptor_binary_parse_add_term(rdf_parser, term))
+      return 1;
+  }
+
+  if(p != end)
+    goto bad;
+
+  return 0;
+
+  bad:
+  raptor_parser_error(rdf_parser, "Bad binary RDF term record");
+  return 1;
+}
+
+
+/*
+ * raptor_binary_parse_statements:
+ * @rdf_parser: parser
+ * @p: STATEMENTS record payload
+ * @end: end of payload
+ *
+ * INTERNAL - Generate the statements in a STATEMENTS record
+ *
+ * The terms are passed to the statement handler straight from the
+ * dictionary so a statement costs no allocation.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_binary_parse_statements(raptor_parser* rdf_parser,
+                               const unsigned char* p,
+                               const unsigned char* end)
+{
+  raptor_binary_parser_context* context;
+  raptor_statement *statement = &rdf_parser->statement;
+  raptor_term** terms;
+  size_t terms_count;
+  size_t count;
+
+  context = (raptor_binary_parser_context*)rdf_parser->context;
+  terms = context->terms;
+  terms_count = context->terms_count;
+
+  if(raptor_binary_read_varint(&p, end, &count))
+    goto bad;
+
+  if(count && !rdf_parser->emitted_default_graph) {
+    raptor_parser_start_graph(rdf_parser, NULL, 0);
+    rdf_parser->emitted_default_graph++;
+  }
+
+  while(count--) {
+    unsigned int flags;
+    size_t object;
+
+    if(p == end)
+      goto bad;
+    flags = *p++;
+
+    if(!(flags & RAPTOR_BINARY_SAME_SUBJECT) &&
+       raptor_binary_read_varint(&p, end, &context->last_subject))
+      goto bad;
+    if(!(flags & RAPTOR_BINARY_SAME_PREDICATE) &&
+       raptor_binary_read_varint(&p, end, &context->last_predicate))
+      goto bad;
+    if(raptor_binary_read_varint(&p, end, &object))
+      goto bad;
+    if(!(flags & RAPTOR_BINARY_SAME_GRAPH)) {
+      context->last_graph = 0;
+      if((flags & RAPTOR_BINARY_HAS_GRAPH) &&
+         raptor_binary_read_varint(&p, end, &context->last_graph))
+        goto bad;
+    }
+
+    if(!context->last_subject || context->last_subject > terms_count ||
+       !context->last_predicate || context->last_predicate > terms_count ||
+       !object || object > terms_count ||
+       context->last_graph > terms_count)
+      goto bad;
+
+    statement->subject = terms[context->last_subject - 1];
+    statement->predicate = terms[context->last_predicate - 1];
+    statement->object = terms[object - 1];
+    statement->graph = context->last_graph ? terms[context->last_graph - 1] : NULL;
+
+    if(statement->subject->type == RAPTOR_TERM_TYPE_LITERAL ||
+       statement->predicate->type != RAPTOR_TERM_TYPE_URI ||
+       (statement->graph &&
+        statement->graph->type == RAPTOR_TERM_TYPE_LITERAL))
+      goto bad;
+
+    if(rdf_parser->statement_handler)
+      (*rdf_parser->statement_handler)(rdf_parser->user_data, statement);
+
+    if(rdf_parser->failed)
+      break;
+  }
+
+  statement->subject = NULL;
+  statement->predicate = NULL;
+  statement->object = NULL;
+  statement->graph = NULL;
+
+  if(!rdf_parser->failed && p != end)
+    goto bad;
+
+  return 0;
+
+  bad:
+  statement->subject = NULL;
+  statement->predicate = NULL;
+  statement->object = NULL;
+  statement->graph = NULL;
+
+  raptor_parser_error(rdf_parser, "Bad binary RDF statement record");
+  return 1;
+}
+
+
+/*
+ * raptor_binary_parse_records:
+ * @rdf_parser: parser
+ * @buffer: content
+ * @len: length of content
+ * @used_p: pointer to store the number of bytes used
+ *
+ * INTERNAL - Handle the stream headers and complete records in a buffer
+ *
+ * Stops at the first incomplete header or record which is left
+ * for the caller to keep until more content arrives.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_binary_parse_records(raptor_parser* rdf_parser,
+                            const unsigned char *buffer, size_t len,
+                            size_t* used_p)
+{
+  raptor_binary_parser_context* context;
+  const unsigned char* p = buffer;
+  const unsigned char* end = buffer + len;
+  int rc = 0;
+
+  context = (raptor_binary_parser_context*)rdf_parser->context;
+
+  while(p < end && !rdf_parser->failed) {
+    const unsigned char* payload;
+    size_t payload_len;
+    unsigned char tag;
+    int vrc;
+
+    rdf_parser->locator.byte = RAPTOR_GOOD_CAST(int, context->offset + RAPTOR_GOOD_CAST(size_t, p - buffer));
+
+    if(!context->in_stream) {
+      if(RAPTOR_GOOD_CAST(size_t, end - p) < RAPTOR_BINARY_HEADER_LEN) {
+        if(memcmp(p, RAPTOR_BINARY_MAGIC, RAPTOR_GOOD_CAST(size_t, end - p)))
+          goto not_binary;
+        break;
+      }
+      if(memcmp(p, RAPTOR_BINARY_MAGIC, RAPTOR_BINARY_MAGIC_LEN))
+        goto not_binary;
+      if(p[RAPTOR_BINARY_MAGIC_LEN] != RAPTOR_BINARY_VERSION) {
+        raptor_parser_error(rdf_parser,
+                            "Unsupported binary RDF version %d",
+                            p[RAPTOR_BINARY_MAGIC_LEN]);
+        rc = 1;
+        break;
+      }
+      p += RAPTOR_BINARY_HEADER_LEN;
+      context->in_stream = 1;
+      continue;
+    }
+
+    tag = *p;
+    payload = p + 1;
+    vrc = raptor_binary_read_varint(&payload, end, &payload_len);
+    if(vrc > 0)
+      break;
+    if(vrc < 0) {
+      raptor_parser_error(rdf_parser, "Bad binary RDF record length");
+      rc = 1;
+      break;
+    }
+    if(payload_len > RAPTOR_GOOD_CAST(size_t, end - payload))
+      break;
+
+    switch(tag) {
+      case RAPTOR_BINARY_TERMS:
+        rc = raptor_binary_parse_terms(rdf_parser, payload,
+                                       payload + payload_len);
+        break;
+
+      case RAPTOR_BINARY_STATEMENTS:
+        rc = raptor_binary_parse_statements(rdf_parser, payload,
+                                            payload + payload_len);
+        break;
+
+      case RAPTOR_BINARY_RESET:
+        raptor_binary_parser_reset_terms(context);
+        break;
+
+      case RAPTOR_BINARY_END:
+        raptor_binary_parser_reset_terms(context);
+        context->in_stream = 0;
+        break;
+
+      default:
+        raptor_parser_error(rdf_parser, "Unknown binary RDF record type %d",
+                            tag);
+        rc = 1;
+        break;
+    }
+    if(rc)
+      break;
+
+    p = payload + payload_len;
+  }
+
+  *used_p = RAPTOR_GOOD_CAST(size_t, p - buffer);
+  context->offset += *used_p;
+  return rc;
+
+  not_binary:
+  raptor_parser_error(rdf_parser, "Content is not binary RDF");
+  *used_p = RAPTOR_GOOD_CAST(size_t, p - buffer);
+  context->offset += *used_p;
+  return 1;
+}
+
+
+/*
+ * raptor_binary_parse_keep_pending:
+ * @context: parser context
+ * @buffer: bytes
+ * @len: number of bytes
+ *
+ * INTERNAL - Append bytes to the pending incomplete record
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_binary_parse_keep_pending(raptor_binary_parser_context* context,
+                                 const unsigned char* buffer, size_t len)
+{
+  if(context->pending_len + len > context->pending_size) {
+    size_t new_size = context->pending_size ? context->pending_size : 4096;
+    unsigned char* new_pending;
+
+    while(new_size < context->pending_len + len)
+      new_size <<= 1;
+
+    new_pending = RAPTOR_REALLOC(unsigned char*, context->pending, new_size);
+    if(!new_pending)
+      return 1;
+    context->pending = new_pending;
+    context->pending_size = new_size;
+  }
+
+  memcpy(context->pending + context->pending_len, buffer, len);
+  context->pending_len += len;
+
+  return 0;
+}
+
+
+static int
+raptor_binary_parse_chunk(raptor_parser* rdf_parser,
+                          const unsigned char *buffer, size_t len,
+                          int is_end)
+{
+  raptor_binary_parser_context* context;
+  size_t used = 0;
+  int rc = 0;
+
+  context = (raptor_binary_parser_context*)rdf_parser->context;
+
+  if(context->failed)
+    return 1;
+
+  rdf_parser->locator.line = -1;
+  rdf_parser->locator.column = -1;
+
+  if(context->pending_len) {
+    /* finish the incomplete record first */
+    if(len && raptor_binary_parse_keep_pending(context, buffer, len))
+      goto oom;
+
+    rc = raptor_binary_parse_records(rdf_parser, context->pending,
+                                     context->pending_len, &used);
+    context->pending_len -= used;
+    if(context->pending_len)
+      memmove(context->pending, context->pending + used,
+              context->pending_len);
+  } else if(len) {
+    /* parse straight from the caller's buffer and keep any tail */
+    rc = raptor_binary_parse_records(rdf_parser, buffer, len, &used);
+    if(!rc && used < len &&
+       raptor_binary_parse_keep_pending(context, buffer + used, len - used))
+      goto oom;
+  }
+
+  if(!rc && is_end && !rdf_parser->failed &&
+     (context->pending_len || context->in_stream)) {
+    raptor_parser_error(rdf_parser, "Binary RDF content is truncated");
+    rc = 1;
+  }
+
+  if(rc)
+    context->failed = 1;
+
+  return rc;
+
+  oom:
+  raptor_parser_fatal_error(rdf_parser, "Out of memory");
+  context->failed = 1;
+  return 1;
+}
+
+
+/*
+ * raptor_binary_parse_file_handle:
+ * @rdf_parser: parser
+ * @handle: file handle open at the start of the content
+ *
+ * INTERNAL - Parse a whole regular file by mapping it into memory
+ *
+ * Return value: <0 if the file cannot be mapped or does not start
+ * with a binary RDF header, otherwise non-0 on failure
+ */
+static int
+raptor_binary_parse_file_handle(raptor_parser* rdf_parser, FILE* handle)
+{
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H) && defined(HAVE_SYS_STAT_H)
+  struct stat buf;
+  size_t len;
+  void* map;
+  int fd;
+  int rc;
+
+  fd = fileno(handle);
+  if(fd < 0 || fstat(fd, &buf) || !S_ISREG(buf.st_mode) ||
+     buf.st_size < RAPTOR_BINARY_HEADER_LEN)
+    return -1;
+  len = RAPTOR_GOOD_CAST(size_t, buf.st_size);
+  if(RAPTOR_GOOD_CAST(off_t, len) != buf.st_size)
+    return -1;
+
+  map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  if(map == MAP_FAILED)
+    return -1;
+
+  /* leave anything else such as compressed content to be read */
+  if(memcmp(map, RAPTOR_BINARY_MAGIC, RAPTOR_BINARY_MAGIC_LEN)) {
+    munmap(map, len);
+    return -1;
+  }
+
+#ifdef MADV_SEQUENTIAL
+  madvise(map, len, MADV_SEQUENTIAL);
+#endif
+
+  rc = raptor_parser_parse_chunk(rdf_parser, (const unsigned char*)map,
+                                 len, 1);
+
+  munmap(map, len);
+
+  return rc != 0;
+#else
+  return -1;
+#endif
+}
+
+
+static int
+raptor_binary_parse_recognise_syntax(raptor_parser_factory* factory,
+                                     const unsigned char *buffer, size_t len,
+                                     unsigned int patterns,
+                                     const unsigned char *identifier,
+                                     const unsigned char *suffix,
+                                     const char *mime_type)
+{
+  int score = 0;
+
+  if(buffer && len >= RAPTOR_BINARY_MAGIC_LEN &&
+     !memcmp(buffer, RAPTOR_BINARY_MAGIC, RAPTOR_BINARY_MAGIC_LEN))
+    return 10;
+
+  if(suffix && !strcmp((const char*)suffix, "rbin"))
+    score = 8;
+
+  if(mime_type && strstr((const char*)mime_type, "x-raptor-binary"))
+    score += 6;
+
+  return score;
+}
+
+
+static const char* const binary_parser_names[2] = { "binary", NULL };
+
+static const char* const binary_parser_uri_strings[2] = {
+  "http://librdf.org/raptor/binary",
+  NULL
+};
+
+#define BINARY_PARSER_TYPES_COUNT 1
+static const raptor_type_q binary_parser_types[BINARY_PARSER_TYPES_COUNT + 1] = {
+  { "application/x-raptor-binary", 27, 10},
+  { NULL, 0, 0}
+};
+
+static int
+raptor_binary_parser_register_factory(raptor_parser_factory *factory)
+{
+  int rc = 0;
+
+  factory->desc.names = binary_parser_names;
+
+  factory->desc.mime_types = binary_parser_types;
+
+  factory->desc.label = "Raptor Binary RDF";
+  factory->desc.uri_strings = binary_parser_uri_strings;
+
+  factory->desc.flags = 0;
+
+  factory->context_length     = sizeof(raptor_binary_parser_context);
+
+  factory->init      = raptor_binary_parse_init;
+  factory->terminate = raptor_binary_parse_terminate;
+  factory->start     = raptor_binary_parse_start;
+  factory->chunk     = raptor_binary_parse_chunk;
+  factory->recognise_syntax = raptor_binary_parse_recognise_syntax;
+  factory->parse_file_handle = raptor_binary_parse_file_handle;
+
+  return rc;
+}
+
+
+int
+raptor_init_parser_binary(raptor_world* world)
+{
+  return !raptor_world_register_parser_factory(world,
+                                               &raptor_binary_parser_register_factory);
+}
+
+#endif
+
+
+
+#ifdef RAPTOR_SERIALIZER_BINARY
+
+/* statements per STATEMENTS record */
+#define RAPTOR_BINARY_BLOCK_STATEMENTS 4096
+
+/* terms in the dictionary before it is reset */
+#define RAPTOR_BINARY_MAX_TERMS (1 << 20)
+
+/* initial number of dictionary hash table entries - must be a power of 2 */
+#define RAPTOR_BINARY_INITIAL_TABLE_SIZE 4096
+
+/* size of the arena blocks that term strings are copied into */
+#define RAPTOR_BINARY_ARENA_BLOCK_SIZE 65536
+
+
+typedef struct
+{
+  unsigned char* data;
+  size_t len;
+  size_t size;
+} raptor_binary_buffer;
+
+
+typedef struct
+{
+  /* term string in an arena block */
+  const unsigned char* string;
+  size_t len;
+
+  /* language after the string in the same arena block or NULL */
+  const unsigned char* language;
+  size_t language_len;
+
+  /* datatype URI term number or 0 */
+  size_t datatype;
+
+  /* full hash */
+  unsigned int hash;
+
+  /* term kind or 0 if the entry is empty */
+  unsigned char kind;
+
+  /* term number */
+  size_t id;
+} raptor_binary_entry;
+
+
+typedef struct raptor_binary_arena_block_s
+{
+  struct raptor_binary_arena_block_s* next;
+
+  /* size of the data area following this header */
+  size_t size;
+
+  /* bytes used in the data area */
+  size_t used;
+} raptor_binary_arena_block;
+
+
+/*
+ * Raptor binary serializer object
+ */
+typedef struct {
+  /* dictionary hash table of size (power of 2) entries */
+  raptor_binary_entry* entries;
+  size_t size;
+
+  /* number of terms defined, also the last term number */
+  size_t count;
+
+  /* reset the dictionary when it would hold more than this many terms */
+  size_t max_terms;
+
+  /* arena blocks holding the term strings, most recent first */
+  raptor_binary_arena_block* blocks;
+
+  /* TERMS record payload waiting to be written */
+  raptor_binary_buffer terms;
+  size_t terms_count;
+
+  /* STATEMENTS record payload waiting to be written */
+  raptor_binary_buffer statements;
+  size_t statements_count;
+
+  /* term numbers used by the previous statement */
+  size_t last_subject;
+  size_t last_predicate;
+  size_t last_graph;
+} raptor_binary_serializer_context;
+
+
+static int
+raptor_binary_buffer_reserve(raptor_binary_buffer* buffer, size_t len)
+{
+  size_t new_size;
+  unsigned char* new_data;
+
+  if(buffer->len + len <= buffer->size)
+    return 0;
+
+  new_size = buffer->size ? buffer->size : 65536;
+  while(new_size < buffer->len + len)
+    new_size <<= 1;
+
+  new_data = RAPTOR_REALLOC(unsigned char*, buffer->data, new_size);
+  if(!new_data)
+    return 1;
+
+  buffer->data = new_data;
+  buffer->size = new_size;
+  return 0;
+}
+
+
+static void
+raptor_binary_buffer_add_varint(raptor_binary_buffer* buffer, size_t value)
+{
+  buffer->len += raptor_binary_write_varint(buffer->data + buffer->len,
+                                            value);
+}
+
+
+static void
+raptor_binary_serializer_reset_terms(raptor_binary_serializer_context* context)
+{
+  raptor_binary_arena_block *block = context->blocks;
+
+  while(block) {
+    raptor_binary_arena_block *next = block->next;
+    RAPTOR_FREE(raptor_binary_arena_block, block);
+    block = next;
+  }
+  context->blocks = NULL;
+
+  if(context->entries)
+    memset(context->entries, 0, context->size * sizeof(raptor_binary_entry));
+  context->count = 0;
+
+  context->last_subject = 0;
+  context->last_predicate = 0;
+  context->last_graph = 0;
+}
+
+
+static int
+raptor_binary_serialize_init(raptor_serializer* serializer, const char *name)
+{
+  raptor_binary_serializer_context* context;
+
+  context = (raptor_binary_serializer_context*)serializer->context;
+
+  context->entries = RAPTOR_CALLOC(raptor_binary_entry*,
+                                   RAPTOR_BINARY_INITIAL_TABLE_SIZE,
+                                   sizeof(raptor_binary_entry));
+  if(!context->entries)
+    return 1;
+  context->size = RAPTOR_BINARY_INITIAL_TABLE_SIZE;
+  context->max_terms = RAPTOR_BINARY_MAX_TERMS;
+
+  return 0;
+}
+
+
+static void
+raptor_binary_serialize_terminate(raptor_serializer* serializer)
+{
+  raptor_binary_serializer_context* context;
+
+  context = (raptor_binary_serializer_context*)serializer->context;
+
+  raptor_binary_serializer_reset_terms(context);
+
+  if(context->entries)
+    RAPTOR_FREE(raptor_binary_entry*, context->entries);
+  if(context->terms.data)
+    RAPTOR_FREE(char*, context->terms.data);
+  if(context->statements.data)
+    RAPTOR_FREE(char*, context->statements.data);
+}
+
+
+static int
+raptor_binary_serialize_declare_namespace(raptor_serializer* serializer,
+                                          raptor_uri *uri,
+                                          const unsigned char *prefix)
+{
+  /* NOP */
+  return 0;
+}
+
+
+/*
+ * raptor_binary_serialize_write_record:
+ * @serializer: serializer
+ * @tag: record tag
+ * @count: count of items in @payload
+ * @payload: record payload after the count or NULL for an empty record
+ *
+ * INTERNAL - Write a record to the serializer iostream
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_binary_serialize_write_record(raptor_serializer* serializer,
+                                     unsigned char tag, size_t count,
+                                     raptor_binary_buffer* payload)
+{
+  unsigned char header[1 + 2 * RAPTOR_BINARY_VARINT_MAX_LEN];
+  unsigned char count_buf[RAPTOR_BINARY_VARINT_MAX_LEN];
+  size_t header_len = 1;
+  size_t count_len = 0;
+
+  header[0] = tag;
+  if(payload) {
+    count_len = raptor_binary_write_varint(count_buf, count);
+    header_len += raptor_binary_write_varint(header + 1,
+                                             count_len + payload->len);
+    memcpy(header + header_len, count_buf, count_len);
+    header_len += count_len;
+  } else
+    header[header_len++] = 0;
+
+  if(raptor_iostream_write_bytes(header, 1, header_len,
+                                 serializer->iostream) != (int)header_len)
+    return 1;
+
+  if(payload && payload->len &&
+     raptor_iostream_write_bytes(payload->data, 1, payload->len,
+                                 serializer->iostream) != (int)payload->len)
+    return 1;
+
+  return 0;
+}
+
+
+/*
+ * raptor_binary_serialize_write_pending:
+ * @serializer: serializer
+ *
+ * INTERNAL - Write the waiting TERMS and STATEMENTS records
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_binary_serialize_write_pending(raptor_serializer* serializer)
+{
+  raptor_binary_serializer_context* context;
+  int rc = 0;
+
+  context = (raptor_binary_serializer_context*)serializer->context;
+
+  if(context->terms_count)
+    rc = raptor_binary_serialize_write_record(serializer,
+                                              RAPTOR_BINARY_TERMS,
+                                              context->terms_count,
+                                              &context->terms);
+  if(!rc && context->statements_count)
+    rc = raptor_binary_serialize_write_record(serializer,
+                                              RAPTOR_BINARY_STATEMENTS,
+                                              context->statements_count,
+                                              &context->statements);
+
+  context->terms.len = 0;
+  context->terms_count = 0;
+  context->statements.len = 0;
+  context->statements_count = 0;
+
+  return rc;
+}
+
+
+/*
+ * raptor_binary_hash:
+ * @kind: term kind
+ * @string: term string
+ * @len: length of @string
+ * @language: language or NULL
+ * @language_len: length of @language
+ * @datatype: datatype term number or 0
+ *
+ * INTERNAL - Hash a term as for the ID set
+ */
+static unsigned int
+raptor_binary_hash(unsigned char kind,
+                   const unsigned char* string, size_t len,
+                   const unsigned char* language, size_t language_len,
+                   size_t datatype)
+{
+  unsigned int hash = 5381 + kind;
+
+  while(len--)
+    hash = ((hash << 5) + hash) + *string++; /* hash * 33 + c */
+  while(language_len--)
+    hash = ((hash << 5) + hash) + *language++;
+  hash += RAPTOR_GOOD_CAST(unsigned int, datatype);
+
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bU;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35U;
+  hash ^= hash >> 16;
+
+  return hash;
+}
+
+
+/*
+ * raptor_binary_serialize_grow:
+ * @context: serializer context
+ *
+ * INTERNAL - Double the size of the dictionary hash table
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_binary_serialize_grow(raptor_binary_serializer_context* context)
+{
+  size_t new_size = context->size << 1;
+  size_t mask = new_size - 1;
+  raptor_binary_entry* new_entries;
+  size_t i;
+
+  new_entries = RAPTOR_CALLOC(raptor_binary_entry*, new_size,
+                              sizeof(raptor_binary_entry));
+  if(!new_entries)
+    return 1;
+
+  for(i = 0; i < context->size; i++) {
+    raptor_binary_entry* entry = &context->entries[i];
+    size_t j;
+
+    if(!entry->kind)
+      continue;
+
+    for(j = entry->hash & mask; new_entries[j].kind; j = (j + 1) & mask)
+      ;
+    new_entries[j] = *entry;
+  }
+
+  RAPTOR_FREE(raptor_binary_entry*, context->entries);
+  context->entries = new_entries;
+  context->size = new_size;
+
+  return 0;
+}
+
+
+/*
+ * raptor_binary_serialize_copy:
+ * @context: serializer context
+ * @string: bytes
+ * @len: length of @string
+ *
+ * INTERNAL - Copy bytes into the serializer's arena
+ *
+ * Return value: pointer to copy or NULL on failure
+ */
+static unsigned char*
+raptor_binary_serialize_copy(raptor_binary_serializer_context* context,
+                             const unsigned char* string, size_t len)
+{
+  raptor_binary_arena_block* block = context->blocks;
+  unsigned char* copy;
+
+  if(!block || block->size - block->used < len) {
+    size_t size = RAPTOR_BINARY_ARENA_BLOCK_SIZE;
+
+    if(len > size)
+      size = len;
+
+    block = (raptor_binary_arena_block*)RAPTOR_MALLOC(void*,
+                                                      sizeof(*block) + size);
+    if(!block)
+      return NULL;
+
+    block->size = size;
+    block->used = 0;
+    block->next = context->blocks;
+    context->blocks = block;
+  }
+
+  copy = (unsigned char*)(block + 1) + block->used;
+  if(len)
+    memcpy(copy, string, len);
+  block->used += len;
+
+  return copy;
+}
+
+
+/*
+ * raptor_binary_serialize_term_id:
+ * @context: serializer context
+ * @kind: term kind
+ * @string: term string
+ * @len: length of @string
+ * @language: language or NULL
+ * @language_len: length of @language
+ * @datatype: datatype term number or 0
+ *
+ * INTERNAL - Get the number of a term, defining it if not yet seen
+ *
+ * New terms are added to the waiting TERMS record.
+ *
+ * Return value: term number or 0 on failure
+ */
+static size_t
+raptor_binary_serialize_term_id(raptor_binary_serializer_context* context,
+                                unsigned char kind,
+                                const unsigned char* string, size_t len,
+                                const unsigned char* language,
+                                size_t language_len,
+                                size_t datatype)
+{
+  unsigned int hash;
+  size_t mask;
+  size_t i;
+  raptor_binary_entry* entry;
+  unsigned char* copy;
+
+  hash = raptor_binary_hash(kind, string, len, language, language_len,
+                            datatype);
+  mask = context->size - 1;
+
+  for(i = hash & mask; context->entries[i].kind; i = (i + 1) & mask) {
+    entry = &context->entries[i];
+    if(entry->hash == hash && entry->kind == kind && entry->len == len &&
+       entry->language_len == language_len && entry->datatype == datatype &&
+       !memcmp(entry->string, string, len) &&
+       (!language_len || !memcmp(entry->language, language, language_len)))
+      return entry->id;
+  }
+
+  /* keep the table at most half full */
+  if((context->count + 1) * 2 > context->size) {
+    if(raptor_binary_serialize_grow(context))
+      return 0;
+    mask = context->size - 1;
+    for(i = hash & mask; context->entries[i].kind; i = (i + 1) & mask)
+      ;
+  }
+
+  copy = raptor_binary_serialize_copy(context, string, len);
+  if(!copy)
+    return 0;
+
+  if(raptor_binary_buffer_reserve(&context->terms,
+                                  1 + 3 * RAPTOR_BINARY_VARINT_MAX_LEN +
+                                  len + language_len))
+    return 0;
+
+  entry = &context->entries[i];
+  entry->string = copy;
+  entry->len = len;
+  entry->language = NULL;
+  entry->language_len = language_len;
+  if(language_len) {
+    entry->language = raptor_binary_serialize_copy(context, language,
+                                                   language_len);
+    if(!entry->language)
+      return 0;
+  }
+  entry->datatype = datatype;
+  entry->hash = hash;
+  entry->kind = kind;
+  entry->id = ++context->count;
+
+  context->terms.data[context->terms.len++] = kind;
+  raptor_binary_buffer_add_varint(&context->terms, len);
+  memcpy(context->terms.data + context->terms.len, string, len);
+  context->terms.len += len;
+  if(kind == RAPTOR_BINARY_LANG_LITERAL) {
+    raptor_binary_buffer_add_varint(&context->terms, language_len);
+    memcpy(context->terms.data + context->terms.len, language, language_len);
+    context->terms.len += language_len;
+  } else if(kind == RAPTOR_BINARY_TYPED_LITERAL)
+    raptor_binary_buffer_add_varint(&context->terms, datatype);
+  context->terms_count++;
+
+  return entry->id;
+}
+
+
+/*
+ * raptor_binary_serialize_term:
+ * @context: serializer context
+ * @term: term
+ *
+ * INTERNAL - Get the number of a #raptor_term, defining it if not yet seen
+ *
+ * Return value: term number or 0 on failure
+ */
+static size_t
+raptor_binary_serialize_term(raptor_binary_serializer_context* context,
+                             raptor_term* term)
+{
+  const unsigned char* string;
+  size_t len;
+
+  switch(term->type) {
+    case RAPTOR_TERM_TYPE_URI:
+      string = raptor_uri_as_counted_string(term->value.uri, &len);
+      return raptor_binary_serialize_term_id(context, RAPTOR_BINARY_URI,
+                                             string, len, NULL, 0, 0);
+
+    case RAPTOR_TERM_TYPE_BLANK:
+      return raptor_binary_serialize_term_id(context, RAPTOR_BINARY_BLANK,
+                                             term->value.blank.string,
+                                             term->value.blank.string_len,
+                                             NULL, 0, 0);
+
+    case RAPTOR_TERM_TYPE_LITERAL:
+      if(term->value.literal.datatype) {
+        size_t datatype;
+
+        string = raptor_uri_as_counted_string(term->value.literal.datatype,
+                                              &len);
+        datatype = raptor_binary_serialize_term_id(context, RAPTOR_BINARY_URI,
+                                                   string, len, NULL, 0, 0);
+        if(!datatype)
+          return 0;
+        return raptor_binary_serialize_term_id(context,
+                                               RAPTOR_BINARY_TYPED_LITERAL,
+                                               term->value.literal.string,
+                                               term->value.literal.string_len,
+                                               NULL, 0, datatype);
+      }
+
+      if(term->value.literal.language_len)
+        return raptor_binary_serialize_term_id(context,
+                                               RAPTOR_BINARY_LANG_LITERAL,
+                                               term->value.literal.string,
+                                               term->value.literal.string_len,
+                                               term->value.literal.language,
+                                               term->value.literal.language_len,
+                                               0);
+
+      return raptor_binary_serialize_term_id(context, RAPTOR_BINARY_LITERAL,
+                                             term->value.literal.string,
+                                             term->value.literal.string_len,
+                                             NULL, 0, 0);
+
+    case RAPTOR_TERM_TYPE_UNKNOWN:
+    default:
+      break;
+  }
+
+  return 0;
+}
+
+
+static int
+raptor_binary_serialize_start(raptor_serializer* serializer)
+{
+  raptor_binary_serializer_context* context;
+  unsigned char header[RAPTOR_BINARY_HEADER_LEN];
+
+  context = (raptor_binary_serializer_context*)serializer->context;
+
+  raptor_binary_serializer_reset_terms(context);
+  context->terms.len = 0;
+  context->terms_count = 0;
+  context->statements.len = 0;
+  context->statements_count = 0;
+
+  memcpy(header, RAPTOR_BINARY_MAGIC, RAPTOR_BINARY_MAGIC_LEN);
+  header[RAPTOR_BINARY_MAGIC_LEN] = RAPTOR_BINARY_VERSION;
+
+  if(raptor_iostream_write_bytes(header, 1, RAPTOR_BINARY_HEADER_LEN,
+                                 serializer->iostream) != RAPTOR_BINARY_HEADER_LEN)
+    return 1;
+
+  return 0;
+}
+
+
+static int
+raptor_binary_serialize_statement(raptor_serializer* serializer,
+                                  raptor_statement *statement)
+{
+  raptor_binary_serializer_context* context;
+  size_t subject, predicate, object;
+  size_t graph = 0;
+  unsigned int flags = 0;
+  unsigned char* flags_p;
+
+  context = (raptor_binary_serializer_context*)serializer->context;
+
+  /* A statement defines at most 5 terms: the datatype is the extra one */
+  if(context->count + 5 > context->max_terms) {
+    if(raptor_binary_serialize_write_pending(serializer) ||
+       raptor_binary_serialize_write_record(serializer, RAPTOR_BINARY_RESET,
+                                            0, NULL))
+      return 1;
+    raptor_binary_serializer_reset_terms(context);
+  }
+
+  subject = raptor_binary_serialize_term(context, statement->subject);
+  predicate = raptor_binary_serialize_term(context, statement->predicate);
+  object = raptor_binary_serialize_term(context, statement->object);
+  if(statement->graph)
+    graph = raptor_binary_serialize_term(context, statement->graph);
+  if(!subject || !predicate || !object || (statement->graph && !graph))
+    goto failed;
+
+  if(raptor_binary_buffer_reserve(&context->statements,
+                                  1 + 4 * RAPTOR_BINARY_VARINT_MAX_LEN))
+    goto failed;
+
+  flags_p = context->statements.data + context->statements.len++;
+
+  if(subject == context->last_subject)
+    flags |= RAPTOR_BINARY_SAME_SUBJECT;
+  else
+    raptor_binary_buffer_add_varint(&context->statements, subject);
+
+  if(predicate == context->last_predicate)
+    flags |= RAPTOR_BINARY_SAME_PREDICATE;
+  else
+    raptor_binary_buffer_add_varint(&context->statements, predicate);
+
+  raptor_binary_buffer_add_varint(&context->statements, object);
+
+  if(graph == context->last_graph)
+    flags |= RAPTOR_BINARY_SAME_GRAPH;
+  else if(graph) {
+    flags |= RAPTOR_BINARY_HAS_GRAPH;
+    raptor_binary_buffer_add_varint(&context->statements, graph);
+  }
+
+  *flags_p = RAPTOR_GOOD_CAST(unsigned char, flags);
+
+  context->last_subject = subject;
+  context->last_predicate = predicate;
+  context->last_graph = graph;
+
+  if(++context->statements_count == RAPTOR_BINARY_BLOCK_STATEMENTS)
+    return raptor_binary_serialize_write_pending(serializer);
+
+  return 0;
+
+  failed:
+  raptor_log_error_formatted(serializer->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                             "Cannot write binary RDF statement");
+  return 1;
+}
+
+
+static int
+raptor_binary_serialize_flush(raptor_serializer* serializer)
+{
+  return raptor_binary_serialize_write_pending(serializer);
+}
+
+
+static int
+raptor_binary_serialize_end(raptor_serializer* serializer)
+{
+  if(raptor_binary_serialize_write_pending(serializer))
+    return 1;
+
+  return raptor_binary_serialize_write_record(serializer, RAPTOR_BINARY_END,
+                                              0, NULL);
+}
+
+
+/*
+ * raptor_binary_serializer_set_max_terms:
+ * @serializer: binary serializer
+ * @max_terms: most terms to hold before resetting the dictionary
+ *
+ * INTERNAL - Bound the dictionary that a reader of the stream keeps
+ *
+ * A smaller dictionary makes a longer stream since terms are defined
+ * again after each reset.  Should be called before the first statement
+ * is serialized.
+ */
+void
+raptor_binary_serializer_set_max_terms(raptor_serializer* serializer,
+                                       size_t max_terms)
+{
+  raptor_binary_serializer_context* context;
+
+  context = (raptor_binary_serializer_context*)serializer->context;
+
+  /* a statement may need up to 5 new terms */
+  if(max_terms < 5)
+    max_terms = 5;
+  context->max_terms = max_terms;
+}
+
+
+static void
+raptor_binary_serialize_finish_factory(raptor_serializer_factory* factory)
+{
+
+}
+
+
+static const char* const binary_serializer_names[2] = { "binary", NULL};
+
+static const char* const binary_serializer_uri_strings[2] = {
+  "http://librdf.org/raptor/binary",
+  NULL
+};
+
+#define BINARY_SERIALIZER_TYPES_COUNT 1
+static const raptor_type_q binary_serializer_types[BINARY_SERIALIZER_TYPES_COUNT + 1] = {
+  { "application/x-raptor-binary", 27, 10},
+  { NULL, 0, 0}
+};
+
+static int
+raptor_binary_serializer_register_factory(raptor_serializer_factory *factory)
+{
+  factory->desc.names = binary_serializer_names;
+  factory->desc.mime_types = binary_serializer_types;
+
+  factory->desc.label = "Raptor Binary RDF";
+  factory->desc.uri_strings = binary_serializer_uri_strings;
+
+  factory->context_length     = sizeof(raptor_binary_serializer_context);
+
+  factory->init                = raptor_binary_serialize_init;
+  factory->terminate           = raptor_binary_serialize_terminate;
+  factory->declare_namespace   = raptor_binary_serialize_declare_namespace;
+  factory->serialize_start     = raptor_binary_serialize_start;
+  factory->serialize_statement = raptor_binary_serialize_statement;
+  factory->serialize_end       = raptor_binary_serialize_end;
+  factory->finish_factory      = raptor_binary_serialize_finish_factory;
+  factory->serialize_flush     = raptor_binary_serialize_flush;
+
+  return 0;
+}
+
+
+int
+raptor_init_serializer_binary(raptor_world* world)
+{
+  return !raptor_serializer_register_factory(world,
+                                             &raptor_binary_serializer_register_factory);
+}
+
+#endif
+
+/* end not STANDALONE */
+#endif
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+static const char *program;
+
+static const char* const test_nquads =
+  "<http://example.org/s> <http://example.org/p> <http://example.org/o> .\n"
+  "<http://example.org/s> <http://example.org/p> \"plain\" .\n"
+  "<http://example.org/s> <http://example.org/q> \"\" .\n"
+  "<http://example.org/s> <http://example.org/q> \"line\\nbreak \\\"quoted\\\" caf\\u00E9\" .\n"
+  "_:b1 <http://example.org/p> \"chat\"@fr <http://example.org/g> .\n"
+  "_:b1 <http://example.org/p> \"chat\"@en-GB <http://example.org/g> .\n"
+  "_:b1 <http://example.org/p> \"10\"^^<http://www.w3.org/2001/XMLSchema#integer> <http://example.org/g> .\n"
+  "_:b2 <http://example.org/p> _:b1 _:g .\n"
+  "<http://example.org/s> <http://example.org/p> <http://example.org/o> _:g .\n"
+  "<http://example.org/s> <http://example.org/p> \"10\"^^<http://www.w3.org/2001/XMLSchema#integer> .\n";
+
+
+static void
+test_statement_handler(void *user_data, raptor_statement *statement)
+{
+  raptor_serializer* serializer = (raptor_serializer*)user_data;
+
+  raptor_serializer_serialize_statement(serializer, statement);
+}
+
+
+static void
+test_ignore_log(void *user_data, raptor_log_message *message)
+{
+  int* errors = (int*)user_data;
+
+  if(message->level >= RAPTOR_LOG_LEVEL_ERROR)
+    (*errors)++;
+}
+
+
+/*
+ * Parse @data in @syntax_name with chunks of @chunk_size bytes (or
+ * from @filename if not NULL) and serialize the statements to a
+ * string with @serializer_name.  Returns NULL on parse failure.
+ */
+static unsigned char*
+test_convert(raptor_world* world,
+             const char* syntax_name, const char* serializer_name,
+             const unsigned char* data, size_t data_len, size_t chunk_size,
+             const char* filename, size_t* len_p)
+{
+  raptor_parser* parser;
+  raptor_serializer* serializer;
+  raptor_uri* base_uri;
+  void* string = NULL;
+  size_t offset;
+  int rc = 0;
+
+  base_uri = raptor_new_uri(world, (const unsigned char*)"http://example.org/");
+  parser = raptor_new_parser(world, syntax_name);
+  serializer = raptor_new_serializer(world, serializer_name);
+  if(!base_uri || !parser || !serializer) {
+    fprintf(stderr, "%s: Failed to create %s parser or %s serializer\n",
+            program, syntax_name, serializer_name);
+    exit(1);
+  }
+
+  raptor_serializer_start_to_string(serializer, base_uri, &string, len_p);
+  raptor_parser_set_statement_handler(parser, serializer,
+                                      test_statement_handler);
+
+  if(filename) {
+    unsigned char* uri_string;
+    raptor_uri* uri;
+
+    uri_string = raptor_uri_filename_to_uri_string(filename);
+    uri = raptor_new_uri(world, uri_string);
+    raptor_free_memory(uri_string);
+    rc = raptor_parser_parse_file(parser, uri, NULL);
+    raptor_free_uri(uri);
+  } else {
+    rc = raptor_parser_parse_start(parser, base_uri);
+    for(offset = 0; !rc && offset < data_len; offset += chunk_size) {
+      size_t len = data_len - offset;
+
+      if(len > chunk_size)
+        len = chunk_size;
+      rc = raptor_parser_parse_chunk(parser, data + offset, len, 0);
+    }
+    if(!rc)
+      rc = raptor_parser_parse_chunk(parser, NULL, 0, 1);
+  }
+
+  raptor_serializer_serialize_end(serializer);
+  raptor_free_serializer(serializer);
+  raptor_free_parser(parser);
+  raptor_free_uri(base_uri);
+
+  if(rc) {
+    raptor_free_memory(string);
+    return NULL;
+  }
+
+  return (unsigned char*)string;
+}
+
+
+static int
+test_expect(const char* label, const unsigned char* got, size_t got_len,
+            const unsigned char* expected, size_t expected_len)
+{
+  if(!got) {
+    fprintf(stderr, "%s: %s: parsing failed\n", program, label);
+    return 1;
+  }
+
+  if(got_len != expected_len || memcmp(got, expected, expected_len)) {
+    fprintf(stderr, "%s: %s: got\n%s\nexpected\n%s\n", program, label,
+            (const char*)got, (const char*)expected);
+    return 1;
+  }
+
+  return 0;
+}
+
+
+static int
+test_write_file(const char* filename, const unsigned char* data, size_t len)
+{
+  FILE* fh = fopen(filename, "wb");
+
+  if(!fh) {
+    fprintf(stderr, "%s: Failed to write '%s'\n", program, filename);
+    return 1;
+  }
+  fwrite(data, 1, len, fh);
+  fclose(fh);
+  return 0;
+}
+
+
+/*
+ * Parse hand built binary content that is expected to fail or give
+ * @expected N-Quads
+ */
+static int
+test_records(raptor_world* world, const char* label,
+             const unsigned char* data, size_t data_len,
+             const char* expected)
+{
+  unsigned char* nquads;
+  size_t nquads_len = 0;
+  int errors = 0;
+  int failures = 0;
+
+  raptor_world_set_log_handler(world, &errors, test_ignore_log);
+  nquads = test_convert(world, "binary", "nquads", data, data_len, 3,
+                        NULL, &nquads_len);
+  raptor_world_set_log_handler(world, NULL, NULL);
+
+  if(expected) {
+    failures += test_expect(label, nquads, nquads_len,
+                            (const unsigned char*)expected, strlen(expected));
+  } else if(nquads || !errors) {
+    fprintf(stderr, "%s: %s: bad content was not reported\n", program,
+            label);
+    failures++;
+  }
+
+  if(nquads)
+    raptor_free_memory(nquads);
+
+  return failures;
+}
+
+
+#define HEADER RAPTOR_BINARY_MAGIC "\001"
+
+/* terms <a> <b> then statement <a> <b> <a> */
+#define TERMS_A_B "T\007\002\001\001a\001\001b"
+#define STATEMENT_A_B_A "S\005\001\000\001\002\001"
+#define A_B_A "<a> <b> <a> .\n"
+
+#define RECORDS_CASE(label, data, expected) \
+  { label, data, sizeof(data) - 1, expected }
+
+static const struct {
+  const char* label;
+  const char* data;
+  size_t len;
+  const char* expected;
+} test_record_cases[] = {
+  RECORDS_CASE("two streams",
+               HEADER TERMS_A_B STATEMENT_A_B_A "E\000"
+               HEADER TERMS_A_B STATEMENT_A_B_A "E\000",
+               A_B_A A_B_A),
+  RECORDS_CASE("reset",
+               HEADER TERMS_A_B "R\000" TERMS_A_B STATEMENT_A_B_A "E\000",
+               A_B_A),
+  RECORDS_CASE("empty", "", ""),
+  RECORDS_CASE("not binary", A_B_A, NULL),
+  RECORDS_CASE("bad version", RAPTOR_BINARY_MAGIC "\002E\000", NULL),
+  RECORDS_CASE("no end", HEADER TERMS_A_B STATEMENT_A_B_A, NULL),
+  RECORDS_CASE("truncated record",
+               HEADER TERMS_A_B "S\005\001\000\001", NULL),
+  RECORDS_CASE("unknown term",
+               HEADER TERMS_A_B "S\005\001\000\001\002\003" "E\000", NULL),
+  RECORDS_CASE("reset forgets terms",
+               HEADER TERMS_A_B "R\000" STATEMENT_A_B_A "E\000", NULL),
+  RECORDS_CASE("literal subject",
+               HEADER "T\004\001\003\001a" STATEMENT_A_B_A "E\000", NULL),
+  { NULL, NULL, 0, NULL }
+};
+
+
+int
+main(int argc, char *argv[])
+{
+  raptor_world *world;
+  const unsigned char* nquads_data = (const unsigned char*)test_nquads;
+  size_t nquads_data_len = strlen(test_nquads);
+  unsigned char* expected;
+  size_t expected_len = 0;
+  unsigned char* binary;
+  size_t binary_len = 0;
+  unsigned char* nquads;
+  size_t nquads_len = 0;
+  static const size_t chunk_sizes[4] = { 1, 7, 64, 65536 };
+  const char* filename = "raptor_binary_test.rbin";
+  int i;
+  int failures = 0;
+
+  program = raptor_basename(argv[0]);
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  /* N-Quads -> N-Quads gives the canonical form to compare against */
+  expected = test_convert(world, "nquads", "nquads",
+                          nquads_data, nquads_data_len, 65536, NULL,
+                          &expected_len);
+  binary = test_convert(world, "nquads", "binary",
+                        nquads_data, nquads_data_len, 65536, NULL,
+                        &binary_len);
+  if(!expected || !binary) {
+    fprintf(stderr, "%s: Failed to parse the test N-Quads\n", program);
+    exit(1);
+  }
+
+  if(binary_len < RAPTOR_BINARY_HEADER_LEN ||
+     memcmp(binary, RAPTOR_BINARY_MAGIC, RAPTOR_BINARY_MAGIC_LEN)) {
+    fprintf(stderr, "%s: Binary output has no header\n", program);
+    failures++;
+  }
+
+  /* N-Quads -> binary -> N-Quads, in chunks straddling records */
+  for(i = 0; i < 4; i++) {
+    nquads = test_convert(world, "binary", "nquads", binary, binary_len,
+                          chunk_sizes[i], NULL, &nquads_len);
+    failures += test_expect("round trip", nquads, nquads_len,
+                            expected, expected_len);
+    if(nquads)
+      raptor_free_memory(nquads);
+  }
+
+  /* from a file, which is mapped rather than read when possible */
+  if(!test_write_file(filename, binary, binary_len)) {
+    nquads = test_convert(world, "binary", "nquads", NULL, 0, 0, filename,
+                          &nquads_len);
+    failures += test_expect("file round trip", nquads, nquads_len,
+                            expected, expected_len);
+    if(nquads)
+      raptor_free_memory(nquads);
+
+    /* a truncated file must fail */
+    if(!test_write_file(filename, binary, binary_len - 1)) {
+      int errors = 0;
+
+      raptor_world_set_log_handler(world, &errors, test_ignore_log);
+      nquads = test_convert(world, "binary", "nquads", NULL, 0, 0, filename,
+                            &nquads_len);
+      raptor_world_set_log_handler(world, NULL, NULL);
+      if(nquads || !errors) {
+        fprintf(stderr, "%s: truncated file was not reported\n", program);
+        failures++;
+      }
+      if(nquads)
+        raptor_free_memory(nquads);
+    }
+    remove(filename);
+  } else
+    failures++;
+
+  for(i = 0; test_record_cases[i].label; i++)
+    failures += test_records(world, test_record_cases[i].label,
+                             (const unsigned char*)test_record_cases[i].data,
+                             test_record_cases[i].len,
+                             test_record_cases[i].expected);
+
+  raptor_free_memory(binary);
+  raptor_free_memory(expected);
+  raptor_free_world(world);
+
+  return failures;
+}
+
+#endif
@@ -0,0 +1,1842 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_bptree.c - B+ Tree ordered set with pooled wide nodes
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ * This is a drop-in alternative to raptor_avltree with the same
+ * method set (add, search, remove, delete, trim, visit, range
+ * iterators).  Items live in wide leaf nodes linked in order so
+ * in-order walks are sequential scans and a search needs only
+ * O(log32 n) node visits.  Nodes are carved out of chunks owned by
+ * the tree and recycled through a free list, so adding an item does
+ * not need a malloc per item.
+ *
+ * Branch separator keys are always the smallest item of the subtree
+ * to their right and point at items stored in the leaves; they are
+ * updated whenever that item is removed, so a separator never points
+ * at an item that has been handed back to the caller.
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+#ifndef STANDALONE
+
+#define RAPTOR_BPTREE_ENOMEM -1
+#define RAPTOR_BPTREE_EXISTS 1
+
+/* maximum number of items in a leaf or separators in a branch */
+#define RAPTOR_BPTREE_MAX_ITEMS 32
+/* minimum number of items in a non-root node */
+#define RAPTOR_BPTREE_MIN_ITEMS (RAPTOR_BPTREE_MAX_ITEMS / 2)
+/* number of nodes allocated at once by a node pool */
+#define RAPTOR_BPTREE_POOL_CHUNK_NODES 64
+
+
+typedef struct raptor_bptree_node_s raptor_bptree_node;
+typedef struct raptor_bptree_leaf_s raptor_bptree_leaf;
+typedef struct raptor_bptree_branch_s raptor_bptree_branch;
+
+/* Header and items shared by leaf and branch nodes */
+struct raptor_bptree_node_s {
+  /* number of items (leaf) or separator keys (branch) */
+  unsigned short count;
+
+  /* non-0 if this is a leaf */
+  unsigned short is_leaf;
+
+  /* leaf: the data items in order
+   * branch: items[i] is the smallest item in subtree children[i+1]
+   */
+  void* items[RAPTOR_BPTREE_MAX_ITEMS];
+};
+
+struct raptor_bptree_leaf_s {
+  raptor_bptree_node node;
+
+  /* in-order neighbour leaves */
+  raptor_bptree_leaf* prev;
+  raptor_bptree_leaf* next;
+};
+
+struct raptor_bptree_branch_s {
+  raptor_bptree_node node;
+
+  /* node.count + 1 children */
+  raptor_bptree_node* children[RAPTOR_BPTREE_MAX_ITEMS + 1];
+};
+
+
+/* Chunk of nodes in a pool */
+typedef struct raptor_bptree_chunk_s {
+  struct raptor_bptree_chunk_s* next;
+} raptor_bptree_chunk;
+
+/* Fixed size node allocator */
+typedef struct {
+  /* size of one node (bytes) */
+  size_t node_size;
+
+  /* chunks allocated so far, most recent first */
+  raptor_bptree_chunk* chunks;
+
+  /* unused area at the end of the most recent chunk */
+  char* chunk_next;
+  char* chunk_end;
+
+  /* freed nodes; the first word of each is the next pointer */
+  void* free_list;
+  unsigned int free_count;
+} raptor_bptree_pool;
+
+
+/* B+ Tree */
+struct raptor_bptree_s {
+  /* root node of tree or NULL if empty */
+  raptor_bptree_node* root;
+
+  /* number of levels; leaves are at depth height - 1 */
+  int height;
+
+  /* leftmost and rightmost leaves */
+  raptor_bptree_leaf* first;
+  raptor_bptree_leaf* last;
+
+  /* item comparison function */
+  raptor_data_compare_handler compare_handler;
+
+  /* item deletion function (optional) */
+  raptor_data_free_handler free_handler;
+
+  /* item print function (optional) */
+  raptor_data_print_handler print_handler;
+
+  /* tree bitflags - bitmask of #raptor_bptree_bitflags flags */
+  unsigned int flags;
+
+  /* number of items in tree */
+  unsigned int size;
+
+  raptor_bptree_pool leaf_pool;
+  raptor_bptree_pool branch_pool;
+};
+
+
+/* B+ Tree iterator */
+struct raptor_bptree_iterator_s {
+  raptor_bptree* tree;
+
+  /* current position */
+  raptor_bptree_leaf* leaf;
+  int index;
+
+  void* range;
+  raptor_data_free_handler range_free_handler;
+
+  int direction;
+
+  int is_finished;
+};
+
+
+#ifndef TRUE
+#define	TRUE		1
+#define	FALSE		0
+#endif
+
+
+static void
+raptor_bptree_pool_init(raptor_bptree_pool* pool, size_t node_size)
+{
+  memset(pool, 0, sizeof(*pool));
+  /* keep nodes pointer aligned */
+  pool->node_size = (node_size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+}
+
+
+static void
+raptor_bptree_pool_finish(raptor_bptree_pool* pool)
+{
+  raptor_bptree_chunk* chunk;
+  raptor_bptree_chunk* next;
+
+  for(chunk = pool->chunks; chunk; chunk = next) {
+    next = chunk->next;
+    RAPTOR_FREE(raptor_bptree_chunk, chunk);
+  }
+
+  pool->chunks = NULL;
+  pool->chunk_next = pool->chunk_end = NULL;
+  pool->free_list = NULL;
+  pool->free_count = 0;
+}
+
+
+static void
+raptor_bptree_pool_free(raptor_bptree_pool* pool, void* node)
+{
+  *(void**)node = pool->free_list;
+  pool->free_list = node;
+  pool->free_count++;
+}
+
+
+/*
+ * raptor_bptree_pool_reserve:
+ *
+ * Make sure the next @count allocations from @pool cannot fail.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_bptree_pool_reserve(raptor_bptree_pool* pool, unsigned int count)
+{
+  raptor_bptree_chunk* chunk;
+  size_t header_size = pool->node_size;
+
+  if(pool->free_count +
+     (unsigned int)((pool->chunk_end - pool->chunk_next) / pool->node_size)
+     >= count)
+    return 0;
+
+  /* first node slot holds the chunk header, keeping nodes aligned */
+  chunk = RAPTOR_MALLOC(raptor_bptree_chunk*,
+                        header_size +
+                        pool->node_size * RAPTOR_BPTREE_POOL_CHUNK_NODES);
+  if(!chunk)
+    return 1;
+
+  /* keep any tail of the previous chunk */
+  while(pool->chunk_next != pool->chunk_end) {
+    raptor_bptree_pool_free(pool, pool->chunk_next);
+    pool->chunk_next += pool->node_size;
+  }
+
+  chunk->next = pool->chunks;
+  pool->chunks = chunk;
+  pool->chunk_next = (char*)chunk + header_size;
+  pool->chunk_end = pool->chunk_next +
+                    pool->node_size * RAPTOR_BPTREE_POOL_CHUNK_NODES;
+
+  return 0;
+}
+
+
+/* Allocate a node from space already reserved */
+static void*
+raptor_bptree_pool_alloc(raptor_bptree_pool* pool)
+{
+  void* node;
+
+  if(pool->free_list) {
+    node = pool->free_list;
+    pool->free_list = *(void**)node;
+    pool->free_count--;
+    return node;
+  }
+
+  node = pool->chunk_next;
+  pool->chunk_next += pool->node_size;
+
+  return node;
+}
+
+
+static raptor_bptree_leaf*
+raptor_bptree_new_leaf(raptor_bptree* tree)
+{
+  raptor_bptree_leaf* leaf;
+
+  leaf = (raptor_bptree_leaf*)raptor_bptree_pool_alloc(&tree->leaf_pool);
+
+  leaf->node.count = 0;
+  leaf->node.is_leaf = 1;
+  leaf->prev = NULL;
+  leaf->next = NULL;
+
+  return leaf;
+}
+
+
+static raptor_bptree_branch*
+raptor_bptree_new_branch(raptor_bptree* tree)
+{
+  raptor_bptree_branch* branch;
+
+  branch = (raptor_bptree_branch*)raptor_bptree_pool_alloc(&tree->branch_pool);
+
+  branch->node.count = 0;
+  branch->node.is_leaf = 0;
+
+  return branch;
+}
+
+
+static void
+raptor_bptree_free_node(raptor_bptree* tree, raptor_bptree_node* node)
+{
+  if(node->is_leaf)
+    raptor_bptree_pool_free(&tree->leaf_pool, node);
+  else
+    raptor_bptree_pool_free(&tree->branch_pool, node);
+}
+
+
+/**
+ * raptor_new_bptree:
+ * @compare_handler: item comparison handler for ordering
+ * @free_handler: item free handler (or NULL)
+ * @flags: B+ Tree flags - bitmask of #raptor_bptree_bitflags flags.
+ *
+ * INTERNAL - B+ Tree Constructor
+ *
+ * Return value: new B+ Tree or NULL on failure
+ */
+raptor_bptree*
+raptor_new_bptree(raptor_data_compare_handler compare_handler,
+                  raptor_data_free_handler free_handler,
+                  unsigned int flags)
+{
+  raptor_bptree* tree;
+
+  tree = RAPTOR_CALLOC(raptor_bptree*, 1, sizeof(*tree));
+  if(!tree)
+    return NULL;
+
+  tree->compare_handler = compare_handler;
+  tree->free_handler = free_handler;
+  tree->flags = flags;
+
+  raptor_bptree_pool_init(&tree->leaf_pool, sizeof(raptor_bptree_leaf));
+  raptor_bptree_pool_init(&tree->branch_pool, sizeof(raptor_bptree_branch));
+
+  return tree;
+}
+
+
+/**
+ * raptor_bptree_trim:
+ * @tree: B+ Tree object
+ *
+ * INTERNAL - Delete all items from a B+ Tree but keep the shell.
+ */
+void
+raptor_bptree_trim(raptor_bptree* tree)
+{
+  if(!tree)
+    return;
+
+  if(tree->free_handler) {
+    raptor_bptree_leaf* leaf;
+
+    for(leaf = tree->first; leaf; leaf = leaf->next) {
+      int i;
+      for(i = 0; i < leaf->node.count; i++)
+        tree->free_handler(leaf->node.items[i]);
+    }
+  }
+
+  /* every node is owned by one of the pools */
+  raptor_bptree_pool_finish(&tree->leaf_pool);
+  raptor_bptree_pool_finish(&tree->branch_pool);
+
+  tree->root = NULL;
+  tree->height = 0;
+  tree->first = tree->last = NULL;
+  tree->size = 0;
+}
+
+
+/**
+ * raptor_free_bptree:
+ * @tree: B+ Tree object
+ *
+ * INTERNAL - B+ Tree destructor
+ */
+void
+raptor_free_bptree(raptor_bptree* tree)
+{
+  if(!tree)
+    return;
+
+  raptor_bptree_trim(tree);
+
+  RAPTOR_FREE(raptor_bptree, tree);
+}
+
+
+/*
+ * raptor_bptree_branch_child_index:
+ *
+ * Find the child of @branch that may contain @p_data: the number of
+ * separators less than or equal to it.
+ */
+static int
+raptor_bptree_branch_child_index(raptor_bptree* tree,
+                                 raptor_bptree_node* branch,
+                                 const void* p_data)
+{
+  int lo = 0;
+  int hi = branch->count;
+
+  while(lo < hi) {
+    int mid = (lo + hi) >> 1;
+    if(tree->compare_handler(p_data, branch->items[mid]) < 0)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+
+  return lo;
+}
+
+
+/*
+ * raptor_bptree_leaf_index:
+ *
+ * Find the position of the first item in @leaf not less than
+ * @p_data; *@found_p is set if that item compares equal.
+ */
+static int
+raptor_bptree_leaf_index(raptor_bptree* tree, raptor_bptree_node* leaf,
+                         const void* p_data, int* found_p)
+{
+  int lo = 0;
+  int hi = leaf->count;
+
+  *found_p = 0;
+  while(lo < hi) {
+    int mid = (lo + hi) >> 1;
+    int cmp = tree->compare_handler(p_data, leaf->items[mid]);
+    if(cmp > 0)
+      lo = mid + 1;
+    else {
+      if(!cmp) {
+        *found_p = 1;
+        return mid;
+      }
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+
+/**
+ * raptor_bptree_search:
+ * @tree: B+ Tree object
+ * @p_data: pointer to data item
+ *
+ * INTERNAL - Find an item in a B+ Tree
+ *
+ * Return value: shared pointer to item (still owned by B+ Tree) or NULL on failure or if not found
+ */
+void*
+raptor_bptree_search(raptor_bptree* tree, const void* p_data)
+{
+  raptor_bptree_node* node = tree->root;
+  int found;
+  int i;
+
+  if(!node)
+    return NULL;
+
+  while(!node->is_leaf) {
+    i = raptor_bptree_branch_child_index(tree, node, p_data);
+    node = ((raptor_bptree_branch*)node)->children[i];
+  }
+
+  i = raptor_bptree_leaf_index(tree, node, p_data, &found);
+
+  return found ? node->items[i] : NULL;
+}
+
+
+/* Result of inserting into a subtree */
+typedef struct {
+  /* new right sibling if the subtree root was split, and its smallest item */
+  raptor_bptree_node* split_node;
+  void* split_item;
+
+  /* new smallest item of the subtree if it changed, else NULL */
+  void* new_min;
+
+  /* item replaced by a duplicate (to be freed by the caller) */
+  void* replaced;
+} raptor_bptree_insert_result;
+
+
+static int
+raptor_bptree_leaf_insert(raptor_bptree* tree, raptor_bptree_leaf* leaf,
+                          void* p_data, raptor_bptree_insert_result* result)
+{
+  raptor_bptree_node* node = &leaf->node;
+  raptor_bptree_node* target;
+  raptor_bptree_leaf* right;
+  int found;
+  int pos;
+
+  pos = raptor_bptree_leaf_index(tree, node, p_data, &found);
+  if(found) {
+    if(tree->flags & RAPTOR_BPTREE_FLAG_REPLACE_DUPLICATES) {
+      /* replace item with equivalent key */
+      result->replaced = node->items[pos];
+      node->items[pos] = p_data;
+      if(!pos)
+        result->new_min = p_data;
+      return 0;
+    }
+
+    /* ignore item with equivalent key */
+    if(tree->free_handler)
+      tree->free_handler(p_data);
+    return RAPTOR_BPTREE_EXISTS;
+  }
+
+  target = node;
+  if(node->count == RAPTOR_BPTREE_MAX_ITEMS) {
+    /* split: move upper half into a new right sibling */
+    right = raptor_bptree_new_leaf(tree);
+
+    right->node.count = RAPTOR_BPTREE_MAX_ITEMS - RAPTOR_BPTREE_MIN_ITEMS;
+    memcpy(right->node.items, &node->items[RAPTOR_BPTREE_MIN_ITEMS],
+           right->node.count * sizeof(void*));
+    node->count = RAPTOR_BPTREE_MIN_ITEMS;
+
+    right->prev = leaf;
+    right->next = leaf->next;
+    if(leaf->next)
+      leaf->next->prev = right;
+    else
+      tree->last = right;
+    leaf->next = right;
+
+    if(pos > RAPTOR_BPTREE_MIN_ITEMS) {
+      target = &right->node;
+      pos -= RAPTOR_BPTREE_MIN_ITEMS;
+    }
+
+    result->split_node = &right->node;
+  }
+
+  memmove(&target->items[pos + 1], &target->items[pos],
+          (target->count - pos) * sizeof(void*));
+  target->items[pos] = p_data;
+  target->count++;
+  tree->size++;
+
+  if(result->split_node)
+    result->split_item = result->split_node->items[0];
+
+  if(target == node && !pos)
+    result->new_min = p_data;
+
+  return 0;
+}
+
+
+static int
+raptor_bptree_insert_internal(raptor_bptree* tree, raptor_bptree_node* node,
+                              void* p_data,
+                              raptor_bptree_insert_result* result)
+{
+  raptor_bptree_branch* branch = (raptor_bptree_branch*)node;
+  raptor_bptree_insert_result child_result;
+  raptor_bptree_branch* right;
+  void* items[RAPTOR_BPTREE_MAX_ITEMS + 1];
+  raptor_bptree_node* children[RAPTOR_BPTREE_MAX_ITEMS + 2];
+  int total;
+  int i;
+  int rc;
+
+  if(node->is_leaf)
+    return raptor_bptree_leaf_insert(tree, (raptor_bptree_leaf*)node, p_data,
+                                     result);
+
+  i = raptor_bptree_branch_child_index(tree, node, p_data);
+
+  memset(&child_result, 0, sizeof(child_result));
+  rc = raptor_bptree_insert_internal(tree, branch->children[i], p_data,
+                                     &child_result);
+  result->replaced = child_result.replaced;
+  if(rc)
+    return rc;
+
+  if(child_result.new_min) {
+    if(i)
+      node->items[i - 1] = child_result.new_min;
+    else
+      result->new_min = child_result.new_min;
+  }
+
+  if(!child_result.split_node)
+    return 0;
+
+  if(node->count < RAPTOR_BPTREE_MAX_ITEMS) {
+    memmove(&node->items[i + 1], &node->items[i],
+            (node->count - i) * sizeof(void*));
+    memmove(&branch->children[i + 2], &branch->children[i + 1],
+            (node->count - i) * sizeof(raptor_bptree_node*));
+    node->items[i] = child_result.split_item;
+    branch->children[i + 1] = child_result.split_node;
+    node->count++;
+    return 0;
+  }
+
+  /* full branch: split around the middle separator which moves up */
+  right = raptor_bptree_new_branch(tree);
+
+  total = node->count;
+  memcpy(items, node->items, i * sizeof(void*));
+  items[i] = child_result.split_item;
+  memcpy(&items[i + 1], &node->items[i], (total - i) * sizeof(void*));
+  memcpy(children, branch->children, (i + 1) * sizeof(raptor_bptree_node*));
+  children[i + 1] = child_result.split_node;
+  memcpy(&children[i + 2], &branch->children[i + 1],
+         (total - i) * sizeof(raptor_bptree_node*));
+  total++;
+
+  node->count = RAPTOR_BPTREE_MIN_ITEMS;
+  memcpy(node->items, items, RAPTOR_BPTREE_MIN_ITEMS * sizeof(void*));
+  memcpy(branch->children, children,
+         (RAPTOR_BPTREE_MIN_ITEMS + 1) * sizeof(raptor_bptree_node*));
+
+  right->node.count = total - RAPTOR_BPTREE_MIN_ITEMS - 1;
+  memcpy(right->node.items, &items[RAPTOR_BPTREE_MIN_ITEMS + 1],
+         right->node.count * sizeof(void*));
+  memcpy(right->children, &children[RAPTOR_BPTREE_MIN_ITEMS + 1],
+         (right->node.count + 1) * sizeof(raptor_bptree_node*));
+
+  result->split_node = &right->node;
+  result->split_item = items[RAPTOR_BPTREE_MIN_ITEMS];
+
+  return 0;
+}
+
+
+/**
+ * raptor_bptree_add:
+ * @tree: B+ Tree object
+ * @p_data: pointer to data item
+ *
+ * INTERNAL - add an item to a B+ Tree
+ *
+ * The item added becomes owned by the B+ Tree, and will be freed by
+ * the free_handler argument given to raptor_new_bptree().
+ *
+ * Return value: 0 on success, >0 if equivalent item exists (and the old element remains in the tree), <0 on failure
+ */
+int
+raptor_bptree_add(raptor_bptree* tree, void* p_data)
+{
+  raptor_bptree_insert_result result;
+  int rc;
+
+  /* worst case is a leaf split plus a split at every branch level
+   * and a new root, so reserve that before changing anything
+   */
+  if(raptor_bptree_pool_reserve(&tree->leaf_pool, 1) ||
+     raptor_bptree_pool_reserve(&tree->branch_pool,
+                                (unsigned int)tree->height + 1)) {
+    if(tree->free_handler)
+      tree->free_handler(p_data);
+    return RAPTOR_BPTREE_ENOMEM;
+  }
+
+  if(!tree->root) {
+    raptor_bptree_leaf* leaf = raptor_bptree_new_leaf(tree);
+    tree->root = &leaf->node;
+    tree->height = 1;
+    tree->first = tree->last = leaf;
+  }
+
+  memset(&result, 0, sizeof(result));
+  rc = raptor_bptree_insert_internal(tree, tree->root, p_data, &result);
+
+  if(result.replaced && tree->free_handler)
+    tree->free_handler(result.replaced);
+
+  if(rc)
+    return rc;
+
+  if(result.split_node) {
+    raptor_bptree_branch* root = raptor_bptree_new_branch(tree);
+
+    root->node.count = 1;
+    root->node.items[0] = result.split_item;
+    root->children[0] = tree->root;
+    root->children[1] = result.split_node;
+    tree->root = &root->node;
+    tree->height++;
+  }
+
+#if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
+  raptor_bptree_check(tree);
+#endif
+
+  return 0;
+}
+
+
+/*
+ * raptor_bptree_rebalance:
+ *
+ * Fix up child @i of @branch after it dropped below the minimum
+ * size, by borrowing from a sibling or merging with one.
+ */
+static void
+raptor_bptree_rebalance(raptor_bptree* tree, raptor_bptree_branch* branch,
+                        int i)
+{
+  raptor_bptree_node* child = branch->children[i];
+  raptor_bptree_node* left = i ? branch->children[i - 1] : NULL;
+  raptor_bptree_node* right;
+  int sep;
+
+  right = (i < branch->node.count) ? branch->children[i + 1] : NULL;
+
+  if(left && left->count > RAPTOR_BPTREE_MIN_ITEMS) {
+    /* borrow the last item (or subtree) of the left sibling */
+    memmove(&child->items[1], &child->items[0], child->count * sizeof(void*));
+    if(child->is_leaf) {
+      child->items[0] = left->items[left->count - 1];
+    } else {
+      raptor_bptree_branch* cb = (raptor_bptree_branch*)child;
+      raptor_bptree_branch* lb = (raptor_bptree_branch*)left;
+
+      memmove(&cb->children[1], &cb->children[0],
+              (child->count + 1) * sizeof(raptor_bptree_node*));
+      child->items[0] = branch->node.items[i - 1];
+      cb->children[0] = lb->children[left->count];
+    }
+    child->count++;
+    left->count--;
+    branch->node.items[i - 1] = child->is_leaf ? child->items[0] :
+                                left->items[left->count];
+    return;
+  }
+
+  if(right && right->count > RAPTOR_BPTREE_MIN_ITEMS) {
+    /* borrow the first item (or subtree) of the right sibling */
+    if(child->is_leaf) {
+      child->items[child->count] = right->items[0];
+      memmove(&right->items[0], &right->items[1],
+              (right->count - 1) * sizeof(void*));
+      branch->node.items[i] = right->items[0];
+    } else {
+      raptor_bptree_branch* cb = (raptor_bptree_branch*)child;
+      raptor_bptree_branch* rb = (raptor_bptree_branch*)right;
+
+      child->items[child->count] = branch->node.items[i];
+      cb->children[child->count + 1] = rb->children[0];
+      branch->node.items[i] = right->items[0];
+      memmove(&right->items[0], &right->items[1],
+              (right->count - 1) * sizeof(void*));
+      memmove(&rb->children[0], &rb->children[1],
+              right->count * sizeof(raptor_bptree_node*));
+    }
+    child->count++;
+    right->count--;
+    return;
+  }
+
+  /* merge with a sibling: the right one of the pair is emptied */
+  if(left) {
+    right = child;
+    sep = i - 1;
+  } else {
+    left = child;
+    sep = i;
+  }
+
+  if(left->is_leaf) {
+    raptor_bptree_leaf* ll = (raptor_bptree_leaf*)left;
+    raptor_bptree_leaf* rl = (raptor_bptree_leaf*)right;
+
+    memcpy(&left->items[left->count], right->items,
+           right->count * sizeof(void*));
+    left->count = RAPTOR_GOOD_CAST(unsigned short, left->count + right->count);
+
+    ll->next = rl->next;
+    if(rl->next)
+      rl->next->prev = ll;
+    else
+      tree->last = ll;
+  } else {
+    raptor_bptree_branch* lb = (raptor_bptree_branch*)left;
+    raptor_bptree_branch* rb = (raptor_bptree_branch*)right;
+
+    left->items[left->count] = branch->node.items[sep];
+    memcpy(&left->items[left->count + 1], right->items,
+           right->count * sizeof(void*));
+    memcpy(&lb->children[left->count + 1], rb->children,
+           (right->count + 1) * sizeof(raptor_bptree_node*));
+    left->count = RAPTOR_GOOD_CAST(unsigned short,
+                                   left->count + right->count + 1);
+  }
+
+  raptor_bptree_free_node(tree, right);
+
+  memmove(&branch->node.items[sep], &branch->node.items[sep + 1],
+          (branch->node.count - sep - 1) * sizeof(void*));
+  memmove(&branch->children[sep + 1], &branch->children[sep + 2],
+          (branch->node.count - sep - 1) * sizeof(raptor_bptree_node*));
+  branch->node.count--;
+}
+
+
+/*
+ * raptor_bptree_remove_internal:
+ *
+ * Remove the item matching @p_data from the subtree at @node.  If
+ * the smallest item of the subtree changes, *@new_min_p is set to
+ * the new one.
+ */
+static void*
+raptor_bptree_remove_internal(raptor_bptree* tree, raptor_bptree_node* node,
+                              const void* p_data, void** new_min_p)
+{
+  raptor_bptree_branch* branch;
+  void* child_min = NULL;
+  void* rdata;
+  int i;
+
+  if(node->is_leaf) {
+    int found;
+
+    i = raptor_bptree_leaf_index(tree, node, p_data, &found);
+    if(!found)
+      return NULL;
+
+    rdata = node->items[i];
+    memmove(&node->items[i], &node->items[i + 1],
+            (node->count - i - 1) * sizeof(void*));
+    node->count--;
+    if(!i && node->count)
+      *new_min_p = node->items[0];
+    return rdata;
+  }
+
+  branch = (raptor_bptree_branch*)node;
+  i = raptor_bptree_branch_child_index(tree, node, p_data);
+  rdata = raptor_bptree_remove_internal(tree, branch->children[i], p_data,
+                                        &child_min);
+  if(!rdata)
+    return NULL;
+
+  if(child_min) {
+    if(i)
+      node->items[i - 1] = child_min;
+    else
+      *new_min_p = child_min;
+  }
+
+  if(branch->children[i]->count < RAPTOR_BPTREE_MIN_ITEMS)
+    raptor_bptree_rebalance(tree, branch, i);
+
+  return rdata;
+}
+
+
+/**
+ * raptor_bptree_remove:
+ * @tree: B+ Tree object
+ * @p_data: pointer to data item
+ *
+ * INTERNAL - Remove an item from a B+ Tree and return it
+ *
+ * The item removed is no longer owned by the B+ Tree and is
+ * owned by the caller.
+ *
+ * Return value: object or NULL on failure or if not found
+ */
+void*
+raptor_bptree_remove(raptor_bptree* tree, void* p_data)
+{
+  raptor_bptree_node* root = tree->root;
+  void* new_min = NULL;
+  void* rdata;
+
+  if(!root)
+    return NULL;
+
+  rdata = raptor_bptree_remove_internal(tree, root, p_data, &new_min);
+  if(!rdata)
+    return NULL;
+
+  tree->size--;
+
+  if(!root->count) {
+    /* shrink the tree by a level */
+    if(root->is_leaf) {
+      tree->root = NULL;
+      tree->height = 0;
+      tree->first = tree->last = NULL;
+    } else {
+      tree->root = ((raptor_bptree_branch*)root)->children[0];
+      tree->height--;
+    }
+    raptor_bptree_free_node(tree, root);
+  }
+
+#if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
+  raptor_bptree_check(tree);
+#endif
+
+  return rdata;
+}
+
+
+/**
+ * raptor_bptree_delete:
+ * @tree: B+ Tree object
+ * @p_data: pointer to data item
+ *
+ * INTERNAL - Remove an item from a B+ Tree and free it
+ *
+ * Return value: non-0 if an item was found and deleted
+ */
+int
+raptor_bptree_delete(raptor_bptree* tree, void* p_data)
+{
+  void* rdata;
+
+  rdata = raptor_bptree_remove(tree, p_data);
+  if(rdata) {
+    if(tree->free_handler)
+      tree->free_handler(rdata);
+  }
+
+  return (rdata != NULL);
+}
+
+
+/**
+ * raptor_bptree_visit:
+ * @tree: B+ Tree object
+ * @visit_handler: visit function to call at each item
+ * @user_data: user data pointer fo visit function
+ *
+ * INTERNAL - Perform an in-order visit of the items in the B+ Tree
+ *
+ * The depth passed to @visit_handler is the depth of the leaf
+ * holding the item.
+ *
+ * Return value: 0 if traversal was terminated early by @visit_handler
+ */
+int
+raptor_bptree_visit(raptor_bptree* tree,
+                    raptor_bptree_visit_handler visit_handler,
+                    void* user_data)
+{
+  raptor_bptree_leaf* leaf;
+  int depth = tree->height - 1;
+
+  for(leaf = tree->first; leaf; leaf = leaf->next) {
+    int i;
+
+    for(i = 0; i < leaf->node.count; i++) {
+      if(!visit_handler(depth, leaf->node.items[i], user_data))
+        return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+
+/**
+ * raptor_bptree_size:
+ * @tree: B+ Tree object
+ *
+ * INTERNAL - Get the number of items in the B+ Tree
+ *
+ * Return value: number of items in tree
+ */
+int
+raptor_bptree_size(raptor_bptree* tree)
+{
+  return RAPTOR_BAD_CAST(int, tree->size);
+}
+
+
+/**
+ * raptor_bptree_set_print_handler:
+ * @tree: B+ Tree object
+ * @print_handler: print function
+ *
+ * INTERNAL - Set the handler for printing an item in a tree
+ *
+ */
+void
+raptor_bptree_set_print_handler(raptor_bptree* tree,
+                                raptor_data_print_handler print_handler)
+{
+  tree->print_handler = print_handler;
+}
+
+
+/*
+ * raptor_bptree_seek:
+ *
+ * Position @iterator at the first item matching its range (or the
+ * last one if going backwards).
+ */
+static void
+raptor_bptree_seek(raptor_bptree_iterator* iterator)
+{
+  raptor_bptree* tree = iterator->tree;
+  raptor_bptree_node* node = tree->root;
+  void* range = iterator->range;
+  int i;
+
+  while(!node->is_leaf) {
+    /* count separators before (or, going backwards, not after) range */
+    int lo = 0;
+    int hi = node->count;
+
+    while(lo < hi) {
+      int mid = (lo + hi) >> 1;
+      int cmp = tree->compare_handler(range, node->items[mid]);
+      if(cmp > 0 || (cmp == 0 && iterator->direction < 0))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    node = ((raptor_bptree_branch*)node)->children[lo];
+  }
+
+  iterator->leaf = (raptor_bptree_leaf*)node;
+
+  /* first item not before range, or last item not after it */
+  for(i = 0; i < node->count; i++) {
+    int cmp = tree->compare_handler(range, node->items[i]);
+    if(iterator->direction < 0 ? (cmp < 0) : (cmp <= 0))
+      break;
+  }
+
+  iterator->index = (iterator->direction < 0) ? i - 1 : i;
+}
+
+
+/* Move @iterator along the leaf chain until it is on an item or at the end */
+static void
+raptor_bptree_iterator_settle(raptor_bptree_iterator* iterator)
+{
+  while(iterator->leaf) {
+    if(iterator->index < 0) {
+      iterator->leaf = iterator->leaf->prev;
+      if(iterator->leaf)
+        iterator->index = iterator->leaf->node.count - 1;
+    } else if(iterator->index >= iterator->leaf->node.count) {
+      iterator->leaf = iterator->leaf->next;
+      iterator->index = 0;
+    } else
+      break;
+  }
+
+  if(!iterator->leaf) {
+    iterator->is_finished = 1;
+    return;
+  }
+
+  if(iterator->range &&
+     iterator->tree->compare_handler(iterator->range,
+                                     iterator->leaf->node.items[iterator->index]))
+    iterator->is_finished = 1;
+}
+
+
+/**
+ * raptor_new_bptree_iterator:
+ * @tree: #raptor_bptree object
+ * @range: range
+ * @range_free_handler: function to free @range object
+ * @direction: <0 to go 'backwards' otherwise 'forwards'
+ *
+ * INTERNAL - Get an in-order iterator for the start of a range, or the entire contents
+ *
+ * If range is NULL, the entire tree is walked in order.  If range
+ * specifies a range (i.e. the tree comparison function will 'match'
+ * (return 0 for) range and /several/ items), the iterator will be
+ * placed at the first item matching range, and
+ * raptor_bptree_iterator_next will iterate over all items (and only
+ * items) that match range.
+ *
+ * Return value: a new #raptor_bptree_iterator object or NULL on failure
+ **/
+raptor_bptree_iterator*
+raptor_new_bptree_iterator(raptor_bptree* tree, void* range,
+                           raptor_data_free_handler range_free_handler,
+                           int direction)
+{
+  raptor_bptree_iterator* iterator;
+
+  iterator = RAPTOR_CALLOC(raptor_bptree_iterator*, 1, sizeof(*iterator));
+  if(!iterator)
+    return NULL;
+
+  iterator->tree = tree;
+  iterator->range = range;
+  iterator->range_free_handler = range_free_handler;
+  iterator->direction = direction;
+
+  if(!tree->root) {
+    iterator->is_finished = 1;
+    return iterator;
+  }
+
+  if(range)
+    raptor_bptree_seek(iterator);
+  else if(direction < 0) {
+    iterator->leaf = tree->last;
+    iterator->index = tree->last->node.count - 1;
+  } else {
+    iterator->leaf = tree->first;
+    iterator->index = 0;
+  }
+
+  raptor_bptree_iterator_settle(iterator);
+
+  return iterator;
+}
+
+
+/**
+ * raptor_free_bptree_iterator:
+ * @iterator: B+ Tree iterator object
+ *
+ * INTERNAL - B+ Tree Iterator destructor
+ */
+void
+raptor_free_bptree_iterator(raptor_bptree_iterator* iterator)
+{
+  if(!iterator)
+    return;
+
+  if(iterator->range && iterator->range_free_handler)
+    iterator->range_free_handler(iterator->range);
+
+  RAPTOR_FREE(raptor_bptree_iterator, iterator);
+}
+
+
+/**
+ * raptor_bptree_iterator_is_end:
+ * @iterator: B+ Tree iterator object
+ *
+ * INTERNAL - Test if an iteration is finished
+ *
+ * Return value: non-0 if iteration is finished
+ */
+int
+raptor_bptree_iterator_is_end(raptor_bptree_iterator* iterator)
+{
+  return iterator->is_finished;
+}
+
+
+/**
+ * raptor_bptree_iterator_next:
+ * @iterator: B+ Tree iterator object
+ *
+ * INTERNAL - Move iteration to next/prev object
+ *
+ * Return value: non-0 if iteration is finished
+ */
+int
+raptor_bptree_iterator_next(raptor_bptree_iterator* iterator)
+{
+  if(iterator->is_finished)
+    return 1;
+
+  if(iterator->direction < 0)
+    iterator->index--;
+  else
+    iterator->index++;
+
+  raptor_bptree_iterator_settle(iterator);
+
+  return iterator->is_finished;
+}
+
+
+/**
+ * raptor_bptree_iterator_get:
+ * @iterator: B+ Tree iterator object
+ *
+ * INTERNAL - Get current iteration object
+ *
+ * Return value: object or NULL if iteration is finished
+ */
+void*
+raptor_bptree_iterator_get(raptor_bptree_iterator* iterator)
+{
+  if(iterator->is_finished)
+    return NULL;
+
+  return iterator->leaf->node.items[iterator->index];
+}
+
+
+/**
+ * raptor_bptree_print:
+ * @tree: B+ Tree
+ * @stream: stream to print to
+ *
+ * INTERNAL - Print the items in the tree in order to a stream (for debugging)
+ *
+ * Return value: non-0 on failure
+ */
+int
+raptor_bptree_print(raptor_bptree* tree, FILE* stream)
+{
+  raptor_bptree_leaf* leaf;
+  int count = 0;
+
+  fprintf(stream, "B+ Tree size %u\n", tree->size);
+  for(leaf = tree->first; leaf; leaf = leaf->next) {
+    int i;
+
+    for(i = 0; i < leaf->node.count; i++) {
+      void* data = leaf->node.items[i];
+
+      fprintf(stream, "%d) ", count++);
+      if(tree->print_handler)
+        tree->print_handler(data, stream);
+      else
+        fprintf(stream, "Data Node %p\n", RAPTOR_VOIDP(data));
+    }
+  }
+
+  return 0;
+}
+
+
+#ifdef RAPTOR_DEBUG
+
+static void
+raptor_bptree_check_fail(raptor_bptree* tree, raptor_bptree_node* node,
+                         const char* message)
+{
+  fprintf(stderr, "B+ Tree %p node %p: %s\n", RAPTOR_VOIDP(tree),
+          RAPTOR_VOIDP(node), message);
+  fflush(stderr);
+  abort();
+}
+
+
+/* check subtree at @node; returns its smallest item */
+static void*
+raptor_bptree_check_internal(raptor_bptree* tree, raptor_bptree_node* node,
+                             int depth, unsigned int* count_p)
+{
+  raptor_bptree_branch* branch = (raptor_bptree_branch*)node;
+  void* min;
+  int i;
+
+  if(node != tree->root && node->count < RAPTOR_BPTREE_MIN_ITEMS)
+    raptor_bptree_check_fail(tree, node, "too few items");
+
+  for(i = 1; i < node->count; i++) {
+    if(tree->compare_handler(node->items[i - 1], node->items[i]) >= 0)
+      raptor_bptree_check_fail(tree, node, "items out of order");
+  }
+
+  if(node->is_leaf) {
+    if(depth != tree->height - 1)
+      raptor_bptree_check_fail(tree, node, "leaf at wrong depth");
+    *count_p += node->count;
+    return node->count ? node->items[0] : NULL;
+  }
+
+  min = raptor_bptree_check_internal(tree, branch->children[0], depth + 1,
+                                     count_p);
+  for(i = 0; i < node->count; i++) {
+    void* child_min;
+
+    child_min = raptor_bptree_check_internal(tree, branch->children[i + 1],
+                                             depth + 1, count_p);
+    if(child_min != node->items[i])
+      raptor_bptree_check_fail(tree, node,
+                               "separator is not smallest item of subtree");
+  }
+
+  return min;
+}
+
+
+/* debugging tree check - ordering, separators, depths and counts */
+void
+raptor_bptree_check(raptor_bptree* tree)
+{
+  unsigned int count = 0;
+  unsigned int leaf_count = 0;
+  raptor_bptree_leaf* leaf;
+
+  if(tree->root)
+    raptor_bptree_check_internal(tree, tree->root, 0, &count);
+
+  for(leaf = tree->first; leaf; leaf = leaf->next) {
+    if(leaf->next && leaf->next->prev != leaf)
+      raptor_bptree_check_fail(tree, &leaf->node, "bad leaf chain");
+    leaf_count += leaf->node.count;
+  }
+
+  if(count != tree->size || leaf_count != tree->size) {
+    fprintf(stderr, "B+ Tree %p size is %u.  actual count %u (leaves %u)\n",
+            RAPTOR_VOIDP(tree), tree->size, count, leaf_count);
+    abort();
+  }
+}
+
+#endif
+
+#endif
+
+
+#ifdef STANDALONE
+
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+typedef struct
+{
+  FILE *fh;
+  int count;
+  const char** results;
+  int failed;
+} visit_state;
+
+
+static int
+check_string(int depth, void* data, void *user_data)
+{
+  visit_state* vs = (visit_state*)user_data;
+  const char* result = vs->results[vs->count];
+
+  if(strcmp((const char*)data, result)) {
+    fprintf(vs->fh, "%3d: Expected '%s' but found '%s'\n", vs->count,
+            result, (char*)data);
+    vs->failed = 1;
+  }
+  vs->count++;
+
+  return 1;
+}
+
+
+static int
+compare_strings(const void *l, const void *r)
+{
+  return strcmp((const char*)l, (const char*)r);
+}
+
+
+static int
+compare_ints(const void *l, const void *r)
+{
+  int a = *(const int*)l;
+  int b = *(const int*)r;
+  return (a > b) - (a < b);
+}
+
+
+/* compare by value / 10 so an item matches a run of 10 values */
+static int
+compare_ints_decade(const void *l, const void *r)
+{
+  int a = *(const int*)l / 10;
+  int b = *(const int*)r / 10;
+  return (a > b) - (a < b);
+}
+
+
+/* range items are negative: -1 - value matches the decade of value */
+static int
+compare_ints_or_range(const void *l, const void *r)
+{
+  int a = *(const int*)l;
+  int b = *(const int*)r;
+
+  if(a < 0 || b < 0) {
+    a = (a < 0) ? (-1 - a) / 10 : a / 10;
+    b = (b < 0) ? (-1 - b) / 10 : b / 10;
+  }
+  return (a > b) - (a < b);
+}
+
+
+static unsigned int test_seed = 1;
+
+static unsigned int
+test_rand(void)
+{
+  test_seed = test_seed * 1103515245U + 12345U;
+  return (test_seed >> 8) & 0xffffff;
+}
+
+
+static int
+test_strings(const char* program)
+{
+#define ITEM_COUNT 8
+  const char *items[ITEM_COUNT+1] = { "ron", "amy", "jen", "bij", "jib", "daj", "jim", "def", NULL };
+#define DELETE_COUNT 2
+  const char *delete_items[DELETE_COUNT+1] = { "jen", "jim", NULL };
+#define RESULT_COUNT (ITEM_COUNT-DELETE_COUNT)
+  const char *results[RESULT_COUNT+1] = { "amy", "bij", "daj", "def", "jib", "ron", NULL};
+  raptor_bptree* tree;
+  raptor_bptree_iterator* iter;
+  visit_state vs;
+  int i;
+
+  tree = raptor_new_bptree(compare_strings,
+                           NULL, /* no free as they are static pointers above */
+                           0);
+  if(!tree) {
+    fprintf(stderr, "%s: Failed to create tree\n", program);
+    return 1;
+  }
+
+  for(i = 0; items[i]; i++) {
+    if(raptor_bptree_add(tree, (void*)items[i])) {
+      fprintf(stderr, "%s: Adding tree item %d '%s' failed\n", program, i,
+              items[i]);
+      return 1;
+    }
+    if(!raptor_bptree_search(tree, (void*)items[i])) {
+      fprintf(stderr, "%s: Tree did NOT contain item %d '%s' as expected\n",
+              program, i, items[i]);
+      return 1;
+    }
+  }
+
+  if(raptor_bptree_add(tree, (void*)items[0]) <= 0) {
+    fprintf(stderr, "%s: Adding duplicate item '%s' did not fail\n", program,
+            items[0]);
+    return 1;
+  }
+
+  for(i = 0; delete_items[i]; i++) {
+    if(!raptor_bptree_delete(tree, (void*)delete_items[i])) {
+      fprintf(stderr, "%s: Deleting tree item %d '%s' failed\n", program, i,
+              delete_items[i]);
+      return 1;
+    }
+  }
+
+  iter = raptor_new_bptree_iterator(tree, NULL, NULL, 1);
+  for(i = 0; 1; i++) {
+    const char* data = (const char*)raptor_bptree_iterator_get(iter);
+    const char* result = results[i];
+    if((!data && data != result) || (data && strcmp(data, result))) {
+      fprintf(stderr, "%3d: Forwards iterator expected '%s' but found '%s'\n",
+              i, result, data);
+      return 1;
+    }
+    if(raptor_bptree_iterator_next(iter))
+      break;
+  }
+  raptor_free_bptree_iterator(iter);
+  if(i != RESULT_COUNT - 1) {
+    fprintf(stderr, "%s: Forward iterator ended at %d not %d\n", program, i,
+            RESULT_COUNT - 1);
+    return 1;
+  }
+
+  vs.fh = stderr;
+  vs.count = 0;
+  vs.results = results;
+  vs.failed = 0;
+  raptor_bptree_visit(tree, check_string, &vs);
+  if(vs.failed || vs.count != RESULT_COUNT) {
+    fprintf(stderr, "%s: Checking tree failed\n", program);
+    return 1;
+  }
+
+  for(i = 0; results[i]; i++) {
+    char* data = (char*)raptor_bptree_remove(tree, (void*)results[i]);
+    if(!data || strcmp(data, results[i])) {
+      fprintf(stderr, "%s: remove %i failed at item '%s'\n", program, i,
+              results[i]);
+      return 1;
+    }
+  }
+  if(raptor_bptree_size(tree)) {
+    fprintf(stderr, "%s: tree not empty after removing all items\n", program);
+    return 1;
+  }
+
+  raptor_free_bptree(tree);
+
+  return 0;
+}
+
+
+/* Random adds and deletes checked against a bitmap of present values */
+static int
+test_random(const char* program)
+{
+#define RANDOM_RANGE 20000
+#define RANDOM_OPS 200000
+  int* values;
+  char* present;
+  raptor_bptree* tree;
+  raptor_bptree_iterator* iter;
+  int expected = 0;
+  int i;
+  int rc = 1;
+
+  values = (int*)malloc(RANDOM_RANGE * sizeof(int));
+  present = (char*)calloc(RANDOM_RANGE, 1);
+  tree = raptor_new_bptree(compare_ints, NULL, 0);
+  if(!values || !present || !tree)
+    goto done;
+
+  for(i = 0; i < RANDOM_RANGE; i++)
+    values[i] = i;
+
+  for(i = 0; i < RANDOM_OPS; i++) {
+    int v = (int)(test_rand() % RANDOM_RANGE);
+    /* grow for the first half then mostly shrink */
+    int add = (test_rand() % 100) < ((i < RANDOM_OPS / 2) ? 70 : 30);
+
+    if(add) {
+      int r = raptor_bptree_add(tree, &values[v]);
+      if((r != 0) != (present[v] != 0)) {
+        fprintf(stderr, "%s: add %d returned %d\n", program, v, r);
+        goto done;
+      }
+      if(!present[v])
+        expected++;
+      present[v] = 1;
+    } else {
+      int* data = (int*)raptor_bptree_remove(tree, &values[v]);
+      if((data != NULL) != (present[v] != 0) || (data && *data != v)) {
+        fprintf(stderr, "%s: remove %d failed\n", program, v);
+        goto done;
+      }
+      if(present[v])
+        expected--;
+      present[v] = 0;
+    }
+#ifdef RAPTOR_DEBUG
+    if(!(i % 1000))
+      raptor_bptree_check(tree);
+#endif
+  }
+
+  if(raptor_bptree_size(tree) != expected) {
+    fprintf(stderr, "%s: size %d expected %d\n", program,
+            raptor_bptree_size(tree), expected);
+    goto done;
+  }
+
+  for(i = 0; i < RANDOM_RANGE; i++) {
+    int* data = (int*)raptor_bptree_search(tree, &values[i]);
+    if((data != NULL) != (present[i] != 0)) {
+      fprintf(stderr, "%s: search %d failed\n", program, i);
+      goto done;
+    }
+  }
+
+  /* backwards walk of everything */
+  iter = raptor_new_bptree_iterator(tree, NULL, NULL, -1);
+  for(i = RANDOM_RANGE - 1; i >= 0; i--) {
+    int* data;
+
+    if(!present[i])
+      continue;
+    data = (int*)raptor_bptree_iterator_get(iter);
+    if(!data || *data != i) {
+      fprintf(stderr, "%s: backwards iterator expected %d\n", program, i);
+      goto done;
+    }
+    raptor_bptree_iterator_next(iter);
+  }
+  if(!raptor_bptree_iterator_is_end(iter)) {
+    fprintf(stderr, "%s: backwards iterator did not end\n", program);
+    goto done;
+  }
+  raptor_free_bptree_iterator(iter);
+
+  rc = 0;
+
+  done:
+  if(tree)
+    raptor_free_bptree(tree);
+  if(present)
+    free(present);
+  if(values)
+    free(values);
+
+  return rc;
+}
+
+
+/* Range iterators over single items and over runs of items */
+static int
+test_ranges(const char* program)
+{
+#define RANGE_VALUES 3000
+  int values[RANGE_VALUES];
+  raptor_bptree* tree;
+  int i;
+  int rc = 1;
+
+  for(i = 0; i < RANGE_VALUES; i++)
+    values[i] = i;
+
+  /* only even values are present */
+  tree = raptor_new_bptree(compare_ints, NULL, 0);
+  if(!tree)
+    return 1;
+  for(i = 0; i < RANGE_VALUES; i += 2)
+    raptor_bptree_add(tree, &values[i]);
+
+  for(i = 0; i < RANGE_VALUES; i += 7) {
+    int dir;
+
+    for(dir = -1; dir <= 1; dir += 2) {
+      raptor_bptree_iterator* iter;
+      int* data;
+      int n = 0;
+
+      iter = raptor_new_bptree_iterator(tree, &values[i], NULL, dir);
+      while((data = (int*)raptor_bptree_iterator_get(iter))) {
+        if(*data != i) {
+          fprintf(stderr, "%s: range %d returned %d\n", program, i, *data);
+          goto done;
+        }
+        n++;
+        raptor_bptree_iterator_next(iter);
+      }
+      raptor_free_bptree_iterator(iter);
+      if(n != !(i & 1)) {
+        fprintf(stderr, "%s: range %d returned %d items\n", program, i, n);
+        goto done;
+      }
+    }
+  }
+  raptor_free_bptree(tree);
+
+  /* every value present; a range item matches a whole decade */
+  tree = raptor_new_bptree(compare_ints_or_range, NULL, 0);
+  if(!tree)
+    return 1;
+  for(i = 0; i < RANGE_VALUES; i++)
+    raptor_bptree_add(tree, &values[i]);
+
+  for(i = 0; i < RANGE_VALUES; i += 10) {
+    int dir;
+
+    for(dir = -1; dir <= 1; dir += 2) {
+      raptor_bptree_iterator* iter;
+      int* range;
+      int expect = (dir < 0) ? i + 9 : i;
+      int* data;
+
+      range = (int*)malloc(sizeof(int));
+      if(!range)
+        goto done;
+      *range = -1 - (i + 5);
+      iter = raptor_new_bptree_iterator(tree, range, free, dir);
+      while((data = (int*)raptor_bptree_iterator_get(iter))) {
+        if(*data != expect) {
+          fprintf(stderr, "%s: decade %d dir %d got %d expected %d\n",
+                  program, i, dir, *data, expect);
+          goto done;
+        }
+        expect += dir;
+        raptor_bptree_iterator_next(iter);
+      }
+      raptor_free_bptree_iterator(iter);
+      if(expect != ((dir < 0) ? i - 1 : i + 10)) {
+        fprintf(stderr, "%s: decade %d dir %d ended early at %d\n",
+                program, i, dir, expect);
+        goto done;
+      }
+    }
+  }
+  raptor_free_bptree(tree);
+
+  /* replacing duplicates leaves the last value added for each decade */
+  tree = raptor_new_bptree(compare_ints_decade, NULL,
+                           RAPTOR_BPTREE_FLAG_REPLACE_DUPLICATES);
+  if(!tree)
+    return 1;
+  for(i = 0; i < RANGE_VALUES; i++)
+    raptor_bptree_add(tree, &values[i]);
+  if(raptor_bptree_size(tree) != RANGE_VALUES / 10) {
+    fprintf(stderr, "%s: replacing tree has size %d\n", program,
+            raptor_bptree_size(tree));
+    goto done;
+  }
+  for(i = 0; i < RANGE_VALUES; i += 10) {
+    int* data = (int*)raptor_bptree_search(tree, &values[i]);
+    if(!data || *data != i + 9) {
+      fprintf(stderr, "%s: replaced item for %d is wrong\n", program, i);
+      goto done;
+    }
+  }
+
+  rc = 0;
+
+  done:
+  raptor_free_bptree(tree);
+
+  return rc;
+}
+
+
+#ifdef HAVE_GETTIMEOFDAY
+static double
+bench_now(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+}
+
+
+static int
+bench_count_visit(int depth, void* data, void *user_data)
+{
+  (*(long*)user_data) += *(int*)data;
+  return 1;
+}
+
+
+/* Insert, lookup and in-order iteration timings against raptor_avltree */
+static void
+bench(const char* program, int count)
+{
+  int* values;
+  raptor_bptree* btree;
+  raptor_avltree* atree;
+  double t0;
+  long sum;
+  int i;
+
+  values = (int*)malloc(RAPTOR_GOOD_CAST(size_t, count) * sizeof(int));
+  if(!values)
+    return;
+  /* random permutation so inserts are not in order */
+  for(i = 0; i < count; i++)
+    values[i] = i;
+  for(i = count - 1; i > 0; i--) {
+    int j = (int)(((unsigned long)test_rand() << 8 ^ test_rand()) %
+                  (unsigned long)(i + 1));
+    int t = values[i];
+    values[i] = values[j];
+    values[j] = t;
+  }
+
+  btree = raptor_new_bptree(compare_ints, NULL, 0);
+  atree = raptor_new_avltree(compare_ints, NULL, 0);
+
+  t0 = bench_now();
+  for(i = 0; i < count; i++)
+    raptor_avltree_add(atree, &values[i]);
+  fprintf(stdout, "%s: %d avltree add    %8.3fs\n", program, count,
+          bench_now() - t0);
+  t0 = bench_now();
+  for(i = 0; i < count; i++)
+    raptor_bptree_add(btree, &values[i]);
+  fprintf(stdout, "%s: %d bptree  add    %8.3fs\n", program, count,
+          bench_now() - t0);
+
+  t0 = bench_now();
+  for(i = 0; i < count; i++)
+    raptor_avltree_search(atree, &values[i]);
+  fprintf(stdout, "%s: %d avltree search %8.3fs\n", program, count,
+          bench_now() - t0);
+  t0 = bench_now();
+  for(i = 0; i < count; i++)
+    raptor_bptree_search(btree, &values[i]);
+  fprintf(stdout, "%s: %d bptree  search %8.3fs\n", program, count,
+          bench_now() - t0);
+
+  sum = 0;
+  t0 = bench_now();
+  raptor_avltree_visit(atree, bench_count_visit, &sum);
+  fprintf(stdout, "%s: %d avltree visit  %8.3fs\n", program, count,
+          bench_now() - t0);
+  sum = 0;
+  t0 = bench_now();
+  raptor_bptree_visit(btree, bench_count_visit, &sum);
+  fprintf(stdout, "%s: %d bptree  visit  %8.3fs\n", program, count,
+          bench_now() - t0);
+
+  raptor_free_avltree(atree);
+  raptor_free_bptree(btree);
+  free(values);
+}
+#endif
+
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+int
+main(int argc, char *argv[])
+{
+  raptor_world *world;
+  const char *program = raptor_basename(argv[0]);
+  int rc = 0;
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  if(argc == 2) {
+    /* benchmark mode: raptor_bptree_test COUNT */
+#ifdef HAVE_GETTIMEOFDAY
+    bench(program, atoi(argv[1]));
+#endif
+  } else {
+    rc = test_strings(program) || test_random(program) ||
+         test_ranges(program);
+  }
+
+  raptor_free_world(world);
+
+  return rc;
+}
+
+#endif
@@ -0,0 +1,1763 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_compress.c - Raptor gzip and zstd compressed iostreams
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <sys/types.h>
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+/* Size of the compressed data buffer: read from or written to the
+ * underlying FILE* in blocks of this many bytes.
+ */
+#define RAPTOR_COMPRESS_BUFFER_SIZE 65536
+
+#ifdef HAVE_PTHREAD
+/* Read-ahead: a worker thread reads and decompresses into a ring of
+ * this many blocks of decompressed data while the caller consumes them.
+ */
+#define RAPTOR_COMPRESS_READ_AHEAD_BLOCKS 3
+#define RAPTOR_COMPRESS_READ_AHEAD_BLOCK_SIZE 262144
+
+typedef struct
+{
+  unsigned char* data;
+  size_t len;
+  /* non-0 if no more blocks follow: end of data or failure */
+  int last;
+  int failed;
+} raptor_compress_block;
+#endif
+
+typedef struct
+{
+  raptor_world* world;
+
+  FILE* handle;
+  /* non-0 if handle was opened here and is closed in finish */
+  int close_handle;
+  /* non-0 if handle is a regular file, so a read never blocks for long */
+  int regular;
+
+  raptor_compression compression;
+
+  /* compressed data: pending input when reading, pending output
+   * when writing
+   */
+  unsigned char* buffer;
+  size_t buffer_len;
+  size_t buffer_pos;
+
+  /* reading: the underlying handle is drained */
+  int handle_eof;
+  /* reading: last compressed member or frame was completed */
+  int member_end;
+  /* reading: all data returned; writing: compressed stream ended */
+  int stream_end;
+
+  int failed;
+  /* static strings describing the failure, reported by the reader */
+  const char* error_action;
+  const char* error_detail;
+  int error_reported;
+
+  /* non-0 for a compressing (write) stream */
+  int writing;
+
+#ifdef HAVE_PTHREAD
+  /* non-0 if the read-ahead worker thread was started */
+  int read_ahead;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t block_full;
+  pthread_cond_t block_free;
+  /* fields above the ring are only used by the worker once started;
+   * the ring indexes and counts are protected by lock
+   */
+  raptor_compress_block blocks[RAPTOR_COMPRESS_READ_AHEAD_BLOCKS];
+  int full_count;
+  int produce_index;
+  int stop;
+  /* set by the worker as it exits */
+  int worker_done;
+  /* set when the iostream is freed before the worker exits; the
+   * worker then frees the context itself
+   */
+  int orphaned;
+  /* consumer side, only used by the reading thread */
+  int consume_index;
+  size_t consume_pos;
+  int consume_held;
+  int consume_end;
+  int consume_failed;
+#endif
+
+#ifdef HAVE_ZLIB
+  z_stream zs;
+  int zs_init;
+#endif
+#ifdef HAVE_ZSTD
+  ZSTD_DStream* zds;
+  ZSTD_CStream* zcs;
+#endif
+} raptor_compress_iostream_context;
+
+
+static const char* const raptor_compression_names[RAPTOR_COMPRESSION_LAST + 1] = {
+  "none", "auto", "gzip", "zstd"
+};
+
+
+/*
+ * raptor_compression_sniff:
+ * @buffer: start of data
+ * @len: length of @buffer
+ *
+ * INTERNAL - Detect compression from the magic bytes at the start of data
+ *
+ * Return value: compression method, #RAPTOR_COMPRESSION_NONE if not recognised
+ */
+static raptor_compression
+raptor_compression_sniff(const unsigned char* buffer, size_t len)
+{
+  if(len >= 2 && buffer[0] == 0x1f && buffer[1] == 0x8b)
+    return RAPTOR_COMPRESSION_GZIP;
+
+  if(len >= 4 && buffer[0] == 0x28 && buffer[1] == 0xb5 &&
+     buffer[2] == 0x2f && buffer[3] == 0xfd)
+    return RAPTOR_COMPRESSION_ZSTD;
+
+  return RAPTOR_COMPRESSION_NONE;
+}
+
+
+#ifndef STANDALONE
+
+/**
+ * raptor_compression_is_supported:
+ * @compression: compression method
+ *
+ * Check if a compression method was enabled when Raptor was built.
+ *
+ * #RAPTOR_COMPRESSION_NONE and #RAPTOR_COMPRESSION_AUTO are always
+ * supported; auto-detected input that uses a method that is not
+ * supported fails when the iostream is constructed.
+ *
+ * Return value: non-0 if @compression is supported
+ **/
+int
+raptor_compression_is_supported(raptor_compression compression)
+{
+  switch(compression) {
+    case RAPTOR_COMPRESSION_NONE:
+    case RAPTOR_COMPRESSION_AUTO:
+      return 1;
+
+    case RAPTOR_COMPRESSION_GZIP:
+#ifdef HAVE_ZLIB
+      return 1;
+#else
+      return 0;
+#endif
+
+    case RAPTOR_COMPRESSION_ZSTD:
+#ifdef HAVE_ZSTD
+      return 1;
+#else
+      return 0;
+#endif
+
+    default:
+      return 0;
+  }
+}
+
+
+/*
+ * raptor_compression_from_filename:
+ * @filename: filename
+ *
+ * INTERNAL - Pick compression from a filename extension
+ *
+ * Return value: compression method, #RAPTOR_COMPRESSION_NONE if not recognised
+ */
+static raptor_compression
+raptor_compression_from_filename(const char* filename)
+{
+  const char* ext = strrchr(filename, '.');
+
+  if(!ext)
+    return RAPTOR_COMPRESSION_NONE;
+  ext++;
+
+  if(!strcmp(ext, "gz"))
+    return RAPTOR_COMPRESSION_GZIP;
+  if(!strcmp(ext, "zst") || !strcmp(ext, "zstd"))
+    return RAPTOR_COMPRESSION_ZSTD;
+
+  return RAPTOR_COMPRESSION_NONE;
+}
+
+
+/* Record a failure; it is logged by raptor_compress_iostream_report()
+ * so that a read-ahead worker thread never calls the log handler.
+ */
+static void
+raptor_compress_iostream_error(raptor_compress_iostream_context* con,
+                               const char* action, const char* detail)
+{
+  if(con->failed)
+    return;
+  con->failed = 1;
+  con->error_action = action;
+  con->error_detail = detail;
+}
+
+
+static void
+raptor_compress_iostream_report(raptor_compress_iostream_context* con)
+{
+  if(!con->error_action || con->error_reported)
+    return;
+  con->error_reported = 1;
+  raptor_log_error_formatted(con->world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                             "%s %s failed - %s",
+                             raptor_compression_names[con->compression],
+                             con->error_action,
+                             con->error_detail ? con->error_detail : "unknown error");
+}
+
+
+static void
+raptor_free_compress_iostream_context(raptor_compress_iostream_context* con)
+{
+#ifdef HAVE_ZLIB
+  if(con->zs_init) {
+    if(con->writing)
+      deflateEnd(&con->zs);
+    else
+      inflateEnd(&con->zs);
+  }
+#endif
+#ifdef HAVE_ZSTD
+  if(con->zds)
+    ZSTD_freeDStream(con->zds);
+  if(con->zcs)
+    ZSTD_freeCStream(con->zcs);
+#endif
+
+  if(con->close_handle && con->handle)
+    fclose(con->handle);
+
+  if(con->buffer)
+    RAPTOR_FREE(char*, con->buffer);
+
+  RAPTOR_FREE(raptor_compress_iostream_context, con);
+}
+
+
+/* Local handlers for reading compressed data */
+
+#ifdef HAVE_PTHREAD
+/* Free the read-ahead ring and locks once the worker has exited */
+static void
+raptor_compress_iostream_free_read_ahead(raptor_compress_iostream_context* con)
+{
+  int i;
+
+  pthread_cond_destroy(&con->block_free);
+  pthread_cond_destroy(&con->block_full);
+  pthread_mutex_destroy(&con->lock);
+  for(i = 0; i < RAPTOR_COMPRESS_READ_AHEAD_BLOCKS; i++)
+    RAPTOR_FREE(char*, con->blocks[i].data);
+}
+#endif
+
+
+static void
+raptor_compress_iostream_read_finish(void *user_data)
+{
+  raptor_compress_iostream_context* con;
+
+  con = (raptor_compress_iostream_context*)user_data;
+
+#ifdef HAVE_PTHREAD
+  if(con->read_ahead) {
+    pthread_t thread = con->thread;
+    int orphan;
+
+    pthread_mutex_lock(&con->lock);
+    con->stop = 1;
+    pthread_cond_signal(&con->block_free);
+    /* The worker may be blocked reading a pipe that is never closed.
+     * Rather than wait for it, leave it to free the context when the
+     * read returns.  Only done for a handle opened here, which nothing
+     * else can close under the worker.
+     */
+    orphan = (!con->worker_done && con->close_handle && !con->regular);
+    if(orphan)
+      con->orphaned = 1;
+    pthread_mutex_unlock(&con->lock);
+
+    if(orphan) {
+      pthread_detach(thread);
+      return;
+    }
+
+    pthread_join(thread, NULL);
+    raptor_compress_iostream_free_read_ahead(con);
+  }
+#endif
+
+  raptor_free_compress_iostream_context(con);
+}
+
+
+/* Refill the compressed input buffer once it has been consumed */
+static void
+raptor_compress_iostream_fill(raptor_compress_iostream_context* con)
+{
+  size_t len;
+
+  if(con->buffer_pos < con->buffer_len || con->handle_eof)
+    return;
+
+  len = fread(con->buffer, 1, RAPTOR_COMPRESS_BUFFER_SIZE, con->handle);
+  con->buffer_len = len;
+  con->buffer_pos = 0;
+  if(len < RAPTOR_COMPRESS_BUFFER_SIZE) {
+    con->handle_eof = 1;
+    if(ferror(con->handle))
+      raptor_compress_iostream_error(con, "read", "I/O error");
+  }
+}
+
+
+/*
+ * raptor_compress_iostream_inflate:
+ * @con: context
+ * @ptr: output buffer
+ * @len: size of @ptr
+ * @end_p: pointer to store non-0 if a compressed member or frame ended
+ *
+ * INTERNAL - Decompress some of the pending input into @ptr
+ *
+ * Return value: number of bytes written to @ptr
+ */
+static size_t
+raptor_compress_iostream_inflate(raptor_compress_iostream_context* con,
+                                 unsigned char* ptr, size_t len, int* end_p)
+{
+  size_t avail = con->buffer_len - con->buffer_pos;
+
+  *end_p = 0;
+
+  switch(con->compression) {
+#ifdef HAVE_ZLIB
+    case RAPTOR_COMPRESSION_GZIP:
+    {
+      int zrc;
+
+      con->zs.next_in = con->buffer + con->buffer_pos;
+      con->zs.avail_in = RAPTOR_GOOD_CAST(uInt, avail);
+      con->zs.next_out = ptr;
+      con->zs.avail_out = RAPTOR_GOOD_CAST(uInt, len);
+
+      zrc = inflate(&con->zs, Z_NO_FLUSH);
+      con->buffer_pos += avail - con->zs.avail_in;
+      len -= con->zs.avail_out;
+
+      if(zrc == Z_STREAM_END) {
+        /* allow concatenated gzip members as produced by pigz or cat */
+        *end_p = 1;
+        inflateReset(&con->zs);
+      } else if(zrc != Z_OK && zrc != Z_BUF_ERROR)
+        raptor_compress_iostream_error(con, "decompression", con->zs.msg);
+
+      return len;
+    }
+#endif
+
+#ifdef HAVE_ZSTD
+    case RAPTOR_COMPRESSION_ZSTD:
+    {
+      ZSTD_inBuffer in;
+      ZSTD_outBuffer out;
+      size_t zrc;
+
+      in.src = con->buffer;
+      in.size = con->buffer_len;
+      in.pos = con->buffer_pos;
+      out.dst = ptr;
+      out.size = len;
+      out.pos = 0;
+
+      zrc = ZSTD_decompressStream(con->zds, &out, &in);
+      con->buffer_pos = in.pos;
+
+      if(ZSTD_isError(zrc))
+        raptor_compress_iostream_error(con, "decompression",
+                                       ZSTD_getErrorName(zrc));
+      else if(!zrc)
+        *end_p = 1;
+
+      return out.pos;
+    }
+#endif
+
+    case RAPTOR_COMPRESSION_NONE:
+      if(avail > len)
+        avail = len;
+      memcpy(ptr, con->buffer + con->buffer_pos, avail);
+      con->buffer_pos += avail;
+      *end_p = 1;
+      return avail;
+
+    case RAPTOR_COMPRESSION_AUTO:
+    default:
+      raptor_compress_iostream_error(con, "decompression", "unsupported");
+      return 0;
+  }
+}
+
+
+/*
+ * raptor_compress_iostream_produce:
+ * @con: context
+ * @out: output buffer
+ * @total: size of @out
+ *
+ * INTERNAL - Read and decompress until @out is full or the data ends
+ *
+ * Sets the failed field on failure.
+ *
+ * Return value: number of bytes written to @out, less than @total only at the end
+ */
+static size_t
+raptor_compress_iostream_produce(raptor_compress_iostream_context* con,
+                                 unsigned char* out, size_t total)
+{
+  size_t out_len = 0;
+
+  while(out_len < total && !con->stream_end && !con->failed) {
+    size_t before_pos;
+    size_t len;
+    int member_end;
+
+    if(con->compression == RAPTOR_COMPRESSION_NONE &&
+       con->buffer_pos == con->buffer_len && !con->handle_eof) {
+      /* uncompressed data is read straight into the output */
+      size_t want = total - out_len;
+
+      len = fread(out + out_len, 1, want, con->handle);
+      out_len += len;
+      if(len < want) {
+        con->handle_eof = 1;
+        con->member_end = 1;
+        if(ferror(con->handle))
+          raptor_compress_iostream_error(con, "read", "I/O error");
+      }
+      continue;
+    }
+
+    raptor_compress_iostream_fill(con);
+    if(con->failed)
+      break;
+
+    if(con->buffer_pos == con->buffer_len && con->handle_eof) {
+      if(con->member_end) {
+        con->stream_end = 1;
+        break;
+      }
+    }
+
+    before_pos = con->buffer_pos;
+    len = raptor_compress_iostream_inflate(con, out + out_len,
+                                           total - out_len, &member_end);
+    if(con->failed)
+      break;
+    out_len += len;
+
+    if(member_end)
+      con->member_end = 1;
+    else if(con->buffer_pos != before_pos)
+      con->member_end = 0;
+
+    if(!member_end && !len && con->buffer_pos == before_pos &&
+       con->buffer_pos == con->buffer_len && con->handle_eof) {
+      raptor_compress_iostream_error(con, "decompression",
+                                     "truncated input");
+      break;
+    }
+  }
+
+  return out_len;
+}
+
+
+#ifdef HAVE_PTHREAD
+static void*
+raptor_compress_iostream_read_ahead_worker(void* arg)
+{
+  raptor_compress_iostream_context* con;
+  int orphaned;
+
+  con = (raptor_compress_iostream_context*)arg;
+
+  pthread_mutex_lock(&con->lock);
+  while(1) {
+    raptor_compress_block* block;
+
+    while(con->full_count == RAPTOR_COMPRESS_READ_AHEAD_BLOCKS && !con->stop)
+      pthread_cond_wait(&con->block_free, &con->lock);
+    if(con->stop)
+      break;
+    block = &con->blocks[con->produce_index];
+    pthread_mutex_unlock(&con->lock);
+
+    block->len = raptor_compress_iostream_produce(con, block->data,
+                                                  RAPTOR_COMPRESS_READ_AHEAD_BLOCK_SIZE);
+    block->failed = con->failed;
+    block->last = (con->failed || con->stream_end);
+
+    pthread_mutex_lock(&con->lock);
+    con->produce_index = (con->produce_index + 1) % RAPTOR_COMPRESS_READ_AHEAD_BLOCKS;
+    con->full_count++;
+    pthread_cond_signal(&con->block_full);
+    if(block->last)
+      break;
+  }
+  con->worker_done = 1;
+  orphaned = con->orphaned;
+  pthread_mutex_unlock(&con->lock);
+
+  /* once done is set and the lock released, only an orphaned worker
+   * may touch the context
+   */
+  if(orphaned) {
+    raptor_compress_iostream_free_read_ahead(con);
+    raptor_free_compress_iostream_context(con);
+  }
+
+  return NULL;
+}
+
+
+/* Consume blocks produced by the read-ahead worker */
+static int
+raptor_compress_iostream_read_ahead_bytes(raptor_compress_iostream_context* con,
+                                          unsigned char* out, size_t total)
+{
+  size_t out_len = 0;
+
+  if(con->consume_failed)
+    return -1;
+
+  while(out_len < total && !con->consume_end) {
+    raptor_compress_block* block = &con->blocks[con->consume_index];
+    size_t len;
+
+    if(!con->consume_held) {
+      pthread_mutex_lock(&con->lock);
+      while(!con->full_count)
+        pthread_cond_wait(&con->block_full, &con->lock);
+      pthread_mutex_unlock(&con->lock);
+      con->consume_held = 1;
+      con->consume_pos = 0;
+    }
+
+    len = block->len - con->consume_pos;
+    if(len > total - out_len)
+      len = total - out_len;
+    memcpy(out + out_len, block->data + con->consume_pos, len);
+    con->consume_pos += len;
+    out_len += len;
+
+    if(con->consume_pos < block->len)
+      continue;
+
+    if(block->failed) {
+      /* the worker has finished so its error fields are stable */
+      con->consume_failed = 1;
+      raptor_compress_iostream_report(con);
+      return -1;
+    }
+    if(block->last) {
+      con->consume_end = 1;
+      break;
+    }
+
+    pthread_mutex_lock(&con->lock);
+    con->consume_index = (con->consume_index + 1) % RAPTOR_COMPRESS_READ_AHEAD_BLOCKS;
+    con->full_count--;
+    pthread_cond_signal(&con->block_free);
+    pthread_mutex_unlock(&con->lock);
+    con->consume_held = 0;
+  }
+
+  return RAPTOR_BAD_CAST(int, out_len);
+}
+
+
+/*
+ * raptor_compress_iostream_start_read_ahead:
+ * @con: context
+ *
+ * INTERNAL - Start the read-ahead worker thread
+ *
+ * On failure reading continues on the calling thread.
+ */
+static void
+raptor_compress_iostream_start_read_ahead(raptor_compress_iostream_context* con)
+{
+  int i;
+
+  for(i = 0; i < RAPTOR_COMPRESS_READ_AHEAD_BLOCKS; i++) {
+    con->blocks[i].data = RAPTOR_MALLOC(unsigned char*,
+                                        RAPTOR_COMPRESS_READ_AHEAD_BLOCK_SIZE);
+    if(!con->blocks[i].data)
+      goto failed;
+  }
+
+  if(pthread_mutex_init(&con->lock, NULL))
+    goto failed;
+  if(pthread_cond_init(&con->block_full, NULL)) {
+    pthread_mutex_destroy(&con->lock);
+    goto failed;
+  }
+  if(pthread_cond_init(&con->block_free, NULL)) {
+    pthread_cond_destroy(&con->block_full);
+    pthread_mutex_destroy(&con->lock);
+    goto failed;
+  }
+
+  if(pthread_create(&con->thread, NULL,
+                    raptor_compress_iostream_read_ahead_worker, con)) {
+    pthread_cond_destroy(&con->block_free);
+    pthread_cond_destroy(&con->block_full);
+    pthread_mutex_destroy(&con->lock);
+    goto failed;
+  }
+
+  con->read_ahead = 1;
+  return;
+
+  failed:
+  for(i = 0; i < RAPTOR_COMPRESS_READ_AHEAD_BLOCKS; i++) {
+    if(con->blocks[i].data) {
+      RAPTOR_FREE(char*, con->blocks[i].data);
+      con->blocks[i].data = NULL;
+    }
+  }
+}
+#endif
+
+
+static int
+raptor_compress_iostream_read_bytes(void *user_data,
+                                    void *ptr, size_t size, size_t nmemb)
+{
+  raptor_compress_iostream_context* con;
+  size_t len;
+
+  con = (raptor_compress_iostream_context*)user_data;
+
+#ifdef HAVE_PTHREAD
+  if(con->read_ahead) {
+    int count = raptor_compress_iostream_read_ahead_bytes(con,
+                                                          (unsigned char*)ptr,
+                                                          size * nmemb);
+    return (count < 0) ? count : RAPTOR_BAD_CAST(int, RAPTOR_GOOD_CAST(size_t, count) / size);
+  }
+#endif
+
+  if(con->failed)
+    return -1;
+
+  len = raptor_compress_iostream_produce(con, (unsigned char*)ptr, size * nmemb);
+  if(con->failed) {
+    raptor_compress_iostream_report(con);
+    return -1;
+  }
+
+  return RAPTOR_BAD_CAST(int, len / size);
+}
+
+
+static int
+raptor_compress_iostream_read_eof(void *user_data)
+{
+  raptor_compress_iostream_context* con;
+
+  con = (raptor_compress_iostream_context*)user_data;
+#ifdef HAVE_PTHREAD
+  if(con->read_ahead)
+    return con->consume_end || con->consume_failed;
+#endif
+  return con->stream_end || con->failed;
+}
+
+
+static const raptor_iostream_handler raptor_iostream_read_compress_handler = {
+  /* .version     = */ 2,
+  /* .init        = */ NULL,
+  /* .finish      = */ raptor_compress_iostream_read_finish,
+  /* .write_byte  = */ NULL,
+  /* .write_bytes = */ NULL,
+  /* .write_end   = */ NULL,
+  /* .read_bytes  = */ raptor_compress_iostream_read_bytes,
+  /* .read_eof    = */ raptor_compress_iostream_read_eof
+};
+
+
+static raptor_iostream*
+raptor_new_iostream_from_handle_compressed_internal(raptor_world *world,
+                                                    FILE *handle,
+                                                    int close_handle,
+                                                    raptor_compression compression)
+{
+  raptor_compress_iostream_context* con;
+  raptor_iostream* iostr;
+
+  con = RAPTOR_CALLOC(raptor_compress_iostream_context*, 1, sizeof(*con));
+  if(!con) {
+    if(close_handle)
+      fclose(handle);
+    return NULL;
+  }
+  con->world = world;
+  con->handle = handle;
+  con->close_handle = close_handle;
+  con->compression = compression;
+#if defined(HAVE_SYS_STAT_H) && defined(HAVE_UNISTD_H)
+  if(1) {
+    struct stat buf;
+
+    con->regular = (!fstat(fileno(handle), &buf) && S_ISREG(buf.st_mode));
+  }
+#endif
+
+  con->buffer = RAPTOR_MALLOC(unsigned char*, RAPTOR_COMPRESS_BUFFER_SIZE);
+  if(!con->buffer)
+    goto failed;
+
+  /* The first block is read now so that the compression can be
+   * sniffed without needing to seek or push back on the handle.
+   */
+  raptor_compress_iostream_fill(con);
+  if(con->failed) {
+    raptor_compress_iostream_report(con);
+    goto failed;
+  }
+
+  if(con->compression == RAPTOR_COMPRESSION_AUTO)
+    con->compression = raptor_compression_sniff(con->buffer, con->buffer_len);
+
+  if(!raptor_compression_is_supported(con->compression)) {
+    raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                               "%s compressed input is not supported",
+                               raptor_compression_names[con->compression]);
+    goto failed;
+  }
+
+#ifdef HAVE_ZLIB
+  if(con->compression == RAPTOR_COMPRESSION_GZIP) {
+    /* 16 + MAX_WBITS: gzip wrapper only */
+    if(inflateInit2(&con->zs, 16 + MAX_WBITS) != Z_OK)
+      goto failed;
+    con->zs_init = 1;
+  }
+#endif
+#ifdef HAVE_ZSTD
+  if(con->compression == RAPTOR_COMPRESSION_ZSTD) {
+    con->zds = ZSTD_createDStream();
+    if(!con->zds || ZSTD_isError(ZSTD_initDStream(con->zds)))
+      goto failed;
+  }
+#endif
+
+#ifdef HAVE_PTHREAD
+  /* Read ahead from regular files unless small uncompressed input was
+   * read entirely in the first block.  Pipes and terminals are read
+   * on demand so that interactive input is not held up, except to
+   * decompress from a handle opened here.  Not worth a thread when
+   * there is no other CPU to run it.
+   */
+  if((con->regular ?
+      !(con->handle_eof && con->compression == RAPTOR_COMPRESSION_NONE) :
+      (con->close_handle && con->compression != RAPTOR_COMPRESSION_NONE))
+#if defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+     && sysconf(_SC_NPROCESSORS_ONLN) > 1
+#endif
+     )
+    raptor_compress_iostream_start_read_ahead(con);
+#endif
+
+  iostr = raptor_new_iostream_from_handler(world, con,
+                                           &raptor_iostream_read_compress_handler);
+  if(!iostr)
+    goto failed;
+
+  return iostr;
+
+  failed:
+  raptor_compress_iostream_read_finish(con);
+  return NULL;
+}
+
+
+/**
+ * raptor_new_iostream_from_file_handle_compressed:
+ * @world: raptor world
+ * @handle: Input file_handle to read compressed data from
+ * @compression: compression method or #RAPTOR_COMPRESSION_AUTO
+ *
+ * Constructor - create a new iostream decompressing from a file_handle.
+ *
+ * With #RAPTOR_COMPRESSION_AUTO the method is detected from the
+ * leading magic bytes and data that is not recognised is read
+ * unchanged.  Compressed data is read from @handle in large blocks.
+ *
+ * When Raptor is built with thread support, more than one CPU is
+ * available and @handle is a regular file, reading and decompressing
+ * runs ahead on a separate thread so @handle must not be used
+ * elsewhere until the iostream is freed.  Pipes and terminals are
+ * only read when data is asked for.
+ *
+ * The @handle must already be open for reading.
+ * NOTE: This does not fclose the @handle when it is finished.
+ *
+ * Return value: new #raptor_iostream object or NULL on failure
+ **/
+raptor_iostream*
+raptor_new_iostream_from_file_handle_compressed(raptor_world *world,
+                                                FILE *handle,
+                                                raptor_compression compression)
+{
+  RAPTOR_CHECK_CONSTRUCTOR_WORLD(world);
+
+  if(!handle || compression > RAPTOR_COMPRESSION_LAST)
+    return NULL;
+
+  raptor_world_open(world);
+
+  return raptor_new_iostream_from_handle_compressed_internal(world, handle, 0,
+                                                             compression);
+}
+
+
+/**
+ * raptor_new_iostream_from_filename_compressed:
+ * @world: raptor world
+ * @filename: Input filename to open and read compressed data from
+ * @compression: compression method or #RAPTOR_COMPRESSION_AUTO
+ *
+ * Constructor - create a new iostream decompressing from a filename.
+ *
+ * With #RAPTOR_COMPRESSION_AUTO the method is detected from the
+ * leading magic bytes, which works whatever the filename extension,
+ * and data that is not recognised is read unchanged.
+ * Reading and decompressing may run ahead on a separate thread as
+ * described in raptor_new_iostream_from_file_handle_compressed()
+ * and also does so for compressed data from a pipe.  Freeing the
+ * iostream does not wait for a pipe read that is still blocked;
+ * the file is closed once that read returns.
+ *
+ * Return value: new #raptor_iostream object or NULL on failure
+ **/
+raptor_iostream*
+raptor_new_iostream_from_filename_compressed(raptor_world *world,
+                                             const char *filename,
+                                             raptor_compression compression)
+{
+  FILE *handle;
+
+  RAPTOR_CHECK_CONSTRUCTOR_WORLD(world);
+
+  if(!filename || compression > RAPTOR_COMPRESSION_LAST)
+    return NULL;
+
+  raptor_world_open(world);
+
+  handle = fopen(filename, "rb");
+  if(!handle)
+    return NULL;
+
+  return raptor_new_iostream_from_handle_compressed_internal(world, handle, 1,
+                                                             compression);
+}
+
+
+/* Local handlers for writing compressed data */
+
+/* Write out the pending compressed output */
+static int
+raptor_compress_iostream_flush(raptor_compress_iostream_context* con)
+{
+  if(con->buffer_len) {
+    if(fwrite(con->buffer, 1, con->buffer_len, con->handle) != con->buffer_len) {
+      raptor_compress_iostream_error(con, "write", "I/O error");
+      return 1;
+    }
+    con->buffer_len = 0;
+  }
+  return 0;
+}
+
+
+/*
+ * raptor_compress_iostream_deflate:
+ * @con: context
+ * @ptr: input data
+ * @len: length of @ptr
+ * @end: non-0 to finish the compressed stream
+ *
+ * INTERNAL - Compress data into the output buffer, flushing it as it fills
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_compress_iostream_deflate(raptor_compress_iostream_context* con,
+                                 const unsigned char* ptr, size_t len,
+                                 int end)
+{
+  switch(con->compression) {
+#ifdef HAVE_ZLIB
+    case RAPTOR_COMPRESSION_GZIP:
+      con->zs.next_in = (Bytef*)ptr;
+      con->zs.avail_in = RAPTOR_GOOD_CAST(uInt, len);
+      while(1) {
+        int zrc;
+
+        con->zs.next_out = con->buffer + con->buffer_len;
+        con->zs.avail_out = RAPTOR_GOOD_CAST(uInt, RAPTOR_COMPRESS_BUFFER_SIZE - con->buffer_len);
+        zrc = deflate(&con->zs, end ? Z_FINISH : Z_NO_FLUSH);
+        con->buffer_len = RAPTOR_COMPRESS_BUFFER_SIZE - con->zs.avail_out;
+
+        if(zrc == Z_STREAM_ERROR) {
+          raptor_compress_iostream_error(con, "compression", con->zs.msg);
+          return 1;
+        }
+
+        if(con->buffer_len == RAPTOR_COMPRESS_BUFFER_SIZE) {
+          if(raptor_compress_iostream_flush(con))
+            return 1;
+          continue;
+        }
+
+        /* output space remains so all input was consumed */
+        if(!end || zrc == Z_STREAM_END)
+          break;
+      }
+      return 0;
+#endif
+
+#ifdef HAVE_ZSTD
+    case RAPTOR_COMPRESSION_ZSTD:
+    {
+      ZSTD_inBuffer in;
+
+      in.src = ptr;
+      in.size = len;
+      in.pos = 0;
+      while(1) {
+        ZSTD_outBuffer out;
+        size_t zrc;
+
+        out.dst = con->buffer;
+        out.size = RAPTOR_COMPRESS_BUFFER_SIZE;
+        out.pos = con->buffer_len;
+        zrc = ZSTD_compressStream2(con->zcs, &out, &in,
+                                   end ? ZSTD_e_end : ZSTD_e_continue);
+        con->buffer_len = out.pos;
+
+        if(ZSTD_isError(zrc)) {
+          raptor_compress_iostream_error(con, "compression",
+                                         ZSTD_getErrorName(zrc));
+          return 1;
+        }
+
+        if(con->buffer_len == RAPTOR_COMPRESS_BUFFER_SIZE) {
+          if(raptor_compress_iostream_flush(con))
+            return 1;
+          continue;
+        }
+
+        if(end ? !zrc : (in.pos == in.size))
+          break;
+      }
+      return 0;
+    }
+#endif
+
+    case RAPTOR_COMPRESSION_NONE:
+    case RAPTOR_COMPRESSION_AUTO:
+    default:
+      if(len && fwrite(ptr, 1, len, con->handle) != len) {
+        raptor_compress_iostream_error(con, "write", "I/O error");
+        return 1;
+      }
+      return 0;
+  }
+}
+
+
+static int
+raptor_compress_iostream_write_end(void *user_data)
+{
+  raptor_compress_iostream_context* con;
+  int rc = 0;
+
+  con = (raptor_compress_iostream_context*)user_data;
+  if(con->stream_end)
+    return con->failed;
+  con->stream_end = 1;
+
+  if(!con->failed) {
+    if(!raptor_compress_iostream_deflate(con, NULL, 0, 1))
+      raptor_compress_iostream_flush(con);
+    raptor_compress_iostream_report(con);
+  }
+  rc = con->failed;
+  if(fflush(con->handle))
+    rc = 1;
+
+  return rc;
+}
+
+
+static void
+raptor_compress_iostream_write_finish(void *user_data)
+{
+  raptor_compress_iostream_context* con;
+
+  con = (raptor_compress_iostream_context*)user_data;
+
+  /* raptor_free_iostream() does not end the stream so the compressed
+   * stream trailer is written here if necessary
+   */
+  raptor_compress_iostream_write_end(con);
+
+  raptor_free_compress_iostream_context(con);
+}
+
+
+static int
+raptor_compress_iostream_write_bytes(void *user_data,
+                                     const void *ptr, size_t size, size_t nmemb)
+{
+  raptor_compress_iostream_context* con;
+
+  con = (raptor_compress_iostream_context*)user_data;
+  if(con->failed || con->stream_end)
+    return 0;
+
+  if(raptor_compress_iostream_deflate(con, (const unsigned char*)ptr,
+                                      size * nmemb, 0)) {
+    raptor_compress_iostream_report(con);
+    return 0;
+  }
+
+  return RAPTOR_BAD_CAST(int, nmemb);
+}
+
+
+static int
+raptor_compress_iostream_write_byte(void *user_data, const int byte)
+{
+  unsigned char c = RAPTOR_GOOD_CAST(unsigned char, byte);
+
+  return (raptor_compress_iostream_write_bytes(user_data, &c, 1, 1) != 1);
+}
+
+
+static const raptor_iostream_handler raptor_iostream_write_compress_handler = {
+  /* .version     = */ 2,
+  /* .init        = */ NULL,
+  /* .finish      = */ raptor_compress_iostream_write_finish,
+  /* .write_byte  = */ raptor_compress_iostream_write_byte,
+  /* .write_bytes = */ raptor_compress_iostream_write_bytes,
+  /* .write_end   = */ raptor_compress_iostream_write_end,
+  /* .read_bytes  = */ NULL,
+  /* .read_eof    = */ NULL
+};
+
+
+static raptor_iostream*
+raptor_new_iostream_to_handle_compressed_internal(raptor_world *world,
+                                                  FILE *handle,
+                                                  int close_handle,
+                                                  raptor_compression compression)
+{
+  raptor_compress_iostream_context* con;
+  raptor_iostream* iostr;
+
+  if(!raptor_compression_is_supported(compression)) {
+    raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                               "%s compressed output is not supported",
+                               raptor_compression_names[compression]);
+    if(close_handle)
+      fclose(handle);
+    return NULL;
+  }
+
+  con = RAPTOR_CALLOC(raptor_compress_iostream_context*, 1, sizeof(*con));
+  if(!con) {
+    if(close_handle)
+      fclose(handle);
+    return NULL;
+  }
+  con->world = world;
+  con->handle = handle;
+  con->close_handle = close_handle;
+  con->compression = compression;
+  con->writing = 1;
+
+  con->buffer = RAPTOR_MALLOC(unsigned char*, RAPTOR_COMPRESS_BUFFER_SIZE);
+  if(!con->buffer)
+    goto failed;
+
+#ifdef HAVE_ZLIB
+  if(compression == RAPTOR_COMPRESSION_GZIP) {
+    /* 16 + MAX_WBITS: write a gzip wrapper */
+    if(deflateInit2(&con->zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                    16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+      goto failed;
+    con->zs_init = 1;
+  }
+#endif
+#ifdef HAVE_ZSTD
+  if(compression == RAPTOR_COMPRESSION_ZSTD) {
+    con->zcs = ZSTD_createCStream();
+    if(!con->zcs ||
+       ZSTD_isError(ZSTD_CCtx_setParameter(con->zcs, ZSTD_c_compressionLevel,
+                                           ZSTD_CLEVEL_DEFAULT)))
+      goto failed;
+  }
+#endif
+
+  iostr = raptor_new_iostream_from_handler(world, con,
+                                           &raptor_iostream_write_compress_handler);
+  if(!iostr)
+    goto failed;
+
+  return iostr;
+
+  failed:
+  raptor_free_compress_iostream_context(con);
+  return NULL;
+}
+
+
+/**
+ * raptor_new_iostream_to_file_handle_compressed:
+ * @world: raptor world
+ * @handle: Output file_handle to write compressed data to
+ * @compression: compression method
+ *
+ * Constructor - create a new iostream compressing to a file_handle.
+ *
+ * Compressed data is written to @handle in large blocks and the
+ * compressed stream is completed by raptor_iostream_write_end() or
+ * when the iostream is freed.  #RAPTOR_COMPRESSION_AUTO writes
+ * uncompressed data since there is no filename to use.
+ *
+ * The @handle must already be open for writing.
+ * NOTE: This does not fclose the @handle when it is finished.
+ *
+ * Return value: new #raptor_iostream object or NULL on failure
+ **/
+raptor_iostream*
+raptor_new_iostream_to_file_handle_compressed(raptor_world *world,
+                                              FILE *handle,
+                                              raptor_compression compression)
+{
+  RAPTOR_CHECK_CONSTRUCTOR_WORLD(world);
+
+  if(!handle || compression > RAPTOR_COMPRESSION_LAST)
+    return NULL;
+
+  raptor_world_open(world);
+
+  if(compression == RAPTOR_COMPRESSION_AUTO)
+    compression = RAPTOR_COMPRESSION_NONE;
+
+  return raptor_new_iostream_to_handle_compressed_internal(world, handle, 0,
+                                                           compression);
+}
+
+
+/**
+ * raptor_new_iostream_to_filename_compressed:
+ * @world: raptor world
+ * @filename: Output filename to open and write compressed data to
+ * @compression: compression method or #RAPTOR_COMPRESSION_AUTO
+ *
+ * Constructor - create a new iostream compressing to a filename.
+ *
+ * With #RAPTOR_COMPRESSION_AUTO the method is chosen from the
+ * filename extension: .gz for gzip, .zst or .zstd for Zstandard and
+ * otherwise no compression.
+ *
+ * Return value: new #raptor_iostream object or NULL on failure
+ **/
+raptor_iostream*
+raptor_new_iostream_to_filename_compressed(raptor_world *world,
+                                           const char *filename,
+                                           raptor_compression compression)
+{
+  FILE *handle;
+
+  RAPTOR_CHECK_CONSTRUCTOR_WORLD(world);
+
+  if(!filename || compression > RAPTOR_COMPRESSION_LAST)
+    return NULL;
+
+  raptor_world_open(world);
+
+  if(compression == RAPTOR_COMPRESSION_AUTO)
+    compression = raptor_compression_from_filename(filename);
+
+  if(!raptor_compression_is_supported(compression)) {
+    raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                               "%s compressed output is not supported",
+                               raptor_compression_names[compression]);
+    return NULL;
+  }
+
+  handle = fopen(filename, "wb");
+  if(!handle)
+    return NULL;
+
+  return raptor_new_iostream_to_handle_compressed_internal(world, handle, 1,
+                                                           compression);
+}
+
+
+/* end not STANDALONE */
+#endif
+
+
+
+#ifdef STANDALONE
+
+#if defined(HAVE_PTHREAD) && defined(HAVE_ZLIB) && defined(HAVE_SYS_STAT_H) && defined(HAVE_FCNTL_H)
+#define TEST_PIPE 1
+#include <fcntl.h>
+#include <signal.h>
+#endif
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+static const char *program;
+
+#define TEST_STRING_REPEAT 20000
+
+static const char* const test_line =
+  "<http://example.org/subject> <http://example.org/predicate> \"object\" .\n";
+
+
+static int
+test_round_trip(raptor_world *world, const char* filename,
+                raptor_compression compression,
+                const unsigned char* data, size_t data_len)
+{
+  raptor_iostream *iostr;
+  unsigned char* buffer = NULL;
+  unsigned char magic[4];
+  size_t magic_len;
+  size_t read_len = 0;
+  FILE* fh;
+  int rc = 1;
+
+  iostr = raptor_new_iostream_to_filename_compressed(world, filename,
+                                                     compression);
+  if(!iostr) {
+    fprintf(stderr, "%s: Failed to create %s write iostream to '%s'\n",
+            program, raptor_compression_names[compression], filename);
+    return 1;
+  }
+  raptor_iostream_write_bytes(data, 1, data_len, iostr);
+  raptor_free_iostream(iostr);
+
+  /* the written data must be compressed when asked for */
+  fh = fopen(filename, "rb");
+  if(!fh) {
+    fprintf(stderr, "%s: Failed to read back '%s'\n", program, filename);
+    return 1;
+  }
+  magic_len = fread(magic, 1, 4, fh);
+  fclose(fh);
+  if(compression != RAPTOR_COMPRESSION_AUTO &&
+     raptor_compression_sniff(magic, magic_len) != compression) {
+    fprintf(stderr, "%s: '%s' is not %s compressed\n", program, filename,
+            raptor_compression_names[compression]);
+    return 1;
+  }
+
+  iostr = raptor_new_iostream_from_filename_compressed(world, filename,
+                                                       RAPTOR_COMPRESSION_AUTO);
+  if(!iostr) {
+    fprintf(stderr, "%s: Failed to create read iostream from '%s'\n",
+            program, filename);
+    return 1;
+  }
+
+  buffer = RAPTOR_MALLOC(unsigned char*, data_len + 1);
+  if(!buffer)
+    goto tidy;
+
+  /* read in odd sized pieces to cross the internal block boundaries */
+  while(!raptor_iostream_read_eof(iostr)) {
+    int count;
+    size_t want = 1000 + (read_len % 7919);
+
+    if(read_len + want > data_len + 1)
+      want = data_len + 1 - read_len;
+    count = raptor_iostream_read_bytes(buffer + read_len, 1, want, iostr);
+    if(count < 0) {
+      fprintf(stderr, "%s: Reading '%s' failed\n", program, filename);
+      goto tidy;
+    }
+    read_len += RAPTOR_GOOD_CAST(size_t, count);
+    if(read_len > data_len)
+      break;
+  }
+
+  if(read_len != data_len || memcmp(buffer, data, data_len)) {
+    fprintf(stderr, "%s: Read %d bytes from '%s', expected %d\n",
+            program, (int)read_len, filename, (int)data_len);
+    goto tidy;
+  }
+
+  rc = 0;
+
+  tidy:
+  if(buffer)
+    RAPTOR_FREE(char*, buffer);
+  raptor_free_iostream(iostr);
+  remove(filename);
+
+  return rc;
+}
+
+
+static int
+test_truncated(raptor_world *world, const char* filename,
+               raptor_compression compression,
+               const unsigned char* data, size_t data_len)
+{
+  raptor_iostream *iostr;
+  unsigned char buffer[4096];
+  unsigned char compressed[65536];
+  FILE* fh;
+  size_t size;
+  int count = 0;
+
+  iostr = raptor_new_iostream_to_filename_compressed(world, filename,
+                                                     compression);
+  if(!iostr)
+    return 1;
+  raptor_iostream_write_bytes(data, 1, data_len, iostr);
+  raptor_free_iostream(iostr);
+
+  /* cut off the end of the compressed stream */
+  fh = fopen(filename, "rb");
+  if(!fh)
+    return 1;
+  size = fread(compressed, 1, sizeof(compressed), fh);
+  fclose(fh);
+  fh = fopen(filename, "wb");
+  if(!fh || size < 8 || size == sizeof(compressed)) {
+    if(fh)
+      fclose(fh);
+    remove(filename);
+    return 1;
+  }
+  fwrite(compressed, 1, size - 8, fh);
+  fclose(fh);
+
+  iostr = raptor_new_iostream_from_filename_compressed(world, filename,
+                                                       compression);
+  if(!iostr) {
+    remove(filename);
+    return 1;
+  }
+  while(!raptor_iostream_read_eof(iostr)) {
+    count = raptor_iostream_read_bytes(buffer, 1, sizeof(buffer), iostr);
+    if(count < 0)
+      break;
+  }
+  raptor_free_iostream(iostr);
+  remove(filename);
+
+  if(count >= 0) {
+    fprintf(stderr, "%s: Reading truncated %s '%s' did not fail\n", program,
+            raptor_compression_names[compression], filename);
+    return 1;
+  }
+
+  return 0;
+}
+
+
+/* Free a read iostream after a short read, while any read-ahead is
+ * still pending, which must neither hang nor leak.
+ */
+static int
+test_early_free(raptor_world *world, const char* filename,
+                raptor_compression compression,
+                const unsigned char* data, size_t data_len)
+{
+  raptor_iostream *iostr;
+  unsigned char buffer[100];
+  int count;
+
+  iostr = raptor_new_iostream_to_filename_compressed(world, filename,
+                                                     compression);
+  if(!iostr)
+    return 1;
+  raptor_iostream_write_bytes(data, 1, data_len, iostr);
+  raptor_free_iostream(iostr);
+
+  iostr = raptor_new_iostream_from_filename_compressed(world, filename,
+                                                       RAPTOR_COMPRESSION_AUTO);
+  if(!iostr) {
+    remove(filename);
+    return 1;
+  }
+  count = raptor_iostream_read_bytes(buffer, 1, sizeof(buffer), iostr);
+  raptor_free_iostream(iostr);
+  remove(filename);
+
+  if(count != (int)sizeof(buffer) || memcmp(buffer, data, sizeof(buffer))) {
+    fprintf(stderr, "%s: Short read from %s '%s' failed\n", program,
+            raptor_compression_names[compression], filename);
+    return 1;
+  }
+
+  return 0;
+}
+
+
+#ifdef TEST_PIPE
+typedef struct
+{
+  /* FIFO to open for writing or NULL to write to fd */
+  const char* fifo;
+  int fd;
+  const unsigned char* data;
+  size_t len;
+  /* the writer keeps its end open until this can be read */
+  int release_fd;
+} test_pipe_writer;
+
+
+static void*
+test_pipe_writer_run(void* arg)
+{
+  test_pipe_writer* writer = (test_pipe_writer*)arg;
+  int fd = writer->fd;
+  size_t offset = 0;
+  char c;
+
+  if(writer->fifo)
+    fd = open(writer->fifo, O_WRONLY);
+  if(fd < 0)
+    return NULL;
+
+  while(offset < writer->len) {
+    ssize_t count = write(fd, writer->data + offset, writer->len - offset);
+    if(count <= 0)
+      break;
+    offset += RAPTOR_GOOD_CAST(size_t, count);
+  }
+
+  /* stay open like a producer that has paused */
+  if(read(writer->release_fd, &c, 1) < 0)
+    c = 0;
+  close(fd);
+
+  return NULL;
+}
+
+
+/* Read a little of a gzip stream from a pipe whose writer pauses
+ * without closing it, then free the iostream.  Freeing must not wait
+ * for a read that only returns when the writer closes the pipe.
+ * With @use_fifo the pipe is a FIFO opened by filename, otherwise an
+ * anonymous pipe passed as a file handle.
+ */
+static int
+test_pipe_early_free(raptor_world *world, const char* filename,
+                     int use_fifo)
+{
+  raptor_iostream *iostr = NULL;
+  unsigned char* data = NULL;
+  unsigned char* compressed = NULL;
+  size_t data_len = 1048576;
+  size_t compressed_len;
+  unsigned char buffer[100];
+  unsigned int seed = 1;
+  test_pipe_writer writer;
+  pthread_t thread;
+  int pipe_fds[2] = { -1, -1 };
+  int release_fds[2] = { -1, -1 };
+  FILE* fh = NULL;
+  int count = -1;
+  size_t i;
+  int rc = 1;
+
+  /* text that compresses little, so that the first 256k read ahead
+   * needs much more than one 64k read from the pipe
+   */
+  data = RAPTOR_MALLOC(unsigned char*, data_len);
+  if(!data)
+    return 1;
+  for(i = 0; i < data_len; i++) {
+    seed = seed * 1103515245U + 12345U;
+    data[i] = (i % 72 == 71) ? '\n' :
+      RAPTOR_GOOD_CAST(unsigned char, 'a' + ((seed >> 16) % 26));
+  }
+
+  /* a FIFO left by an earlier run would block opening it to write */
+  remove(filename);
+  iostr = raptor_new_iostream_to_filename_compressed(world, filename,
+                                                     RAPTOR_COMPRESSION_GZIP);
+  if(!iostr)
+    goto tidy;
+  raptor_iostream_write_bytes(data, 1, data_len, iostr);
+  raptor_free_iostream(iostr);
+  iostr = NULL;
+
+  compressed = RAPTOR_MALLOC(unsigned char*, data_len);
+  fh = fopen(filename, "rb");
+  if(!compressed || !fh)
+    goto tidy;
+  compressed_len = fread(compressed, 1, data_len, fh);
+  fclose(fh);
+  fh = NULL;
+  remove(filename);
+
+  /* write the part holding about the first 384k of text */
+  writer.data = compressed;
+  writer.len = compressed_len / 8 * 3;
+  writer.fifo = NULL;
+  writer.fd = -1;
+
+  if(pipe(release_fds))
+    goto tidy;
+  writer.release_fd = release_fds[0];
+
+  if(use_fifo) {
+    if(mkfifo(filename, 0600))
+      goto tidy;
+    writer.fifo = filename;
+  } else {
+    if(pipe(pipe_fds))
+      goto tidy;
+    writer.fd = pipe_fds[1];
+  }
+
+  if(pthread_create(&thread, NULL, test_pipe_writer_run, &writer))
+    goto tidy;
+
+  /* fail rather than hang */
+  alarm(60);
+
+  if(use_fifo)
+    iostr = raptor_new_iostream_from_filename_compressed(world, filename,
+                                                         RAPTOR_COMPRESSION_AUTO);
+  else {
+    fh = fdopen(pipe_fds[0], "rb");
+    if(fh) {
+      pipe_fds[0] = -1;
+      iostr = raptor_new_iostream_from_file_handle_compressed(world, fh,
+                                                              RAPTOR_COMPRESSION_AUTO);
+    }
+  }
+  if(iostr) {
+    count = raptor_iostream_read_bytes(buffer, 1, sizeof(buffer), iostr);
+    raptor_free_iostream(iostr);
+    iostr = NULL;
+  }
+  if(fh) {
+    fclose(fh);
+    fh = NULL;
+  }
+
+  alarm(0);
+
+  /* let the writer close its end */
+  close(release_fds[1]);
+  release_fds[1] = -1;
+  pthread_join(thread, NULL);
+
+  if(count != (int)sizeof(buffer) || memcmp(buffer, data, sizeof(buffer))) {
+    fprintf(stderr, "%s: Short read from gzip %s failed\n", program,
+            use_fifo ? "FIFO" : "pipe");
+    goto tidy;
+  }
+
+  rc = 0;
+
+  tidy:
+  if(iostr)
+    raptor_free_iostream(iostr);
+  if(fh)
+    fclose(fh);
+  for(i = 0; i < 2; i++) {
+    if(pipe_fds[i] >= 0)
+      close(pipe_fds[i]);
+    if(release_fds[i] >= 0)
+      close(release_fds[i]);
+  }
+  remove(filename);
+  if(compressed)
+    RAPTOR_FREE(char*, compressed);
+  RAPTOR_FREE(char*, data);
+
+  return rc;
+}
+#endif
+
+
+static void
+test_ignore_log(void *user_data, raptor_log_message *message)
+{
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  raptor_world *world;
+  unsigned char* data;
+  size_t line_len = strlen(test_line);
+  size_t data_len = line_len * TEST_STRING_REPEAT;
+  size_t i;
+  int failures = 0;
+
+  program = raptor_basename(argv[0]);
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  data = RAPTOR_MALLOC(unsigned char*, data_len);
+  if(!data)
+    exit(1);
+  for(i = 0; i < TEST_STRING_REPEAT; i++)
+    memcpy(data + (i * line_len), test_line, line_len);
+  /* vary the content so it is not all one repeated block */
+  for(i = 0; i < data_len; i += 997)
+    data[i] = RAPTOR_GOOD_CAST(unsigned char, 'A' + (i % 26));
+
+  failures += test_round_trip(world, "raptor_compress_test.nt",
+                              RAPTOR_COMPRESSION_AUTO, data, data_len);
+  failures += test_round_trip(world, "raptor_compress_test.nt",
+                              RAPTOR_COMPRESSION_NONE, data, 0);
+
+#ifdef HAVE_ZLIB
+  failures += test_round_trip(world, "raptor_compress_test.nt.gz",
+                              RAPTOR_COMPRESSION_AUTO, data, data_len);
+  failures += test_round_trip(world, "raptor_compress_test.out",
+                              RAPTOR_COMPRESSION_GZIP, data, data_len);
+  failures += test_round_trip(world, "raptor_compress_test.out",
+                              RAPTOR_COMPRESSION_GZIP, data, 0);
+#endif
+#ifdef HAVE_ZSTD
+  failures += test_round_trip(world, "raptor_compress_test.nt.zst",
+                              RAPTOR_COMPRESSION_AUTO, data, data_len);
+  failures += test_round_trip(world, "raptor_compress_test.out",
+                              RAPTOR_COMPRESSION_ZSTD, data, data_len);
+  failures += test_round_trip(world, "raptor_compress_test.out",
+                              RAPTOR_COMPRESSION_ZSTD, data, 0);
+#endif
+
+  failures += test_early_free(world, "raptor_compress_test.nt",
+                              RAPTOR_COMPRESSION_NONE, data, data_len);
+#ifdef HAVE_ZLIB
+  failures += test_early_free(world, "raptor_compress_test.out",
+                              RAPTOR_COMPRESSION_GZIP, data, data_len);
+#endif
+#ifdef HAVE_ZSTD
+  failures += test_early_free(world, "raptor_compress_test.out",
+                              RAPTOR_COMPRESSION_ZSTD, data, data_len);
+#endif
+
+  /* truncated input is reported as an error, not a short read */
+  raptor_world_set_log_handler(world, NULL, test_ignore_log);
+
+#ifdef TEST_PIPE
+  /* the pipe is closed under a writer that has not finished */
+#ifdef SIGPIPE
+  signal(SIGPIPE, SIG_IGN);
+#endif
+  failures += test_pipe_early_free(world, "raptor_compress_test.fifo", 1);
+  failures += test_pipe_early_free(world, "raptor_compress_test.fifo", 0);
+#endif
+#ifdef HAVE_ZLIB
+  failures += test_truncated(world, "raptor_compress_test.out",
+                             RAPTOR_COMPRESSION_GZIP, data, data_len);
+#endif
+#ifdef HAVE_ZSTD
+  failures += test_truncated(world, "raptor_compress_test.out",
+                             RAPTOR_COMPRESSION_ZSTD, data, data_len);
+#endif
+
+  RAPTOR_FREE(char*, data);
+  raptor_free_world(world);
+
+  return failures;
+}
+
+#endif
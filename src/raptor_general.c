@@ -144,6 +144,10 @@ raptor_new_world_internal(unsigned int version_decimal)
                           RAPTOR_WORLD_FLAG_LIBXML_STRUCTURED_ERROR_SAVE ;
     /* set: URI Interning */
     world->uri_interning = 1;
+    /* set: escaped forms of interned URIs kept up to 4M bytes */
+    world->uri_escaped_cache_size = RAPTOR_URI_ESCAPED_CACHE_DEFAULT_SIZE;
+    /* set: up to 16 compiled GRDDL XSLT stylesheets kept */
+    world->grddl_xslt_cache_size = RAPTOR_GRDDL_XSLT_CACHE_DEFAULT_SIZE;
 
     world->internal_ignore_errors = 0;
   }
@@ -476,6 +480,20 @@ raptor_world_set_flag(raptor_world *world, raptor_world_flag flag, int value)
     case RAPTOR_WORLD_FLAG_WWW_SKIP_INIT_FINISH:
       world->www_skip_www_init_finish = value;
       break;
+
+    case RAPTOR_WORLD_FLAG_URI_ESCAPED_CACHE_SIZE:
+      if(value < 0)
+        rc = -2;
+      else
+        world->uri_escaped_cache_size = RAPTOR_GOOD_CAST(size_t, value);
+      break;
+
+    case RAPTOR_WORLD_FLAG_GRDDL_XSLT_CACHE_SIZE:
+      if(value < 0)
+        rc = -2;
+      else
+        world->grddl_xslt_cache_size = value;
+      break;
   }
 
   return rc;
@@ -54,6 +54,8 @@
 /* for xmlXPathRegisterNs() */
 #include <libxml/xpathInternals.h>
 #include <libxml/xinclude.h>
+/* for xmlStringTextNoenc */
+#include <libxml/parserInternals.h>
 #include <libxml/HTMLparser.h>
 
 #include <libxslt/xslt.h>
@@ -400,6 +402,14 @@ raptor_grddl_parse_start(raptor_parser *rdf_parser)
   grddl_parser->content_type_check = 0;
   grddl_parser->process_this_as_rdfxml = 0;
 
+  /* An internal parser kept from an earlier parse holds copies of the
+   * handlers then in use; make a new one with the current handlers */
+  if(grddl_parser->internal_parser) {
+    raptor_free_parser(grddl_parser->internal_parser);
+    grddl_parser->internal_parser = NULL;
+    grddl_parser->internal_parser_name = NULL;
+  }
+
   return 0;
 }
 
@@ -659,20 +669,71 @@ raptor_grddl_ensure_internal_parser(raptor_parser* rdf_parser,
 }
 
 
-/* Run a GRDDL transform using a pre-parsed XSLT stylesheet already
- * formed into a libxml document (with URI)
+#ifdef RAPTOR_PARSER_RDFXML
+/*
+ * Return non-0 if XSLT result @res can be given to the RDF/XML parser
+ * as a tree rather than serialized and parsed again: it is an XML
+ * document with a root element, the output media type is RDF/XML as
+ * worked out below for text results, and no text disables output
+ * escaping, which only has a meaning once serialized.
+ */
+static int
+raptor_grddl_result_is_rdfxml_tree(xsltStylesheetPtr sheet, xmlDocPtr res)
+{
+  const char* method = (const char*)sheet->method;
+  const char* media_type = (const char*)sheet->mediaType;
+  xmlNodePtr node;
+
+  if(res->type != XML_DOCUMENT_NODE || !xmlDocGetRootElement(res))
+    return 0;
+
+  if(method && strcmp(method, "xml"))
+    return 0;
+
+  if(media_type && strcmp(media_type, "application/xml") &&
+     strcmp(media_type, "application/rdf+xml"))
+    return 0;
+
+  node = res->children;
+  while(node) {
+    if(node->type == XML_TEXT_NODE && node->name == xmlStringTextNoenc)
+      return 0;
+
+    if(node->type == XML_ELEMENT_NODE && node->children) {
+      node = node->children;
+      continue;
+    }
+
+    while(!node->next) {
+      node = node->parent;
+      if(!node || node->type != XML_ELEMENT_NODE)
+        return 1;
+    }
+    node = node->next;
+  }
+
+  return 1;
+}
+#endif
+
+
+/* Run a GRDDL transform using a compiled XSLT stylesheet.
+ *
+ * The stylesheet is not changed so it can be kept and used again.
  */
 static int
 raptor_grddl_run_grddl_transform_doc(raptor_parser* rdf_parser,
                                      grddl_xml_context* xml_context,
-                                     xmlDocPtr xslt_doc,
+                                     xsltStylesheetPtr sheet,
                                      xmlDocPtr doc)
 {
   raptor_world* world = rdf_parser->world;
   raptor_grddl_parser_context* grddl_parser;
   int ret = 0;
-  xsltStylesheetPtr sheet = NULL;
   xmlDocPtr res = NULL;
+  xmlChar* saved_method;
+  const char* method;
+  const char* media_type;
   xmlChar *doc_txt = NULL;
   int doc_txt_len = 0;
   const char* parser_name;
@@ -697,15 +758,6 @@ raptor_grddl_run_grddl_transform_doc(raptor_parser* rdf_parser,
   
   raptor_libxslt_set_global_state(rdf_parser);
 
-  /* This calls xsltGetDefaultSecurityPrefs() */
-  sheet = xsltParseStylesheetDoc(xslt_doc);
-  if(!sheet) {
-    raptor_parser_error(rdf_parser, "Failed to parse stylesheet in '%s'",
-                        raptor_uri_as_string(xslt_uri));
-    ret = 1;
-    goto cleanup_xslt;
-  }
-
   /* This calls xsltGetDefaultSecurityPrefs() */
   userCtxt = xsltNewTransformContext(sheet, doc);
 
@@ -751,63 +803,69 @@ raptor_grddl_run_grddl_transform_doc(raptor_parser* rdf_parser,
     goto cleanup_xslt;
   }
 
-  if(res->type == XML_HTML_DOCUMENT_NODE) {
-    if(sheet->method != NULL)
-      xmlFree(sheet->method);
-    sheet->method = (xmlChar*)xmlMalloc(5);
-    memcpy(sheet->method, "html", 5);
+#ifdef RAPTOR_PARSER_RDFXML
+  if(raptor_grddl_result_is_rdfxml_tree(sheet, res)) {
+    /* generate the triples from the result tree directly */
+    ret = raptor_grddl_ensure_internal_parser(rdf_parser, "rdfxml", 0);
+    if(!ret)
+      ret = raptor_parser_parse_start(grddl_parser->internal_parser,
+                                      base_uri);
+    if(!ret)
+      ret = raptor_rdfxml_parse_xml_doc(grddl_parser->internal_parser, res);
+    goto cleanup_xslt;
   }
+#endif
+
+  /* write the resulting XML to a string, as HTML if that was the
+   * result whatever the sheet says */
+  saved_method = sheet->method;
+  if(res->type == XML_HTML_DOCUMENT_NODE)
+    sheet->method = (xmlChar*)"html";
+  method = (const char*)sheet->method;
 
-  /* write the resulting XML to a string */
   xsltSaveResultToString(&doc_txt, &doc_txt_len, res, sheet);
+
+  sheet->method = saved_method;
   
   if(!doc_txt || !doc_txt_len) {
     raptor_parser_warning(rdf_parser, "XSLT returned an empty document");
     goto cleanup_xslt;
   }
 
+  media_type = (const char*)sheet->mediaType;
+
   RAPTOR_DEBUG4("XSLT returned %d bytes document method %s media type %s\n",
                 doc_txt_len,
-                (sheet->method ? (const char*)sheet->method : "NULL"),
-                (sheet->mediaType ? (const char*)sheet->mediaType : "NULL"));
+                (method ? method : "NULL"),
+                (media_type ? media_type : "NULL"));
 
   /* Set mime types for XSLT <xsl:output method> content */
-  if(sheet->mediaType == NULL && sheet->method) {
-    if(!(strcmp((const char*)sheet->method, "text"))) {
-      sheet->mediaType = (xmlChar*)xmlMalloc(11);
-      memcpy(sheet->mediaType, "text/plain",11);
-    } else if(!(strcmp((const char*)sheet->method, "xml"))) {
-      sheet->mediaType = (xmlChar*)xmlMalloc(16);
-      memcpy(sheet->mediaType, "application/xml",16);
-    } else if(!(strcmp((const char*)sheet->method, "html"))) {
-      sheet->mediaType = (xmlChar*)xmlMalloc(10);
-      memcpy(sheet->mediaType, "text/html",10);
-    }
+  if(media_type == NULL && method) {
+    if(!(strcmp(method, "text")))
+      media_type = "text/plain";
+    else if(!(strcmp(method, "xml")))
+      media_type = "application/xml";
+    else if(!(strcmp(method, "html")))
+      media_type = "text/html";
   }
 
   /* Assume all that all media XML is RDF/XML and also that
    * with no information at all we have RDF/XML
    */
-  if(!sheet->mediaType ||
-     (sheet->mediaType &&
-      !strcmp((const char*)sheet->mediaType, "application/xml"))) {
-    if(sheet->mediaType)
-      xmlFree(sheet->mediaType);
-    sheet->mediaType = (xmlChar*)xmlMalloc(20);
-    memcpy(sheet->mediaType, "application/rdf+xml",20);
-  }
+  if(!media_type || !strcmp(media_type, "application/xml"))
+    media_type = "application/rdf+xml";
   
   parser_name = raptor_world_guess_parser_name(rdf_parser->world, NULL,
-                                               (const char*)sheet->mediaType,
+                                               media_type,
                                                doc_txt, doc_txt_len, NULL);
   if(!parser_name) {
     RAPTOR_DEBUG3("Parser %p: Guessed no parser from mime type '%s' and content - ending",
-                  RAPTOR_VOIDP(rdf_parser), sheet->mediaType);
+                  RAPTOR_VOIDP(rdf_parser), media_type);
     goto cleanup_xslt;
   }
   
   RAPTOR_DEBUG4("Parser %p: Guessed parser %s from mime type '%s' and content\n",
-                RAPTOR_VOIDP(rdf_parser), parser_name, sheet->mediaType);
+                RAPTOR_VOIDP(rdf_parser), parser_name, media_type);
 
   if(!strcmp((const char*)parser_name, "grddl")) {
     RAPTOR_DEBUG2("Parser %p: Ignoring guess to run grddl parser - ending",
@@ -841,9 +899,6 @@ raptor_grddl_run_grddl_transform_doc(raptor_parser* rdf_parser,
   if(res)
     xmlFreeDoc(res);
   
-  if(sheet)
-    xsltFreeStylesheet(sheet);
-  
   raptor_libxslt_reset_global_state(rdf_parser);
 
   return ret;
@@ -855,6 +910,8 @@ typedef struct
   raptor_parser* rdf_parser;
   xmlParserCtxtPtr xc;
   raptor_uri* base_uri;
+  /* copy of the bytes to save in the cache directory or NULL */
+  raptor_stringbuffer* sb;
 } raptor_grddl_xml_parse_bytes_context;
   
 
@@ -869,6 +926,11 @@ raptor_grddl_uri_xml_parse_bytes(raptor_www* www,
   
   xpbc = (raptor_grddl_xml_parse_bytes_context*)userdata;
 
+  if(xpbc->sb)
+    raptor_stringbuffer_append_counted_string(xpbc->sb,
+                                              (const unsigned char*)ptr,
+                                              len, 1);
+
   if(!xpbc->xc) {
     xmlParserCtxtPtr xc;
     
@@ -963,6 +1025,299 @@ raptor_grddl_fetch_uri(raptor_parser* rdf_parser,
 }
 
 
+/*
+ * Compiled XSLT stylesheet cache
+ *
+ * Kept in the world by transformation URI, least recently used out
+ * once world->grddl_xslt_cache_size stylesheets are held.
+ */
+typedef struct
+{
+  raptor_uri* uri;
+  xsltStylesheetPtr sheet;
+  unsigned long last_used;
+} raptor_grddl_xslt_cache_entry;
+
+typedef struct
+{
+  raptor_grddl_xslt_cache_entry* entries;
+  int size;
+  int count;
+  unsigned long clock;
+} raptor_grddl_xslt_cache;
+
+
+static xsltStylesheetPtr
+raptor_grddl_xslt_cache_get(raptor_world* world, raptor_uri* uri)
+{
+  raptor_grddl_xslt_cache* cache;
+  int i;
+
+  cache = (raptor_grddl_xslt_cache*)world->grddl_xslt_cache;
+  if(!cache)
+    return NULL;
+
+  for(i = 0; i < cache->count; i++) {
+    raptor_grddl_xslt_cache_entry* entry = &cache->entries[i];
+
+    if(raptor_uri_equals(entry->uri, uri)) {
+      entry->last_used = ++cache->clock;
+      return entry->sheet;
+    }
+  }
+
+  return NULL;
+}
+
+
+/* Keep @sheet for @uri.  Returns non-0 if it was not kept and the
+ * caller still owns it */
+static int
+raptor_grddl_xslt_cache_add(raptor_world* world, raptor_uri* uri,
+                            xsltStylesheetPtr sheet)
+{
+  raptor_grddl_xslt_cache* cache;
+  raptor_grddl_xslt_cache_entry* entry;
+  int i;
+
+  if(world->grddl_xslt_cache_size <= 0)
+    return 1;
+
+  cache = (raptor_grddl_xslt_cache*)world->grddl_xslt_cache;
+  if(!cache) {
+    cache = RAPTOR_CALLOC(raptor_grddl_xslt_cache*, 1, sizeof(*cache));
+    if(!cache)
+      return 1;
+    cache->size = world->grddl_xslt_cache_size;
+    cache->entries = RAPTOR_CALLOC(raptor_grddl_xslt_cache_entry*,
+                                   RAPTOR_GOOD_CAST(size_t, cache->size),
+                                   sizeof(*cache->entries));
+    if(!cache->entries) {
+      RAPTOR_FREE(raptor_grddl_xslt_cache, cache);
+      return 1;
+    }
+    world->grddl_xslt_cache = cache;
+  }
+
+  if(cache->count < cache->size)
+    entry = &cache->entries[cache->count++];
+  else {
+    /* replace the least recently used */
+    entry = &cache->entries[0];
+    for(i = 1; i < cache->count; i++) {
+      if(cache->entries[i].last_used < entry->last_used)
+        entry = &cache->entries[i];
+    }
+
+    RAPTOR_DEBUG2("Dropping compiled XSLT sheet for URI %s\n",
+                  raptor_uri_as_string(entry->uri));
+    raptor_free_uri(entry->uri);
+    xsltFreeStylesheet(entry->sheet);
+  }
+
+  entry->uri = raptor_uri_copy(uri);
+  entry->sheet = sheet;
+  entry->last_used = ++cache->clock;
+
+  return 0;
+}
+
+
+static void
+raptor_grddl_xslt_cache_free(raptor_world* world)
+{
+  raptor_grddl_xslt_cache* cache;
+  int i;
+
+  cache = (raptor_grddl_xslt_cache*)world->grddl_xslt_cache;
+  if(!cache)
+    return;
+
+  for(i = 0; i < cache->count; i++) {
+    raptor_free_uri(cache->entries[i].uri);
+    xsltFreeStylesheet(cache->entries[i].sheet);
+  }
+  RAPTOR_FREE(raptor_grddl_xslt_cache_entry*, cache->entries);
+  RAPTOR_FREE(raptor_grddl_xslt_cache, cache);
+  world->grddl_xslt_cache = NULL;
+}
+
+
+/* Return non-0 if raptor_grddl_fetch_uri() could be allowed to
+ * retrieve @uri, so that a kept copy of it may be used instead */
+static int
+raptor_grddl_fetch_allowed(raptor_parser* rdf_parser, raptor_uri* uri)
+{
+  if(RAPTOR_OPTIONS_GET_NUMERIC(rdf_parser, RAPTOR_OPTION_NO_NET) &&
+     !raptor_uri_uri_string_is_file_uri(raptor_uri_as_string(uri)))
+    return 0;
+
+  if(rdf_parser->uri_filter &&
+     rdf_parser->uri_filter(rdf_parser->uri_filter_user_data, uri))
+    return 0;
+
+  return 1;
+}
+
+
+/*
+ * Saved XSLT stylesheet bytes in the grddlCacheDirectory option
+ * directory.  Each file is named by a hash of the URI and starts with
+ * the URI on a line of its own which is checked when it is read.
+ */
+static char*
+raptor_grddl_cache_file_name(const char* dir, raptor_uri* uri)
+{
+  const unsigned char* p;
+  unsigned long hash = 2166136261UL;
+  size_t dir_len = strlen(dir);
+  char* name;
+
+  /* FNV-1a */
+  for(p = raptor_uri_as_string(uri); *p; p++)
+    hash = ((hash ^ *p) * 16777619UL) & 0xffffffffUL;
+
+  /* dir + '/' + 8 hex digits + ".xsl" + NUL */
+  name = RAPTOR_MALLOC(char*, dir_len + 14);
+  if(name)
+    sprintf(name, "%s/%08lx.xsl", dir, hash);
+
+  return name;
+}
+
+
+/* Feed the saved bytes for @uri in @file_name to @xpbc.  Returns
+ * non-0 if there is no usable saved copy */
+static int
+raptor_grddl_read_cache_file(const char* file_name, raptor_uri* uri,
+                             raptor_grddl_xml_parse_bytes_context* xpbc)
+{
+  FILE* fh;
+  raptor_stringbuffer* sb;
+  unsigned char buffer[4096];
+  const unsigned char* uri_string;
+  size_t uri_len;
+  const unsigned char* bytes;
+  size_t bytes_len;
+  size_t len;
+  int rc = 1;
+
+  fh = fopen(file_name, "rb");
+  if(!fh)
+    return 1;
+
+  sb = raptor_new_stringbuffer();
+  if(!sb) {
+    fclose(fh);
+    return 1;
+  }
+
+  while((len = fread(buffer, 1, sizeof(buffer), fh)) > 0)
+    raptor_stringbuffer_append_counted_string(sb, buffer, len, 1);
+  fclose(fh);
+
+  uri_string = raptor_uri_as_counted_string(uri, &uri_len);
+  bytes = raptor_stringbuffer_as_string(sb);
+  bytes_len = raptor_stringbuffer_length(sb);
+  if(bytes && bytes_len > uri_len + 1 &&
+     !memcmp(bytes, uri_string, uri_len) && bytes[uri_len] == '\n') {
+    RAPTOR_DEBUG3("Using saved XSLT sheet for URI %s from %s\n",
+                  uri_string, file_name);
+    raptor_grddl_uri_xml_parse_bytes(NULL, xpbc, bytes + uri_len + 1, 1,
+                                     bytes_len - uri_len - 1);
+    rc = 0;
+  }
+
+  raptor_free_stringbuffer(sb);
+
+  return rc;
+}
+
+
+static void
+raptor_grddl_write_cache_file(const char* file_name, raptor_uri* uri,
+                              raptor_stringbuffer* sb)
+{
+  FILE* fh;
+  char* tmp_name;
+  size_t file_name_len = strlen(file_name);
+  const unsigned char* uri_string;
+  size_t uri_len;
+  size_t len = raptor_stringbuffer_length(sb);
+  int failed;
+
+  /* write a temporary file and rename it so readers never see part */
+  tmp_name = RAPTOR_MALLOC(char*, file_name_len + 5);
+  if(!tmp_name)
+    return;
+  memcpy(tmp_name, file_name, file_name_len);
+  memcpy(tmp_name + file_name_len, ".tmp", 5);
+
+  fh = fopen(tmp_name, "wb");
+  if(!fh) {
+    RAPTOR_FREE(char*, tmp_name);
+    return;
+  }
+
+  uri_string = raptor_uri_as_counted_string(uri, &uri_len);
+  failed = (fwrite(uri_string, 1, uri_len, fh) != uri_len ||
+            fputc('\n', fh) == EOF ||
+            (len && fwrite(raptor_stringbuffer_as_string(sb), 1, len, fh) != len));
+  if(fclose(fh))
+    failed = 1;
+
+  if(failed || rename(tmp_name, file_name))
+    remove(tmp_name);
+
+  RAPTOR_FREE(char*, tmp_name);
+}
+
+
+/* Fetch the XSLT stylesheet at @uri into @xpbc, reading and writing
+ * a saved copy when the grddlCacheDirectory option is set */
+static int
+raptor_grddl_fetch_xslt_uri(raptor_parser* rdf_parser, raptor_uri* uri,
+                            raptor_grddl_xml_parse_bytes_context* xpbc)
+{
+  const char* cache_dir;
+  char* file_name = NULL;
+  int ret;
+
+  cache_dir = RAPTOR_OPTIONS_GET_STRING(rdf_parser,
+                                        RAPTOR_OPTION_GRDDL_CACHE_DIRECTORY);
+  /* local files are not worth saving again */
+  if(cache_dir && *cache_dir &&
+     !raptor_uri_uri_string_is_file_uri(raptor_uri_as_string(uri)) &&
+     raptor_grddl_fetch_allowed(rdf_parser, uri))
+    file_name = raptor_grddl_cache_file_name(cache_dir, uri);
+
+  if(file_name) {
+    if(!raptor_grddl_read_cache_file(file_name, uri, xpbc)) {
+      RAPTOR_FREE(char*, file_name);
+      return 0;
+    }
+    xpbc->sb = raptor_new_stringbuffer();
+  }
+
+  ret = raptor_grddl_fetch_uri(rdf_parser,
+                               uri,
+                               raptor_grddl_uri_xml_parse_bytes, xpbc,
+                               NULL, NULL,
+                               FETCH_ACCEPT_XSLT);
+
+  if(xpbc->sb) {
+    if(!ret && xpbc->xc)
+      raptor_grddl_write_cache_file(file_name, uri, xpbc->sb);
+    raptor_free_stringbuffer(xpbc->sb);
+    xpbc->sb = NULL;
+  }
+  if(file_name)
+    RAPTOR_FREE(char*, file_name);
+
+  return ret;
+}
+
+
 /* Run a GRDDL transform using a XSLT stylesheet at a given URI */
 static int
 raptor_grddl_run_grddl_transform_uri(raptor_parser* rdf_parser,
@@ -973,44 +1328,75 @@ raptor_grddl_run_grddl_transform_uri(raptor_parser* rdf_parser,
   raptor_grddl_xml_parse_bytes_context xpbc;
   int ret = 0;
   raptor_uri* xslt_uri;
-  raptor_uri* base_uri;
   raptor_uri* old_locator_uri;
   raptor_locator *locator = &rdf_parser->locator;
+  xsltStylesheetPtr sheet = NULL;
 
   xslt_uri = xml_context->uri;
-  base_uri = xml_context->base_uri ? xml_context->base_uri : xml_context->uri;
 
   RAPTOR_DEBUG3("Running GRDDL transform with XSLT URI %s and base URI %s\n",
                 raptor_uri_as_string(xslt_uri),
-                raptor_uri_as_string(base_uri));
+                raptor_uri_as_string(xml_context->base_uri ? xml_context->base_uri : xslt_uri));
   
+  old_locator_uri = locator->uri;
+  locator->uri = xslt_uri;
+
+  /* a kept stylesheet is only used where it could be fetched again */
+  if(raptor_grddl_fetch_allowed(rdf_parser, xslt_uri))
+    sheet = raptor_grddl_xslt_cache_get(rdf_parser->world, xslt_uri);
+  if(sheet) {
+    RAPTOR_DEBUG2("Using compiled XSLT sheet for URI %s\n",
+                  raptor_uri_as_string(xslt_uri));
+    ret = raptor_grddl_run_grddl_transform_doc(rdf_parser,
+                                               xml_context,
+                                               sheet,
+                                               doc);
+    locator->uri = old_locator_uri;
+    return ret;
+  }
+
   /* make an xsltStylesheetPtr via the raptor_grddl_uri_xml_parse_bytes 
-   * callback as bytes are returned
+   * callback as bytes are returned.  The sheet is parsed with its
+   * own URI as the base so that it does not depend on the document
+   * and can be kept.
    */
   xpbc.xc = NULL;
   xpbc.rdf_parser = rdf_parser;
-  xpbc.base_uri = base_uri;
+  xpbc.base_uri = xslt_uri;
+  xpbc.sb = NULL;
 
-  old_locator_uri = locator->uri;
-  locator->uri = xslt_uri;
-  ret = raptor_grddl_fetch_uri(rdf_parser,
-                             xslt_uri,
-                             raptor_grddl_uri_xml_parse_bytes, &xpbc,
-                             NULL, NULL,
-                             FETCH_ACCEPT_XSLT);
+  ret = raptor_grddl_fetch_xslt_uri(rdf_parser, xslt_uri, &xpbc);
   xslt_ctxt = xpbc.xc;
-  if(ret) {
+  if(ret || !xslt_ctxt) {
     locator->uri = old_locator_uri;
     raptor_parser_warning(rdf_parser, "Fetching XSLT document URI '%s' failed",
                           raptor_uri_as_string(xslt_uri));
     ret = 0;
   } else {
     xmlParseChunk(xpbc.xc, NULL, 0, 1);
-  
-    ret = raptor_grddl_run_grddl_transform_doc(rdf_parser,
-                                               xml_context,
-                                               xslt_ctxt->myDoc,
-                                               doc);
+
+    raptor_libxslt_set_global_state(rdf_parser);
+    /* This calls xsltGetDefaultSecurityPrefs(); on success the sheet
+     * owns the document */
+    sheet = xsltParseStylesheetDoc(xslt_ctxt->myDoc);
+    raptor_libxslt_reset_global_state(rdf_parser);
+
+    if(!sheet) {
+      raptor_parser_error(rdf_parser, "Failed to parse stylesheet in '%s'",
+                          raptor_uri_as_string(xslt_uri));
+      if(xslt_ctxt->myDoc)
+        xmlFreeDoc(xslt_ctxt->myDoc);
+      ret = 1;
+    } else {
+      ret = raptor_grddl_run_grddl_transform_doc(rdf_parser,
+                                                 xml_context,
+                                                 sheet,
+                                                 doc);
+      if(raptor_grddl_xslt_cache_add(rdf_parser->world, xslt_uri, sheet))
+        xsltFreeStylesheet(sheet);
+    }
+    xslt_ctxt->myDoc = NULL;
+
     locator->uri = old_locator_uri;
   }
 
@@ -1187,6 +1573,7 @@ raptor_grddl_run_xpath_match(raptor_parser* rdf_parser,
 
         xml_context = raptor_new_xml_context(rdf_parser->world, uri, base_uri);
         raptor_sequence_push(seq, xml_context);
+        raptor_free_uri(uri);
       }
       RAPTOR_FREE(char*, buffer);
     } else if(flags & MATCH_IS_HARDCODED) {
@@ -1413,12 +1800,11 @@ raptor_grddl_parse_chunk(raptor_parser* rdf_parser,
   if(!is_end)
     return 0;
 
-  buffer_len = raptor_stringbuffer_length(grddl_parser->sb);
-  buffer = RAPTOR_MALLOC(unsigned char*, buffer_len + 1);
-  if(buffer)
-    raptor_stringbuffer_copy_to_string(grddl_parser->sb, 
-                                       buffer, buffer_len);
-  
+  /* take ownership of the accumulated content rather than copying it */
+  buffer = raptor_stringbuffer_as_string_detach(grddl_parser->sb, &buffer_len);
+  if(!buffer && !buffer_len)
+    buffer = RAPTOR_CALLOC(unsigned char*, 1, 1);
+
 
   uri_string = raptor_uri_as_string(rdf_parser->base_uri);
 
@@ -1931,6 +2317,7 @@ raptor_grddl_parse_chunk(raptor_parser* rdf_parser,
 static int
 raptor_grddl_parse_recognise_syntax(raptor_parser_factory* factory,
                                     const unsigned char *buffer, size_t len,
+                                    unsigned int patterns,
                                     const unsigned char *identifier,
                                     const unsigned char *suffix,
                                     const char *mime_type)
@@ -2064,6 +2451,8 @@ raptor_terminate_parser_grddl_common(raptor_world *world)
     world->xslt_security_preferences = NULL;
   }
 
+  raptor_grddl_xslt_cache_free(world);
+
   xsltCleanupGlobals();
 }
 
@@ -2120,3 +2509,389 @@ raptor_libxslt_reset_global_state(raptor_parser* rdf_parser)
                           grddl_parser->saved_xsltGenericError);
 }
 
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+static const char *program;
+
+#define TEST_SHEET_FORMAT \
+"<?xml version=\"1.0\"?>\n" \
+"<xsl:stylesheet version=\"1.0\"\n" \
+"  xmlns:xsl=\"http://www.w3.org/1999/XSL/Transform\"\n" \
+"  xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n" \
+"<xsl:template match=\"/\">\n" \
+"<rdf:RDF><rdf:Description rdf:about=\"http://example.org/s\">\n" \
+"<rdf:value>sheet %d</rdf:value>\n" \
+"</rdf:Description></rdf:RDF>\n" \
+"</xsl:template>\n" \
+"</xsl:stylesheet>\n"
+
+#define TEST_DOCUMENT_FORMAT \
+"<?xml version=\"1.0\"?>\n" \
+"<html xmlns=\"http://www.w3.org/1999/xhtml\">\n" \
+"<head profile=\"http://www.w3.org/2003/g/data-view\">\n" \
+"<title>test</title>\n" \
+"<link rel=\"transformation\" href=\"%s\" />\n" \
+"</head>\n" \
+"<body></body>\n" \
+"</html>\n"
+
+/* stylesheet URI that is only ever read from the cache directory */
+#define TEST_REMOTE_SHEET "http://example.org/raptor-grddl-test.xsl"
+
+#define TEST_CACHE_DIR "."
+
+
+static int
+test_write_file(const char* name, const char* format, ...)
+{
+  FILE* fh;
+  va_list arguments;
+  int rc;
+
+  fh = fopen(name, "w");
+  if(!fh)
+    return 1;
+
+  va_start(arguments, format);
+  rc = (vfprintf(fh, format, arguments) < 0);
+  va_end(arguments);
+
+  if(fclose(fh))
+    rc = 1;
+
+  return rc;
+}
+
+
+static void
+test_write_sheet(int i)
+{
+  char name[40];
+
+  sprintf(name, "raptor_grddl_test-%d.xsl", i);
+  test_write_file(name, TEST_SHEET_FORMAT, i);
+}
+
+
+static void
+test_write_document(int i, const char* sheet_uri)
+{
+  char name[40];
+  char href[40];
+
+  sprintf(name, "raptor_grddl_test-%d.html", i);
+  if(!sheet_uri) {
+    sprintf(href, "raptor_grddl_test-%d.xsl", i);
+    sheet_uri = href;
+  }
+  test_write_file(name, TEST_DOCUMENT_FORMAT, sheet_uri);
+}
+
+
+static void
+test_remove_files(int i)
+{
+  char name[40];
+
+  sprintf(name, "raptor_grddl_test-%d.xsl", i);
+  remove(name);
+  sprintf(name, "raptor_grddl_test-%d.html", i);
+  remove(name);
+}
+
+
+static raptor_uri*
+test_file_uri(raptor_world* world, const char* format, int i)
+{
+  char name[40];
+  unsigned char* uri_string;
+  raptor_uri* uri;
+
+  sprintf(name, format, i);
+  uri_string = raptor_uri_filename_to_uri_string(name);
+  if(!uri_string)
+    return NULL;
+  uri = raptor_new_uri(world, uri_string);
+  raptor_free_memory(uri_string);
+
+  return uri;
+}
+
+
+static void
+test_count_statement(void* user_data, raptor_statement* statement)
+{
+  (*(int*)user_data)++;
+}
+
+
+/* allow local files and the test stylesheet only */
+static int
+test_uri_filter(void* user_data, raptor_uri* uri)
+{
+  const char* uri_string = (const char*)raptor_uri_as_string(uri);
+
+  if(raptor_uri_uri_string_is_file_uri(raptor_uri_as_string(uri)) ||
+     !strcmp(uri_string, TEST_REMOTE_SHEET))
+    return 0;
+
+  return 1;
+}
+
+
+static void
+test_ignore_log(void *user_data, raptor_log_message *message)
+{
+}
+
+
+/*
+ * Parse document @i with GRDDL and return the number of triples or
+ * -1 on failure.  With @cache_dir set, the network is allowed but
+ * only for the test stylesheet, which must then come from the
+ * directory.
+ */
+static int
+test_parse_document(raptor_world* world, int i, const char* cache_dir)
+{
+  raptor_parser* parser;
+  raptor_uri* uri;
+  int count = 0;
+  int rc;
+
+  parser = raptor_new_parser(world, "grddl");
+  uri = test_file_uri(world, "raptor_grddl_test-%d.html", i);
+  if(!parser || !uri) {
+    if(parser)
+      raptor_free_parser(parser);
+    if(uri)
+      raptor_free_uri(uri);
+    return -1;
+  }
+
+  if(cache_dir) {
+    raptor_parser_set_option(parser, RAPTOR_OPTION_GRDDL_CACHE_DIRECTORY,
+                             cache_dir, 0);
+    raptor_parser_set_uri_filter(parser, test_uri_filter, NULL);
+  } else
+    raptor_parser_set_option(parser, RAPTOR_OPTION_NO_NET, NULL, 1);
+  raptor_parser_set_statement_handler(parser, &count, test_count_statement);
+
+  rc = raptor_parser_parse_file(parser, uri, NULL);
+
+  raptor_free_uri(uri);
+  raptor_free_parser(parser);
+
+  return rc ? -1 : count;
+}
+
+
+static int
+test_cache_has(raptor_world* world, int i)
+{
+  raptor_uri* uri;
+  int found;
+
+  uri = test_file_uri(world, "raptor_grddl_test-%d.xsl", i);
+  if(!uri)
+    return 0;
+  found = (raptor_grddl_xslt_cache_get(world, uri) != NULL);
+  raptor_free_uri(uri);
+
+  return found;
+}
+
+
+static int
+test_cache_count(raptor_world* world)
+{
+  raptor_grddl_xslt_cache* cache;
+
+  cache = (raptor_grddl_xslt_cache*)world->grddl_xslt_cache;
+  return cache ? cache->count : 0;
+}
+
+
+#define CHECK(cond, message) \
+  do { \
+    if(!(cond)) { \
+      fprintf(stderr, "%s: %s\n", program, message); \
+      failures++; \
+    } \
+  } while(0)
+
+
+/* A second parse using the same transformation runs the kept sheet */
+static int
+test_cache_hit(raptor_world* world)
+{
+  int failures = 0;
+
+  test_write_sheet(1);
+  test_write_document(1, NULL);
+
+  CHECK(test_parse_document(world, 1, NULL) == 1,
+        "First parse did not run the transformation");
+  CHECK(test_cache_count(world) == 1, "Compiled sheet was not kept");
+
+  /* only the kept sheet can give the triple now */
+  test_remove_files(1);
+  test_write_document(1, NULL);
+  CHECK(test_parse_document(world, 1, NULL) == 1,
+        "Second parse did not use the kept sheet");
+
+  raptor_grddl_xslt_cache_free(world);
+  CHECK(test_parse_document(world, 1, NULL) == 0,
+        "Parse after clearing the cache still used the sheet");
+
+  test_remove_files(1);
+
+  return failures;
+}
+
+
+/* With room for two sheets, the least recently used is dropped */
+static int
+test_cache_lru(raptor_world* world)
+{
+  int failures = 0;
+  int i;
+
+  for(i = 1; i <= 3; i++) {
+    test_write_sheet(i);
+    test_write_document(i, NULL);
+  }
+
+  CHECK(test_parse_document(world, 1, NULL) == 1, "Parse of 1 failed");
+  CHECK(test_parse_document(world, 2, NULL) == 1, "Parse of 2 failed");
+  /* use 1 again so that 2 is the least recently used */
+  CHECK(test_parse_document(world, 1, NULL) == 1, "Parse of 1 failed");
+  CHECK(test_parse_document(world, 3, NULL) == 1, "Parse of 3 failed");
+
+  CHECK(test_cache_count(world) == 2, "Cache does not hold exactly 2 sheets");
+  CHECK(test_cache_has(world, 1), "Recently used sheet 1 was dropped");
+  CHECK(!test_cache_has(world, 2), "Least recently used sheet 2 was kept");
+  CHECK(test_cache_has(world, 3), "Newest sheet 3 was dropped");
+
+  for(i = 1; i <= 3; i++) {
+    char name[40];
+
+    sprintf(name, "raptor_grddl_test-%d.xsl", i);
+    remove(name);
+  }
+  CHECK(test_parse_document(world, 3, NULL) == 1,
+        "Kept sheet 3 was not used");
+  CHECK(test_parse_document(world, 2, NULL) == 0,
+        "Dropped sheet 2 was still used");
+
+  for(i = 1; i <= 3; i++)
+    test_remove_files(i);
+
+  return failures;
+}
+
+
+/* A stylesheet saved in the cache directory is used instead of a
+ * fetch, and not once the saved copy is removed or is for another URI */
+static int
+test_cache_directory(raptor_world* world)
+{
+  raptor_uri* uri;
+  raptor_uri* other_uri;
+  raptor_stringbuffer* sb;
+  raptor_grddl_xml_parse_bytes_context xpbc;
+  char* file_name;
+  char sheet[1024];
+  int failures = 0;
+
+  uri = raptor_new_uri(world, (const unsigned char*)TEST_REMOTE_SHEET);
+  other_uri = raptor_new_uri(world,
+                             (const unsigned char*)"http://example.org/other.xsl");
+  file_name = raptor_grddl_cache_file_name(TEST_CACHE_DIR, uri);
+  sb = raptor_new_stringbuffer();
+  if(!uri || !other_uri || !file_name || !sb) {
+    failures++;
+    goto tidy;
+  }
+
+  sprintf(sheet, TEST_SHEET_FORMAT, 4);
+  raptor_stringbuffer_append_string(sb, (const unsigned char*)sheet, 1);
+  raptor_grddl_write_cache_file(file_name, uri, sb);
+
+  test_write_document(4, TEST_REMOTE_SHEET);
+  CHECK(test_parse_document(world, 4, TEST_CACHE_DIR) == 1,
+        "Saved sheet was not used");
+
+  /* the saved copy is read again once the compiled sheet is gone */
+  raptor_grddl_xslt_cache_free(world);
+  CHECK(test_parse_document(world, 4, TEST_CACHE_DIR) == 1,
+        "Saved sheet was not read again");
+
+  /* a saved copy is only used for the URI it was saved for */
+  xpbc.xc = NULL;
+  xpbc.rdf_parser = NULL;
+  xpbc.base_uri = other_uri;
+  xpbc.sb = NULL;
+  CHECK(raptor_grddl_read_cache_file(file_name, other_uri, &xpbc) &&
+        !xpbc.xc, "Saved sheet used for another URI");
+
+  remove(file_name);
+  CHECK(raptor_grddl_read_cache_file(file_name, uri, &xpbc) && !xpbc.xc,
+        "Removed saved sheet was still read");
+
+  tidy:
+  test_remove_files(4);
+  if(sb)
+    raptor_free_stringbuffer(sb);
+  if(file_name) {
+    remove(file_name);
+    RAPTOR_FREE(char*, file_name);
+  }
+  if(other_uri)
+    raptor_free_uri(other_uri);
+  if(uri)
+    raptor_free_uri(uri);
+
+  return failures;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  raptor_world *world;
+  int failures = 0;
+
+  program = raptor_basename(argv[0]);
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+  /* failed fetches are expected */
+  raptor_world_set_log_handler(world, NULL, test_ignore_log);
+
+  failures += test_cache_hit(world);
+  failures += test_cache_directory(world);
+  raptor_free_world(world);
+
+  world = raptor_new_world();
+  if(!world)
+    exit(1);
+  raptor_world_set_flag(world, RAPTOR_WORLD_FLAG_GRDDL_XSLT_CACHE_SIZE, 2);
+  if(raptor_world_open(world))
+    exit(1);
+  raptor_world_set_log_handler(world, NULL, test_ignore_log);
+
+  failures += test_cache_lru(world);
+  raptor_free_world(world);
+
+  return failures;
+}
+
+#endif
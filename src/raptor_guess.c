@@ -87,6 +87,18 @@ raptor_guess_parse_terminate(raptor_parser *rdf_parser)
 }
 
 
+static int
+raptor_guess_parse_start(raptor_parser *rdf_parser)
+{
+  raptor_guess_parser_context *guess_parser = (raptor_guess_parser_context*)rdf_parser->context;
+
+  /* guess again for each parse; a guessed parser is kept for reuse */
+  guess_parser->do_guess = 1;
+
+  return 0;
+}
+
+
 static void
 raptor_guess_parse_content_type_handler(raptor_parser* rdf_parser, 
                                         const char* content_type)
@@ -130,11 +142,19 @@ raptor_guess_parse_chunk(raptor_parser* rdf_parser,
     name = raptor_world_guess_parser_name(rdf_parser->world,
                                           NULL, guess_parser->content_type,
                                           buffer, len, identifier);
-    if(!name) {
+    if(!name)
       raptor_parser_error(rdf_parser,
                           "Failed to guess parser from content type '%s'",
                           guess_parser->content_type ? 
                           guess_parser->content_type : "(none)");
+
+    /* the content type only applies to this parse */
+    if(guess_parser->content_type) {
+      RAPTOR_FREE(char*, guess_parser->content_type);
+      guess_parser->content_type = NULL;
+    }
+
+    if(!name) {
       raptor_parser_parse_abort(rdf_parser);
       if(guess_parser->parser) {
         raptor_free_parser(guess_parser->parser);
@@ -193,7 +213,8 @@ raptor_guess_guess_get_name(raptor_parser* rdf_parser)
   raptor_guess_parser_context *guess_parser;
   guess_parser = (raptor_guess_parser_context*)rdf_parser->context;
 
-  if(guess_parser)
+  /* only name the parser guessed for the current parse */
+  if(guess_parser && guess_parser->parser && !guess_parser->do_guess)
     return raptor_parser_get_name(guess_parser->parser);
   else
     return rdf_parser->factory->desc.names[0];
@@ -244,6 +265,7 @@ raptor_guess_parser_register_factory(raptor_parser_factory *factory)
   
   factory->init      = raptor_guess_parse_init;
   factory->terminate = raptor_guess_parse_terminate;
+  factory->start     = raptor_guess_parse_start;
   factory->chunk     = raptor_guess_parse_chunk;
   factory->content_type_handler = raptor_guess_parse_content_type_handler;
   factory->accept_header = raptor_guess_accept_header;
@@ -229,14 +229,35 @@ void raptor_libxml_free(xmlParserCtxtPtr xc);
 /* raptor_parse.c - exported to libxml part */
 extern void raptor_libxml_update_document_locator(raptor_sax2* sax2, raptor_locator* locator);
 
+/* raptor_sax2.c */
+int raptor_sax2_parse_xml_doc(raptor_sax2* sax2, xmlDocPtr doc);
+
+/* raptor_rdfxml.c */
+int raptor_rdfxml_parse_xml_doc(raptor_parser* rdf_parser, xmlDocPtr doc);
+
 /* end of libxml-only */
 #endif
 
 
+#ifdef RAPTOR_XML_NATIVE
+
+/* raptor_xmltok.c */
+typedef struct raptor_xmltok_s raptor_xmltok;
+
+raptor_xmltok* raptor_new_xmltok(raptor_sax2* sax2);
+void raptor_free_xmltok(raptor_xmltok* xt);
+int raptor_xmltok_parse_chunk(raptor_xmltok* xt, const unsigned char *buffer, size_t len, int is_end);
+void raptor_xmltok_update_document_locator(raptor_xmltok* xt, raptor_locator* locator);
+
+#endif
+
+
 typedef struct raptor_parser_factory_s raptor_parser_factory;
 typedef struct raptor_serializer_factory_s raptor_serializer_factory;
 typedef struct raptor_id_set_s raptor_id_set;
 typedef struct raptor_uri_detail_s raptor_uri_detail;
+typedef struct raptor_uri_relative_cache_s raptor_uri_relative_cache;
+typedef struct raptor_parser_pull_s raptor_parser_pull;
 
 
 /* raptor_option.c */
@@ -560,11 +581,20 @@ struct raptor_parser_s {
   /* internal data for lexers */
   void* lexer_user_data;
 
+  /* raptor_parser_next_statement() state or NULL */
+  raptor_parser_pull* pull;
+
   /* internal read buffer */
   unsigned char buffer[RAPTOR_READ_BUFFER_SIZE + 1];
 };
 
 
+/* Maximum number of recognise_patterns for a parser factory */
+#define RAPTOR_RECOGNISE_PATTERNS_MAX 16
+
+/* Test if recognise_patterns string @n was found */
+#define RAPTOR_RECOGNISE_HAS_PATTERN(patterns, n) (((patterns) >> (n)) & 1U)
+
 /** A Parser Factory */
 struct raptor_parser_factory_s {
   raptor_world* world;
@@ -597,8 +627,20 @@ struct raptor_parser_factory_s {
   /* score recognition of the syntax by a block of characters, the
    *  content identifier or it's suffix or a mime type
    *  (different from the factory-registered one)
+   *
+   *  @patterns has bit N set if recognise_patterns[N] was found in
+   *  the block of characters.
+   */
+  int (*recognise_syntax)(raptor_parser_factory* factory, const unsigned char *buffer, size_t len, unsigned int patterns, const unsigned char *identifier, const unsigned char *suffix, const char *mime_type);
+
+  /* strings that recognise_syntax looks for in the block of
+   * characters, NULL terminated (OPTIONAL).  All the factories'
+   * strings are searched for together in one pass over the block.
    */
-  int (*recognise_syntax)(raptor_parser_factory* factory, const unsigned char *buffer, size_t len, const unsigned char *identifier, const unsigned char *suffix, const char *mime_type);
+  const char* const* recognise_patterns;
+
+  /* index of each recognise_patterns string in the world's matcher */
+  int recognise_pattern_ids[RAPTOR_RECOGNISE_PATTERNS_MAX];
 
   /* get the Content-Type value of a URI request */
   void (*content_type_handler)(raptor_parser* rdf_parser, const char* content_type);
@@ -617,6 +659,11 @@ struct raptor_parser_factory_s {
 
   /* get the locator (OPTIONAL) */
   raptor_locator* (*get_locator)(raptor_parser* rdf_parser);
+
+  /* parse all the content of a file handle (OPTIONAL) - return <0
+   * if it cannot be used so that the file is read in chunks instead
+   */
+  int (*parse_file_handle)(raptor_parser* rdf_parser, FILE* handle);
 };
 
 
@@ -635,6 +682,11 @@ struct raptor_serializer_s {
   /* base URI of RDF/XML */
   raptor_uri *base_uri;
 
+  /* relative URI strings against relative_cache_base - see
+   * raptor_serializer_uri_to_relative_string() */
+  raptor_uri_relative_cache* relative_cache;
+  raptor_uri* relative_cache_base;
+
   /* serializer specific stuff */
   void *context;
 
@@ -707,6 +759,7 @@ typedef struct
 
 /* raptor_serialize.c */
 raptor_serializer_factory* raptor_serializer_register_factory(raptor_world* world, int (*factory) (raptor_serializer_factory*));
+unsigned char* raptor_serializer_uri_to_relative_string(raptor_serializer* rdf_serializer, raptor_uri* uri);
 
 
 /* raptor_general.c */
@@ -723,7 +776,10 @@ RAPTOR_INTERNAL_API const char* raptor_basename(const char *name);
 int raptor_term_print_as_ntriples(const raptor_term *term, FILE* stream);
 
 /* raptor_ntriples.c */
-size_t raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator, unsigned char *string, size_t *len_p, raptor_term** term_p, int allow_turtle);
+/* raptor_ntriples_parse_term() flags */
+#define RAPTOR_NTRIPLES_TERM_ALLOW_TURTLE 1
+#define RAPTOR_NTRIPLES_TERM_TRUSTED 2
+size_t raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator, unsigned char *string, size_t *len_p, raptor_term** term_p, int flags);
 
 /* raptor_parse.c */
 raptor_parser_factory* raptor_world_get_parser_factory(raptor_world* world, const char *name);  
@@ -769,6 +825,19 @@ int raptor_check_ordinal(const unsigned char *name);
 
 /* raptor_locator.c */
 
+/* Move the @locator column and byte on by the input consumed from
+ * @mark up to @p and then set @mark to @p.  Parsers keep a mark rather
+ * than counting every byte and use this before the locator is read.
+ */
+#define RAPTOR_LOCATOR_ADVANCE(locator, mark, p) \
+  do { \
+    if(locator) { \
+      int raptor_locator_delta = RAPTOR_BAD_CAST(int, (p) - (mark)); \
+      (locator)->column += raptor_locator_delta; \
+      (locator)->byte += raptor_locator_delta; \
+    } \
+    (mark) = (p); \
+  } while(0)
 
 #ifdef HAVE_STRCASECMP
 #define raptor_strcasecmp strcasecmp
@@ -811,6 +880,9 @@ struct raptor_qname_s {
   /* optional value - used when name is an attribute */
   const unsigned char *value;
   size_t value_length;
+  /* allocated sizes of local_name and value buffers if known or 0 */
+  size_t local_name_size;
+  size_t value_size;
 };
 
 
@@ -819,6 +891,8 @@ struct raptor_qname_s {
 #ifdef RAPTOR_DEBUG
 void raptor_qname_print(FILE *stream, raptor_qname* name);
 #endif
+raptor_qname* raptor_new_qname_reuse(raptor_namespace_stack *nstack, const unsigned char *name, const unsigned char *value, raptor_qname* qname, unsigned long *reused_p);
+void raptor_qname_clear(raptor_qname* qname);
 
 
 /* raptor_uri.c */
@@ -827,6 +901,16 @@ int raptor_uri_init(raptor_world* world);
 void raptor_uri_finish(raptor_world* world);
 raptor_uri* raptor_new_uri_from_rdf_ordinal(raptor_world* world, int ordinal);
 size_t raptor_uri_normalize_path(unsigned char* path_buffer, size_t path_len);
+/* Default RAPTOR_WORLD_FLAG_URI_ESCAPED_CACHE_SIZE */
+#define RAPTOR_URI_ESCAPED_CACHE_DEFAULT_SIZE (4 * 1024 * 1024)
+void raptor_uri_escaped_cache_add(raptor_uri* uri, int now);
+
+/* Entries kept by a raptor_uri_relative_cache before it is emptied */
+#define RAPTOR_URI_RELATIVE_CACHE_SIZE 4096
+raptor_uri_relative_cache* raptor_new_uri_relative_cache(raptor_uri* base_uri);
+void raptor_free_uri_relative_cache(raptor_uri_relative_cache* cache);
+const unsigned char* raptor_uri_relative_cache_get(raptor_uri_relative_cache* cache, raptor_uri* uri, size_t* length_p);
+int raptor_uri_relative_cache_escaped_write(raptor_uri_relative_cache* cache, raptor_uri* uri, unsigned int flags, raptor_iostream *iostr);
 
 /* parsers */
 int raptor_init_parser_rdfxml(raptor_world* world);
@@ -841,8 +925,11 @@ int raptor_init_parser_rss(raptor_world* world);
 int raptor_init_parser_rdfa(raptor_world* world);
 int raptor_init_parser_json(raptor_world* world);
 int raptor_init_parser_nquads(raptor_world* world);
+int raptor_init_parser_binary(raptor_world* world);
 
 void raptor_terminate_parser_grddl_common(raptor_world *world);
+/* Default RAPTOR_WORLD_FLAG_GRDDL_XSLT_CACHE_SIZE */
+#define RAPTOR_GRDDL_XSLT_CACHE_DEFAULT_SIZE 16
 
 #ifdef RAPTOR_PARSER_RDFA
 #define rdfa_add_item raptor_librdfa_rdfa_add_item
@@ -962,6 +1049,10 @@ int raptor_init_serializer_html(raptor_world* world);
 /* raptor_serialize_json.c */  
 int raptor_init_serializer_json(raptor_world* world);
 
+/* raptor_binary.c */
+int raptor_init_serializer_binary(raptor_world* world);
+void raptor_binary_serializer_set_max_terms(raptor_serializer* serializer, size_t max_terms);
+
 /* raptor_unicode.c */
 extern const raptor_unichar raptor_unicode_max_codepoint;
 
@@ -1080,6 +1171,8 @@ struct raptor_xml_element_s {
   raptor_qname *name;
   raptor_qname **attributes;
   unsigned int attribute_count;
+  /* allocated size of attributes array */
+  unsigned int attributes_size;
 
   /* value of xml:lang attribute on this element or NULL */
   const unsigned char *xml_language;
@@ -1101,6 +1194,9 @@ struct raptor_xml_element_s {
 };
 
 
+/* Maximum number of released qnames a #raptor_sax2 keeps for reuse */
+#define RAPTOR_SAX2_QNAME_POOL_SIZE 64
+
 struct raptor_sax2_s {
 #ifdef RAPTOR_XML_LIBXML
   int magic;
@@ -1123,6 +1219,11 @@ struct raptor_sax2_s {
 
 #endif  
 
+#ifdef RAPTOR_XML_NATIVE
+  /* native tokenizer for the current document */
+  raptor_xmltok* xt;
+#endif
+
   /* element depth */
   int depth;
 
@@ -1166,6 +1267,16 @@ struct raptor_sax2_s {
 
   void* uri_filter_user_data;
   raptor_uri_filter_func uri_filter;
+
+  /* released elements kept for reuse, linked by parent field */
+  raptor_xml_element* element_pool;
+
+  /* released qnames kept for reuse */
+  raptor_qname* qname_pool[RAPTOR_SAX2_QNAME_POOL_SIZE];
+  int qname_pool_count;
+
+  /* allocations avoided by the pools in the current document */
+  unsigned long pool_allocations_avoided;
 };
 
 int raptor_sax2_init(raptor_world* world);
@@ -1175,6 +1286,7 @@ void raptor_sax2_finish(raptor_world* world);
 raptor_xml_element* raptor_xml_element_pop(raptor_sax2* sax2);
 void raptor_xml_element_push(raptor_sax2* sax2, raptor_xml_element* element);
 int raptor_sax2_get_depth(raptor_sax2* sax2);
+unsigned long raptor_sax2_get_pool_allocations_avoided(raptor_sax2* sax2);
 void raptor_sax2_inc_depth(raptor_sax2* sax2);
 void raptor_sax2_dec_depth(raptor_sax2* sax2);
 void raptor_sax2_update_document_locator(raptor_sax2* sax2, raptor_locator* locator);
@@ -1192,6 +1304,9 @@ void raptor_sax2_comment(void* user_data, const unsigned char *s);
 void raptor_sax2_unparsed_entity_decl(void* user_data, const unsigned char* entityName, const unsigned char* base, const unsigned char* systemId, const unsigned char* publicId, const unsigned char* notationName);
 int raptor_sax2_external_entity_ref(void* user_data, const unsigned char* context, const unsigned char* base, const unsigned char* systemId, const unsigned char* publicId);
 int raptor_sax2_check_load_uri_string(raptor_sax2* sax2, const unsigned char* uri_string);
+#if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
+void raptor_sax2_stats_print(raptor_sax2* sax2, FILE *stream);
+#endif
 
 /* turtle_parser.y and turtle_lexer.l */
 typedef struct raptor_turtle_parser_s raptor_turtle_parser;
@@ -1257,6 +1372,9 @@ time_t raptor_parse_date(const char *p, time_t *now);
 typedef void (*raptor_simple_message_handler)(void *user_data, const char *message, ...) RAPTOR_PRINTF_FORMAT(2, 3);
 
 
+/* raptor_stringbuffer.c */
+void raptor_stringbuffer_clear(raptor_stringbuffer* stringbuffer);
+
 /* turtle_common.c */
 RAPTOR_INTERNAL_API int raptor_stringbuffer_append_turtle_string(raptor_stringbuffer* stringbuffer, const unsigned char *text, size_t len, int delim, raptor_simple_message_handler error_handler, void *error_data, int is_uri);
 
@@ -1322,6 +1440,44 @@ void raptor_avltree_check(raptor_avltree* tree);
 #endif
 
 
+/* raptor_bptree.c */
+typedef struct raptor_bptree_s raptor_bptree;
+typedef struct raptor_bptree_iterator_s raptor_bptree_iterator;
+
+/* B+ Tree visitor function - same as #raptor_avltree_visit_handler */
+typedef raptor_avltree_visit_handler raptor_bptree_visit_handler;
+
+/*
+ * raptor_bptree_bitflags:
+ * @RAPTOR_BPTREE_FLAG_REPLACE_DUPLICATES: If set raptor_bptree_add() will replace any duplicate items, as for #RAPTOR_AVLTREE_FLAG_REPLACE_DUPLICATES
+ *
+ * Bit flags for B+ Tree class constructor raptor_new_bptree()
+ */
+typedef enum {
+  RAPTOR_BPTREE_FLAG_REPLACE_DUPLICATES = 1
+} raptor_bptree_bitflags;
+
+RAPTOR_INTERNAL_API raptor_bptree* raptor_new_bptree(raptor_data_compare_handler compare_handler, raptor_data_free_handler free_handler, unsigned int flags);
+RAPTOR_INTERNAL_API void raptor_free_bptree(raptor_bptree* tree);
+RAPTOR_INTERNAL_API int raptor_bptree_add(raptor_bptree* tree, void* p_data);
+RAPTOR_INTERNAL_API void* raptor_bptree_remove(raptor_bptree* tree, void* p_data);
+RAPTOR_INTERNAL_API int raptor_bptree_delete(raptor_bptree* tree, void* p_data);
+RAPTOR_INTERNAL_API void raptor_bptree_trim(raptor_bptree* tree);
+RAPTOR_INTERNAL_API void* raptor_bptree_search(raptor_bptree* tree, const void* p_data);
+RAPTOR_INTERNAL_API int raptor_bptree_visit(raptor_bptree* tree, raptor_bptree_visit_handler visit_handler, void* user_data);
+RAPTOR_INTERNAL_API int raptor_bptree_size(raptor_bptree* tree);
+RAPTOR_INTERNAL_API void raptor_bptree_set_print_handler(raptor_bptree* tree, raptor_data_print_handler print_handler);
+RAPTOR_INTERNAL_API int raptor_bptree_print(raptor_bptree* tree, FILE* stream);
+RAPTOR_INTERNAL_API raptor_bptree_iterator* raptor_new_bptree_iterator(raptor_bptree* tree, void* range, raptor_data_free_handler range_free_handler, int direction);
+RAPTOR_INTERNAL_API void raptor_free_bptree_iterator(raptor_bptree_iterator* iterator);
+RAPTOR_INTERNAL_API int raptor_bptree_iterator_is_end(raptor_bptree_iterator* iterator);
+RAPTOR_INTERNAL_API int raptor_bptree_iterator_next(raptor_bptree_iterator* iterator);
+RAPTOR_INTERNAL_API void* raptor_bptree_iterator_get(raptor_bptree_iterator* iterator);
+#ifdef RAPTOR_DEBUG
+RAPTOR_INTERNAL_API void raptor_bptree_check(raptor_bptree* tree);
+#endif
+
+
 raptor_qname* raptor_new_qname_from_resource(raptor_sequence* namespaces, raptor_namespace_stack* nstack, int* namespace_count, raptor_abbrev_node* node);
 
 
@@ -1394,6 +1550,13 @@ int raptor_json_writer_key_uri_value(raptor_json_writer* json_writer, const char
 
 /* raptor_memstr.c */
 const char* raptor_memstr(const char *haystack, size_t haystack_len, const char *needle);
+typedef struct raptor_memstr_matcher_s raptor_memstr_matcher;
+raptor_memstr_matcher* raptor_new_memstr_matcher(raptor_world* world);
+void raptor_free_memstr_matcher(raptor_memstr_matcher* matcher);
+int raptor_memstr_matcher_add(raptor_memstr_matcher* matcher, const char *needle);
+int raptor_memstr_matcher_get_count(raptor_memstr_matcher* matcher);
+int raptor_memstr_matcher_compile(raptor_memstr_matcher* matcher);
+int raptor_memstr_matcher_search(raptor_memstr_matcher* matcher, const char *haystack, size_t haystack_len, unsigned char* found);
 
 /* raptor_serialize_rdfxmla.c special functions for embedding rdf/xml */
 int raptor_rdfxmla_serialize_set_write_rdf_RDF(raptor_serializer* serializer, int value);
@@ -1436,6 +1599,9 @@ struct raptor_world_s {
   /* sequence of parser factories */
   raptor_sequence *parsers;
 
+  /* matcher for all parser factories' recognise_patterns or NULL */
+  raptor_memstr_matcher *parser_patterns;
+
   /* sequence of serializer factories */
   raptor_sequence *serializers;
 
@@ -1463,6 +1629,11 @@ struct raptor_world_s {
    */
   int xslt_security_preferences_policy;
 
+  /* Maximum number of compiled GRDDL XSLT stylesheets kept */
+  int grddl_xslt_cache_size;
+  /* Cache of compiled stylesheets by URI owned by the GRDDL parser */
+  void* grddl_xslt_cache;
+
   /* Flags for libxml set by raptor_world_set_libxml_flags().
    * See #raptor_libxml_flags for meanings 
    */
@@ -1476,7 +1647,7 @@ struct raptor_world_s {
   xmlGenericErrorFunc libxml_saved_generic_error_handler;
 #endif  
 
-  raptor_avltree *uris_tree;
+  raptor_bptree *uris_tree;
 
   raptor_uri* concepts[RDF_NS_LAST + 1];
 
@@ -1488,6 +1659,11 @@ struct raptor_world_s {
   /* should */
   int uri_interning;
 
+  /* limit and current total bytes of escaped URI forms kept with
+   * interned URIs */
+  size_t uri_escaped_cache_size;
+  size_t uri_escaped_cache_used;
+
   /* generate blank node ID policy */
   void *generate_bnodeid_handler_user_data;
   raptor_generate_bnodeid_handler generate_bnodeid_handler;
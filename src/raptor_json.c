@@ -83,6 +83,16 @@ typedef enum {
 #define RAPTOR_YAJL_LEN_TYPE unsigned int
 #endif
 
+/* Maximum number of predicate terms kept for reuse */
+#define RAPTOR_JSON_PREDICATE_CACHE_SIZE 1024
+
+/* A predicate term, keyed by the string it was created from */
+typedef struct {
+  unsigned char* string;
+  size_t length;
+  raptor_term* term;
+} raptor_json_cached_term;
+
 /*
  * JSON parser object
  */
@@ -106,6 +116,12 @@ struct raptor_json_parser_context_s {
 
   /* Temporary storage, while creating statements */
   raptor_statement statement;
+
+  /* Terms kept from earlier statements, so that repeated predicates,
+   * subjects and datatypes share one term rather than being rebuilt */
+  raptor_avltree* predicates;
+  raptor_term* last_subject;
+  raptor_uri* last_datatype;
 };
 
 typedef struct raptor_json_parser_context_s raptor_json_parser_context;
@@ -128,6 +144,23 @@ raptor_json_reset_term(raptor_json_parser_context *context)
   context->attrib = RAPTOR_JSON_ATTRIB_UNKNOWN;
 }
 
+static void
+raptor_json_reset_cache(raptor_json_parser_context *context)
+{
+  if(context->predicates) {
+    raptor_free_avltree(context->predicates);
+    context->predicates = NULL;
+  }
+  if(context->last_subject) {
+    raptor_free_term(context->last_subject);
+    context->last_subject = NULL;
+  }
+  if(context->last_datatype) {
+    raptor_free_uri(context->last_datatype);
+    context->last_datatype = NULL;
+  }
+}
+
 static unsigned char*
 raptor_json_cstring_from_counted_string(raptor_parser *rdf_parser, const unsigned char* str, RAPTOR_YAJL_LEN_TYPE len)
 {
@@ -169,6 +202,144 @@ raptor_json_new_term_from_counted_string(raptor_parser *rdf_parser, const unsign
 }
 
 
+static int
+raptor_json_cached_term_compare(const void* a, const void* b)
+{
+  const raptor_json_cached_term* ct_a = (const raptor_json_cached_term*)a;
+  const raptor_json_cached_term* ct_b = (const raptor_json_cached_term*)b;
+
+  if(ct_a->length != ct_b->length)
+    return (ct_a->length < ct_b->length) ? -1 : 1;
+
+  return memcmp(ct_a->string, ct_b->string, ct_a->length);
+}
+
+
+static void
+raptor_json_free_cached_term(void* data)
+{
+  raptor_json_cached_term* ct = (raptor_json_cached_term*)data;
+
+  RAPTOR_FREE(char*, ct->string);
+  raptor_free_term(ct->term);
+  RAPTOR_FREE(raptor_json_cached_term, ct);
+}
+
+
+/*
+ * raptor_json_lookup_predicate:
+ * @context: JSON parser context
+ * @str: predicate string
+ * @len: length of @str
+ *
+ * INTERNAL - Find a URI predicate term created earlier from the same string
+ *
+ * Return value: new reference to the term or NULL if it was not found
+ */
+static raptor_term*
+raptor_json_lookup_predicate(raptor_json_parser_context *context,
+                             const unsigned char* str, size_t len)
+{
+  raptor_json_cached_term key;
+  raptor_json_cached_term* ct;
+
+  if(!context->predicates)
+    return NULL;
+
+  key.string = (unsigned char*)str;
+  key.length = len;
+  ct = (raptor_json_cached_term*)raptor_avltree_search(context->predicates,
+                                                       &key);
+
+  return ct ? raptor_term_copy(ct->term) : NULL;
+}
+
+
+/*
+ * raptor_json_cache_predicate:
+ * @context: JSON parser context
+ * @str: predicate string
+ * @len: length of @str
+ * @term: URI predicate term made from @str
+ *
+ * INTERNAL - Remember a URI predicate term for reuse by later statements
+ *
+ * Nothing more is remembered once the cache is full.  Failing to
+ * remember a term is not an error.
+ */
+static void
+raptor_json_cache_predicate(raptor_json_parser_context *context,
+                            const unsigned char* str, size_t len,
+                            raptor_term* term)
+{
+  raptor_json_cached_term* ct;
+
+  if(!context->predicates) {
+    context->predicates = raptor_new_avltree(raptor_json_cached_term_compare,
+                                             raptor_json_free_cached_term,
+                                             0);
+    if(!context->predicates)
+      return;
+  }
+
+  if(raptor_avltree_size(context->predicates) >= RAPTOR_JSON_PREDICATE_CACHE_SIZE)
+    return;
+
+  ct = RAPTOR_CALLOC(raptor_json_cached_term*, 1, sizeof(*ct));
+  if(!ct)
+    return;
+
+  ct->string = RAPTOR_MALLOC(unsigned char*, len + 1);
+  if(!ct->string) {
+    RAPTOR_FREE(raptor_json_cached_term, ct);
+    return;
+  }
+  memcpy(ct->string, str, len);
+  ct->string[len] = '\0';
+  ct->length = len;
+  ct->term = raptor_term_copy(term);
+
+  raptor_avltree_add(context->predicates, ct);
+}
+
+
+/*
+ * raptor_json_term_matches:
+ * @context: JSON parser context
+ * @term: term to check or NULL
+ *
+ * INTERNAL - Check if a term is the one described by the term being read
+ *
+ * Return value: non-0 if @term has the type and value of the current term
+ */
+static int
+raptor_json_term_matches(raptor_json_parser_context *context,
+                         raptor_term* term)
+{
+  const unsigned char *value = context->term_value;
+
+  if(!term || !value || term->type != context->term_type)
+    return 0;
+
+  switch(term->type) {
+    case RAPTOR_TERM_TYPE_URI:
+      return !strcmp((const char*)raptor_uri_as_string(term->value.uri),
+                     (const char*)value);
+
+    case RAPTOR_TERM_TYPE_BLANK:
+      if(strlen((const char*)value) > 2 && value[0] == '_' && value[1] == ':')
+        value = &value[2];
+      return !strcmp((const char*)term->value.blank.string,
+                     (const char*)value);
+
+    case RAPTOR_TERM_TYPE_LITERAL:
+    case RAPTOR_TERM_TYPE_UNKNOWN:
+    default:
+      return 0;
+  }
+}
+
+
 static raptor_term*
 raptor_json_generate_term(raptor_parser *rdf_parser)
 {
@@ -194,11 +365,18 @@ raptor_json_generate_term(raptor_parser *rdf_parser)
     case RAPTOR_TERM_TYPE_LITERAL: {
       raptor_uri *datatype_uri = NULL;
       if(context->term_datatype) {
-        datatype_uri = raptor_new_uri(rdf_parser->world, context->term_datatype);
+        /* literals in a dataset mostly share a few datatypes */
+        if(!context->last_datatype ||
+           strcmp((const char*)raptor_uri_as_string(context->last_datatype),
+                  (const char*)context->term_datatype)) {
+          if(context->last_datatype)
+            raptor_free_uri(context->last_datatype);
+          context->last_datatype = raptor_new_uri(rdf_parser->world,
+                                                  context->term_datatype);
+        }
+        datatype_uri = context->last_datatype;
       }
       term = raptor_new_term_from_literal(rdf_parser->world, context->term_value, datatype_uri, context->term_lang);
-      if(datatype_uri)
-        raptor_free_uri(datatype_uri);
       break;
     }
     case RAPTOR_TERM_TYPE_BLANK: {
@@ -320,11 +498,23 @@ static int raptor_json_yajl_map_key(void * ctx, const unsigned char * str,
       return 1;
     }
   } else if(context->state == RAPTOR_JSON_STATE_RESOURCES_PREDICATE) {
+    /* only URI predicates are cached since the triples form can give
+     * a "_:" string as a URI */
+    int is_blank = (len > 2 && str[0] == '_' && str[1] == ':');
+
     if(context->statement.predicate)
       raptor_free_term(context->statement.predicate);
-    context->statement.predicate = raptor_json_new_term_from_counted_string(rdf_parser, str, len);
-    if(!context->statement.predicate)
-      return 0;
+    context->statement.predicate = NULL;
+    if(!is_blank)
+      context->statement.predicate = raptor_json_lookup_predicate(context, str, len);
+    if(!context->statement.predicate) {
+      context->statement.predicate = raptor_json_new_term_from_counted_string(rdf_parser, str, len);
+      if(!context->statement.predicate)
+        return 0;
+      if(!is_blank)
+        raptor_json_cache_predicate(context, str, len,
+                                    context->statement.predicate);
+    }
     return 1;
   } else if(context->state == RAPTOR_JSON_STATE_TRIPLES_TRIPLE) {
     if(!strncmp((const char*)str, "subject", len)) {
@@ -420,7 +610,31 @@ static int raptor_json_yajl_end_map(void * ctx)
     context->state = RAPTOR_JSON_STATE_MAP_ROOT;
     return 1;
   } else if(context->state == RAPTOR_JSON_STATE_TRIPLES_TERM) {
-    raptor_term *term = raptor_json_generate_term(rdf_parser);
+    raptor_term *term = NULL;
+
+    /* triples are usually grouped by subject and use few predicates */
+    if(context->term == RAPTOR_JSON_TERM_SUBJECT &&
+       raptor_json_term_matches(context, context->last_subject)) {
+      term = raptor_term_copy(context->last_subject);
+    } else if(context->term == RAPTOR_JSON_TERM_PREDICATE &&
+              context->term_type == RAPTOR_TERM_TYPE_URI &&
+              context->term_value) {
+      size_t len = strlen((const char*)context->term_value);
+      term = raptor_json_lookup_predicate(context, context->term_value, len);
+      if(!term) {
+        term = raptor_json_generate_term(rdf_parser);
+        if(term)
+          raptor_json_cache_predicate(context, context->term_value, len,
+                                      term);
+      }
+    } else {
+      term = raptor_json_generate_term(rdf_parser);
+      if(term && context->term == RAPTOR_JSON_TERM_SUBJECT) {
+        if(context->last_subject)
+          raptor_free_term(context->last_subject);
+        context->last_subject = raptor_term_copy(term);
+      }
+    }
     if(!term)
       return 0;
 
@@ -601,6 +815,7 @@ raptor_json_parse_terminate(raptor_parser* rdf_parser)
 
   raptor_json_reset_term(context);
   raptor_statement_clear(&context->statement);
+  raptor_json_reset_cache(context);
 }
 
 
@@ -691,6 +906,7 @@ raptor_json_parse_start(raptor_parser* rdf_parser)
   context->state = RAPTOR_JSON_STATE_ROOT;
   raptor_json_reset_term(context);
   raptor_statement_clear(&context->statement);
+  raptor_json_reset_cache(context);
 
   return 0;
 }
@@ -699,6 +915,7 @@ raptor_json_parse_start(raptor_parser* rdf_parser)
 static int
 raptor_json_parse_recognise_syntax(raptor_parser_factory* factory,
                                        const unsigned char *buffer, size_t len,
+                                       unsigned int patterns,
                                        const unsigned char *identifier,
                                        const unsigned char *suffix,
                                        const char *mime_type)
@@ -51,6 +51,9 @@ struct raptor_json_writer_s {
   raptor_world* world;
 
   raptor_uri* base_uri;
+
+  /* relative URI strings against base_uri; made on first use */
+  raptor_uri_relative_cache* relative_cache;
   
   /* outputting to this iostream */
   raptor_iostream *iostr;
@@ -108,6 +111,9 @@ raptor_free_json_writer(raptor_json_writer* json_writer)
 {
   RAPTOR_ASSERT_OBJECT_POINTER_RETURN(json_writer, raptor_json_writer);
 
+  if(json_writer->relative_cache)
+    raptor_free_uri_relative_cache(json_writer->relative_cache);
+
   RAPTOR_FREE(raptor_json_writer, json_writer);
 }
 
@@ -180,7 +186,16 @@ raptor_json_writer_key_uri_value(raptor_json_writer* json_writer,
   size_t value_len;
   int rc = 0;
   
-  value = (const char*)raptor_uri_to_relative_counted_uri_string(json_writer->base_uri, uri, &value_len);
+  if(json_writer->base_uri) {
+    if(!json_writer->relative_cache) {
+      json_writer->relative_cache = raptor_new_uri_relative_cache(json_writer->base_uri);
+      if(!json_writer->relative_cache)
+        return 1;
+    }
+    value = (const char*)raptor_uri_relative_cache_get(json_writer->relative_cache,
+                                                       uri, &value_len);
+  } else
+    value = (const char*)raptor_uri_as_counted_string(uri, &value_len);
   if(!value)
     return 1;
 
@@ -189,8 +204,6 @@ raptor_json_writer_key_uri_value(raptor_json_writer* json_writer,
                                     value, value_len);
   else
     rc = raptor_json_writer_quoted(json_writer, value, value_len);
-  
-  RAPTOR_FREE(char*, value);
 
   return rc;
 }
@@ -323,9 +323,17 @@ raptor_librdfa_parse_chunk(raptor_parser* rdf_parser,
   return rval != RDFA_PARSE_SUCCESS;
 }
 
+/* strings looked for by raptor_librdfa_parse_recognise_syntax() */
+static const char* const rdfa_recognise_patterns[3] = {
+  "-//W3C//DTD XHTML+RDFa 1.0//EN",
+  "http://www.w3.org/MarkUp/DTD/xhtml-rdfa-1.dtd",
+  NULL
+};
+
 static int
 raptor_librdfa_parse_recognise_syntax(raptor_parser_factory* factory, 
                                       const unsigned char *buffer, size_t len,
+                                      unsigned int patterns,
                                       const unsigned char *identifier, 
                                       const unsigned char *suffix, 
                                       const char *mime_type)
@@ -338,8 +346,8 @@ raptor_librdfa_parse_recognise_syntax(raptor_parser_factory* factory,
   }
   
   if(buffer && len) {
-#define  HAS_RDFA_1 (raptor_memstr((const char*)buffer, len, "-//W3C//DTD XHTML+RDFa 1.0//EN") != NULL)
-#define  HAS_RDFA_2 (raptor_memstr((const char*)buffer, len, "http://www.w3.org/MarkUp/DTD/xhtml-rdfa-1.dtd") != NULL)
+#define  HAS_RDFA_1 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 0)
+#define  HAS_RDFA_2 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 1)
 
     if(HAS_RDFA_1 || HAS_RDFA_2)
       score = 10;
@@ -385,6 +393,7 @@ raptor_librdfa_parser_register_factory(raptor_parser_factory *factory)
   factory->start     = raptor_librdfa_parse_start;
   factory->chunk     = raptor_librdfa_parse_chunk;
   factory->recognise_syntax = raptor_librdfa_parse_recognise_syntax;
+  factory->recognise_patterns = rdfa_recognise_patterns;
 
   return rc;
 }
@@ -1,6 +1,6 @@
 /* -*- Mode: c; c-basic-offset: 2 -*-
  *
- * raptor_memstr.c - search for a string in a block of memory
+ * raptor_memstr.c - search for strings in a block of memory
  *
  * Copyright (C) 2008, David Beckett http://www.dajobe.org/
  * 
@@ -73,4 +73,633 @@ raptor_memstr(const char *haystack, size_t haystack_len, const char *needle)
   return NULL;
 }
 
-    
+
+/*
+ * Multiple string matcher
+ *
+ * An Aho-Corasick automaton over all the added needles, stored as a
+ * full transition table indexed by byte class so that searching is
+ * one table lookup per byte of the haystack.  Bytes that appear in
+ * no needle all share class 0.
+ */
+struct raptor_memstr_matcher_s {
+  raptor_world* world;
+
+  /* needles in order of addition; shared, not copied */
+  const char** needles;
+  int needles_count;
+  int needles_size;
+
+  /* compiled automaton or NULL if not compiled */
+  unsigned char classes[256];
+  int classes_count;
+  int states_count;
+  /* next state: [state * classes_count + class] */
+  unsigned short* next;
+  /* index of the needle ending at a state or -1 */
+  int* match;
+  /* nearest state for a shorter suffix that ends a needle or 0 */
+  unsigned short* match_link;
+};
+
+
+/*
+ * raptor_new_memstr_matcher:
+ * @world: raptor world
+ *
+ * INTERNAL - Constructor - create a matcher for searching for many strings at once
+ *
+ * Return value: new matcher or NULL on failure
+ */
+raptor_memstr_matcher*
+raptor_new_memstr_matcher(raptor_world* world)
+{
+  raptor_memstr_matcher* matcher;
+
+  matcher = RAPTOR_CALLOC(raptor_memstr_matcher*, 1, sizeof(*matcher));
+  if(!matcher)
+    return NULL;
+
+  matcher->world = world;
+
+  return matcher;
+}
+
+
+static void
+raptor_memstr_matcher_clear_automaton(raptor_memstr_matcher* matcher)
+{
+  if(matcher->next) {
+    RAPTOR_FREE(shortarray, matcher->next);
+    matcher->next = NULL;
+  }
+  if(matcher->match) {
+    RAPTOR_FREE(intarray, matcher->match);
+    matcher->match = NULL;
+  }
+  if(matcher->match_link) {
+    RAPTOR_FREE(shortarray, matcher->match_link);
+    matcher->match_link = NULL;
+  }
+  matcher->states_count = 0;
+}
+
+
+/*
+ * raptor_free_memstr_matcher:
+ * @matcher: matcher
+ *
+ * INTERNAL - Destructor - destroy a matcher
+ */
+void
+raptor_free_memstr_matcher(raptor_memstr_matcher* matcher)
+{
+  if(!matcher)
+    return;
+
+  raptor_memstr_matcher_clear_automaton(matcher);
+
+  if(matcher->needles)
+    RAPTOR_FREE(stringarray, matcher->needles);
+
+  RAPTOR_FREE(raptor_memstr_matcher, matcher);
+}
+
+
+/*
+ * raptor_memstr_matcher_add:
+ * @matcher: matcher
+ * @needle: non-empty string to search for
+ *
+ * INTERNAL - Add a string to search for
+ *
+ * The @needle string is shared and must remain valid for the
+ * lifetime of the matcher.  Adding a string equal to one already
+ * added returns the existing index.  The matcher must be compiled
+ * with raptor_memstr_matcher_compile() before searching.
+ *
+ * Return value: index of the needle or <0 on failure
+ */
+int
+raptor_memstr_matcher_add(raptor_memstr_matcher* matcher, const char *needle)
+{
+  int i;
+
+  if(!needle || !*needle)
+    return -1;
+
+  for(i = 0; i < matcher->needles_count; i++) {
+    if(!strcmp(matcher->needles[i], needle))
+      return i;
+  }
+
+  if(matcher->needles_count == matcher->needles_size) {
+    int new_size = matcher->needles_size ? matcher->needles_size * 2 : 8;
+    const char** new_needles;
+
+    new_needles = RAPTOR_REALLOC(const char**, matcher->needles,
+                                 sizeof(const char*) * RAPTOR_GOOD_CAST(size_t, new_size));
+    if(!new_needles)
+      return -1;
+
+    matcher->needles = new_needles;
+    matcher->needles_size = new_size;
+  }
+
+  matcher->needles[matcher->needles_count] = needle;
+
+  raptor_memstr_matcher_clear_automaton(matcher);
+
+  return matcher->needles_count++;
+}
+
+
+/*
+ * raptor_memstr_matcher_get_count:
+ * @matcher: matcher
+ *
+ * INTERNAL - Get the number of different needles added
+ *
+ * Return value: number of needles
+ */
+int
+raptor_memstr_matcher_get_count(raptor_memstr_matcher* matcher)
+{
+  return matcher->needles_count;
+}
+
+
+/*
+ * raptor_memstr_matcher_compile:
+ * @matcher: matcher
+ *
+ * INTERNAL - Build the search automaton for the added needles
+ *
+ * Return value: non-0 on failure
+ */
+int
+raptor_memstr_matcher_compile(raptor_memstr_matcher* matcher)
+{
+  unsigned short* fail = NULL;
+  unsigned short* queue = NULL;
+  size_t max_states = 1;
+  int classes_count = 1;
+  int states_count = 1;
+  int head, tail;
+  int i;
+  int rc = 1;
+
+  raptor_memstr_matcher_clear_automaton(matcher);
+
+  memset(matcher->classes, 0, sizeof(matcher->classes));
+  for(i = 0; i < matcher->needles_count; i++) {
+    const unsigned char* p;
+
+    for(p = (const unsigned char*)matcher->needles[i]; *p; p++) {
+      if(!matcher->classes[*p])
+        matcher->classes[*p] = RAPTOR_GOOD_CAST(unsigned char, classes_count++);
+      max_states++;
+    }
+  }
+
+  /* states are stored in unsigned shorts */
+  if(max_states > 0xFFFF)
+    return 1;
+
+  matcher->classes_count = classes_count;
+
+  matcher->next = RAPTOR_CALLOC(unsigned short*, max_states * RAPTOR_GOOD_CAST(size_t, classes_count),
+                                sizeof(unsigned short));
+  matcher->match = RAPTOR_MALLOC(int*, max_states * sizeof(int));
+  matcher->match_link = RAPTOR_CALLOC(unsigned short*, max_states,
+                                      sizeof(unsigned short));
+  fail = RAPTOR_CALLOC(unsigned short*, max_states, sizeof(unsigned short));
+  queue = RAPTOR_MALLOC(unsigned short*, max_states * sizeof(unsigned short));
+  if(!matcher->next || !matcher->match || !matcher->match_link ||
+     !fail || !queue)
+    goto tidy;
+
+  for(i = 0; i < RAPTOR_GOOD_CAST(int, max_states); i++)
+    matcher->match[i] = -1;
+
+  /* build the trie of needles; 0 marks a missing child since the
+   * root is never a child */
+  for(i = 0; i < matcher->needles_count; i++) {
+    const unsigned char* p;
+    unsigned int state = 0;
+
+    for(p = (const unsigned char*)matcher->needles[i]; *p; p++) {
+      unsigned short* slot;
+
+      slot = &matcher->next[state * RAPTOR_GOOD_CAST(unsigned int, classes_count) + matcher->classes[*p]];
+      if(!*slot)
+        *slot = RAPTOR_GOOD_CAST(unsigned short, states_count++);
+      state = *slot;
+    }
+    matcher->match[state] = i;
+  }
+
+  /* walk the trie breadth first, setting the failure link of each
+   * child and filling in missing transitions from the failure state,
+   * which is always shallower and so already complete */
+  head = tail = 0;
+  for(i = 0; i < classes_count; i++) {
+    if(matcher->next[i])
+      queue[tail++] = matcher->next[i];
+  }
+
+  while(head < tail) {
+    unsigned int state = queue[head++];
+    unsigned short* row = &matcher->next[state * RAPTOR_GOOD_CAST(unsigned int, classes_count)];
+    unsigned short* fail_row = &matcher->next[fail[state] * RAPTOR_GOOD_CAST(unsigned int, classes_count)];
+
+    for(i = 0; i < classes_count; i++) {
+      unsigned short child = row[i];
+
+      if(child) {
+        unsigned short f = fail_row[i];
+
+        fail[child] = f;
+        matcher->match_link[child] = (matcher->match[f] >= 0) ? f : matcher->match_link[f];
+        queue[tail++] = child;
+      } else
+        row[i] = fail_row[i];
+    }
+  }
+
+  matcher->states_count = states_count;
+  rc = 0;
+
+  tidy:
+  if(fail)
+    RAPTOR_FREE(shortarray, fail);
+  if(queue)
+    RAPTOR_FREE(shortarray, queue);
+  if(rc)
+    raptor_memstr_matcher_clear_automaton(matcher);
+
+  return rc;
+}
+
+
+/*
+ * raptor_memstr_matcher_search:
+ * @matcher: compiled matcher
+ * @haystack: memory block to search in
+ * @haystack_len: size of memory block
+ * @found: array of raptor_memstr_matcher_get_count() flags to set
+ *
+ * INTERNAL - Search for all the needles in a block of memory in one pass
+ *
+ * Sets @found[i] to 1 if needle i is present in @haystack and 0
+ * otherwise.  As with raptor_memstr(), the searching will end if a
+ * NUL is found in @haystack.
+ *
+ * Return value: number of different needles found or <0 on failure
+ */
+int
+raptor_memstr_matcher_search(raptor_memstr_matcher* matcher,
+                             const char *haystack, size_t haystack_len,
+                             unsigned char* found)
+{
+  const unsigned char* p = (const unsigned char*)haystack;
+  const unsigned short* next = matcher->next;
+  const unsigned int classes_count = RAPTOR_GOOD_CAST(unsigned int, matcher->classes_count);
+  unsigned int state = 0;
+  int count = 0;
+
+  if(!next)
+    return -1;
+
+  if(matcher->needles_count)
+    memset(found, 0, RAPTOR_GOOD_CAST(size_t, matcher->needles_count));
+
+  if(!haystack)
+    return 0;
+
+  for(; haystack_len && *p; p++, haystack_len--) {
+    unsigned int s;
+
+    state = next[state * classes_count + matcher->classes[*p]];
+
+    s = (matcher->match[state] >= 0) ? state : matcher->match_link[state];
+    for(; s; s = matcher->match_link[s]) {
+      int i = matcher->match[s];
+
+      if(!found[i]) {
+        found[i] = 1;
+        count++;
+      }
+    }
+  }
+
+  return count;
+}
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+static const char *program;
+
+
+/*
+ * Search @haystack with @matcher and check every needle was found
+ * exactly when raptor_memstr() finds it.  Returns number of errors.
+ */
+static int
+test_memstr_matcher_compare(raptor_memstr_matcher* matcher,
+                            const char** needles, int needles_count,
+                            const char *haystack, size_t haystack_len)
+{
+  unsigned char found[64];
+  int expected_count = 0;
+  int count;
+  int failures = 0;
+  int i;
+
+  count = raptor_memstr_matcher_search(matcher, haystack, haystack_len,
+                                       found);
+
+  for(i = 0; i < needles_count; i++) {
+    int expected = (raptor_memstr(haystack, haystack_len, needles[i]) != NULL);
+
+    expected_count += expected;
+    if(found[i] != expected) {
+      fprintf(stderr,
+              "%s: Needle '%s' in '%.*s' (length %d) found %d, expected %d\n",
+              program, needles[i], (int)haystack_len, haystack,
+              (int)haystack_len, found[i], expected);
+      failures++;
+    }
+  }
+
+  if(count != expected_count) {
+    fprintf(stderr, "%s: Search of '%.*s' returned %d, expected %d\n",
+            program, (int)haystack_len, haystack, count, expected_count);
+    failures++;
+  }
+
+  return failures;
+}
+
+
+static raptor_memstr_matcher*
+test_new_memstr_matcher(raptor_world* world,
+                        const char** needles, int needles_count)
+{
+  raptor_memstr_matcher* matcher;
+  int i;
+
+  matcher = raptor_new_memstr_matcher(world);
+  if(!matcher) {
+    fprintf(stderr, "%s: Failed to create matcher\n", program);
+    return NULL;
+  }
+
+  for(i = 0; i < needles_count; i++) {
+    if(raptor_memstr_matcher_add(matcher, needles[i]) != i) {
+      fprintf(stderr, "%s: Adding needle '%s' did not return index %d\n",
+              program, needles[i], i);
+      raptor_free_memstr_matcher(matcher);
+      return NULL;
+    }
+  }
+
+  if(raptor_memstr_matcher_compile(matcher)) {
+    fprintf(stderr, "%s: Failed to compile matcher\n", program);
+    raptor_free_memstr_matcher(matcher);
+    return NULL;
+  }
+
+  return matcher;
+}
+
+
+/* needles that are prefixes, suffixes and infixes of each other */
+#define OVERLAP_NEEDLES_COUNT 7
+static const char* overlap_needles[OVERLAP_NEEDLES_COUNT] = {
+  "he", "she", "his", "hers", "e", "aaa", "aa"
+};
+
+/* each haystack is searched with every length up to its buffer size */
+#define OVERLAP_HAYSTACKS_COUNT 10
+static const struct {
+  const char* string;
+  size_t len;
+} overlap_haystacks[OVERLAP_HAYSTACKS_COUNT] = {
+  { "ushers", 6 },
+  { "hishers", 7 },
+  { "sh", 2 },
+  { "hershe", 6 },
+  { "aaaa", 4 },
+  { "xaax", 4 },
+  /* searching ends at a NUL */
+  { "h\0ers", 5 },
+  { "\0he", 3 },
+  { "", 0 },
+  { "no match here at all", 20 }
+};
+
+
+static int
+test_memstr_matcher_overlaps(raptor_world* world)
+{
+  raptor_memstr_matcher* matcher;
+  int failures = 0;
+  int i;
+
+  matcher = test_new_memstr_matcher(world, overlap_needles,
+                                    OVERLAP_NEEDLES_COUNT);
+  if(!matcher)
+    return 1;
+
+  for(i = 0; i < OVERLAP_HAYSTACKS_COUNT; i++) {
+    const char* haystack = overlap_haystacks[i].string;
+    size_t len;
+
+    /* every prefix so matches are cut at the end of the buffer */
+    for(len = 0; len <= overlap_haystacks[i].len; len++)
+      failures += test_memstr_matcher_compare(matcher, overlap_needles,
+                                              OVERLAP_NEEDLES_COUNT,
+                                              haystack, len);
+  }
+
+  /* a match that runs past the end of the buffer is not found */
+  failures += test_memstr_matcher_compare(matcher, overlap_needles,
+                                          OVERLAP_NEEDLES_COUNT,
+                                          "xxhers", 5);
+
+  raptor_free_memstr_matcher(matcher);
+
+  return failures;
+}
+
+
+static int
+test_memstr_matcher_api(raptor_world* world)
+{
+  raptor_memstr_matcher* matcher;
+  unsigned char found[2];
+  int failures = 0;
+
+  matcher = raptor_new_memstr_matcher(world);
+  if(!matcher) {
+    fprintf(stderr, "%s: Failed to create matcher\n", program);
+    return 1;
+  }
+
+  if(raptor_memstr_matcher_search(matcher, "abc", 3, found) >= 0) {
+    fprintf(stderr, "%s: Search before compile did not fail\n", program);
+    failures++;
+  }
+
+  if(raptor_memstr_matcher_add(matcher, "") >= 0 ||
+     raptor_memstr_matcher_add(matcher, NULL) >= 0) {
+    fprintf(stderr, "%s: Adding an empty needle did not fail\n", program);
+    failures++;
+  }
+
+  if(raptor_memstr_matcher_add(matcher, "abc") != 0 ||
+     raptor_memstr_matcher_add(matcher, "bcd") != 1 ||
+     raptor_memstr_matcher_add(matcher, "abc") != 0 ||
+     raptor_memstr_matcher_get_count(matcher) != 2) {
+    fprintf(stderr, "%s: Adding a duplicate needle gave a new index\n",
+            program);
+    failures++;
+  }
+
+  if(raptor_memstr_matcher_compile(matcher)) {
+    fprintf(stderr, "%s: Failed to compile matcher\n", program);
+    raptor_free_memstr_matcher(matcher);
+    return failures + 1;
+  }
+
+  if(raptor_memstr_matcher_search(matcher, NULL, 0, found) != 0 ||
+     found[0] || found[1]) {
+    fprintf(stderr, "%s: Search of NULL found something\n", program);
+    failures++;
+  }
+
+  if(raptor_memstr_matcher_search(matcher, "xabcdx", 6, found) != 2 ||
+     !found[0] || !found[1]) {
+    fprintf(stderr, "%s: Search of 'xabcdx' did not find both needles\n",
+            program);
+    failures++;
+  }
+
+  /* adding a needle needs the matcher compiling again */
+  raptor_memstr_matcher_add(matcher, "x");
+  if(raptor_memstr_matcher_search(matcher, "abc", 3, found) >= 0) {
+    fprintf(stderr, "%s: Search after adding a needle did not fail\n",
+            program);
+    failures++;
+  }
+
+  raptor_free_memstr_matcher(matcher);
+
+  return failures;
+}
+
+
+#define RANDOM_ROUNDS 200
+#define RANDOM_NEEDLES_MAX 12
+#define RANDOM_NEEDLE_LEN_MAX 5
+#define RANDOM_HAYSTACKS 20
+#define RANDOM_HAYSTACK_LEN_MAX 40
+
+static unsigned long test_random_state = 1;
+
+static int
+test_random(int n)
+{
+  test_random_state = test_random_state * 1103515245UL + 12345UL;
+  return (int)((test_random_state >> 16) % (unsigned long)n);
+}
+
+
+/* a 3 letter alphabet so that needles overlap often */
+static int
+test_memstr_matcher_random(raptor_world* world)
+{
+  char needle_buffers[RANDOM_NEEDLES_MAX][RANDOM_NEEDLE_LEN_MAX + 1];
+  const char* needles[RANDOM_NEEDLES_MAX];
+  char haystack[RANDOM_HAYSTACK_LEN_MAX];
+  int failures = 0;
+  int round;
+
+  for(round = 0; round < RANDOM_ROUNDS && !failures; round++) {
+    raptor_memstr_matcher* matcher;
+    int needles_count = 0;
+    int count = 1 + test_random(RANDOM_NEEDLES_MAX);
+    int i;
+
+    while(needles_count < count) {
+      char* needle = needle_buffers[needles_count];
+      int len = 1 + test_random(RANDOM_NEEDLE_LEN_MAX);
+      int j;
+
+      for(i = 0; i < len; i++)
+        needle[i] = (char)('a' + test_random(3));
+      needle[len] = '\0';
+
+      /* needles must be different to get their own index */
+      for(j = 0; j < needles_count; j++) {
+        if(!strcmp(needles[j], needle))
+          break;
+      }
+      if(j == needles_count)
+        needles[needles_count++] = needle;
+    }
+
+    matcher = test_new_memstr_matcher(world, needles, needles_count);
+    if(!matcher)
+      return failures + 1;
+
+    for(i = 0; i < RANDOM_HAYSTACKS; i++) {
+      size_t len = (size_t)test_random(RANDOM_HAYSTACK_LEN_MAX + 1);
+      size_t j;
+
+      for(j = 0; j < len; j++)
+        haystack[j] = (char)('a' + test_random(3));
+
+      failures += test_memstr_matcher_compare(matcher, needles,
+                                              needles_count, haystack, len);
+    }
+
+    raptor_free_memstr_matcher(matcher);
+  }
+
+  return failures;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  raptor_world *world;
+  int failures = 0;
+
+  program = raptor_basename(argv[0]);
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  failures += test_memstr_matcher_api(world);
+  failures += test_memstr_matcher_overlaps(world);
+  failures += test_memstr_matcher_random(world);
+
+  raptor_free_world(world);
+
+  if(failures)
+    fprintf(stderr, "%s: %d tests failed\n", program, failures);
+
+  return failures;
+}
+
+#endif /* STANDALONE */
@@ -103,6 +103,46 @@ raptor_ntriples_term_valid(unsigned char c, int position,
 }
 
 
+/*
+ * raptor_ntriples_term_is_plain:
+ * @string: term characters before the ending character
+ * @len: length of @string
+ * @term_class: string class
+ *
+ * INTERNAL - Check if a term can be copied without parsing each character
+ *
+ * Return value: non-0 if @string has no escapes, is valid UTF-8 and
+ * for a URI has no spaces
+ */
+static int
+raptor_ntriples_term_is_plain(const unsigned char *string, size_t len,
+                              raptor_ntriples_term_class term_class)
+{
+  unsigned int seen = 0;
+  size_t i;
+
+  /* collect the kinds of byte seen without branching on each one */
+  for(i = 0; i < len; i++) {
+    unsigned char c = string[i];
+
+    seen |= RAPTOR_GOOD_CAST(unsigned int, c == '\\') |
+            (RAPTOR_GOOD_CAST(unsigned int, c == ' ') << 1) |
+            RAPTOR_GOOD_CAST(unsigned int, c & 0x80);
+  }
+
+  if(seen & 1)
+    return 0;
+
+  if(term_class == RAPTOR_TERM_CLASS_URI && (seen & 2))
+    return 0;
+
+  if((seen & 0x80) && !raptor_unicode_check_utf8_string(string, len))
+    return 0;
+
+  return 1;
+}
+
+
 /*
  * raptor_ntriples_parse_term_internal:
  * @world: raptor world
@@ -113,6 +153,7 @@ raptor_ntriples_term_valid(unsigned char c, int position,
  * @dest_lenp: pointer to length of destination string (out)
  * @end_char: string ending character
  * @class: string class
+ * @trusted: non-0 to copy a term with no escapes without checking each character
  *
  * INTERNAL - Parse an N-Triples term with escapes.
  *
@@ -129,6 +170,10 @@ raptor_ntriples_term_valid(unsigned char c, int position,
  *
  * URIs may not have \t \b \n \r \f or raw ' ' or \u0020 or \u003C or \u003E
  *
+ * If @trusted is set, a term ending at @end_char that
+ * raptor_ntriples_term_is_plain() accepts is copied in one step;
+ * any other term is parsed as usual so that errors are reported.
+ *
  * Return value: Non 0 on failure
  **/
 static int
@@ -138,15 +183,44 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
                                     unsigned char *dest,
                                     size_t *lenp, size_t *dest_lenp,
                                     char end_char,
-                                    raptor_ntriples_term_class term_class)
+                                    raptor_ntriples_term_class term_class,
+                                    int trusted)
 {
   const unsigned char *p = *start;
+  /* input position that the locator has been advanced to */
+  const unsigned char *mark = p;
   unsigned char c = '\0';
   size_t ulen = 0;
   unsigned long unichar = 0;
   unsigned int position = 0;
   int end_char_seen = 0;
 
+  if(trusted && end_char) {
+    const unsigned char *end;
+
+    end = (const unsigned char*)memchr(p, end_char, *lenp);
+    if(end &&
+       raptor_ntriples_term_is_plain(p, RAPTOR_GOOD_CAST(size_t, end - p),
+                                     term_class)) {
+      size_t len = RAPTOR_GOOD_CAST(size_t, end - p);
+
+      memmove(dest, p, len);
+      dest[len] = '\0';
+
+      /* move past the end char */
+      p = end + 1;
+      *lenp -= len + 1;
+      RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
+
+      if(dest_lenp)
+        *dest_lenp = p - *start;
+
+      *start = p;
+
+      return 0;
+    }
+  }
+
   /* find end of string, fixing backslashed characters on the way */
   while(*lenp > 0) {
     int unichar_width;
@@ -155,12 +229,9 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
 
     p++;
     (*lenp)--;
-    if(locator) {
-      locator->column++;
-      locator->byte++;
-    }
 
     if(term_class == RAPTOR_TERM_CLASS_URI && c == ' ') {
+      RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
       raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator,
                                  "URI error - illegal character %d (0x%02X) found.",
                                  c, RAPTOR_GOOD_CAST(unsigned int, c));
@@ -172,6 +243,7 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
       int unichar_len;
       unichar_len = raptor_unicode_utf8_string_get_char(p - 1, 1 + *lenp, NULL);
       if(unichar_len < 0 || RAPTOR_GOOD_CAST(size_t, unichar_len) > *lenp) {
+        RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
         raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator,
                                    "UTF-8 encoding error at character %d (0x%02X) found.",
                                    c, RAPTOR_GOOD_CAST(unsigned int, c));
@@ -185,10 +257,6 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
 
       p += unichar_len;
       (*lenp) -= unichar_len;
-      if(locator) {
-        locator->column += unichar_len;
-        locator->byte += unichar_len;
-      }
       continue;
     }
 
@@ -202,26 +270,19 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
       if(!raptor_ntriples_term_valid(c, position, term_class)) {
         if(end_char) {
           /* end char was expected, so finding an invalid thing is an error */
+          RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
           raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Missing terminating '%c' (found '%c')", end_char, c);
           return 0;
         } else {
           /* it's the end - so rewind 1 to save next char */
           p--;
           (*lenp)++;
-          if(locator) {
-            locator->column--;
-            locator->byte--;
-          }
           if(term_class == RAPTOR_TERM_CLASS_BNODEID && dest[-1] == '.') {
             /* If bnode id ended on '.' move back one */
             dest--;
 
             p--;
             (*lenp)++;
-            if(locator) {
-              locator->column--;
-              locator->byte--;
-            }
           }
           break;
         }
@@ -234,6 +295,7 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
     }
 
     if(!*lenp) {
+      RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
       raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "\\ at end of input.");
       return 0;
     }
@@ -242,10 +304,6 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
 
     p++;
     (*lenp)--;
-    if(locator) {
-      locator->column++;
-      locator->byte++;
-    }
 
     switch(c) {
       case '"':
@@ -258,6 +316,7 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
       case 'r':
       case 't':
         if(term_class == RAPTOR_TERM_CLASS_URI) {
+          RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
           raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "URI error - illegal URI escape '\\%c'.", c);
           return 1;
         }
@@ -289,6 +348,7 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
         ulen = (c == 'u') ? 4 : 8;
 
         if(*lenp < ulen) {
+          RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
           raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "%c over end of input.", c);
           return 0;
         }
@@ -300,6 +360,7 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
           for(ii = 0; ii < ulen; ii++) {
             char cc = p[ii];
             if(!isxdigit(RAPTOR_GOOD_CAST(char, cc))) {
+              RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
               raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "N-Triples string error - illegal hex digit %c in Unicode escape '%c%s...'",
                             cc, c, p);
               n = 1;
@@ -312,6 +373,7 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
 
           n = sscanf((const char*)p, ((ulen == 4) ? "%04lx" : "%08lx"), &unichar);
           if(n != 1) {
+            RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
             raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Illegal Uncode escape '%c%s...'", c, p);
             break;
           }
@@ -319,24 +381,23 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
 
         p += ulen;
         (*lenp) -= ulen;
-        if(locator) {
-          locator->column += RAPTOR_GOOD_CAST(int, ulen);
-          locator->byte += RAPTOR_GOOD_CAST(int, ulen);
-        }
 
         if(term_class == RAPTOR_TERM_CLASS_URI &&
            (unichar == 0x0020 || unichar == 0x003C || unichar == 0x003E)) {
+          RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
           raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "URI error - illegal Unicode escape \\u%04lX in URI.", unichar);
           break;
         }
 
         if(unichar > raptor_unicode_max_codepoint) {
+          RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
           raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Illegal Unicode character with code point #x%lX (max #x%lX).", unichar, raptor_unicode_max_codepoint);
           break;
         }
 
         unichar_width = raptor_unicode_utf8_string_put_char(unichar, dest, 4);
         if(unichar_width < 0) {
+          RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
           raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Illegal Unicode character with code point #x%lX.", unichar);
           break;
         }
@@ -351,6 +412,7 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
         break;
 
       default:
+        RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
         raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Illegal string escape \\%c in \"%s\"", c, (char*)start);
         return 0;
     }
@@ -360,6 +422,7 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
 
 
   if(end_char && !end_char_seen) {
+    RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
     raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Missing terminating '%c' before end of input.", end_char);
     return 1;
   }
@@ -367,6 +430,8 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
   /* terminate dest, can be shorter than source */
   *dest = '\0';
 
+  RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
+
   if(dest_lenp)
     *dest_lenp = p - *start;
 
@@ -378,7 +443,6 @@ raptor_ntriples_parse_term_internal(raptor_world* world,
 
 static int
 raptor_parse_turtle_term_internal(raptor_world* world,
-                                  raptor_locator* locator,
                                   const unsigned char **start,
                                   unsigned char *dest,
                                   size_t *len_p, size_t *dest_lenp,
@@ -410,10 +474,6 @@ raptor_parse_turtle_term_internal(raptor_world* world,
 
     p++;
     (*len_p)--;
-    if(locator) {
-      locator->column++;
-      locator->byte++;
-    }
 
     *dest++ = c;
 
@@ -445,7 +505,9 @@ raptor_parse_turtle_term_internal(raptor_world* world,
  * @string: string input (in)
  * @len_p: pointer to length of @string (in/out)
  * @term_p: pointer to store term (out)
- * @allow_turtle: non-0 to allow Turtle forms such as integers, boolean
+ * @flags: bitmask of RAPTOR_NTRIPLES_TERM_ALLOW_TURTLE to allow Turtle
+ *   forms such as integers, boolean and RAPTOR_NTRIPLES_TERM_TRUSTED to
+ *   copy URIs and strings with no escapes without checking each character
  *
  * INTERNAL - Parse an N-Triples string into a #raptor_term
  *
@@ -458,9 +520,15 @@ raptor_parse_turtle_term_internal(raptor_world* world,
 size_t
 raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
                            unsigned char *string, size_t *len_p,
-                           raptor_term** term_p, int allow_turtle)
+                           raptor_term** term_p, int flags)
 {
+  int allow_turtle = (flags & RAPTOR_NTRIPLES_TERM_ALLOW_TURTLE) != 0;
+  int trusted = (flags & RAPTOR_NTRIPLES_TERM_TRUSTED) != 0;
   unsigned char *p = string;
+  /* input position that the locator has been advanced to; the
+   * locator is only advanced before it is used and by
+   * raptor_ntriples_parse_term_internal() for the bytes it consumes */
+  const unsigned char *mark = string;
   unsigned char *dest;
   size_t term_length = 0;
 
@@ -470,17 +538,17 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
 
       p++;
       (*len_p)--;
-      if(locator) {
-        locator->column++;
-        locator->byte++;
-      }
+
+      RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
 
       if(raptor_ntriples_parse_term_internal(world, locator,
                                              (const unsigned char**)&p,
                                              dest, len_p, &term_length,
-                                             '>', RAPTOR_TERM_CLASS_URI)) {
+                                             '>', RAPTOR_TERM_CLASS_URI,
+                                             trusted)) {
         goto fail;
       }
+      mark = p;
 
       if(1) {
         raptor_uri *uri;
@@ -489,16 +557,20 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
         if(!strncmp((const char*)dest,
                     "http://www.w3.org/1999/02/22-rdf-syntax-ns#_", 44)) {
           int ordinal = raptor_check_ordinal(dest + 44);
-          if(ordinal <= 0)
+          if(ordinal <= 0) {
+            RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
             raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Illegal ordinal value %d in property '%s'.", ordinal, dest);
+          }
         }
         if(raptor_uri_uri_string_is_absolute(dest) <= 0) {
+          RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
           raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "URI '%s' is not absolute.", dest);
           goto fail;
         }
 
         uri = raptor_new_uri(world, dest);
         if(!uri) {
+          RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
           raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Could not create URI for '%s'", (const char *)dest);
           goto fail;
         }
@@ -525,7 +597,7 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
 
         dest = p;
 
-        if(raptor_parse_turtle_term_internal(world, locator,
+        if(raptor_parse_turtle_term_internal(world,
                                              (const unsigned char**)&p,
                                              dest, len_p, &term_length,
                                              &datatype_uri)) {
@@ -545,17 +617,17 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
 
       p++;
       (*len_p)--;
-      if(locator) {
-        locator->column++;
-        locator->byte++;
-      }
+
+      RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
 
       if(raptor_ntriples_parse_term_internal(world, locator,
                                              (const unsigned char**)&p,
                                              dest, len_p, &term_length,
-                                             '"', RAPTOR_TERM_CLASS_STRING)) {
+                                             '"', RAPTOR_TERM_CLASS_STRING,
+                                             trusted)) {
         goto fail;
       }
+      mark = p;
 
       if(1) {
         unsigned char *object_literal_language = NULL;
@@ -571,24 +643,26 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
           /* Skip - */
           p++;
           (*len_p)--;
-          if(locator) {
-            locator->column++;
-            locator->byte++;
-          }
 
           if(!*len_p) {
+            RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
             raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Missing language after \"string\"-");
             goto fail;
           }
 
+          RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
+
           if(raptor_ntriples_parse_term_internal(world, locator,
                                   (const unsigned char**)&p,
                                   object_literal_language, len_p, &lang_len,
-                                  '\0', RAPTOR_TERM_CLASS_LANGUAGE)) {
+                                  '\0', RAPTOR_TERM_CLASS_LANGUAGE,
+                                  trusted)) {
             goto fail;
           }
+          mark = p;
 
           if(!lang_len) {
+            RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
             raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Invalid language tag at @%s", p);
             goto fail;
           }
@@ -613,31 +687,29 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
           /* Skip ^^ */
           p += 2;
           *len_p -= 2;
-          if(locator) {
-            locator->column += 2;
-            locator->byte += 2;
-          }
 
           if(!*len_p || (*len_p && *p != '<')) {
+            RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
             raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Missing datatype URI-ref in\"string\"^^<URI-ref> after ^^");
             goto fail;
           }
 
           p++;
           (*len_p)--;
-          if(locator) {
-            locator->column++;
-            locator->byte++;
-          }
+
+          RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
 
           if(raptor_ntriples_parse_term_internal(world, locator,
                                   (const unsigned char**)&p,
                                   object_literal_datatype, len_p, NULL,
-                                  '>', RAPTOR_TERM_CLASS_URI)) {
+                                  '>', RAPTOR_TERM_CLASS_URI,
+                                  trusted)) {
             goto fail;
           }
+          mark = p;
 
           if(raptor_uri_uri_string_is_absolute(object_literal_datatype) <= 0) {
+            RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
             raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Datatype URI '%s' is not absolute.", object_literal_datatype);
             goto fail;
           }
@@ -645,6 +717,7 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
         }
 
         if(object_literal_datatype && object_literal_language) {
+          RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
           raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Typed literal used with a language - ignoring the language");
           object_literal_language = NULL;
         }
@@ -653,6 +726,7 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
           datatype_uri = raptor_new_uri(world,
                                         object_literal_datatype);
           if(!datatype_uri) {
+            RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
             raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Could not create literal datatype uri '%s'", object_literal_datatype);
             goto fail;
           }
@@ -676,12 +750,9 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
 
         p++;
         (*len_p)--;
-        if(locator) {
-          locator->column++;
-          locator->byte++;
-        }
 
         if(!*len_p || (*len_p > 0 && *p != ':')) {
+          RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
           raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Illegal bNodeID - _ not followed by :");
           goto fail;
         }
@@ -690,20 +761,21 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
 
         p++;
         (*len_p)--;
-        if(locator) {
-          locator->column++;
-          locator->byte++;
-        }
+
+        RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
 
         if(raptor_ntriples_parse_term_internal(world, locator,
                                                (const unsigned char**)&p,
                                                dest, len_p, &term_length,
                                                '\0',
-                                               RAPTOR_TERM_CLASS_BNODEID)) {
+                                               RAPTOR_TERM_CLASS_BNODEID,
+                                               trusted)) {
           goto fail;
         }
+        mark = p;
 
         if(!term_length) {
+          RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
           raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, locator, "Bad or missing bNodeID after _:");
           goto fail;
         }
@@ -718,6 +790,7 @@ raptor_ntriples_parse_term(raptor_world* world, raptor_locator* locator,
     }
 
   fail:
+  RAPTOR_LOCATOR_ADVANCE(locator, mark, p);
 
   return p - string;
 }
@@ -296,6 +296,42 @@ static const struct
     RAPTOR_OPTION_VALUE_TYPE_BOOL,
     "loadExternalEntities",
     "Parsers and SAX2 should load external entities."
+  },
+  { RAPTOR_OPTION_WRITE_THREADS,
+    RAPTOR_OPTION_AREA_SERIALIZER,
+    RAPTOR_OPTION_VALUE_TYPE_INT,
+    "writeThreads",
+    "Threads used to format N-Triples and N-Quads output"
+  },
+  { RAPTOR_OPTION_GRDDL_CACHE_DIRECTORY,
+    RAPTOR_OPTION_AREA_PARSER,
+    RAPTOR_OPTION_VALUE_TYPE_STRING,
+    "grddlCacheDirectory",
+    "Directory to save fetched GRDDL XSLT stylesheets in"
+  },
+  { RAPTOR_OPTION_RSS_STREAMING,
+    RAPTOR_OPTION_AREA_PARSER,
+    RAPTOR_OPTION_VALUE_TYPE_BOOL,
+    "rssStreaming",
+    "Emit RSS and Atom items as they end"
+  },
+  { RAPTOR_OPTION_JSON_STREAMING,
+    RAPTOR_OPTION_AREA_SERIALIZER,
+    RAPTOR_OPTION_VALUE_TYPE_BOOL,
+    "jsonStreaming",
+    "Write RDF/JSON subjects as they end, for input grouped by subject"
+  },
+  { RAPTOR_OPTION_JSON_SORT_LIMIT,
+    RAPTOR_OPTION_AREA_SERIALIZER,
+    RAPTOR_OPTION_VALUE_TYPE_INT,
+    "jsonSortLimit",
+    "RDF/JSON statements held in memory before sorting through files"
+  },
+  { RAPTOR_OPTION_NTRIPLES_TRUSTED,
+    RAPTOR_OPTION_AREA_PARSER,
+    RAPTOR_OPTION_VALUE_TYPE_BOOL,
+    "ntriplesTrusted",
+    "Read N-Triples and N-Quads as trusted one statement per line input"
   }
 };
 
@@ -53,6 +53,8 @@
 
 /* prototypes for helper functions */
 static void raptor_parser_set_strict(raptor_parser* rdf_parser, int is_strict);
+static void raptor_free_parser_pull(raptor_parser_pull* pull);
+static void raptor_parser_pull_end(raptor_parser* rdf_parser);
 
 /* helper methods */
 
@@ -68,6 +70,69 @@ raptor_free_parser_factory(raptor_parser_factory* factory)
 }
 
 
+/*
+ * raptor_parsers_init_patterns:
+ * @world: raptor world
+ *
+ * INTERNAL - Build the matcher for all parser factories' recognise patterns
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_parsers_init_patterns(raptor_world *world)
+{
+  raptor_memstr_matcher* matcher;
+  raptor_parser_factory *factory;
+  int i;
+
+  if(world->parser_patterns) {
+    raptor_free_memstr_matcher(world->parser_patterns);
+    world->parser_patterns = NULL;
+  }
+
+  matcher = raptor_new_memstr_matcher(world);
+  if(!matcher)
+    return 1;
+
+  for(i = 0;
+      (factory = (raptor_parser_factory*)raptor_sequence_get_at(world->parsers, i));
+      i++) {
+    int j;
+
+    if(!factory->recognise_patterns)
+      continue;
+
+    for(j = 0; factory->recognise_patterns[j]; j++) {
+      int id;
+
+      if(j == RAPTOR_RECOGNISE_PATTERNS_MAX) {
+        raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                                   "Parser %s has more than %d recognise patterns",
+                                   factory->desc.names[0],
+                                   RAPTOR_RECOGNISE_PATTERNS_MAX);
+        goto failed;
+      }
+
+      id = raptor_memstr_matcher_add(matcher, factory->recognise_patterns[j]);
+      if(id < 0)
+        goto failed;
+
+      factory->recognise_pattern_ids[j] = id;
+    }
+  }
+
+  if(raptor_memstr_matcher_compile(matcher))
+    goto failed;
+
+  world->parser_patterns = matcher;
+  return 0;
+
+  failed:
+  raptor_free_memstr_matcher(matcher);
+  return 1;
+}
+
+
 /* class methods */
 
 int
@@ -128,6 +193,13 @@ raptor_parsers_init(raptor_world *world)
   rc+= raptor_init_parser_nquads(world) != 0;
 #endif
 
+#ifdef RAPTOR_PARSER_BINARY
+  rc+= raptor_init_parser_binary(world) != 0;
+#endif
+
+  if(!rc)
+    rc = raptor_parsers_init_patterns(world);
+
   return rc;
 }
 
@@ -138,6 +210,10 @@ raptor_parsers_init(raptor_world *world)
 void
 raptor_parsers_finish(raptor_world *world)
 {
+  if(world->parser_patterns) {
+    raptor_free_memstr_matcher(world->parser_patterns);
+    world->parser_patterns = NULL;
+  }
   if(world->parsers) {
     raptor_free_sequence(world->parsers);
     world->parsers = NULL;
@@ -175,6 +251,12 @@ raptor_world_register_parser_factory(raptor_world* world,
 
   parser->desc.mime_types = NULL;
   
+  /* rebuilt with this factory's patterns by the next guess */
+  if(world->parser_patterns) {
+    raptor_free_memstr_matcher(world->parser_patterns);
+    world->parser_patterns = NULL;
+  }
+
   if(raptor_sequence_push(world->parsers, parser))
     return NULL; /* on error, parser is already freed by the sequence */
   
@@ -431,6 +513,9 @@ raptor_new_parser_for_content(raptor_world* world,
 int
 raptor_parser_parse_start(raptor_parser *rdf_parser, raptor_uri *uri) 
 {
+  if(rdf_parser->pull)
+    raptor_parser_pull_end(rdf_parser);
+
   if((rdf_parser->factory->desc.flags & RAPTOR_SYNTAX_NEED_BASE_URI) && !uri) {
     raptor_parser_error(rdf_parser, "Missing base URI for %s parser.",
                         rdf_parser->factory->desc.names[0]);
@@ -449,6 +534,10 @@ raptor_parser_parse_start(raptor_parser *rdf_parser, raptor_uri *uri)
   rdf_parser->locator.column = -1;
   rdf_parser->locator.byte   = -1;
 
+  /* a parser may be reused after an earlier parse failed or aborted */
+  rdf_parser->failed = 0;
+  rdf_parser->emitted_default_graph = 0;
+
   if(rdf_parser->factory->start)
     return rdf_parser->factory->start(rdf_parser);
   else
@@ -511,6 +600,9 @@ raptor_free_parser(raptor_parser* rdf_parser)
   if(rdf_parser->sb)
     raptor_free_stringbuffer(rdf_parser->sb);
 
+  if(rdf_parser->pull)
+    raptor_free_parser_pull(rdf_parser->pull);
+
   raptor_object_options_clear(&rdf_parser->options);
 
   RAPTOR_FREE(raptor_parser, rdf_parser);
@@ -569,6 +661,9 @@ raptor_parser_parse_file_stream(raptor_parser* rdf_parser,
  * Parse RDF content at a file URI.
  *
  * If @uri is NULL (source is stdin), then the @base_uri is required.
+ *
+ * Content compressed with gzip or Zstandard is detected from its
+ * leading bytes and decompressed while parsing.
  * 
  * Return value: non 0 on failure
  **/
@@ -580,6 +675,8 @@ raptor_parser_parse_file(raptor_parser* rdf_parser, raptor_uri *uri,
   int free_base_uri = 0;
   const char *filename = NULL;
   FILE *fh = NULL;
+  raptor_iostream *iostr = NULL;
+  raptor_locator *locator = &rdf_parser->locator;
 #if defined(HAVE_UNISTD_H) && defined(HAVE_SYS_STAT_H)
   struct stat buf;
 #endif
@@ -613,9 +710,56 @@ raptor_parser_parse_file(raptor_parser* rdf_parser, raptor_uri *uri,
     fh = stdin;
   }
 
-  rc = raptor_parser_parse_file_stream(rdf_parser, fh, filename, base_uri);
+  locator->line= locator->column = -1;
+  locator->file= filename;
+
+  if(raptor_parser_parse_start(rdf_parser, base_uri)) {
+    rc = 1;
+    goto cleanup;
+  }
+
+  /* Let a parser that can take the whole file at once do so */
+  if(uri && rdf_parser->factory->parse_file_handle) {
+    rc = rdf_parser->factory->parse_file_handle(rdf_parser, fh);
+    if(rc >= 0) {
+      rc = (rc != 0);
+      goto cleanup;
+    }
+    rc = 0;
+  }
+
+  iostr = raptor_new_iostream_from_file_handle_compressed(rdf_parser->world, fh,
+                                                          RAPTOR_COMPRESSION_AUTO);
+  if(!iostr) {
+    raptor_parser_error(rdf_parser, "Cannot read from '%s'",
+                        filename ? filename : "<stdin>");
+    rc = 1;
+    goto cleanup;
+  }
+
+  while(!rc && !raptor_iostream_read_eof(iostr)) {
+    int ilen;
+    size_t len;
+    int is_end;
+
+    ilen = raptor_iostream_read_bytes(rdf_parser->buffer, 1,
+                                      RAPTOR_READ_BUFFER_SIZE, iostr);
+    if(ilen < 0) {
+      rc = 1;
+      break;
+    }
+    len = RAPTOR_GOOD_CAST(size_t, ilen);
+    is_end = (len < RAPTOR_READ_BUFFER_SIZE);
+    rdf_parser->buffer[len] = '\0';
+    rc = raptor_parser_parse_chunk(rdf_parser, rdf_parser->buffer, len, is_end);
+    if(is_end)
+      break;
+  }
+  rc = (rc != 0);
 
   cleanup:
+  if(iostr)
+    raptor_free_iostream(iostr);
   if(uri) {
     if(fh)
       fclose(fh);
@@ -1286,11 +1430,16 @@ raptor_world_guess_parser_name(raptor_world* world,
   raptor_parser_factory *factory;
   unsigned char *suffix = NULL;
   struct syntax_score* scores;
+  unsigned char* found = NULL;
+  int searched = 0;
 
   RAPTOR_ASSERT_OBJECT_POINTER_RETURN_VALUE(world, raptor_world, NULL);
 
   raptor_world_open(world);
 
+  if(!world->parser_patterns && raptor_parsers_init_patterns(world))
+    return NULL;
+
   scores = RAPTOR_CALLOC(struct syntax_score*,
                          raptor_sequence_size(world->parsers),
                          sizeof(struct syntax_score));
@@ -1366,6 +1515,7 @@ raptor_world_guess_parser_name(raptor_world* world,
     
     if(factory->recognise_syntax) {
       int c = -1;
+      unsigned int patterns = 0;
     
       /* Only use first N bytes to avoid HTML documents that contain
        * RDF/XML examples
@@ -1374,12 +1524,38 @@ raptor_world_guess_parser_name(raptor_world* world,
 #if FIRSTN > RAPTOR_READ_BUFFER_SIZE
 #error "RAPTOR_READ_BUFFER_SIZE is not large enough"
 #endif
+      if(factory->recognise_patterns && buffer && len) {
+        int j;
+
+        /* search for every factory's patterns once, when first needed */
+        if(!searched) {
+          searched = 1;
+          found = RAPTOR_CALLOC(unsigned char*,
+                                raptor_memstr_matcher_get_count(world->parser_patterns) + 1,
+                                sizeof(unsigned char));
+          if(!found ||
+             raptor_memstr_matcher_search(world->parser_patterns,
+                                          (const char*)buffer,
+                                          len > FIRSTN ? FIRSTN : len,
+                                          found) < 0) {
+            factory = NULL;
+            i = 0;
+            break;
+          }
+        }
+
+        for(j = 0; factory->recognise_patterns[j]; j++) {
+          if(found[factory->recognise_pattern_ids[j]])
+            patterns |= (1U << j);
+        }
+      }
+
       if(buffer && len && len > FIRSTN) {
         c = buffer[FIRSTN];
         ((char*)buffer)[FIRSTN] = '\0';
       }
 
-      score += factory->recognise_syntax(factory, buffer, len, 
+      score += factory->recognise_syntax(factory, buffer, len, patterns,
                                          identifier, suffix, 
                                          mime_type);
 
@@ -1394,7 +1570,7 @@ raptor_world_guess_parser_name(raptor_world* world,
 #endif
   }
   
-  if(!factory) {
+  if(!factory && i) {
     /* sort the scores and pick a factory if score is good enough */
     qsort(scores, i, sizeof(struct syntax_score), compare_syntax_score);
 
@@ -1402,6 +1578,9 @@ raptor_world_guess_parser_name(raptor_world* world,
       factory = scores[0].factory;
   }
 
+  if(found)
+    RAPTOR_FREE(char*, found);
+
   if(suffix)
     RAPTOR_FREE(char*, suffix);
 
@@ -1745,8 +1924,10 @@ raptor_parser_parse_iostream(raptor_parser* rdf_parser, raptor_iostream *iostr,
 
     ilen = raptor_iostream_read_bytes(rdf_parser->buffer, 1,
                                       RAPTOR_READ_BUFFER_SIZE, iostr);
-    if(ilen < 0)
+    if(ilen < 0) {
+      rc = 1;
       break;
+    }
     len = RAPTOR_GOOD_CAST(size_t, ilen);
     is_end = (len < RAPTOR_READ_BUFFER_SIZE);
 
@@ -1759,6 +1940,270 @@ raptor_parser_parse_iostream(raptor_parser* rdf_parser, raptor_iostream *iostr,
 }
 
 
+/*
+ * Pull parsing state for raptor_parser_next_statement()
+ *
+ * While pulling, the parser statement and graph mark handlers are
+ * replaced by ones that buffer copies of the statements and pass the
+ * graph marks on.  The caller's handlers and user data are put back
+ * when pulling ends.
+ */
+struct raptor_parser_pull_s {
+  /* iostream being parsed or NULL when not pulling */
+  raptor_iostream* iostr;
+
+  /* statements from the last chunk; the storage is reused */
+  raptor_statement* statements;
+  int size;
+  int count;
+
+  /* index of the next statement to return */
+  int next;
+
+  /* 0 while parsing, >0 at the end of content, <0 after a failure */
+  int status;
+
+  /* caller's handlers */
+  void* user_data;
+  raptor_statement_handler statement_handler;
+  raptor_graph_mark_handler graph_mark_handler;
+};
+
+
+static void
+raptor_free_parser_pull(raptor_parser_pull* pull)
+{
+  int i;
+
+  for(i = 0; i < pull->size; i++)
+    raptor_statement_clear(&pull->statements[i]);
+  if(pull->statements)
+    RAPTOR_FREE(raptor_statement*, pull->statements);
+  RAPTOR_FREE(raptor_parser_pull, pull);
+}
+
+
+/*
+ * raptor_parser_pull_end:
+ * @rdf_parser: parser
+ *
+ * INTERNAL - Stop pulling, dropping any statements not yet returned
+ * and restoring the caller's handlers
+ */
+static void
+raptor_parser_pull_end(raptor_parser* rdf_parser)
+{
+  raptor_parser_pull* pull = rdf_parser->pull;
+  int i;
+
+  if(!pull->iostr)
+    return;
+
+  for(i = 0; i < pull->count; i++)
+    raptor_statement_clear(&pull->statements[i]);
+  pull->count = 0;
+  pull->next = 0;
+  pull->iostr = NULL;
+
+  rdf_parser->user_data = pull->user_data;
+  rdf_parser->statement_handler = pull->statement_handler;
+  rdf_parser->graph_mark_handler = pull->graph_mark_handler;
+}
+
+
+static void
+raptor_parser_pull_statement_handler(void *user_data,
+                                     raptor_statement *statement)
+{
+  raptor_parser* rdf_parser = (raptor_parser*)user_data;
+  raptor_parser_pull* pull = rdf_parser->pull;
+  raptor_statement* copy;
+
+  if(pull->count == pull->size) {
+    raptor_statement* statements;
+    int size = pull->size ? pull->size << 1 : 64;
+    int i;
+
+    statements = RAPTOR_REALLOC(raptor_statement*, pull->statements,
+                                RAPTOR_GOOD_CAST(size_t, size) * sizeof(*statements));
+    if(!statements) {
+      raptor_parser_fatal_error(rdf_parser, "Out of memory");
+      raptor_parser_parse_abort(rdf_parser);
+      return;
+    }
+    for(i = pull->size; i < size; i++)
+      raptor_statement_init(&statements[i], rdf_parser->world);
+    pull->statements = statements;
+    pull->size = size;
+  }
+
+  /* terms are shared by reference so this does not copy strings */
+  copy = &pull->statements[pull->count++];
+  copy->subject = raptor_term_copy(statement->subject);
+  copy->predicate = raptor_term_copy(statement->predicate);
+  copy->object = raptor_term_copy(statement->object);
+  copy->graph = raptor_term_copy(statement->graph);
+}
+
+
+static void
+raptor_parser_pull_graph_mark_handler(void *user_data, raptor_uri *graph,
+                                      int flags)
+{
+  raptor_parser* rdf_parser = (raptor_parser*)user_data;
+  raptor_parser_pull* pull = rdf_parser->pull;
+
+  if(pull->graph_mark_handler)
+    pull->graph_mark_handler(pull->user_data, graph, flags);
+}
+
+
+/**
+ * raptor_parser_parse_iostream_start:
+ * @rdf_parser: parser
+ * @iostr: iostream to read from
+ * @base_uri: the base URI to use (or NULL)
+ *
+ * Start parsing content from an iostream, returning statements with
+ * raptor_parser_next_statement()
+ *
+ * Content is read from @iostr and parsed a chunk at a time as
+ * raptor_parser_next_statement() needs more statements.  The caller
+ * keeps ownership of @iostr which must stay valid until
+ * raptor_parser_next_statement() returns non-0 or the parser is
+ * started again or freed.
+ *
+ * The statement handler is not called for these statements.  Graph
+ * marks and namespaces are still passed to their handlers as the
+ * content is parsed, so they can arrive ahead of the statements
+ * returned.
+ *
+ * If the parser requires a base URI and @base_uri is NULL, an error
+ * will be generated and the function will fail.
+ *
+ * Return value: non 0 on failure, <0 if a required base URI was missing
+ **/
+int
+raptor_parser_parse_iostream_start(raptor_parser* rdf_parser,
+                                   raptor_iostream *iostr,
+                                   raptor_uri *base_uri)
+{
+  raptor_parser_pull* pull;
+  int rc;
+
+  RAPTOR_ASSERT_OBJECT_POINTER_RETURN_VALUE(rdf_parser, raptor_parser, 1);
+  RAPTOR_ASSERT_OBJECT_POINTER_RETURN_VALUE(iostr, raptor_iostr, 1);
+
+  rc = raptor_parser_parse_start(rdf_parser, base_uri);
+  if(rc)
+    return rc;
+
+  pull = rdf_parser->pull;
+  if(!pull) {
+    pull = RAPTOR_CALLOC(raptor_parser_pull*, 1, sizeof(*pull));
+    if(!pull) {
+      raptor_parser_fatal_error(rdf_parser, "Out of memory");
+      return 1;
+    }
+    rdf_parser->pull = pull;
+  }
+
+  pull->iostr = iostr;
+  pull->status = 0;
+  pull->user_data = rdf_parser->user_data;
+  pull->statement_handler = rdf_parser->statement_handler;
+  pull->graph_mark_handler = rdf_parser->graph_mark_handler;
+
+  rdf_parser->user_data = rdf_parser;
+  rdf_parser->statement_handler = raptor_parser_pull_statement_handler;
+  rdf_parser->graph_mark_handler = raptor_parser_pull_graph_mark_handler;
+
+  return 0;
+}
+
+
+/**
+ * raptor_parser_next_statement:
+ * @rdf_parser: parser
+ * @statement_p: pointer to store the next statement
+ *
+ * Get the next statement from content started with
+ * raptor_parser_parse_iostream_start()
+ *
+ * More content is read and parsed only when the statements from the
+ * last chunk have all been returned, so the caller can stop at any
+ * point without calling raptor_parser_parse_abort().
+ *
+ * The statement returned in *@statement_p is owned by the parser and
+ * is valid until the next call; it must be copied with
+ * raptor_statement_copy() or its terms with raptor_term_copy() to be
+ * kept.  The statement storage is reused between calls.
+ *
+ * When this returns non-0 pulling has ended and the statement and
+ * graph mark handlers set before raptor_parser_parse_iostream_start()
+ * are restored.
+ *
+ * Return value: 0 if a statement was returned, >0 at the end of the
+ * content or <0 on failure
+ **/
+int
+raptor_parser_next_statement(raptor_parser* rdf_parser,
+                             raptor_statement** statement_p)
+{
+  raptor_parser_pull* pull;
+
+  RAPTOR_ASSERT_OBJECT_POINTER_RETURN_VALUE(rdf_parser, raptor_parser, -1);
+  RAPTOR_ASSERT_OBJECT_POINTER_RETURN_VALUE(statement_p, raptor_statement_p, -1);
+
+  *statement_p = NULL;
+
+  pull = rdf_parser->pull;
+  if(!pull || !pull->iostr)
+    return -1;
+
+  /* release the statement returned last time */
+  if(pull->next)
+    raptor_statement_clear(&pull->statements[pull->next - 1]);
+
+  while(pull->next == pull->count) {
+    int ilen;
+    size_t len;
+    int is_end;
+
+    pull->count = 0;
+    pull->next = 0;
+
+    if(pull->status) {
+      int status = pull->status;
+      raptor_parser_pull_end(rdf_parser);
+      return status;
+    }
+
+    if(raptor_iostream_read_eof(pull->iostr)) {
+      /* the content ended exactly on a chunk boundary */
+      ilen = 0;
+    } else {
+      ilen = raptor_iostream_read_bytes(rdf_parser->buffer, 1,
+                                        RAPTOR_READ_BUFFER_SIZE, pull->iostr);
+      if(ilen < 0) {
+        pull->status = -1;
+        continue;
+      }
+    }
+    len = RAPTOR_GOOD_CAST(size_t, ilen);
+    is_end = (len < RAPTOR_READ_BUFFER_SIZE);
+
+    if(raptor_parser_parse_chunk(rdf_parser, rdf_parser->buffer, len, is_end))
+      pull->status = -1;
+    else if(is_end)
+      pull->status = 1;
+  }
+
+  *statement_p = &pull->statements[pull->next++];
+  return 0;
+}
+
+
 /* end not STANDALONE */
 #endif
 
@@ -1769,6 +2214,98 @@ raptor_parser_parse_iostream(raptor_parser* rdf_parser, raptor_iostream *iostr,
 int main(int argc, char *argv[]);
 
 
+static void
+test_count_statement(void *user_data, raptor_statement *statement)
+{
+  (*(int*)user_data)++;
+}
+
+
+#define TEST_PULL_STATEMENTS 2000
+
+/* Check pulling statements against the push API; returns failures */
+static int
+test_pull(raptor_world *world, const char *program)
+{
+  raptor_parser* parser;
+  raptor_iostream* iostr;
+  raptor_stringbuffer* sb;
+  raptor_statement* statement;
+  const unsigned char* content;
+  size_t content_len;
+  char line[80];
+  int pushed = 0;
+  int pulled = 0;
+  int failures = 0;
+  int rc;
+  int i;
+
+  /* more than one RAPTOR_READ_BUFFER_SIZE chunk of N-Triples */
+  sb = raptor_new_stringbuffer();
+  for(i = 0; i < TEST_PULL_STATEMENTS; i++) {
+    sprintf(line, "<http://example.org/s%d> <http://example.org/p> \"%d\" .\n",
+            i, i);
+    raptor_stringbuffer_append_string(sb, (const unsigned char*)line, 1);
+  }
+  content = raptor_stringbuffer_as_string(sb);
+  content_len = raptor_stringbuffer_length(sb);
+
+  parser = raptor_new_parser(world, "ntriples");
+  raptor_parser_set_statement_handler(parser, &pushed, test_count_statement);
+
+  /* pull every statement in order */
+  iostr = raptor_new_iostream_from_string(world, (void*)content, content_len);
+  raptor_parser_parse_iostream_start(parser, iostr, NULL);
+  while(!(rc = raptor_parser_next_statement(parser, &statement))) {
+    sprintf(line, "%d", pulled);
+    if(strcmp((const char*)statement->object->value.literal.string, line)) {
+      fprintf(stderr, "%s: pulled statement %d has object '%s'\n", program,
+              pulled, statement->object->value.literal.string);
+      failures++;
+      break;
+    }
+    pulled++;
+  }
+  raptor_free_iostream(iostr);
+  if(rc != 1 || pulled != TEST_PULL_STATEMENTS || pushed) {
+    fprintf(stderr,
+            "%s: pulled %d statements ending with %d (pushed %d), expected %d ending with 1\n",
+            program, pulled, rc, pushed, TEST_PULL_STATEMENTS);
+    failures++;
+  }
+
+  /* stop early then push parse with the restored handler */
+  iostr = raptor_new_iostream_from_string(world, (void*)content, content_len);
+  raptor_parser_parse_iostream_start(parser, iostr, NULL);
+  for(i = 0; i < 5; i++) {
+    if(raptor_parser_next_statement(parser, &statement)) {
+      fprintf(stderr, "%s: pulling statement %d failed\n", program, i);
+      failures++;
+    }
+  }
+  raptor_free_iostream(iostr);
+
+  iostr = raptor_new_iostream_from_string(world, (void*)content, content_len);
+  raptor_parser_parse_iostream(parser, iostr, NULL);
+  raptor_free_iostream(iostr);
+  if(pushed != TEST_PULL_STATEMENTS) {
+    fprintf(stderr, "%s: pushed %d statements after pulling, expected %d\n",
+            program, pushed, TEST_PULL_STATEMENTS);
+    failures++;
+  }
+
+  if(raptor_parser_next_statement(parser, &statement) >= 0) {
+    fprintf(stderr, "%s: pulling when not started did not fail\n", program);
+    failures++;
+  }
+
+  raptor_free_parser(parser);
+  raptor_free_stringbuffer(sb);
+
+  return failures;
+}
+
+
 int
 main(int argc, char *argv[])
 {
@@ -1820,6 +2357,11 @@ main(int argc, char *argv[])
   }
   RAPTOR_FREE(char*, s);
 
+#ifdef RAPTOR_PARSER_NTRIPLES
+  if(test_pull(world, program))
+    return 1;
+#endif
+
   raptor_free_world(world);
   
   return 0;
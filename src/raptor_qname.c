@@ -96,35 +96,106 @@ raptor_new_qname(raptor_namespace_stack *nstack,
                  const unsigned char *name,
                  const unsigned char *value)
 {
-  raptor_qname* qname;
+  return raptor_new_qname_reuse(nstack, name, value, NULL, NULL);
+}
+
+
+/*
+ * raptor_qname_reserve_buffer:
+ * @buffer_p: pointer to string buffer
+ * @size_p: pointer to allocated size of buffer
+ * @size: size needed
+ *
+ * INTERNAL - Make sure a qname string buffer can hold @size bytes
+ *
+ * Return value: 0 if the existing buffer was big enough, 1 if a new
+ *   buffer was allocated or <0 on failure
+ */
+static int
+raptor_qname_reserve_buffer(const unsigned char **buffer_p, size_t *size_p,
+                            size_t size)
+{
+  unsigned char *buffer;
+
+  if(*buffer_p && *size_p >= size)
+    return 0;
+
+  buffer = RAPTOR_MALLOC(unsigned char*, size);
+  if(!buffer)
+    return -1;
+
+  if(*buffer_p)
+    RAPTOR_FREE(char*, *buffer_p);
+  *buffer_p = buffer;
+  *size_p = size;
+
+  return 1;
+}
+
+
+/*
+ * raptor_new_qname_reuse:
+ * @nstack: namespace stack to look up for namespaces
+ * @name: element or attribute name
+ * @value: attribute value (else is an element)
+ * @qname: qname cleared with raptor_qname_clear() to reuse or NULL
+ * @reused_p: pointer to count of allocations avoided (or NULL)
+ *
+ * INTERNAL - Constructor - create a new XML qname reusing an old one
+ *
+ * As raptor_new_qname() but the structure and string buffers of
+ * @qname are used when given and large enough.  On failure @qname
+ * is freed.
+ *
+ * Return value: a new #raptor_qname object or NULL on failure
+ */
+raptor_qname*
+raptor_new_qname_reuse(raptor_namespace_stack *nstack, 
+                       const unsigned char *name,
+                       const unsigned char *value,
+                       raptor_qname* qname,
+                       unsigned long *reused_p)
+{
   const unsigned char *p;
   raptor_namespace* ns;
   unsigned char* new_name;
   unsigned int prefix_length;
   unsigned int local_name_length = 0;
+  unsigned long reused = 0;
+  int rc;
 
 #if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
   RAPTOR_DEBUG2("name %s\n", name);
 #endif  
 
-  qname = RAPTOR_CALLOC(raptor_qname*, 1, sizeof(*qname));
-  if(!qname)
-    return NULL;
+  if(qname)
+    reused++;
+  else {
+    qname = RAPTOR_CALLOC(raptor_qname*, 1, sizeof(*qname));
+    if(!qname)
+      return NULL;
+  }
   qname->world = nstack->world;
 
   if(value) {
     size_t value_length = strlen((char*)value);
-    unsigned char* new_value;
 
-    new_value = RAPTOR_MALLOC(unsigned char*, value_length + 1);
-    if(!new_value) {
-      RAPTOR_FREE(raptor_qname, qname);
+    rc = raptor_qname_reserve_buffer(&qname->value, &qname->value_size,
+                                     value_length + 1);
+    if(rc < 0) {
+      raptor_free_qname(qname);
       return NULL;
     } 
+    if(!rc)
+      reused++;
 
-    memcpy(new_value, value, value_length + 1); /* copy NUL */
-    qname->value = new_value;
+    memcpy((unsigned char*)qname->value, value, value_length + 1); /* copy NUL */
     qname->value_length = value_length;
+  } else if(qname->value) {
+    /* an element has no value */
+    RAPTOR_FREE(char*, qname->value);
+    qname->value = NULL;
+    qname->value_size = 0;
   }
 
 
@@ -137,14 +208,18 @@ raptor_new_qname(raptor_namespace_stack *nstack,
     local_name_length = (unsigned int)(p - name);
 
     /* No : in the name */
-    new_name = RAPTOR_MALLOC(unsigned char*, local_name_length + 1);
-    if(!new_name) {
+    rc = raptor_qname_reserve_buffer(&qname->local_name,
+                                     &qname->local_name_size,
+                                     local_name_length + 1);
+    if(rc < 0) {
       raptor_free_qname(qname);
       return NULL;
     }
+    if(!rc)
+      reused++;
+    new_name = (unsigned char*)qname->local_name;
     memcpy(new_name, name, local_name_length); /* no NUL to copy */
     new_name[local_name_length] = '\0';
-    qname->local_name = new_name;
     qname->local_name_length = local_name_length;
 
     /* For elements only, pick up the default namespace if there is one */
@@ -171,14 +246,18 @@ raptor_new_qname(raptor_namespace_stack *nstack,
 
     /* p now is at start of local_name */
     local_name_length = (unsigned int)strlen((char*)p);
-    new_name = RAPTOR_MALLOC(unsigned char*, local_name_length + 1);
-    if(!new_name) {
+    rc = raptor_qname_reserve_buffer(&qname->local_name,
+                                     &qname->local_name_size,
+                                     local_name_length + 1);
+    if(rc < 0) {
       raptor_free_qname(qname);
       return NULL;
     }
+    if(!rc)
+      reused++;
+    new_name = (unsigned char*)qname->local_name;
     memcpy(new_name, p, local_name_length); /* No NUL to copy */
     new_name[local_name_length] = '\0';
-    qname->local_name = new_name;
     qname->local_name_length = local_name_length;
 
     /* Find the namespace */
@@ -209,11 +288,33 @@ raptor_new_qname(raptor_namespace_stack *nstack,
     qname->uri = uri;
   }
 
+  if(reused_p)
+    *reused_p += reused;
 
   return qname;
 }
 
 
+/*
+ * raptor_qname_clear:
+ * @qname: qname
+ *
+ * INTERNAL - Reset a qname for raptor_new_qname_reuse()
+ *
+ * The namespace and URI are released; the string buffers are kept.
+ */
+void
+raptor_qname_clear(raptor_qname* qname)
+{
+  if(qname->uri && qname->nspace)
+    raptor_free_uri(qname->uri);
+  qname->uri = NULL;
+  qname->nspace = NULL;
+  qname->local_name_length = 0;
+  qname->value_length = 0;
+}
+
+
 /**
  * raptor_new_qname_from_namespace_local_name:
  * @world: raptor_world object
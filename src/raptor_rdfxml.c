@@ -590,23 +590,12 @@ raptor_rdfxml_start_element_handler(void *user_data,
 
   /* RDF-specific processing of attributes */
   if(ns_attributes_count) {
-    raptor_qname** new_named_attrs;
     int offset = 0;
     raptor_rdfxml_element* parent_element;
 
     parent_element = element->parent;
 
-    /* Allocate new array to move namespaced-attributes to if
-     * rdf processing is performed
-     */
-    new_named_attrs = RAPTOR_CALLOC(raptor_qname**, ns_attributes_count, 
-                                    sizeof(raptor_qname*));
-    if(!new_named_attrs) {
-      raptor_parser_fatal_error(rdf_parser, "Out of memory");
-      rdf_parser->failed = 1;
-      return;
-    }
-
+    /* Attributes left after rdf processing are moved down in place */
     for(i = 0; i < ns_attributes_count; i++) {
       raptor_qname* attr = named_attrs[i];
 
@@ -682,21 +671,17 @@ raptor_rdfxml_start_element_handler(void *user_data,
       } /* end if leave literal XML alone */
 
       if(attr)
-        new_named_attrs[offset++] = attr;
+        named_attrs[offset++] = attr;
     }
 
     /* new attribute count is set from attributes that haven't been skipped */
+    for(i = offset; i < ns_attributes_count; i++)
+      named_attrs[i] = NULL;
     ns_attributes_count = offset;
-    if(!ns_attributes_count) {
-      /* all attributes were deleted so delete the new array */
-      RAPTOR_FREE(raptor_qname_array, new_named_attrs);
-      new_named_attrs = NULL;
-    }
-
-    RAPTOR_FREE(raptor_qname_array, named_attrs);
-    named_attrs = new_named_attrs;
     raptor_xml_element_set_attributes(xml_element, 
                                       named_attrs, ns_attributes_count);
+    if(!ns_attributes_count)
+      named_attrs = NULL;
   } /* end if ns_attributes_count */
 
 
@@ -1078,9 +1063,28 @@ raptor_rdfxml_parse_terminate(raptor_parser *rdf_parser)
 }
 
 
+/* strings looked for by raptor_rdfxml_parse_recognise_syntax() */
+static const char* const rdfxml_recognise_patterns[14] = {
+  "xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#",
+  "xmlns:rdf='http://www.w3.org/1999/02/22-rdf-syntax-ns#",
+  "xmlns=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#",
+  "xmlns='http://www.w3.org/1999/02/22-rdf-syntax-ns#",
+  "!ENTITY rdf 'http://www.w3.org/1999/02/22-rdf-syntax-ns#'",
+  "!ENTITY rdf \"http://www.w3.org/1999/02/22-rdf-syntax-ns#\"",
+  "xmlns:rdf=\"&rdf;\"",
+  "xmlns:rdf='&rdf;'",
+  "http://www.w3.org/1999/xhtml",
+  "<html",
+  "<rdf:RDF",
+  "rdf:Description",
+  "rdf:about",
+  NULL
+};
+
 static int
 raptor_rdfxml_parse_recognise_syntax(raptor_parser_factory* factory, 
                                      const unsigned char *buffer, size_t len,
+                                     unsigned int patterns,
                                      const unsigned char *identifier, 
                                      const unsigned char *suffix, 
                                      const char *mime_type)
@@ -1123,24 +1127,24 @@ raptor_rdfxml_parse_recognise_syntax(raptor_parser_factory* factory,
     /* Check it's an XML namespace declared and not N3 or Turtle which
      * mention the namespace URI but not in this form.
      */
-#define  HAS_RDF_XMLNS1 (raptor_memstr((const char*)buffer, len, "xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#") != NULL)
-#define  HAS_RDF_XMLNS2 (raptor_memstr((const char*)buffer, len, "xmlns:rdf='http://www.w3.org/1999/02/22-rdf-syntax-ns#") != NULL)
-#define  HAS_RDF_XMLNS3 (raptor_memstr((const char*)buffer, len, "xmlns=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#") != NULL)
-#define  HAS_RDF_XMLNS4 (raptor_memstr((const char*)buffer, len, "xmlns='http://www.w3.org/1999/02/22-rdf-syntax-ns#") != NULL)
-#define  HAS_RDF_ENTITY1 (raptor_memstr((const char*)buffer, len, "!ENTITY rdf 'http://www.w3.org/1999/02/22-rdf-syntax-ns#'") != NULL)
-#define  HAS_RDF_ENTITY2 (raptor_memstr((const char*)buffer, len, "!ENTITY rdf \"http://www.w3.org/1999/02/22-rdf-syntax-ns#\"") != NULL)
-#define  HAS_RDF_ENTITY3 (raptor_memstr((const char*)buffer, len, "xmlns:rdf=\"&rdf;\"") != NULL)
-#define  HAS_RDF_ENTITY4 (raptor_memstr((const char*)buffer, len, "xmlns:rdf='&rdf;'") != NULL)
-#define  HAS_HTML_NS (raptor_memstr((const char*)buffer, len, "http://www.w3.org/1999/xhtml") != NULL)
-#define  HAS_HTML_ROOT (raptor_memstr((const char*)buffer, len, "<html") != NULL)
+#define  HAS_RDF_XMLNS1 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 0)
+#define  HAS_RDF_XMLNS2 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 1)
+#define  HAS_RDF_XMLNS3 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 2)
+#define  HAS_RDF_XMLNS4 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 3)
+#define  HAS_RDF_ENTITY1 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 4)
+#define  HAS_RDF_ENTITY2 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 5)
+#define  HAS_RDF_ENTITY3 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 6)
+#define  HAS_RDF_ENTITY4 RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 7)
+#define  HAS_HTML_NS RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 8)
+#define  HAS_HTML_ROOT RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 9)
 
     if(!HAS_HTML_NS && !HAS_HTML_ROOT &&
        (HAS_RDF_XMLNS1 || HAS_RDF_XMLNS2 || HAS_RDF_XMLNS3 || HAS_RDF_XMLNS4 ||
         HAS_RDF_ENTITY1 || HAS_RDF_ENTITY2 || HAS_RDF_ENTITY3 || HAS_RDF_ENTITY4)
       ) {
-      int has_rdf_RDF = (raptor_memstr((const char*)buffer, len, "<rdf:RDF") != NULL);
-      int has_rdf_Description = (raptor_memstr((const char*)buffer, len, "rdf:Description") != NULL);
-      int has_rdf_about = (raptor_memstr((const char*)buffer, len, "rdf:about") != NULL);
+      int has_rdf_RDF = RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 10);
+      int has_rdf_Description = RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 11);
+      int has_rdf_about = RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 12);
 
       score += 7;
       if(has_rdf_RDF)
@@ -1182,6 +1186,42 @@ raptor_rdfxml_parse_chunk(raptor_parser* rdf_parser,
 }
 
 
+#ifdef RAPTOR_XML_LIBXML
+/**
+ * raptor_rdfxml_parse_xml_doc:
+ * @rdf_parser: RDF/XML parser
+ * @doc: libxml document
+ *
+ * INTERNAL - Parse RDF/XML from a libxml document tree
+ *
+ * Used instead of raptor_parser_parse_chunk() after
+ * raptor_parser_parse_start() by parsers that already have the
+ * document as a tree, such as GRDDL with an XSLT result.
+ *
+ * Return value: non-0 on failure
+ */
+int
+raptor_rdfxml_parse_xml_doc(raptor_parser* rdf_parser, xmlDocPtr doc)
+{
+  raptor_rdfxml_parser* rdf_xml_parser;
+  int rc;
+
+  rdf_xml_parser = (raptor_rdfxml_parser*)rdf_parser->context;
+  if(rdf_parser->failed)
+    return 1;
+
+  rc = raptor_sax2_parse_xml_doc(rdf_xml_parser->sax2, doc);
+
+  if(rdf_parser->emitted_default_graph) {
+    raptor_parser_end_graph(rdf_parser, NULL, 0);
+    rdf_parser->emitted_default_graph--;
+  }
+
+  return rc;
+}
+#endif
+
+
 static void
 raptor_rdfxml_generate_statement(raptor_parser *rdf_parser, 
                                  raptor_term *subject_term,
@@ -3202,6 +3242,7 @@ raptor_rdfxml_parser_register_factory(raptor_parser_factory *factory)
   factory->chunk     = raptor_rdfxml_parse_chunk;
   factory->finish_factory = raptor_rdfxml_parse_finish_factory;
   factory->recognise_syntax = raptor_rdfxml_parse_recognise_syntax;
+  factory->recognise_patterns = rdfxml_recognise_patterns;
 
   return rc;
 }
@@ -3222,5 +3263,7 @@ raptor_rdfxml_parser_stats_print(raptor_rdfxml_parser* rdf_xml_parser,
 {
   fputs("rdf:ID set ", stream);
   raptor_id_set_stats_print(rdf_xml_parser->id_set, stream);
+  fputs("  ", stream);
+  raptor_sax2_stats_print(rdf_xml_parser->sax2, stream);
 }
 #endif
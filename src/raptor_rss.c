@@ -48,6 +48,7 @@
 
 static void raptor_rss_uplift_items(raptor_parser* rdf_parser);
 static int raptor_rss_emit(raptor_parser* rdf_parser);
+static int raptor_rss_stream_end_container(raptor_parser* rdf_parser, raptor_rss_type type);
 
 static void raptor_rss_start_element_handler(void *user_data, raptor_xml_element* xml_element);
 static void raptor_rss_end_element_handler(void *user_data, raptor_xml_element* xml_element);
@@ -98,6 +99,25 @@ struct raptor_rss_parser_s {
 
   /* current BLOCK pointer (inside CONTAINER of type current_type) */
   raptor_rss_block *current_block;
+
+  /* namespaces started in the output */
+  char nspaces_started[RAPTOR_RSS_NAMESPACES_SIZE];
+
+  /* non-0 to emit each container as it ends (RAPTOR_OPTION_RSS_STREAMING) */
+  int streaming;
+
+  /* when streaming: rdf:Seq node of the items and count emitted so far */
+  raptor_term *items_seq;
+  int items_emitted;
+
+  /* when streaming: channel and its rss:items connection are emitted */
+  int channel_emitted;
+  int items_connected;
+
+  /* when streaming: non-0 after an emit error; later nodes are skipped */
+  int stream_failed;
+  /* when streaming: non-0 if the error handler aborted the parse */
+  int stream_aborted;
 };
 
 typedef struct raptor_rss_parser_s raptor_rss_parser;
@@ -154,6 +174,26 @@ raptor_free_rss_element(raptor_rss_element *rss_element)
 }
 
 
+/* free the RSS state of elements left open when a parse stops early */
+static void
+raptor_rss_free_open_elements(raptor_rss_parser* rss_parser)
+{
+  raptor_xml_element* xml_element;
+
+  if(!rss_parser->sax2)
+    return;
+
+  for(xml_element = rss_parser->sax2->current_element;
+      xml_element;
+      xml_element = xml_element->parent) {
+    if(xml_element->user_data) {
+      raptor_free_rss_element((raptor_rss_element*)xml_element->user_data);
+      xml_element->user_data = NULL;
+    }
+  }
+}
+
+
 static int
 raptor_rss_parse_init(raptor_parser* rdf_parser, const char *name)
 {
@@ -213,11 +253,16 @@ raptor_rss_parse_terminate(raptor_parser *rdf_parser)
   raptor_rss_parser *rss_parser = (raptor_rss_parser*)rdf_parser->context;
   int n;
   
-  if(rss_parser->sax2)
+  if(rss_parser->sax2) {
+    raptor_rss_free_open_elements(rss_parser);
     raptor_free_sax2(rss_parser->sax2);
+  }
 
   raptor_rss_model_clear(&rss_parser->model);
 
+  if(rss_parser->items_seq)
+    raptor_free_term(rss_parser->items_seq);
+
   for(n = 0; n < RAPTOR_RSS_NAMESPACES_SIZE; n++) {
     if(rss_parser->nspaces[n])
       raptor_free_namespace(rss_parser->nspaces[n]);
@@ -241,8 +286,32 @@ raptor_rss_parse_start(raptor_parser *rdf_parser)
   if(!uri)
     return 1;
 
-  for(n = 0; n < RAPTOR_RSS_NAMESPACES_SIZE; n++)
+  /* drop any items from a previous parse */
+  raptor_rss_model_clear(&rss_parser->model);
+  raptor_rss_model_init(rdf_parser->world, &rss_parser->model);
+
+  rss_parser->prev_type = RAPTOR_RSS_NONE;
+  rss_parser->current_field = RAPTOR_RSS_FIELD_NONE;
+  rss_parser->current_type = RAPTOR_RSS_NONE;
+  rss_parser->current_block = NULL;
+  rss_parser->is_atom = 0;
+
+  for(n = 0; n < RAPTOR_RSS_NAMESPACES_SIZE; n++) {
     rss_parser->nspaces_seen[n] = 'N';
+    rss_parser->nspaces_started[n] = 'N';
+  }
+
+  rss_parser->streaming = RAPTOR_OPTIONS_GET_NUMERIC(rdf_parser,
+                                                     RAPTOR_OPTION_RSS_STREAMING);
+  if(rss_parser->items_seq) {
+    raptor_free_term(rss_parser->items_seq);
+    rss_parser->items_seq = NULL;
+  }
+  rss_parser->items_emitted = 0;
+  rss_parser->channel_emitted = 0;
+  rss_parser->items_connected = 0;
+  rss_parser->stream_failed = 0;
+  rss_parser->stream_aborted = 0;
 
   /* Optionally forbid internal network and file requests in the XML parser */
   raptor_sax2_set_option(rss_parser->sax2, 
@@ -258,6 +327,7 @@ raptor_rss_parse_start(raptor_parser *rdf_parser)
     raptor_sax2_set_uri_filter(rss_parser->sax2, rdf_parser->uri_filter,
                                rdf_parser->uri_filter_user_data);
   
+  raptor_rss_free_open_elements(rss_parser);
   raptor_sax2_parse_start(rss_parser->sax2, uri);
 
   return 0;
@@ -708,6 +778,7 @@ raptor_rss_end_element_handler(void *user_data,
   raptor_rss_element* rss_element;
   size_t cdata_len = 0;
   unsigned char* cdata = NULL;
+  raptor_rss_type ended_type = RAPTOR_RSS_NONE;
 
   rss_element = (raptor_rss_element*)xml_element->user_data;
 
@@ -859,6 +930,7 @@ raptor_rss_end_element_handler(void *user_data,
       rss_parser->current_field =  RAPTOR_RSS_FIELD_NONE;
     } else {
       RAPTOR_DEBUG3("Ending element %s type %s\n", name, raptor_rss_items_info[rss_parser->current_type].name);
+      ended_type = rss_parser->current_type;
       if(rss_parser->prev_type != RAPTOR_RSS_NONE) {
         rss_parser->current_type = rss_parser->prev_type;
         rss_parser->prev_type = RAPTOR_RSS_NONE;
@@ -877,6 +949,19 @@ raptor_rss_end_element_handler(void *user_data,
     rss_parser->current_block = NULL;
   }
 
+  /* Like raptor_rss_emit(), stop emitting at the first error so it
+   * is reported once.  An abort from the error handler ends the parse
+   * after this chunk. */
+  if(rss_parser->streaming && ended_type != RAPTOR_RSS_NONE) {
+    int was_failed = rdf_parser->failed;
+
+    if(raptor_rss_stream_end_container(rdf_parser, ended_type)) {
+      rss_parser->stream_failed = 1;
+      if(!was_failed && rdf_parser->failed)
+        rss_parser->stream_aborted = 1;
+    }
+  }
+
 
  tidy_end_element:
 
@@ -1006,85 +1091,87 @@ raptor_rss_insert_rss_link(raptor_parser* rdf_parser,
 
 
 static int
-raptor_rss_insert_identifiers(raptor_parser* rdf_parser) 
+raptor_rss_insert_common_identifier(raptor_parser* rdf_parser,
+                                    raptor_rss_item* item, int i)
 {
-  raptor_rss_parser* rss_parser = (raptor_rss_parser*)rdf_parser->context;
-  int i;
-  raptor_rss_item* item;
-  
-  for(i = 0; i< RAPTOR_RSS_COMMON_SIZE; i++) {
-    for(item = rss_parser->model.common[i]; item; item = item->next) {
-      if(!item->fields_count)
-        continue;
-      
-      RAPTOR_DEBUG3("Inserting identifiers in common type %d - %s\n", i, raptor_rss_items_info[i].name);
-    
-      if(item->uri) {
-        item->term = raptor_new_term_from_uri(rdf_parser->world, item->uri);
-      } else {
-        int url_fields[2];
-        int url_fields_count = 1;
-        int f;
-      
-        url_fields[0] = (i== RAPTOR_RSS_IMAGE) ? RAPTOR_RSS_FIELD_URL :
-                                                 RAPTOR_RSS_FIELD_LINK;
-        if(i == RAPTOR_RSS_CHANNEL) {
-          url_fields[1] = RAPTOR_RSS_FIELD_ATOM_ID;
-          url_fields_count++;
-        }
+  if(!item->fields_count)
+    return 0;
 
-        for(f = 0; f < url_fields_count; f++) {
-          raptor_rss_field* field;
-
-          for(field = item->fields[url_fields[f]]; field; field = field->next) {
-            raptor_uri *new_uri = NULL;
-            if(field->value)
-              new_uri = raptor_new_uri(rdf_parser->world,
-                                       (const unsigned char*)field->value);
-            else if(field->uri)
-              new_uri = raptor_uri_copy(field->uri);
-
-            if(new_uri) {
-              item->term = raptor_new_term_from_uri(rdf_parser->world, new_uri);
-              raptor_free_uri(new_uri);
-              if(!item->term)
-                return 1;
-              break;
-            }
-          }
-        }
-      
-        if(!item->term) {
-          const unsigned char *id;
+  RAPTOR_DEBUG3("Inserting identifiers in common type %d - %s\n", i, raptor_rss_items_info[i].name);
+
+  if(item->term) {
+    /* already set from rdf:about or by an earlier call */
+  } else if(item->uri) {
+    item->term = raptor_new_term_from_uri(rdf_parser->world, item->uri);
+  } else {
+    int url_fields[2];
+    int url_fields_count = 1;
+    int f;
+
+    url_fields[0] = (i== RAPTOR_RSS_IMAGE) ? RAPTOR_RSS_FIELD_URL :
+                                             RAPTOR_RSS_FIELD_LINK;
+    if(i == RAPTOR_RSS_CHANNEL) {
+      url_fields[1] = RAPTOR_RSS_FIELD_ATOM_ID;
+      url_fields_count++;
+    }
 
-          /* need to make bnode */
-          id = raptor_world_generate_bnodeid(rdf_parser->world);
-          item->term = raptor_new_term_from_blank(rdf_parser->world, id);
-          RAPTOR_FREE(char*, id);
+    for(f = 0; f < url_fields_count; f++) {
+      raptor_rss_field* field;
+
+      for(field = item->fields[url_fields[f]]; field; field = field->next) {
+        raptor_uri *new_uri = NULL;
+        if(field->value)
+          new_uri = raptor_new_uri(rdf_parser->world,
+                                   (const unsigned char*)field->value);
+        else if(field->uri)
+          new_uri = raptor_uri_copy(field->uri);
+
+        if(new_uri) {
+          item->term = raptor_new_term_from_uri(rdf_parser->world, new_uri);
+          raptor_free_uri(new_uri);
+          if(!item->term)
+            return 1;
+          break;
         }
       }
+    }
 
-      /* Try to add an rss:link if missing */
-      if(i == RAPTOR_RSS_CHANNEL && !item->fields[RAPTOR_RSS_FIELD_LINK]) {
-        if(raptor_rss_insert_rss_link(rdf_parser, item))
-          return 1;
-      }
+    if(!item->term) {
+      const unsigned char *id;
 
-      item->node_type = &raptor_rss_items_info[i];
-      item->node_typei = i;
+      /* need to make bnode */
+      id = raptor_world_generate_bnodeid(rdf_parser->world);
+      item->term = raptor_new_term_from_blank(rdf_parser->world, id);
+      RAPTOR_FREE(char*, id);
     }
   }
-  /* sequence of rss:item */
-  for(item = rss_parser->model.items; item; item = item->next) {
-    raptor_rss_block *block;
-    raptor_uri* uri = NULL;
-    
-    if(!item->fields[RAPTOR_RSS_FIELD_LINK])  {
-      if(raptor_rss_insert_rss_link(rdf_parser, item))
-        return 1;
-    }
-    
 
+  /* Try to add an rss:link if missing */
+  if(i == RAPTOR_RSS_CHANNEL && !item->fields[RAPTOR_RSS_FIELD_LINK]) {
+    if(raptor_rss_insert_rss_link(rdf_parser, item))
+      return 1;
+  }
+
+  item->node_type = &raptor_rss_items_info[i];
+  item->node_typei = i;
+
+  return 0;
+}
+
+
+static int
+raptor_rss_insert_item_identifier(raptor_parser* rdf_parser,
+                                  raptor_rss_item* item)
+{
+  raptor_rss_block *block;
+  raptor_uri* uri = NULL;
+
+  if(!item->fields[RAPTOR_RSS_FIELD_LINK])  {
+    if(raptor_rss_insert_rss_link(rdf_parser, item))
+      return 1;
+  }
+
+  if(!item->term) {
     if(item->uri) {
       uri = raptor_uri_copy(item->uri);
     } else {
@@ -1104,24 +1191,47 @@ raptor_rss_insert_identifiers(raptor_parser* rdf_parser)
     }
 
     if(!uri)
-      continue;
+      return 0;
 
     item->term = raptor_new_term_from_uri(rdf_parser->world, uri);
     raptor_free_uri(uri);
     uri = NULL;
-    
-    for(block = item->blocks; block; block = block->next) {
-      if(!block->identifier) {
-        const unsigned char *id;
-        /* need to make bnode */
-        id = raptor_world_generate_bnodeid(rdf_parser->world);
-        item->term = raptor_new_term_from_blank(rdf_parser->world, id);
-        RAPTOR_FREE(char*, id);
-      }
+  }
+
+  for(block = item->blocks; block; block = block->next) {
+    if(!block->identifier) {
+      const unsigned char *id;
+      /* need to make bnode */
+      id = raptor_world_generate_bnodeid(rdf_parser->world);
+      item->term = raptor_new_term_from_blank(rdf_parser->world, id);
+      RAPTOR_FREE(char*, id);
     }
-    
-    item->node_type = &raptor_rss_items_info[RAPTOR_RSS_ITEM];
-    item->node_typei = RAPTOR_RSS_ITEM;
+  }
+
+  item->node_type = &raptor_rss_items_info[RAPTOR_RSS_ITEM];
+  item->node_typei = RAPTOR_RSS_ITEM;
+
+  return 0;
+}
+
+
+static int
+raptor_rss_insert_identifiers(raptor_parser* rdf_parser) 
+{
+  raptor_rss_parser* rss_parser = (raptor_rss_parser*)rdf_parser->context;
+  int i;
+  raptor_rss_item* item;
+  
+  for(i = 0; i< RAPTOR_RSS_COMMON_SIZE; i++) {
+    for(item = rss_parser->model.common[i]; item; item = item->next) {
+      if(raptor_rss_insert_common_identifier(rdf_parser, item, i))
+        return 1;
+    }
+  }
+  /* sequence of rss:item */
+  for(item = rss_parser->model.items; item; item = item->next) {
+    if(raptor_rss_insert_item_identifier(rdf_parser, item))
+      return 1;
   }
 
   return 0;
@@ -1592,9 +1702,314 @@ raptor_rss_start_namespaces(raptor_parser* rdf_parser)
 
   /* start the namespaces */
   for(n = 0; n < RAPTOR_RSS_NAMESPACES_SIZE; n++) {
-    if(rss_parser->nspaces[n] && rss_parser->nspaces_seen[n] == 'Y')
+    if(rss_parser->nspaces[n] && rss_parser->nspaces_seen[n] == 'Y') {
+      raptor_parser_start_namespace(rdf_parser, rss_parser->nspaces[n]);
+      rss_parser->nspaces_started[n] = 'Y';
+    }
+  }
+}
+
+
+/*
+ * raptor_rss_stream_prepare_item:
+ * @rdf_parser: RSS parser
+ * @item: item about to be emitted
+ *
+ * Add the uplifted fields of @item, start any namespaces it needs that
+ * are not started yet and start the default graph if not yet started.
+ */
+static void
+raptor_rss_stream_prepare_item(raptor_parser* rdf_parser,
+                               raptor_rss_item* item)
+{
+  raptor_rss_parser* rss_parser = (raptor_rss_parser*)rdf_parser->context;
+  int f;
+  int n;
+
+  raptor_rss_uplift_fields(rss_parser, item);
+
+  for(f = 0; f < RAPTOR_RSS_FIELDS_SIZE; f++) {
+    if(item->fields[f])
+      rss_parser->nspaces_seen[raptor_rss_fields_info[f].nspace] = 'Y';
+  }
+
+  for(n = 0; n < RAPTOR_RSS_NAMESPACES_SIZE; n++) {
+    if(rss_parser->nspaces[n] && rss_parser->nspaces_seen[n] == 'Y' &&
+       rss_parser->nspaces_started[n] != 'Y') {
       raptor_parser_start_namespace(rdf_parser, rss_parser->nspaces[n]);
+      rss_parser->nspaces_started[n] = 'Y';
+    }
+  }
+
+  if(!rdf_parser->emitted_default_graph) {
+    raptor_parser_start_graph(rdf_parser, NULL, 0);
+    rdf_parser->emitted_default_graph++;
+  }
+}
+
+
+/* Emit <channelURI> rss:items _:seq once both are known */
+static int
+raptor_rss_stream_connect_items(raptor_parser* rdf_parser)
+{
+  raptor_rss_parser* rss_parser = (raptor_rss_parser*)rdf_parser->context;
+
+  if(rss_parser->items_connected || !rss_parser->channel_emitted ||
+     !rss_parser->items_seq)
+    return 0;
+
+  rss_parser->items_connected = 1;
+  return raptor_rss_emit_connection(rdf_parser,
+                                    rss_parser->model.common[RAPTOR_RSS_CHANNEL]->term,
+                                    rdf_parser->world->rss_fields_info_uris[RAPTOR_RSS_FIELD_ITEMS], 0,
+                                    rss_parser->items_seq);
+}
+
+
+/*
+ * raptor_rss_stream_commons:
+ * @rdf_parser: RSS parser
+ *
+ * Emit and free the ended common containers other than the channel
+ * (authors, images, ...) once the channel identifier is known so that
+ * they can be connected to it.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_rss_stream_commons(raptor_parser* rdf_parser)
+{
+  raptor_rss_parser* rss_parser = (raptor_rss_parser*)rdf_parser->context;
+  raptor_rss_item* channel = rss_parser->model.common[RAPTOR_RSS_CHANNEL];
+  int i;
+
+  if(!channel)
+    return 0;
+
+  /* the channel identifier is fixed the first time it is needed */
+  if(raptor_rss_insert_common_identifier(rdf_parser, channel,
+                                         RAPTOR_RSS_CHANNEL))
+    return 1;
+  if(!channel->term)
+    return 0;
+
+  for(i = 0; i < RAPTOR_RSS_COMMON_SIZE; i++) {
+    raptor_rss_item* item;
+
+    if(i == RAPTOR_RSS_CHANNEL)
+      continue;
+
+    while((item = rss_parser->model.common[i])) {
+      int rc = 0;
+
+      /* the last container of the current types may still be open */
+      if(!item->next &&
+         (i == (int)rss_parser->current_type ||
+          i == (int)rss_parser->prev_type))
+        break;
+
+      rss_parser->model.common[i] = item->next;
+      item->next = NULL;
+
+      if(item->fields_count) {
+        rc = raptor_rss_insert_common_identifier(rdf_parser, item, i);
+        if(!rc) {
+          raptor_rss_stream_prepare_item(rdf_parser, item);
+          rc = raptor_rss_emit_item(rdf_parser, item) ||
+               raptor_rss_emit_connection(rdf_parser, channel->term,
+                                          rdf_parser->world->rss_types_info_uris[i], 0,
+                                          item->term);
+        }
+      }
+
+      raptor_free_rss_item(item);
+      if(rc)
+        return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+/*
+ * raptor_rss_stream_channel:
+ * @rdf_parser: RSS parser
+ *
+ * Emit the channel and anything waiting for its identifier.  Further
+ * channel containers are emitted and freed.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_rss_stream_channel(raptor_parser* rdf_parser)
+{
+  raptor_rss_parser* rss_parser = (raptor_rss_parser*)rdf_parser->context;
+  raptor_rss_item* channel = rss_parser->model.common[RAPTOR_RSS_CHANNEL];
+
+  if(!channel)
+    return 0;
+
+  if(!rss_parser->channel_emitted) {
+    if(raptor_rss_insert_common_identifier(rdf_parser, channel,
+                                           RAPTOR_RSS_CHANNEL))
+      return 1;
+
+    if(!channel->term) {
+      raptor_parser_error(rdf_parser, "RSS channel has no identifier");
+      return 1;
+    }
+
+    raptor_rss_stream_prepare_item(rdf_parser, channel);
+    if(raptor_rss_emit_item(rdf_parser, channel))
+      return 1;
+    rss_parser->channel_emitted = 1;
+  }
+
+  /* the first channel is kept for its identifier */
+  while(channel->next) {
+    raptor_rss_item* item = channel->next;
+    int rc;
+
+    channel->next = item->next;
+    item->next = NULL;
+
+    rc = raptor_rss_insert_common_identifier(rdf_parser, item,
+                                             RAPTOR_RSS_CHANNEL);
+    if(!rc && item->fields_count) {
+      raptor_rss_stream_prepare_item(rdf_parser, item);
+      rc = raptor_rss_emit_item(rdf_parser, item);
+    }
+    raptor_free_rss_item(item);
+    if(rc)
+      return 1;
+  }
+
+  if(raptor_rss_stream_connect_items(rdf_parser))
+    return 1;
+
+  return raptor_rss_stream_commons(rdf_parser);
+}
+
+
+/*
+ * raptor_rss_stream_item:
+ * @rdf_parser: RSS parser
+ *
+ * Emit the last item and free it, adding it to the items rdf:Seq.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_rss_stream_item(raptor_parser* rdf_parser)
+{
+  raptor_rss_parser* rss_parser = (raptor_rss_parser*)rdf_parser->context;
+  raptor_rss_item* item = rss_parser->model.last;
+  int rc;
+
+  if(!item)
+    return 0;
+
+  rc = raptor_rss_insert_item_identifier(rdf_parser, item);
+  if(rc)
+    goto tidy;
+
+  raptor_rss_stream_prepare_item(rdf_parser, item);
+
+  if(!rss_parser->items_seq) {
+    const unsigned char* id;
+
+    /* make a new genid for the <rdf:Seq> node */
+    id = raptor_world_generate_bnodeid(rdf_parser->world);
+    rss_parser->items_seq = raptor_new_term_from_blank(rdf_parser->world, id);
+    RAPTOR_FREE(char*, id);
+
+    /* _:genid1 rdf:type rdf:Seq . */
+    rc = raptor_rss_emit_type_triple(rdf_parser, rss_parser->items_seq,
+                                     RAPTOR_RDF_Seq_URI(rdf_parser->world)) ||
+         raptor_rss_stream_connect_items(rdf_parser);
+    if(rc)
+      goto tidy;
   }
+
+  rss_parser->items_emitted++;
+  rc = raptor_rss_emit_item(rdf_parser, item) ||
+       raptor_rss_emit_connection(rdf_parser, rss_parser->items_seq, NULL,
+                                  rss_parser->items_emitted, item->term);
+
+  tidy:
+  /* earlier items were freed when they ended so this is the only one */
+  raptor_free_rss_item(item);
+  rss_parser->model.items = rss_parser->model.last = NULL;
+
+  return rc;
+}
+
+
+/*
+ * raptor_rss_stream_end_container:
+ * @rdf_parser: RSS parser
+ * @type: type of the container that ended
+ *
+ * Emit a container as soon as its element ends when streaming.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_rss_stream_end_container(raptor_parser* rdf_parser,
+                                raptor_rss_type type)
+{
+  raptor_rss_parser* rss_parser = (raptor_rss_parser*)rdf_parser->context;
+
+  if(rss_parser->stream_failed) {
+    /* keep memory bounded by still dropping each item as it ends */
+    if(type == RAPTOR_RSS_ITEM && rss_parser->model.last) {
+      raptor_free_rss_item(rss_parser->model.last);
+      rss_parser->model.items = rss_parser->model.last = NULL;
+    }
+    return 0;
+  }
+
+  if(type == RAPTOR_RSS_ITEM)
+    return raptor_rss_stream_item(rdf_parser);
+
+  if(type == RAPTOR_RSS_CHANNEL)
+    return raptor_rss_stream_channel(rdf_parser);
+
+  return raptor_rss_stream_commons(rdf_parser);
+}
+
+
+/*
+ * raptor_rss_stream_end:
+ * @rdf_parser: RSS parser
+ *
+ * Emit whatever is left at the end of the feed when streaming.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_rss_stream_end(raptor_parser* rdf_parser)
+{
+  raptor_rss_parser* rss_parser = (raptor_rss_parser*)rdf_parser->context;
+  int rc = 0;
+
+  if(rss_parser->stream_failed)
+    rc = 1;
+  else if(!rss_parser->model.common[RAPTOR_RSS_CHANNEL]) {
+    raptor_parser_error(rdf_parser, "No RSS channel item present");
+    rc = 1;
+  } else {
+    rc = raptor_rss_stream_item(rdf_parser) ||
+         raptor_rss_stream_channel(rdf_parser);
+  }
+
+  if(rdf_parser->emitted_default_graph) {
+    raptor_parser_end_graph(rdf_parser, NULL, 0);
+    rdf_parser->emitted_default_graph--;
+  }
+
+  return rc;
 }
 
 
@@ -1610,11 +2025,20 @@ raptor_rss_parse_chunk(raptor_parser* rdf_parser,
 
   raptor_sax2_parse_chunk(rss_parser->sax2, s, len, is_end);
 
+  /* stop at once if aborted, such as from an error handler */
+  if(rdf_parser->failed) {
+    raptor_rss_free_open_elements(rss_parser);
+    return 1;
+  }
+
   if(!is_end)
     return 0;
 
-  if(rdf_parser->failed)
-    return 1;
+  if(rss_parser->streaming) {
+    if(raptor_rss_stream_end(rdf_parser) && rdf_parser->failed)
+      rss_parser->stream_aborted = 1;
+    return rss_parser->stream_aborted;
+  }
 
   /* turn strings into URIs, move things around if needed */
   if(raptor_rss_insert_identifiers(rdf_parser)) {
@@ -1638,6 +2062,7 @@ raptor_rss_parse_chunk(raptor_parser* rdf_parser,
 static int
 raptor_rss_parse_recognise_syntax(raptor_parser_factory* factory, 
                                   const unsigned char *buffer, size_t len,
+                                  unsigned int patterns,
                                   const unsigned char *identifier, 
                                   const unsigned char *suffix, 
                                   const char *mime_type)
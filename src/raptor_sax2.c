@@ -124,9 +124,25 @@ raptor_free_sax2(raptor_sax2 *sax2)
   }
 #endif
 
+#ifdef RAPTOR_XML_NATIVE
+  if(sax2->xt) {
+    raptor_free_xmltok(sax2->xt);
+    sax2->xt = NULL;
+  }
+#endif
+
   while( (xml_element = raptor_xml_element_pop(sax2)) )
     raptor_free_xml_element(xml_element);
 
+  while(sax2->element_pool) {
+    xml_element = sax2->element_pool;
+    sax2->element_pool = xml_element->parent;
+    raptor_free_xml_element(xml_element);
+  }
+
+  while(sax2->qname_pool_count)
+    raptor_free_qname(sax2->qname_pool[--sax2->qname_pool_count]);
+
   raptor_namespaces_clear(&sax2->namespaces);
 
   if(sax2->base_uri)
@@ -293,6 +309,177 @@ raptor_xml_element_push(raptor_sax2 *sax2, raptor_xml_element* element)
 }
 
 
+/*
+ * raptor_sax2_new_qname:
+ * @sax2: SAX2 object
+ * @name: element or attribute name
+ * @value: attribute value (else is an element)
+ *
+ * INTERNAL - Create a qname, reusing a released one if available
+ *
+ * Return value: new qname or NULL on failure
+ */
+static raptor_qname*
+raptor_sax2_new_qname(raptor_sax2* sax2, const unsigned char *name,
+                      const unsigned char *value)
+{
+  raptor_qname* qname = NULL;
+
+  if(sax2->qname_pool_count)
+    qname = sax2->qname_pool[--sax2->qname_pool_count];
+
+  return raptor_new_qname_reuse(&sax2->namespaces, name, value, qname,
+                                &sax2->pool_allocations_avoided);
+}
+
+
+/*
+ * raptor_sax2_release_qname:
+ * @sax2: SAX2 object
+ * @qname: qname created by raptor_sax2_new_qname()
+ *
+ * INTERNAL - Release a qname to the pool or free it if the pool is full
+ */
+static void
+raptor_sax2_release_qname(raptor_sax2* sax2, raptor_qname* qname)
+{
+  if(sax2->qname_pool_count == RAPTOR_SAX2_QNAME_POOL_SIZE) {
+    raptor_free_qname(qname);
+    return;
+  }
+
+  raptor_qname_clear(qname);
+  sax2->qname_pool[sax2->qname_pool_count++] = qname;
+}
+
+
+/*
+ * raptor_sax2_new_xml_element:
+ * @sax2: SAX2 object
+ * @name: element name
+ * @xml_language: the in-scope XML language (or NULL)
+ * @xml_base: the in-scope XML base URI (or NULL)
+ *
+ * INTERNAL - Create an XML element, reusing a released one if available
+ *
+ * A reused element keeps its content stringbuffer and attributes
+ * array from the previous use.
+ *
+ * Return value: new element or NULL on failure
+ */
+static raptor_xml_element*
+raptor_sax2_new_xml_element(raptor_sax2* sax2, raptor_qname *name,
+                            const unsigned char *xml_language,
+                            raptor_uri *xml_base)
+{
+  raptor_xml_element* xml_element = sax2->element_pool;
+
+  if(!xml_element)
+    return raptor_new_xml_element(name, xml_language, xml_base);
+
+  sax2->element_pool = xml_element->parent;
+  xml_element->parent = NULL;
+  sax2->pool_allocations_avoided++;
+
+  if(xml_element->content_cdata_sb)
+    sax2->pool_allocations_avoided++;
+  else {
+    /* the user of the element took the stringbuffer */
+    xml_element->content_cdata_sb = raptor_new_stringbuffer();
+    if(!xml_element->content_cdata_sb) {
+      raptor_free_xml_element(xml_element);
+      return NULL;
+    }
+  }
+
+  xml_element->name = name;
+  xml_element->xml_language = xml_language;
+  xml_element->base_uri = xml_base;
+
+  return xml_element;
+}
+
+
+/*
+ * raptor_sax2_release_xml_element:
+ * @sax2: SAX2 object
+ * @xml_element: element created by raptor_sax2_new_xml_element()
+ *
+ * INTERNAL - Release an XML element and its qnames to the pools
+ */
+static void
+raptor_sax2_release_xml_element(raptor_sax2* sax2,
+                                raptor_xml_element *xml_element)
+{
+  unsigned int i;
+
+  for(i = 0; i < xml_element->attribute_count; i++) {
+    if(xml_element->attributes[i]) {
+      raptor_sax2_release_qname(sax2, xml_element->attributes[i]);
+      xml_element->attributes[i] = NULL;
+    }
+  }
+  xml_element->attribute_count = 0;
+
+  if(xml_element->name) {
+    raptor_sax2_release_qname(sax2, xml_element->name);
+    xml_element->name = NULL;
+  }
+
+  if(xml_element->content_cdata_sb)
+    raptor_stringbuffer_clear(xml_element->content_cdata_sb);
+  xml_element->content_cdata_length = 0;
+  xml_element->content_cdata_seen = 0;
+  xml_element->content_element_seen = 0;
+
+  if(xml_element->base_uri) {
+    raptor_free_uri(xml_element->base_uri);
+    xml_element->base_uri = NULL;
+  }
+
+  if(xml_element->xml_language) {
+    RAPTOR_FREE(char*, xml_element->xml_language);
+    xml_element->xml_language = NULL;
+  }
+
+  if(xml_element->declared_nspaces) {
+    raptor_free_sequence(xml_element->declared_nspaces);
+    xml_element->declared_nspaces = NULL;
+  }
+
+  xml_element->user_data = NULL;
+
+  xml_element->parent = sax2->element_pool;
+  sax2->element_pool = xml_element;
+}
+
+
+/*
+ * raptor_sax2_get_pool_allocations_avoided:
+ * @sax2: sax2 object
+ *
+ * INTERNAL - Get the number of element, qname and attribute array
+ * allocations avoided by reuse since the parse started.
+ *
+ * Return value: count of allocations avoided
+ */
+unsigned long
+raptor_sax2_get_pool_allocations_avoided(raptor_sax2* sax2)
+{
+  return sax2->pool_allocations_avoided;
+}
+
+
+#if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
+void
+raptor_sax2_stats_print(raptor_sax2* sax2, FILE *stream)
+{
+  fprintf(stream, "sax2 pool allocations avoided: %lu\n",
+          raptor_sax2_get_pool_allocations_avoided(sax2));
+}
+#endif
+
+
 /**
  * raptor_xml_element_is_empty:
  * @xml_element: XML Element
@@ -438,6 +625,7 @@ raptor_sax2_parse_start(raptor_sax2* sax2, raptor_uri *base_uri)
   sax2->depth = 0;
   sax2->root_element = NULL;
   sax2->current_element = NULL;
+  sax2->pool_allocations_avoided = 0;
 
   if(sax2->base_uri)
     raptor_free_uri(sax2->base_uri);
@@ -459,6 +647,13 @@ raptor_sax2_parse_start(raptor_sax2* sax2, raptor_uri *base_uri)
   }
 #endif
 
+#ifdef RAPTOR_XML_NATIVE
+  if(sax2->xt) {
+    raptor_free_xmltok(sax2->xt);
+    sax2->xt = NULL;
+  }
+#endif
+
   raptor_namespaces_clear(&sax2->namespaces);
 
   if(raptor_namespaces_init(sax2->world, &sax2->namespaces, 1)) {
@@ -577,10 +772,207 @@ raptor_sax2_parse_chunk(raptor_sax2* sax2, const unsigned char *buffer,
   handle_error:
 #endif
 
+#ifdef RAPTOR_XML_NATIVE
+  if(!sax2->xt) {
+    if(!len && is_end) {
+      /* no data given at all */
+      raptor_sax2_update_document_locator(sax2, sax2->locator);
+      raptor_log_error(sax2->world, RAPTOR_LOG_LEVEL_ERROR, sax2->locator,
+                       "XML Parsing failed - no element found");
+      return 1;
+    }
+
+    sax2->xt = raptor_new_xmltok(sax2);
+    if(!sax2->xt)
+      return 1;
+  }
+
+  return raptor_xmltok_parse_chunk(sax2->xt, buffer, len, is_end);
+#else
   return 1;
+#endif
+}
+
+
+#ifdef RAPTOR_XML_LIBXML
+/* "prefix:local" or "local" as a new string */
+static unsigned char*
+raptor_sax2_new_xml_node_name(const xmlChar* prefix, const xmlChar* local)
+{
+  size_t prefix_len = prefix ? strlen((const char*)prefix) : 0;
+  size_t local_len = strlen((const char*)local);
+  unsigned char* name;
+  unsigned char* p;
+
+  name = RAPTOR_MALLOC(unsigned char*, prefix_len + local_len + 2);
+  if(!name)
+    return NULL;
+
+  p = name;
+  if(prefix) {
+    memcpy(p, prefix, prefix_len);
+    p += prefix_len;
+    *p++ = ':';
+  }
+  memcpy(p, local, local_len + 1);
+
+  return name;
+}
+
+
+/*
+ * Generate the start element event for element @node with its
+ * namespace declarations and attributes as libxml would when parsing
+ * the serialized element: declarations first, names with prefixes and
+ * values in memory from xmlMalloc() that raptor_sax2_start_element()
+ * may replace.
+ */
+static int
+raptor_sax2_start_xml_node(raptor_sax2* sax2, xmlNodePtr node)
+{
+  xmlNsPtr ns;
+  xmlAttrPtr attr;
+  int count = 0;
+  const unsigned char** atts = NULL;
+  unsigned char* name;
+  int i = 0;
+  int rc = 0;
+
+  for(ns = node->nsDef; ns; ns = ns->next)
+    count++;
+  for(attr = node->properties; attr; attr = attr->next)
+    count++;
+
+  name = raptor_sax2_new_xml_node_name(node->ns ? node->ns->prefix : NULL,
+                                       node->name);
+  if(!name)
+    return 1;
+
+  if(count) {
+    atts = RAPTOR_CALLOC(const unsigned char**, RAPTOR_GOOD_CAST(size_t, (count << 1) + 1),
+                         sizeof(unsigned char*));
+    if(!atts) {
+      RAPTOR_FREE(char*, name);
+      return 1;
+    }
+
+    for(ns = node->nsDef; ns; ns = ns->next) {
+      atts[i++] = ns->prefix ?
+        raptor_sax2_new_xml_node_name((const xmlChar*)"xmlns", ns->prefix) :
+        raptor_sax2_new_xml_node_name(NULL, (const xmlChar*)"xmlns");
+      atts[i++] = xmlStrdup(ns->href ? ns->href : (const xmlChar*)"");
+    }
+
+    for(attr = node->properties; attr; attr = attr->next) {
+      xmlChar* value;
+
+      atts[i++] = raptor_sax2_new_xml_node_name(attr->ns ? attr->ns->prefix : NULL,
+                                                attr->name);
+      value = xmlNodeListGetString(node->doc, attr->children, 1);
+      atts[i++] = value ? value : xmlStrdup((const xmlChar*)"");
+    }
+
+    for(i = 0; i < (count << 1); i++) {
+      if(!atts[i])
+        rc = 1;
+    }
+  }
+
+  if(!rc)
+    raptor_sax2_start_element(sax2, name, atts);
+
+  if(atts) {
+    for(i = 0; i < (count << 1); i += 2) {
+      if(atts[i])
+        RAPTOR_FREE(char*, atts[i]);
+      if(atts[i + 1])
+        xmlFree((xmlChar*)atts[i + 1]);
+    }
+    RAPTOR_FREE(cstringpointer, atts);
+  }
+  RAPTOR_FREE(char*, name);
+
+  return rc;
 }
 
 
+/**
+ * raptor_sax2_parse_xml_doc:
+ * @sax2: sax2 object
+ * @doc: libxml document
+ *
+ * INTERNAL - Generate SAX2 events from a libxml document tree
+ *
+ * The events are those that parsing the document serialized as XML
+ * would give, without making and parsing the text.  Must be called
+ * after raptor_sax2_parse_start() instead of raptor_sax2_parse_chunk().
+ *
+ * Return value: non-0 on failure
+ */
+int
+raptor_sax2_parse_xml_doc(raptor_sax2* sax2, xmlDocPtr doc)
+{
+  xmlNodePtr node;
+
+  node = doc->children;
+  while(node && !sax2->failed) {
+    switch(node->type) {
+      case XML_ELEMENT_NODE:
+        if(raptor_sax2_start_xml_node(sax2, node))
+          return 1;
+        if(node->children) {
+          node = node->children;
+          continue;
+        }
+        raptor_sax2_end_element(sax2, node->name);
+        break;
+
+      case XML_TEXT_NODE:
+        if(node->content)
+          raptor_sax2_characters(sax2, node->content,
+                                 xmlStrlen(node->content));
+        break;
+
+      case XML_CDATA_SECTION_NODE:
+        if(node->content)
+          raptor_sax2_cdata(sax2, node->content, xmlStrlen(node->content));
+        break;
+
+      case XML_COMMENT_NODE:
+        if(node->content)
+          raptor_sax2_comment(sax2, node->content);
+        break;
+
+      case XML_ENTITY_REF_NODE:
+        {
+          xmlChar* content = xmlNodeGetContent(node);
+          if(content) {
+            raptor_sax2_characters(sax2, content, xmlStrlen(content));
+            xmlFree(content);
+          }
+        }
+        break;
+
+      default:
+        /* DTD, processing instructions and others give no events */
+        break;
+    }
+
+    /* move to the next node, ending the elements that are finished */
+    while(!node->next) {
+      node = node->parent;
+      if(!node || node->type != XML_ELEMENT_NODE)
+        return sax2->failed;
+      raptor_sax2_end_element(sax2, node->name);
+    }
+    node = node->next;
+  }
+
+  return sax2->failed;
+}
+#endif
+
+
 /**
  * raptor_sax2_set_option:
  * @sax2: #raptor_sax2 SAX2 object
@@ -619,6 +1011,9 @@ raptor_sax2_update_document_locator(raptor_sax2* sax2,
 #ifdef RAPTOR_XML_LIBXML
   raptor_libxml_update_document_locator(sax2, locator);
 #endif
+#ifdef RAPTOR_XML_NATIVE
+  raptor_xmltok_update_document_locator(sax2->xt, locator);
+#endif
 }
 
 
@@ -766,11 +1161,12 @@ raptor_sax2_start_element(void* user_data, const unsigned char *name,
 
 
   /* Create new element structure */
-  el_name = raptor_new_qname(&sax2->namespaces, name, NULL);
+  el_name = raptor_sax2_new_qname(sax2, name, NULL);
   if(!el_name)
     goto fail;
 
-  xml_element = raptor_new_xml_element(el_name, xml_language, xml_base);
+  xml_element = raptor_sax2_new_xml_element(sax2, el_name, xml_language,
+                                            xml_base);
   if(!xml_element) {
     raptor_free_qname(el_name);
     goto fail;
@@ -782,15 +1178,27 @@ raptor_sax2_start_element(void* user_data, const unsigned char *name,
   /* Turn string attributes into namespaced-attributes */
   if(ns_attributes_count) {
     int i;
-    int offset = 0;
-
-    /* Allocate new array to hold namespaced-attributes */
-    named_attrs = RAPTOR_CALLOC(raptor_qname**, ns_attributes_count, 
-                                sizeof(raptor_qname*));
-    if(!named_attrs) {
-      raptor_log_error(sax2->world, RAPTOR_LOG_LEVEL_FATAL,
-                       sax2->locator, "Out of memory");
-      goto fail;
+
+    /* Reuse the element's attributes array if it is big enough */
+    named_attrs = xml_element->attributes;
+    if(named_attrs &&
+       xml_element->attributes_size >= RAPTOR_GOOD_CAST(unsigned int, ns_attributes_count))
+      sax2->pool_allocations_avoided++;
+    else {
+      if(named_attrs)
+        RAPTOR_FREE(raptor_qname_array, named_attrs);
+      xml_element->attributes_size = 0;
+
+      /* Allocate new array to hold namespaced-attributes */
+      named_attrs = RAPTOR_CALLOC(raptor_qname**, ns_attributes_count, 
+                                  sizeof(raptor_qname*));
+      xml_element->attributes = named_attrs;
+      if(!named_attrs) {
+        raptor_log_error(sax2->world, RAPTOR_LOG_LEVEL_FATAL,
+                         sax2->locator, "Out of memory");
+        goto fail;
+      }
+      xml_element->attributes_size = RAPTOR_GOOD_CAST(unsigned int, ns_attributes_count);
     }
 
     for(i = 0; i < all_atts_count; i++) {
@@ -801,25 +1209,15 @@ raptor_sax2_start_element(void* user_data, const unsigned char *name,
         continue;
 
       /* namespace-name[i] stored in named_attrs[i] */
-      attr = raptor_new_qname(&sax2->namespaces, atts[i<<1], atts[(i<<1)+1]);
-      if(!attr) { /* failed - tidy up and return */
-        int j;
-
-        for(j = 0; j < i; j++)
-          RAPTOR_FREE(raptor_qname, named_attrs[j]);
-        RAPTOR_FREE(raptor_qname_array, named_attrs);
+      attr = raptor_sax2_new_qname(sax2, atts[i<<1], atts[(i<<1)+1]);
+      if(!attr) /* failed - element tidies up the attributes so far */
         goto fail;
-      }
 
-      named_attrs[offset++] = attr;
+      named_attrs[xml_element->attribute_count++] = attr;
     }
   } /* end if ns_attributes_count */
 
 
-  if(named_attrs)
-    raptor_xml_element_set_attributes(xml_element,
-                                      named_attrs, ns_attributes_count);
-
   raptor_xml_element_push(sax2, xml_element);
 
   if(sax2->start_element_handler)
@@ -871,7 +1269,7 @@ raptor_sax2_end_element(void* user_data, const unsigned char *name)
                                   raptor_sax2_get_depth(sax2));
   xml_element = raptor_xml_element_pop(sax2);
   if(xml_element)
-    raptor_free_xml_element(xml_element);
+    raptor_sax2_release_xml_element(sax2, xml_element);
 
   raptor_sax2_dec_depth(sax2);
 }
@@ -115,6 +115,10 @@ raptor_serializers_init(raptor_world* world)
   rc += raptor_init_serializer_nquads(world) != 0;
 #endif
 
+#ifdef RAPTOR_SERIALIZER_BINARY
+  rc += raptor_init_serializer_binary(world) != 0;
+#endif
+
   return rc;
 }
 
@@ -584,6 +588,20 @@ raptor_serializer_serialize_statement(raptor_serializer* rdf_serializer,
 }
 
 
+static void
+raptor_serializer_relative_cache_clear(raptor_serializer* rdf_serializer)
+{
+  if(rdf_serializer->relative_cache) {
+    raptor_free_uri_relative_cache(rdf_serializer->relative_cache);
+    rdf_serializer->relative_cache = NULL;
+  }
+  if(rdf_serializer->relative_cache_base) {
+    raptor_free_uri(rdf_serializer->relative_cache_base);
+    rdf_serializer->relative_cache_base = NULL;
+  }
+}
+
+
 /**
  * raptor_serializer_serialize_end:
  * @rdf_serializer:  the #raptor_serializer
@@ -610,10 +628,63 @@ raptor_serializer_serialize_end(raptor_serializer *rdf_serializer)
       raptor_free_iostream(rdf_serializer->iostream);
     rdf_serializer->iostream = NULL;
   }
+
+  raptor_serializer_relative_cache_clear(rdf_serializer);
+
   return rc;
 }
 
 
+/*
+ * raptor_serializer_uri_to_relative_string:
+ * @rdf_serializer: raptor serializer
+ * @uri: URI to write
+ *
+ * INTERNAL - Get @uri relative to the serializer base URI
+ *
+ * Uses a #raptor_uri_relative_cache so that the base URI is parsed
+ * once per serialization and each interned URI is only made relative
+ * once.  With no base URI this is the full URI string.
+ *
+ * Return value: new string or NULL on failure
+ */
+unsigned char*
+raptor_serializer_uri_to_relative_string(raptor_serializer* rdf_serializer,
+                                         raptor_uri* uri)
+{
+  const unsigned char* str;
+  unsigned char* new_str;
+  size_t len;
+
+  if(!rdf_serializer->base_uri)
+    return raptor_uri_to_relative_uri_string(NULL, uri);
+
+  if(rdf_serializer->relative_cache &&
+     !raptor_uri_equals(rdf_serializer->relative_cache_base,
+                        rdf_serializer->base_uri))
+    raptor_serializer_relative_cache_clear(rdf_serializer);
+
+  if(!rdf_serializer->relative_cache) {
+    rdf_serializer->relative_cache = raptor_new_uri_relative_cache(rdf_serializer->base_uri);
+    if(!rdf_serializer->relative_cache)
+      return NULL;
+    rdf_serializer->relative_cache_base = raptor_uri_copy(rdf_serializer->base_uri);
+  }
+
+  str = raptor_uri_relative_cache_get(rdf_serializer->relative_cache, uri,
+                                      &len);
+  if(!str)
+    return NULL;
+
+  new_str = RAPTOR_MALLOC(unsigned char*, len + 1);
+  if(!new_str)
+    return NULL;
+  memcpy(new_str, str, len + 1);
+
+  return new_str;
+}
+
+
 
 /**
  * raptor_free_serializer:
@@ -637,6 +708,8 @@ raptor_free_serializer(raptor_serializer* rdf_serializer)
   if(rdf_serializer->base_uri)
     raptor_free_uri(rdf_serializer->base_uri);
 
+  raptor_serializer_relative_cache_clear(rdf_serializer);
+
   raptor_object_options_clear(&rdf_serializer->options);
 
   RAPTOR_FREE(raptor_serializer, rdf_serializer);
@@ -52,11 +52,28 @@ typedef struct {
   /* Ordered sequence of triples if is_resource */
   raptor_avltree* avltree;
 
-  /* Last statement generated if is_resource (shared pointer) */
+  /* Last statement generated if is_resource */
   raptor_statement* last_statement;
 
   int need_object_comma;
 
+  /* non-0 to write each subject when the next one starts, for input
+   * grouped by subject (RAPTOR_OPTION_JSON_STREAMING) */
+  int streaming;
+
+  /* Subject of the statements in avltree when streaming */
+  raptor_term* group_subject;
+
+  /* Statements held before they are spilled to a sorted run
+   * (RAPTOR_OPTION_JSON_SORT_LIMIT) or 0 for no limit */
+  int sort_limit;
+
+  /* Sequence of raptor_json_run sorted runs in temporary files */
+  raptor_sequence* runs;
+
+  /* non-0 if writing or merging a sorted run failed */
+  int runs_failed;
+
 } raptor_json_context;
 
 
@@ -67,6 +84,8 @@ static int raptor_json_serialize_start(raptor_serializer* serializer);
 static int raptor_json_serialize_statement(raptor_serializer* serializer, 
                                            raptor_statement *statement);
 static int raptor_json_serialize_end(raptor_serializer* serializer);
+static int raptor_json_serialize_write_avltree(raptor_serializer* serializer);
+static int raptor_json_serialize_spill_run(raptor_serializer* serializer);
 static void raptor_json_serialize_finish_factory(raptor_serializer_factory* factory);
 
 
@@ -105,6 +124,21 @@ raptor_json_serialize_terminate(raptor_serializer* serializer)
     raptor_free_avltree(context->avltree);
     context->avltree = NULL;
   }
+
+  if(context->last_statement) {
+    raptor_free_statement(context->last_statement);
+    context->last_statement = NULL;
+  }
+
+  if(context->group_subject) {
+    raptor_free_term(context->group_subject);
+    context->group_subject = NULL;
+  }
+
+  if(context->runs) {
+    raptor_free_sequence(context->runs);
+    context->runs = NULL;
+  }
 }
 
 
@@ -133,6 +167,12 @@ raptor_json_serialize_start(raptor_serializer* serializer)
       context->json_writer = NULL;
       return 1;
     }
+
+    context->streaming = RAPTOR_OPTIONS_GET_NUMERIC(serializer,
+                                                    RAPTOR_OPTION_JSON_STREAMING);
+    context->sort_limit = RAPTOR_OPTIONS_GET_NUMERIC(serializer,
+                                                     RAPTOR_OPTION_JSON_SORT_LIMIT);
+    context->runs_failed = 0;
   }
 
   /* start callback */
@@ -142,7 +182,12 @@ raptor_json_serialize_start(raptor_serializer* serializer)
     raptor_iostream_write_byte('(', serializer->iostream);
   }
 
-  if(!context->is_resource) {
+  if(context->is_resource) {
+    /* start outer object */
+    raptor_json_writer_newline(context->json_writer);
+    raptor_json_writer_start_block(context->json_writer, '{');
+    raptor_json_writer_newline(context->json_writer);
+  } else {
     /* start outer object */
     raptor_json_writer_start_block(context->json_writer, '{');
     raptor_json_writer_newline(context->json_writer);
@@ -165,10 +210,40 @@ raptor_json_serialize_statement(raptor_serializer* serializer,
   raptor_json_context* context = (raptor_json_context*)serializer->context;
 
   if(context->is_resource) {
-    raptor_statement* s = raptor_statement_copy(statement);
+    raptor_statement* s;
+    int rc;
+
+    /* the error was reported when the run failed */
+    if(context->runs_failed)
+      return 1;
+
+    if(context->streaming) {
+      /* a new subject means the previous one is complete */
+      if(context->group_subject &&
+         !raptor_term_equals(context->group_subject, statement->subject)) {
+        if(raptor_json_serialize_write_avltree(serializer))
+          return 1;
+      }
+
+      if(!context->group_subject) {
+        context->group_subject = raptor_term_copy(statement->subject);
+        if(!context->group_subject)
+          return 1;
+      }
+    }
+
+    s = raptor_statement_copy(statement);
     if(!s)
       return 1;
-    return raptor_avltree_add(context->avltree, s);
+    rc = raptor_avltree_add(context->avltree, s);
+    if(rc)
+      return rc;
+
+    if(!context->streaming && context->sort_limit > 0 &&
+       raptor_avltree_size(context->avltree) >= context->sort_limit)
+      return raptor_json_serialize_spill_run(serializer);
+
+    return 0;
   }
 
   if(context->need_subject_comma) {
@@ -208,14 +283,21 @@ raptor_json_serialize_statement(raptor_serializer* serializer,
 }
 
 
-/* return 0 to abort visit */
-static int
-raptor_json_serialize_avltree_visit(int depth, void* data, void *user_data)
+/*
+ * raptor_json_serialize_write_statement:
+ * @serializer: serializer
+ * @statement: statement to write
+ *
+ * INTERNAL - Write a statement into the resource-centric output
+ *
+ * Statements must arrive in raptor_statement_compare() order.
+ */
+static void
+raptor_json_serialize_write_statement(raptor_serializer* serializer,
+                                      raptor_statement* statement)
 {
-  raptor_serializer* serializer = (raptor_serializer*)user_data;
   raptor_json_context* context = (raptor_json_context*)serializer->context;
 
-  raptor_statement* statement = (raptor_statement*)data;
   raptor_statement* s1 = statement;
   raptor_statement* s2 = context->last_statement;
   int new_subject = 0;
@@ -326,28 +408,496 @@ raptor_json_serialize_avltree_visit(int depth, void* data, void *user_data)
   /* end triple */
 
   context->need_object_comma = 1;
-  context->last_statement = statement;
+
+  /* s1 may be freed before the next statement is written */
+  s1 = raptor_statement_copy(statement);
+  if(context->last_statement)
+    raptor_free_statement(context->last_statement);
+  context->last_statement = s1;
+}
+
+
+/* return 0 to abort visit */
+static int
+raptor_json_serialize_avltree_visit(int depth, void* data, void *user_data)
+{
+  raptor_serializer* serializer = (raptor_serializer*)user_data;
+
+  raptor_json_serialize_write_statement(serializer, (raptor_statement*)data);
 
   return 1;
 }
 
 
+/*
+ * raptor_json_serialize_write_avltree:
+ * @serializer: serializer
+ *
+ * INTERNAL - Write the statements held in memory and forget them
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_json_serialize_write_avltree(raptor_serializer* serializer)
+{
+  raptor_json_context* context = (raptor_json_context*)serializer->context;
+
+  raptor_avltree_visit(context->avltree,
+                       raptor_json_serialize_avltree_visit,
+                       serializer);
+
+  raptor_avltree_trim(context->avltree);
+
+  if(context->group_subject) {
+    raptor_free_term(context->group_subject);
+    context->group_subject = NULL;
+  }
+
+  return 0;
+}
+
+
+/*
+ * The sorted runs are written with the binary syntax when it is
+ * available, since it reads back quickest, otherwise with N-Triples.
+ */
+static const char*
+raptor_json_serialize_run_syntax(raptor_world* world)
+{
+  if(raptor_world_is_serializer_name(world, "binary") &&
+     raptor_world_is_parser_name(world, "binary"))
+    return "binary";
+
+  return "ntriples";
+}
+
+
+/* Most sorted runs that are read at once */
+#define RAPTOR_JSON_MERGE_RUNS 16
+
+/* Most terms a binary run reader keeps at once */
+#define RAPTOR_JSON_RUN_MAX_TERMS 4096
+
+typedef struct {
+  /* temporary file holding the run */
+  FILE* fh;
+
+  /* 0 for a run spilled from memory, otherwise one more than the
+   * highest level of the runs merged into it */
+  int level;
+} raptor_json_run;
+
+
+static void
+raptor_json_serialize_free_run(void* data)
+{
+  raptor_json_run* run = (raptor_json_run*)data;
+
+  if(run->fh)
+    fclose(run->fh);
+  RAPTOR_FREE(raptor_json_run*, run);
+}
+
+
+/* return 0 to abort visit */
+static int
+raptor_json_serialize_run_visit(int depth, void* data, void *user_data)
+{
+  raptor_serializer* run_serializer = (raptor_serializer*)user_data;
+
+  return !raptor_serializer_serialize_statement(run_serializer,
+                                                (raptor_statement*)data);
+}
+
+
+/*
+ * raptor_json_serialize_new_run:
+ * @serializer: serializer
+ * @run_p: pointer to store the new run
+ *
+ * INTERNAL - Create a run in a temporary file and a serializer to
+ * write it
+ *
+ * After the first failure no more runs are created so the error is
+ * only reported once.
+ *
+ * Return value: run serializer or NULL on failure
+ */
+static raptor_serializer*
+raptor_json_serialize_new_run(raptor_serializer* serializer,
+                              raptor_json_run** run_p)
+{
+  raptor_json_context* context = (raptor_json_context*)serializer->context;
+  raptor_world* world = serializer->world;
+  const char* syntax = raptor_json_serialize_run_syntax(world);
+  raptor_serializer* run_serializer = NULL;
+  raptor_json_run* run;
+
+  if(context->runs_failed)
+    return NULL;
+
+  run = RAPTOR_CALLOC(raptor_json_run*, 1, sizeof(*run));
+  if(!run)
+    goto failed;
+
+  run->fh = tmpfile();
+  if(!run->fh) {
+    raptor_log_error_formatted(world, RAPTOR_LOG_LEVEL_ERROR, NULL,
+                               "Could not create a temporary file for sorting JSON statements");
+    goto failed;
+  }
+
+  run_serializer = raptor_new_serializer(world, syntax);
+  if(!run_serializer)
+    goto failed;
+
+#ifdef RAPTOR_SERIALIZER_BINARY
+  if(!strcmp(syntax, "binary"))
+    raptor_binary_serializer_set_max_terms(run_serializer,
+                                           RAPTOR_JSON_RUN_MAX_TERMS);
+#endif
+
+  if(raptor_serializer_start_to_file_handle(run_serializer, NULL, run->fh))
+    goto failed;
+
+  *run_p = run;
+  return run_serializer;
+
+  failed:
+  if(run_serializer)
+    raptor_free_serializer(run_serializer);
+  if(run)
+    raptor_json_serialize_free_run(run);
+  context->runs_failed = 1;
+  return NULL;
+}
+
+
+/*
+ * raptor_json_serialize_add_run:
+ * @serializer: serializer
+ * @run_serializer: serializer writing @run
+ * @run: run
+ *
+ * INTERNAL - Finish writing a run and add it to the runs to merge
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_json_serialize_add_run(raptor_serializer* serializer,
+                              raptor_serializer* run_serializer,
+                              raptor_json_run* run)
+{
+  raptor_json_context* context = (raptor_json_context*)serializer->context;
+  int rc;
+
+  rc = raptor_serializer_serialize_end(run_serializer);
+  /* the run serializer may still hold unwritten output */
+  raptor_free_serializer(run_serializer);
+
+  if(!rc)
+    rc = fflush(run->fh);
+
+  if(!rc && !context->runs) {
+    context->runs = raptor_new_sequence(raptor_json_serialize_free_run, NULL);
+    rc = !context->runs;
+  }
+
+  if(rc) {
+    raptor_json_serialize_free_run(run);
+    context->runs_failed = 1;
+    return 1;
+  }
+
+  if(raptor_sequence_push(context->runs, run)) {
+    context->runs_failed = 1;
+    return 1;
+  }
+
+  return 0;
+}
+
+
+/*
+ * raptor_json_serialize_merge_runs:
+ * @serializer: serializer
+ * @count: number of runs to merge from the end of the runs
+ * @run_serializer: serializer to write the merged run or NULL to
+ *   write the JSON output
+ *
+ * INTERNAL - Merge the last @count sorted runs in order
+ *
+ * Statements that appear in more than one run are written once, as
+ * they would be if all the statements had been held in memory.  The
+ * runs are removed and each is closed as soon as it has been read.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_json_serialize_merge_runs(raptor_serializer* serializer, int count,
+                                 raptor_serializer* run_serializer)
+{
+  raptor_json_context* context = (raptor_json_context*)serializer->context;
+  raptor_world* world = serializer->world;
+  const char* syntax = raptor_json_serialize_run_syntax(world);
+  raptor_json_run** runs;
+  raptor_parser** parsers;
+  raptor_iostream** iostreams;
+  raptor_statement** heads;
+  raptor_statement* last = NULL;
+  int i;
+  int rc = 0;
+
+  runs = RAPTOR_CALLOC(raptor_json_run**, count, sizeof(*runs));
+  parsers = RAPTOR_CALLOC(raptor_parser**, count, sizeof(*parsers));
+  iostreams = RAPTOR_CALLOC(raptor_iostream**, count, sizeof(*iostreams));
+  heads = RAPTOR_CALLOC(raptor_statement**, count, sizeof(*heads));
+  if(!runs || !parsers || !iostreams || !heads) {
+    rc = 1;
+    goto tidy;
+  }
+
+  for(i = count - 1; i >= 0; i--)
+    runs[i] = (raptor_json_run*)raptor_sequence_pop(context->runs);
+
+  for(i = 0; i < count; i++) {
+    rewind(runs[i]->fh);
+    iostreams[i] = raptor_new_iostream_from_file_handle(world, runs[i]->fh);
+    parsers[i] = raptor_new_parser(world, syntax);
+    if(!iostreams[i] || !parsers[i] ||
+       raptor_parser_parse_iostream_start(parsers[i], iostreams[i], NULL)) {
+      rc = 1;
+      goto tidy;
+    }
+
+    rc = raptor_parser_next_statement(parsers[i], &heads[i]);
+    if(rc) {
+      heads[i] = NULL;
+      if(rc < 0)
+        goto tidy;
+      rc = 0;
+    }
+  }
+
+  while(1) {
+    int least = -1;
+
+    for(i = 0; i < count; i++) {
+      if(heads[i] &&
+         (least < 0 || raptor_statement_compare(heads[i], heads[least]) < 0))
+        least = i;
+    }
+    if(least < 0)
+      break;
+
+    if(run_serializer) {
+      if(!last || raptor_statement_compare(heads[least], last)) {
+        if(raptor_serializer_serialize_statement(run_serializer,
+                                                 heads[least])) {
+          rc = 1;
+          goto tidy;
+        }
+
+        if(last)
+          raptor_free_statement(last);
+        last = raptor_statement_copy(heads[least]);
+        if(!last) {
+          rc = 1;
+          goto tidy;
+        }
+      }
+    } else if(!context->last_statement ||
+              raptor_statement_compare(heads[least], context->last_statement))
+      raptor_json_serialize_write_statement(serializer, heads[least]);
+
+    rc = raptor_parser_next_statement(parsers[least], &heads[least]);
+    if(rc) {
+      heads[least] = NULL;
+      if(rc < 0)
+        goto tidy;
+      rc = 0;
+
+      /* this run is used up */
+      raptor_free_parser(parsers[least]);
+      parsers[least] = NULL;
+      raptor_free_iostream(iostreams[least]);
+      iostreams[least] = NULL;
+      raptor_json_serialize_free_run(runs[least]);
+      runs[least] = NULL;
+    }
+  }
+
+  tidy:
+  for(i = 0; i < count; i++) {
+    if(parsers && parsers[i])
+      raptor_free_parser(parsers[i]);
+    if(iostreams && iostreams[i])
+      raptor_free_iostream(iostreams[i]);
+    if(runs && runs[i])
+      raptor_json_serialize_free_run(runs[i]);
+  }
+  if(runs)
+    RAPTOR_FREE(raptor_json_run**, runs);
+  if(parsers)
+    RAPTOR_FREE(raptor_parser**, parsers);
+  if(iostreams)
+    RAPTOR_FREE(raptor_iostream**, iostreams);
+  if(heads)
+    RAPTOR_FREE(raptor_statement**, heads);
+  if(last)
+    raptor_free_statement(last);
+
+  if(rc)
+    context->runs_failed = 1;
+
+  return rc;
+}
+
+
+/*
+ * raptor_json_serialize_merge_to_run:
+ * @serializer: serializer
+ * @count: number of runs to merge from the end of the runs
+ *
+ * INTERNAL - Replace the last @count sorted runs by one merged run
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_json_serialize_merge_to_run(raptor_serializer* serializer, int count)
+{
+  raptor_json_context* context = (raptor_json_context*)serializer->context;
+  raptor_serializer* run_serializer;
+  raptor_json_run* run = NULL;
+  int level = 0;
+  int size = raptor_sequence_size(context->runs);
+  int i;
+
+  for(i = size - count; i < size; i++) {
+    raptor_json_run* merged;
+
+    merged = (raptor_json_run*)raptor_sequence_get_at(context->runs, i);
+    if(merged->level >= level)
+      level = merged->level + 1;
+  }
+
+  run_serializer = raptor_json_serialize_new_run(serializer, &run);
+  if(!run_serializer)
+    return 1;
+  run->level = level;
+
+  if(raptor_json_serialize_merge_runs(serializer, count, run_serializer)) {
+    raptor_free_serializer(run_serializer);
+    raptor_json_serialize_free_run(run);
+    return 1;
+  }
+
+  return raptor_json_serialize_add_run(serializer, run_serializer, run);
+}
+
+
+/*
+ * raptor_json_serialize_spill_run:
+ * @serializer: serializer
+ *
+ * INTERNAL - Write the statements held in memory to a temporary file
+ * as a sorted run and forget them
+ *
+ * Whenever there are RAPTOR_JSON_MERGE_RUNS runs of the same level
+ * they are merged into one run of the next level, so the runs open at
+ * once grow only with the log of the number of statements.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_json_serialize_spill_run(raptor_serializer* serializer)
+{
+  raptor_json_context* context = (raptor_json_context*)serializer->context;
+  raptor_serializer* run_serializer;
+  raptor_json_run* run = NULL;
+
+  run_serializer = raptor_json_serialize_new_run(serializer, &run);
+  if(!run_serializer)
+    return 1;
+
+  if(!raptor_avltree_visit(context->avltree,
+                           raptor_json_serialize_run_visit,
+                           run_serializer)) {
+    raptor_free_serializer(run_serializer);
+    raptor_json_serialize_free_run(run);
+    context->runs_failed = 1;
+    return 1;
+  }
+
+  if(raptor_json_serialize_add_run(serializer, run_serializer, run))
+    return 1;
+
+  raptor_avltree_trim(context->avltree);
+
+  while(1) {
+    int size = raptor_sequence_size(context->runs);
+    raptor_json_run* first;
+    raptor_json_run* last;
+
+    if(size < RAPTOR_JSON_MERGE_RUNS)
+      break;
+
+    /* levels never increase along the runs */
+    first = (raptor_json_run*)raptor_sequence_get_at(context->runs,
+                                                     size - RAPTOR_JSON_MERGE_RUNS);
+    last = (raptor_json_run*)raptor_sequence_get_at(context->runs, size - 1);
+    if(first->level != last->level)
+      break;
+
+    if(raptor_json_serialize_merge_to_run(serializer, RAPTOR_JSON_MERGE_RUNS))
+      return 1;
+  }
+
+  return 0;
+}
+
+
+/*
+ * raptor_json_serialize_write_runs:
+ * @serializer: serializer
+ *
+ * INTERNAL - Write the statements from all the sorted runs in order
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_json_serialize_write_runs(raptor_serializer* serializer)
+{
+  raptor_json_context* context = (raptor_json_context*)serializer->context;
+
+  while(raptor_sequence_size(context->runs) > RAPTOR_JSON_MERGE_RUNS) {
+    if(raptor_json_serialize_merge_to_run(serializer, RAPTOR_JSON_MERGE_RUNS))
+      return 1;
+  }
+
+  return raptor_json_serialize_merge_runs(serializer,
+                                          raptor_sequence_size(context->runs),
+                                          NULL);
+}
+
+
 static int
 raptor_json_serialize_end(raptor_serializer* serializer)
 {
   raptor_json_context* context = (raptor_json_context*)serializer->context;
   char* value;
-  
-  raptor_json_writer_newline(context->json_writer);
+  int rc = 0;
 
   if(context->is_resource) {
-    /* start outer object */
-    raptor_json_writer_start_block(context->json_writer, '{');
-    raptor_json_writer_newline(context->json_writer);
-    
-    raptor_avltree_visit(context->avltree,
-                         raptor_json_serialize_avltree_visit,
-                         serializer);
+    if(context->runs_failed)
+      rc = 1;
+    else if(context->runs) {
+      if(raptor_avltree_size(context->avltree))
+        rc = raptor_json_serialize_spill_run(serializer);
+      if(!rc)
+        rc = raptor_json_serialize_write_runs(serializer);
+    } else
+      rc = raptor_json_serialize_write_avltree(serializer);
 
     /* end last triples block */
     if(context->last_statement) {
@@ -359,6 +909,8 @@ raptor_json_serialize_end(raptor_serializer* serializer)
       raptor_json_writer_newline(context->json_writer);
     }
   } else {
+    raptor_json_writer_newline(context->json_writer);
+
     /* end triples array */
     raptor_json_writer_end_block(context->json_writer, ']');
     raptor_json_writer_newline(context->json_writer);
@@ -383,7 +935,7 @@ raptor_json_serialize_end(raptor_serializer* serializer)
     raptor_iostream_counted_string_write((const unsigned char*)");", 2,
                                          serializer->iostream);
 
-  return 0;
+  return rc;
 }
 
 
@@ -35,20 +35,89 @@
 #ifdef HAVE_STDLIB_H
 #include <stdlib.h>
 #endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 /* Raptor includes */
 #include "raptor2.h"
 #include "raptor_internal.h"
 
 
+#ifndef STANDALONE
+
+#ifdef HAVE_PTHREAD
+/* Number of statements in a batch handed to an encoding thread */
+#define RAPTOR_NTRIPLES_BATCH_SIZE 1024
+
+/* Upper limit on the RAPTOR_OPTION_WRITE_THREADS option value */
+#define RAPTOR_NTRIPLES_MAX_THREADS 64
+
+typedef struct {
+  /* subject, predicate, object and graph (or NULL) of each statement.
+   * References are only taken and released on the serializing thread.
+   */
+  raptor_term* terms[RAPTOR_NTRIPLES_BATCH_SIZE * 4];
+  int count;
+
+  /* formatted output */
+  unsigned char* buffer;
+  size_t length;
+  size_t size;
+  int failed;
+
+  /* set by the encoding thread when buffer is complete; protected by lock */
+  int done;
+} raptor_ntriples_batch;
+
+struct raptor_ntriples_serializer_context_s;
+
+typedef struct {
+  struct raptor_ntriples_serializer_context_s* context;
+  pthread_t thread;
+  /* writes to the buffer of batch */
+  raptor_iostream* iostream;
+  raptor_ntriples_batch* batch;
+} raptor_ntriples_encoder;
+#endif
+
+
 /*
  * Raptor N-Triples serializer object
  */
-typedef struct {
+typedef struct raptor_ntriples_serializer_context_s {
   int is_nquads;
+
+#ifdef HAVE_PTHREAD
+  /* number of encoding threads or 0 when formatting on the caller's thread */
+  int threads_count;
+  raptor_ntriples_encoder* encoders;
+
+  /* ring of batches in sequence order */
+  raptor_ntriples_batch* batches;
+  int batches_count;
+
+  pthread_mutex_t lock;
+  pthread_cond_t batch_queued;
+  pthread_cond_t batch_done;
+  int stop;
+
+  /* sequence numbers of the batch being filled (= batches queued so
+   * far), the next batch to encode and the next batch to write.
+   * queued_seq is only changed by the serializing thread; it and
+   * take_seq are protected by lock.
+   */
+  unsigned long queued_seq;
+  unsigned long take_seq;
+  unsigned long write_seq;
+#endif
 } raptor_ntriples_serializer_context;
 
 
+#ifdef HAVE_PTHREAD
+static void raptor_ntriples_serialize_stop_threads(raptor_serializer* serializer);
+#endif
+
 
 /* create a new serializer */
 static int
@@ -67,7 +136,9 @@ raptor_ntriples_serialize_init(raptor_serializer* serializer, const char *name)
 static void
 raptor_ntriples_serialize_terminate(raptor_serializer* serializer)
 {
-
+#ifdef HAVE_PTHREAD
+  raptor_ntriples_serialize_stop_threads(serializer);
+#endif
 }
   
 
@@ -82,17 +153,6 @@ raptor_ntriples_serialize_declare_namespace(raptor_serializer* serializer,
 }
 
 
-#if 0
-/* start a serialize */
-static int
-raptor_ntriples_serialize_start(raptor_serializer* serializer)
-{
-  return 0;
-}
-#endif
-
-
-
 /**
  * raptor_string_ntriples_write:
  * @string: UTF-8 string to write
@@ -213,6 +273,402 @@ raptor_statement_ntriples_write(const raptor_statement *statement,
 }
 
 
+/* Keep the escaped forms of URIs in @term written more than once, or
+ * straight away if @now is set */
+static void
+raptor_ntriples_term_cache_uris(raptor_term* term, int now)
+{
+  if(!term)
+    return;
+
+  if(term->type == RAPTOR_TERM_TYPE_URI)
+    raptor_uri_escaped_cache_add(term->value.uri, now);
+  else if(term->type == RAPTOR_TERM_TYPE_LITERAL &&
+          term->value.literal.datatype)
+    raptor_uri_escaped_cache_add(term->value.literal.datatype, now);
+}
+
+
+#ifdef HAVE_PTHREAD
+/* Local handlers for writing to the buffer of the batch being encoded */
+
+static int
+raptor_ntriples_encoder_write_bytes(void *user_data, const void *ptr,
+                                    size_t size, size_t nmemb)
+{
+  raptor_ntriples_encoder* encoder = (raptor_ntriples_encoder*)user_data;
+  raptor_ntriples_batch* batch = encoder->batch;
+  size_t len = size * nmemb;
+
+  if(batch->failed)
+    return 0;
+
+  if(batch->length + len > batch->size) {
+    size_t new_size = batch->size ? batch->size : 65536;
+    unsigned char* new_buffer;
+
+    while(new_size < batch->length + len)
+      new_size <<= 1;
+    new_buffer = RAPTOR_REALLOC(unsigned char*, batch->buffer, new_size);
+    if(!new_buffer) {
+      batch->failed = 1;
+      return 0; /* failure */
+    }
+    batch->buffer = new_buffer;
+    batch->size = new_size;
+  }
+
+  memcpy(batch->buffer + batch->length, ptr, len);
+  batch->length += len;
+
+  return RAPTOR_BAD_CAST(int, len); /* success */
+}
+
+static int
+raptor_ntriples_encoder_write_byte(void *user_data, const int byte)
+{
+  unsigned char c = RAPTOR_GOOD_CAST(unsigned char, byte);
+
+  return !raptor_ntriples_encoder_write_bytes(user_data, &c, 1, 1);
+}
+
+static const raptor_iostream_handler raptor_ntriples_encoder_handler = {
+  /* .version     = */ 2,
+  /* .init        = */ NULL,
+  /* .finish      = */ NULL,
+  /* .write_byte  = */ raptor_ntriples_encoder_write_byte,
+  /* .write_bytes = */ raptor_ntriples_encoder_write_bytes,
+  /* .write_end   = */ NULL,
+  /* .read_bytes  = */ NULL,
+  /* .read_eof    = */ NULL
+};
+
+
+static void*
+raptor_ntriples_encoder_run(void* arg)
+{
+  raptor_ntriples_encoder* encoder = (raptor_ntriples_encoder*)arg;
+  raptor_ntriples_serializer_context* context = encoder->context;
+
+  pthread_mutex_lock(&context->lock);
+  while(1) {
+    raptor_ntriples_batch* batch;
+    raptor_statement statement;
+    int i;
+
+    while(context->take_seq == context->queued_seq && !context->stop)
+      pthread_cond_wait(&context->batch_queued, &context->lock);
+    if(context->take_seq == context->queued_seq)
+      break;
+    batch = &context->batches[context->take_seq % RAPTOR_GOOD_CAST(unsigned long, context->batches_count)];
+    context->take_seq++;
+    pthread_mutex_unlock(&context->lock);
+
+    encoder->batch = batch;
+    memset(&statement, 0, sizeof(statement));
+    for(i = 0; i < batch->count; i++) {
+      raptor_term** terms = &batch->terms[i * 4];
+
+      statement.subject = terms[0];
+      statement.predicate = terms[1];
+      statement.object = terms[2];
+      statement.graph = terms[3];
+      /* errors are ignored as for the sequential serializer */
+      raptor_statement_ntriples_write(&statement, encoder->iostream,
+                                      context->is_nquads);
+    }
+
+    pthread_mutex_lock(&context->lock);
+    batch->done = 1;
+    pthread_cond_signal(&context->batch_done);
+  }
+  pthread_mutex_unlock(&context->lock);
+
+  return NULL;
+}
+
+
+/* Release the statement terms of a batch and empty it */
+static void
+raptor_ntriples_batch_clear(raptor_ntriples_batch* batch)
+{
+  int i;
+
+  for(i = 0; i < batch->count * 4; i++) {
+    if(batch->terms[i]) {
+      raptor_free_term(batch->terms[i]);
+      batch->terms[i] = NULL;
+    }
+  }
+  batch->count = 0;
+  batch->length = 0;
+  batch->failed = 0;
+}
+
+
+/*
+ * raptor_ntriples_serialize_write_batches:
+ * @serializer: serializer
+ * @wait_all: non-0 to wait for all queued batches
+ *
+ * INTERNAL - Write encoded batches to the output in sequence order
+ *
+ * Without @wait_all, only waits for an encoding thread when the ring
+ * has no free batch left to fill.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_ntriples_serialize_write_batches(raptor_serializer* serializer,
+                                        int wait_all)
+{
+  raptor_ntriples_serializer_context* context;
+  unsigned long count;
+  int rc = 0;
+
+  context = (raptor_ntriples_serializer_context*)serializer->context;
+  count = RAPTOR_GOOD_CAST(unsigned long, context->batches_count);
+
+  while(context->write_seq != context->queued_seq) {
+    raptor_ntriples_batch* batch = &context->batches[context->write_seq % count];
+    int must_wait = wait_all || (context->queued_seq - context->write_seq >= count);
+
+    pthread_mutex_lock(&context->lock);
+    if(!batch->done && !must_wait) {
+      pthread_mutex_unlock(&context->lock);
+      break;
+    }
+    while(!batch->done)
+      pthread_cond_wait(&context->batch_done, &context->lock);
+    batch->done = 0;
+    pthread_mutex_unlock(&context->lock);
+
+    if(batch->failed) {
+      raptor_log_error(serializer->world, RAPTOR_LOG_LEVEL_FATAL, NULL,
+                       "Out of memory");
+      rc = 1;
+    } else if(batch->length)
+      raptor_iostream_write_bytes(batch->buffer, 1, batch->length,
+                                  serializer->iostream);
+
+    raptor_ntriples_batch_clear(batch);
+    context->write_seq++;
+  }
+
+  return rc;
+}
+
+
+/* Queue the batch being filled for encoding */
+static void
+raptor_ntriples_serialize_queue_batch(raptor_ntriples_serializer_context* context)
+{
+  pthread_mutex_lock(&context->lock);
+  context->queued_seq++;
+  pthread_cond_signal(&context->batch_queued);
+  pthread_mutex_unlock(&context->lock);
+}
+
+
+/* Queue any partly filled batch and write everything queued */
+static int
+raptor_ntriples_serialize_drain(raptor_serializer* serializer)
+{
+  raptor_ntriples_serializer_context* context;
+  raptor_ntriples_batch* batch;
+
+  context = (raptor_ntriples_serializer_context*)serializer->context;
+  batch = &context->batches[context->queued_seq % RAPTOR_GOOD_CAST(unsigned long, context->batches_count)];
+  if(batch->count)
+    raptor_ntriples_serialize_queue_batch(context);
+
+  return raptor_ntriples_serialize_write_batches(serializer, 1);
+}
+
+
+static int
+raptor_ntriples_term_is_known(raptor_term* term)
+{
+  if(!term)
+    return 1;
+
+  return (term->type == RAPTOR_TERM_TYPE_URI ||
+          term->type == RAPTOR_TERM_TYPE_LITERAL ||
+          term->type == RAPTOR_TERM_TYPE_BLANK);
+}
+
+
+/*
+ * raptor_ntriples_serialize_stop_threads:
+ * @serializer: serializer
+ *
+ * INTERNAL - Stop the encoding threads and free the batches
+ *
+ * Statements not yet written are discarded; use
+ * raptor_ntriples_serialize_drain() first to write them.
+ */
+static void
+raptor_ntriples_serialize_stop_threads(raptor_serializer* serializer)
+{
+  raptor_ntriples_serializer_context* context;
+  int i;
+
+  context = (raptor_ntriples_serializer_context*)serializer->context;
+  if(!context->threads_count)
+    return;
+
+  pthread_mutex_lock(&context->lock);
+  context->stop = 1;
+  pthread_cond_broadcast(&context->batch_queued);
+  pthread_mutex_unlock(&context->lock);
+
+  for(i = 0; i < context->threads_count; i++) {
+    pthread_join(context->encoders[i].thread, NULL);
+    raptor_free_iostream(context->encoders[i].iostream);
+  }
+  RAPTOR_FREE(raptor_ntriples_encoder*, context->encoders);
+  context->encoders = NULL;
+  context->threads_count = 0;
+
+  pthread_cond_destroy(&context->batch_done);
+  pthread_cond_destroy(&context->batch_queued);
+  pthread_mutex_destroy(&context->lock);
+
+  for(i = 0; i < context->batches_count; i++) {
+    raptor_ntriples_batch_clear(&context->batches[i]);
+    if(context->batches[i].buffer)
+      RAPTOR_FREE(char*, context->batches[i].buffer);
+  }
+  RAPTOR_FREE(raptor_ntriples_batch*, context->batches);
+  context->batches = NULL;
+  context->batches_count = 0;
+}
+
+
+/*
+ * raptor_ntriples_serialize_start_threads:
+ * @serializer: serializer
+ * @threads_count: number of encoding threads
+ *
+ * INTERNAL - Start threads to format statements in batches
+ *
+ * On failure statements are formatted on the calling thread.
+ */
+static void
+raptor_ntriples_serialize_start_threads(raptor_serializer* serializer,
+                                        int threads_count)
+{
+  raptor_ntriples_serializer_context* context;
+  int i;
+
+  context = (raptor_ntriples_serializer_context*)serializer->context;
+
+  /* two batches per thread so each can be encoded while another is
+   * waiting to be written, plus the one being filled
+   */
+  context->batches_count = (threads_count * 2) + 1;
+  context->batches = RAPTOR_CALLOC(raptor_ntriples_batch*,
+                                   RAPTOR_GOOD_CAST(size_t, context->batches_count),
+                                   sizeof(raptor_ntriples_batch));
+  context->encoders = RAPTOR_CALLOC(raptor_ntriples_encoder*,
+                                    RAPTOR_GOOD_CAST(size_t, threads_count),
+                                    sizeof(raptor_ntriples_encoder));
+  if(!context->batches || !context->encoders)
+    goto failed;
+
+  for(i = 0; i < threads_count; i++) {
+    context->encoders[i].context = context;
+    context->encoders[i].iostream =
+      raptor_new_iostream_from_handler(serializer->world, &context->encoders[i],
+                                       &raptor_ntriples_encoder_handler);
+    if(!context->encoders[i].iostream)
+      goto failed;
+  }
+
+  context->stop = 0;
+  context->queued_seq = 0;
+  context->take_seq = 0;
+  context->write_seq = 0;
+
+  if(pthread_mutex_init(&context->lock, NULL))
+    goto failed;
+  if(pthread_cond_init(&context->batch_queued, NULL)) {
+    pthread_mutex_destroy(&context->lock);
+    goto failed;
+  }
+  if(pthread_cond_init(&context->batch_done, NULL)) {
+    pthread_cond_destroy(&context->batch_queued);
+    pthread_mutex_destroy(&context->lock);
+    goto failed;
+  }
+
+  for(i = 0; i < threads_count; i++) {
+    if(pthread_create(&context->encoders[i].thread, NULL,
+                      raptor_ntriples_encoder_run, &context->encoders[i])) {
+      /* free the iostreams of the encoders that never started */
+      int j;
+
+      for(j = i; j < threads_count; j++)
+        raptor_free_iostream(context->encoders[j].iostream);
+      context->threads_count = i;
+      if(i)
+        raptor_ntriples_serialize_stop_threads(serializer);
+      else {
+        pthread_cond_destroy(&context->batch_done);
+        pthread_cond_destroy(&context->batch_queued);
+        pthread_mutex_destroy(&context->lock);
+        RAPTOR_FREE(raptor_ntriples_encoder*, context->encoders);
+        RAPTOR_FREE(raptor_ntriples_batch*, context->batches);
+        context->encoders = NULL;
+        context->batches = NULL;
+        context->batches_count = 0;
+      }
+      return;
+    }
+  }
+
+  context->threads_count = threads_count;
+  return;
+
+  failed:
+  if(context->encoders) {
+    for(i = 0; i < threads_count; i++) {
+      if(context->encoders[i].iostream)
+        raptor_free_iostream(context->encoders[i].iostream);
+    }
+    RAPTOR_FREE(raptor_ntriples_encoder*, context->encoders);
+    context->encoders = NULL;
+  }
+  if(context->batches) {
+    RAPTOR_FREE(raptor_ntriples_batch*, context->batches);
+    context->batches = NULL;
+  }
+  context->batches_count = 0;
+}
+#endif
+
+
+/* start a serialize */
+static int
+raptor_ntriples_serialize_start(raptor_serializer* serializer)
+{
+#ifdef HAVE_PTHREAD
+  int threads_count;
+
+  raptor_ntriples_serialize_stop_threads(serializer);
+
+  threads_count = RAPTOR_OPTIONS_GET_NUMERIC(serializer,
+                                             RAPTOR_OPTION_WRITE_THREADS);
+  if(threads_count > RAPTOR_NTRIPLES_MAX_THREADS)
+    threads_count = RAPTOR_NTRIPLES_MAX_THREADS;
+  if(threads_count > 0)
+    raptor_ntriples_serialize_start_threads(serializer, threads_count);
+#endif
+
+  return 0;
+}
+
+
 /* serialize a statement */
 static int
 raptor_ntriples_serialize_statement(raptor_serializer* serializer, 
@@ -222,6 +678,56 @@ raptor_ntriples_serialize_statement(raptor_serializer* serializer,
 
   ntriples_serializer = (raptor_ntriples_serializer_context*)serializer->context;
 
+#ifdef HAVE_PTHREAD
+  if(ntriples_serializer->threads_count) {
+    raptor_ntriples_batch* batch;
+    raptor_term** terms;
+    unsigned long count;
+
+    if(!raptor_ntriples_term_is_known(statement->subject) ||
+       !raptor_ntriples_term_is_known(statement->predicate) ||
+       !raptor_ntriples_term_is_known(statement->object) ||
+       (ntriples_serializer->is_nquads &&
+        !raptor_ntriples_term_is_known(statement->graph))) {
+      /* report the error on this thread, after the statements before it */
+      if(raptor_ntriples_serialize_drain(serializer))
+        return 1;
+      goto sequential;
+    }
+
+    /* settle the escaped forms here so that encoding threads only
+     * ever read them */
+    raptor_ntriples_term_cache_uris(statement->subject, 1);
+    raptor_ntriples_term_cache_uris(statement->predicate, 1);
+    raptor_ntriples_term_cache_uris(statement->object, 1);
+    if(ntriples_serializer->is_nquads)
+      raptor_ntriples_term_cache_uris(statement->graph, 1);
+
+    count = RAPTOR_GOOD_CAST(unsigned long, ntriples_serializer->batches_count);
+    batch = &ntriples_serializer->batches[ntriples_serializer->queued_seq % count];
+    terms = &batch->terms[batch->count * 4];
+    terms[0] = statement->subject ? raptor_term_copy(statement->subject) : NULL;
+    terms[1] = statement->predicate ? raptor_term_copy(statement->predicate) : NULL;
+    terms[2] = statement->object ? raptor_term_copy(statement->object) : NULL;
+    terms[3] = (ntriples_serializer->is_nquads && statement->graph) ?
+               raptor_term_copy(statement->graph) : NULL;
+    batch->count++;
+
+    if(batch->count < RAPTOR_NTRIPLES_BATCH_SIZE)
+      return 0;
+
+    raptor_ntriples_serialize_queue_batch(ntriples_serializer);
+    return raptor_ntriples_serialize_write_batches(serializer, 0);
+  }
+
+  sequential:
+#endif
+  raptor_ntriples_term_cache_uris(statement->subject, 0);
+  raptor_ntriples_term_cache_uris(statement->predicate, 0);
+  raptor_ntriples_term_cache_uris(statement->object, 0);
+  if(ntriples_serializer->is_nquads)
+    raptor_ntriples_term_cache_uris(statement->graph, 0);
+
   raptor_statement_ntriples_write(statement,
                                   serializer->iostream,
                                   ntriples_serializer->is_nquads);
@@ -229,14 +735,41 @@ raptor_ntriples_serialize_statement(raptor_serializer* serializer,
 }
 
 
-#if 0
 /* end a serialize */
 static int
 raptor_ntriples_serialize_end(raptor_serializer* serializer)
 {
-  return 0;
+  int rc = 0;
+#ifdef HAVE_PTHREAD
+  raptor_ntriples_serializer_context* ntriples_serializer;
+
+  ntriples_serializer = (raptor_ntriples_serializer_context*)serializer->context;
+  if(ntriples_serializer->threads_count) {
+    rc = raptor_ntriples_serialize_drain(serializer);
+    raptor_ntriples_serialize_stop_threads(serializer);
+  }
+#endif
+
+  return rc;
 }
+
+
+/* flush serializer output */
+static int
+raptor_ntriples_serialize_flush(raptor_serializer* serializer)
+{
+  int rc = 0;
+#ifdef HAVE_PTHREAD
+  raptor_ntriples_serializer_context* ntriples_serializer;
+
+  ntriples_serializer = (raptor_ntriples_serializer_context*)serializer->context;
+  if(ntriples_serializer->threads_count)
+    rc = raptor_ntriples_serialize_drain(serializer);
 #endif
+
+  return rc;
+}
+
   
 /* finish the serializer factory */
 static void
@@ -276,10 +809,11 @@ raptor_ntriples_serializer_register_factory(raptor_serializer_factory *factory)
   factory->init                = raptor_ntriples_serialize_init;
   factory->terminate           = raptor_ntriples_serialize_terminate;
   factory->declare_namespace   = raptor_ntriples_serialize_declare_namespace;
-  factory->serialize_start     = NULL;
+  factory->serialize_start     = raptor_ntriples_serialize_start;
   factory->serialize_statement = raptor_ntriples_serialize_statement;
-  factory->serialize_end       = NULL;
+  factory->serialize_end       = raptor_ntriples_serialize_end;
   factory->finish_factory      = raptor_ntriples_serialize_finish_factory;
+  factory->serialize_flush     = raptor_ntriples_serialize_flush;
 
   return 0;
 }
@@ -314,10 +848,11 @@ raptor_nquads_serializer_register_factory(raptor_serializer_factory *factory)
   factory->init                = raptor_ntriples_serialize_init;
   factory->terminate           = raptor_ntriples_serialize_terminate;
   factory->declare_namespace   = raptor_ntriples_serialize_declare_namespace;
-  factory->serialize_start     = NULL;
+  factory->serialize_start     = raptor_ntriples_serialize_start;
   factory->serialize_statement = raptor_ntriples_serialize_statement;
-  factory->serialize_end       = NULL;
+  factory->serialize_end       = raptor_ntriples_serialize_end;
   factory->finish_factory      = raptor_ntriples_serialize_finish_factory;
+  factory->serialize_flush     = raptor_ntriples_serialize_flush;
 
   return 0;
 }
@@ -340,3 +875,275 @@ raptor_init_serializer_nquads(raptor_world* world)
                                              &raptor_nquads_serializer_register_factory);
 }
 #endif
+
+#endif
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+static const char *program;
+
+#define TEST_STATEMENTS_COUNT 5000
+
+
+static raptor_statement*
+test_make_statement(raptor_world* world, int i)
+{
+  raptor_statement* statement;
+  char buffer[80];
+  char label[80];
+  raptor_uri* datatype;
+
+  statement = raptor_new_statement(world);
+  if(!statement)
+    return NULL;
+
+  if(i % 4 == 1) {
+    sprintf(buffer, "b%d", i % 50);
+    statement->subject = raptor_new_term_from_blank(world,
+                                                    (const unsigned char*)buffer);
+  } else {
+    sprintf(buffer, "http://example.org/s%d", i / 3);
+    statement->subject = raptor_new_term_from_uri_string(world,
+                                                         (const unsigned char*)buffer);
+  }
+
+  sprintf(buffer, "http://example.org/p%d", i % 7);
+  statement->predicate = raptor_new_term_from_uri_string(world,
+                                                         (const unsigned char*)buffer);
+
+  sprintf(label, "line %d\nbreak \"quoted\" caf\xc3\xa9 \x01", i);
+  switch(i % 5) {
+    case 0:
+      statement->object = raptor_new_term_from_literal(world,
+                                                       (const unsigned char*)label,
+                                                       NULL, NULL);
+      break;
+    case 1:
+      statement->object = raptor_new_term_from_literal(world,
+                                                       (const unsigned char*)label,
+                                                       NULL,
+                                                       (const unsigned char*)"en-GB");
+      break;
+    case 2:
+      sprintf(buffer, "%d", i);
+      datatype = raptor_new_uri(world,
+                                (const unsigned char*)"http://www.w3.org/2001/XMLSchema#integer");
+      statement->object = raptor_new_term_from_literal(world,
+                                                       (const unsigned char*)buffer,
+                                                       datatype, NULL);
+      raptor_free_uri(datatype);
+      break;
+    case 3:
+      sprintf(buffer, "b%d", i % 11);
+      statement->object = raptor_new_term_from_blank(world,
+                                                     (const unsigned char*)buffer);
+      break;
+    default:
+      sprintf(buffer, "http://example.org/o%d?q=<%d>", i, i);
+      statement->object = raptor_new_term_from_uri_string(world,
+                                                          (const unsigned char*)buffer);
+      break;
+  }
+
+  if(i % 3) {
+    sprintf(buffer, "http://example.org/g%d", i % 3);
+    statement->graph = raptor_new_term_from_uri_string(world,
+                                                       (const unsigned char*)buffer);
+  }
+
+  return statement;
+}
+
+
+static int
+test_stringbuffer_write_bytes(void *user_data, const void *ptr,
+                              size_t size, size_t nmemb)
+{
+  raptor_stringbuffer* sb = (raptor_stringbuffer*)user_data;
+
+  if(raptor_stringbuffer_append_counted_string(sb, (const unsigned char*)ptr,
+                                               size * nmemb, 1))
+    return 0;
+  return RAPTOR_BAD_CAST(int, size * nmemb);
+}
+
+static int
+test_stringbuffer_write_byte(void *user_data, const int byte)
+{
+  unsigned char c = RAPTOR_GOOD_CAST(unsigned char, byte);
+
+  return !test_stringbuffer_write_bytes(user_data, &c, 1, 1);
+}
+
+static const raptor_iostream_handler test_stringbuffer_handler = {
+  /* .version     = */ 2,
+  /* .init        = */ NULL,
+  /* .finish      = */ NULL,
+  /* .write_byte  = */ test_stringbuffer_write_byte,
+  /* .write_bytes = */ test_stringbuffer_write_bytes,
+  /* .write_end   = */ NULL,
+  /* .read_bytes  = */ NULL,
+  /* .read_eof    = */ NULL
+};
+
+
+/*
+ * Serialize the first @count of @statements with @serializer_name
+ * using @threads_count encoding threads into @sb.  If @flush_at is
+ * >0, flush after that many statements and store the output length
+ * at that point in @flush_len_p.
+ */
+static int
+test_serialize(raptor_world* world, const char* serializer_name,
+               int threads_count, raptor_statement** statements, int count,
+               int flush_at, size_t* flush_len_p, raptor_stringbuffer* sb)
+{
+  raptor_serializer* serializer;
+  raptor_iostream* iostr;
+  int i;
+  int rc = 0;
+
+  serializer = raptor_new_serializer(world, serializer_name);
+  iostr = raptor_new_iostream_from_handler(world, sb,
+                                           &test_stringbuffer_handler);
+  if(!serializer || !iostr) {
+    fprintf(stderr, "%s: Failed to create %s serializer\n", program,
+            serializer_name);
+    rc = 1;
+    goto tidy;
+  }
+
+  raptor_serializer_set_option(serializer, RAPTOR_OPTION_WRITE_THREADS, NULL,
+                               threads_count);
+  raptor_serializer_start_to_iostream(serializer, NULL, iostr);
+  for(i = 0; i < count; i++) {
+    if(raptor_serializer_serialize_statement(serializer, statements[i]))
+      rc = 1;
+    if(flush_at && i + 1 == flush_at) {
+      if(raptor_serializer_flush(serializer))
+        rc = 1;
+      *flush_len_p = raptor_stringbuffer_length(sb);
+    }
+  }
+  if(raptor_serializer_serialize_end(serializer))
+    rc = 1;
+
+  tidy:
+  if(serializer)
+    raptor_free_serializer(serializer);
+  if(iostr)
+    raptor_free_iostream(iostr);
+
+  return rc;
+}
+
+
+static int
+test_compare(raptor_world* world, const char* serializer_name,
+             int threads_count, raptor_statement** statements)
+{
+  raptor_stringbuffer* expected;
+  raptor_stringbuffer* prefix;
+  raptor_stringbuffer* sb;
+  int flush_at = TEST_STATEMENTS_COUNT / 3;
+  size_t flush_len = 0;
+  int failures = 0;
+
+  expected = raptor_new_stringbuffer();
+  prefix = raptor_new_stringbuffer();
+  sb = raptor_new_stringbuffer();
+  if(!expected || !prefix || !sb) {
+    failures++;
+    goto tidy;
+  }
+
+  if(test_serialize(world, serializer_name, 0, statements,
+                    TEST_STATEMENTS_COUNT, 0, NULL, expected) ||
+     test_serialize(world, serializer_name, 0, statements,
+                    flush_at, 0, NULL, prefix) ||
+     test_serialize(world, serializer_name, threads_count, statements,
+                    TEST_STATEMENTS_COUNT, flush_at, &flush_len, sb)) {
+    fprintf(stderr, "%s: %s serializing with %d threads failed\n", program,
+            serializer_name, threads_count);
+    failures++;
+    goto tidy;
+  }
+
+  if(raptor_stringbuffer_length(sb) != raptor_stringbuffer_length(expected) ||
+     memcmp(raptor_stringbuffer_as_string(sb),
+            raptor_stringbuffer_as_string(expected),
+            raptor_stringbuffer_length(sb))) {
+    fprintf(stderr,
+            "%s: %s output with %d threads differs from sequential output\n",
+            program, serializer_name, threads_count);
+    failures++;
+  }
+
+  if(flush_len != raptor_stringbuffer_length(prefix)) {
+    fprintf(stderr,
+            "%s: %s flush with %d threads wrote %d bytes, expected %d\n",
+            program, serializer_name, threads_count, (int)flush_len,
+            (int)raptor_stringbuffer_length(prefix));
+    failures++;
+  }
+
+  tidy:
+  if(expected)
+    raptor_free_stringbuffer(expected);
+  if(prefix)
+    raptor_free_stringbuffer(prefix);
+  if(sb)
+    raptor_free_stringbuffer(sb);
+
+  return failures;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+  raptor_world *world;
+  raptor_statement** statements;
+  int i;
+  int failures = 0;
+
+  program = raptor_basename(argv[0]);
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  statements = RAPTOR_CALLOC(raptor_statement**, TEST_STATEMENTS_COUNT,
+                             sizeof(raptor_statement*));
+  if(!statements)
+    exit(1);
+  for(i = 0; i < TEST_STATEMENTS_COUNT; i++) {
+    statements[i] = test_make_statement(world, i);
+    if(!statements[i])
+      exit(1);
+  }
+
+#ifdef RAPTOR_SERIALIZER_NTRIPLES
+  failures += test_compare(world, "ntriples", 1, statements);
+#endif
+#ifdef RAPTOR_SERIALIZER_NQUADS
+  failures += test_compare(world, "nquads", 1, statements);
+  failures += test_compare(world, "nquads", 3, statements);
+#endif
+
+  for(i = 0; i < TEST_STATEMENTS_COUNT; i++)
+    raptor_free_statement(statements[i]);
+  RAPTOR_FREE(raptor_statement**, statements);
+
+  raptor_free_world(world);
+
+  return failures;
+}
+
+#endif
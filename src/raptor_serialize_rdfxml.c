@@ -437,8 +437,8 @@ raptor_rdfxml_serialize_statement(raptor_serializer* serializer,
     case RAPTOR_TERM_TYPE_URI:
       allocated = 1;
       if(RAPTOR_OPTIONS_GET_NUMERIC(serializer, RAPTOR_OPTION_RELATIVE_URIS)) {
-        subject_uri_string = raptor_uri_to_relative_uri_string(serializer->base_uri,
-                                                               statement->subject->value.uri);
+        subject_uri_string = raptor_serializer_uri_to_relative_string(serializer,
+                                                                     statement->subject->value.uri);
         if(!subject_uri_string)
           goto oom;
       } else {
@@ -572,8 +572,8 @@ raptor_rdfxml_serialize_statement(raptor_serializer* serializer,
     case RAPTOR_TERM_TYPE_URI:
       /* must be URI */
       if(RAPTOR_OPTIONS_GET_NUMERIC(serializer, RAPTOR_OPTION_RELATIVE_URIS)) {
-        object_uri_string = raptor_uri_to_relative_uri_string(serializer->base_uri,
-                                                              statement->object->value.uri);
+        object_uri_string = raptor_serializer_uri_to_relative_string(serializer,
+                                                                    statement->object->value.uri);
       } else {
         object_uri_string = raptor_uri_to_string(statement->object->value.uri);
       }
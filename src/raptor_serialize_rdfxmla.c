@@ -166,7 +166,7 @@ raptor_rdfxmla_emit_resource_uri(raptor_serializer *serializer,
 
   if(RAPTOR_OPTIONS_GET_NUMERIC(serializer, RAPTOR_OPTION_RELATIVE_URIS))
     /* newly allocated string */
-    attr_value = raptor_uri_to_relative_uri_string(serializer->base_uri, uri);
+    attr_value = raptor_serializer_uri_to_relative_string(serializer, uri);
   else
     attr_value = raptor_uri_as_string(uri);
 
@@ -706,8 +706,8 @@ raptor_rdfxmla_emit_subject(raptor_serializer *serializer,
       attr_value = RAPTOR_CALLOC(unsigned char*, 1, sizeof(unsigned char));
     } else if(RAPTOR_OPTIONS_GET_NUMERIC(serializer,
                                          RAPTOR_OPTION_RELATIVE_URIS))
-      attr_value = raptor_uri_to_relative_uri_string(serializer->base_uri,
-                                                     subject_term->value.uri);
+      attr_value = raptor_serializer_uri_to_relative_string(serializer,
+                                                            subject_term->value.uri);
     else
       attr_value = raptor_uri_to_string(subject_term->value.uri);
     
@@ -50,31 +50,66 @@
  *  Destroy Set
  *  Check a (base, ID) pair present add it if not, return if added/not
  *
+ * The set is a single open addressing hash table keyed by (base URI
+ * index, ID).  Base URIs are kept once each in a small array and the
+ * ID strings are copied into large arena blocks that are only freed
+ * with the set, so adding an ID costs no per-item allocation.  Each
+ * table entry keeps the full hash value so that probes that do not
+ * match are rejected without touching the ID string.
  */
 
-struct raptor_base_id_set_s
+/* initial number of hash table entries - must be a power of 2 */
+#define RAPTOR_ID_SET_INITIAL_SIZE 256
+
+/* size of the arena blocks that ID strings are copied into */
+#define RAPTOR_ID_SET_BLOCK_SIZE 16384
+
+
+typedef struct
 {
-  raptor_world* world;
+  /* ID string stored in an arena block or NULL if the entry is empty */
+  const unsigned char *id;
+  size_t id_len;
 
-  /* The base URI of this set of IDs */
-  raptor_uri *uri;
-  
-  /* neighbour ID sets */
-  struct raptor_base_id_set_s* prev;
-  struct raptor_base_id_set_s* next;
+  /* full hash of (base, id) */
+  unsigned int hash;
 
-  /* binary tree */
-  raptor_avltree* tree;
-};
-typedef struct raptor_base_id_set_s raptor_base_id_set;
+  /* index into raptor_id_set bases array */
+  unsigned int base;
+} raptor_id_set_entry;
+
+
+typedef struct raptor_id_set_block_s
+{
+  struct raptor_id_set_block_s* next;
+
+  /* size of the data area following this header */
+  size_t size;
+
+  /* bytes used in the data area */
+  size_t used;
+} raptor_id_set_block;
 
 
 struct raptor_id_set_s
 {
   raptor_world* world;
 
-  /* start of trees, 1 per base URI */
-  struct raptor_base_id_set_s* first;
+  /* base URIs seen so far - an ID entry refers to one by index */
+  raptor_uri** bases;
+  unsigned int bases_count;
+  unsigned int bases_size;
+
+  /* index of the base URI used in the last add */
+  unsigned int last_base;
+
+  /* hash table of size (power of 2) entries, count in use */
+  raptor_id_set_entry* entries;
+  size_t size;
+  size_t count;
+
+  /* arena blocks holding the ID strings, most recent first */
+  raptor_id_set_block* blocks;
 
 #if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
   int hits;
@@ -102,25 +137,16 @@ raptor_new_id_set(raptor_world* world)
 
   set->world = world;
 
-  return set;
-}
-
+  set->entries = RAPTOR_CALLOC(raptor_id_set_entry*,
+                               RAPTOR_ID_SET_INITIAL_SIZE,
+                               sizeof(raptor_id_set_entry));
+  if(!set->entries) {
+    RAPTOR_FREE(raptor_id_set, set);
+    return NULL;
+  }
+  set->size = RAPTOR_ID_SET_INITIAL_SIZE;
 
-/**
- * raptor_free_base_id_set:
- * @set: #raptor_base_id_set
- *
- * INTERNAL - Destructor - Free a Base ID Set.
- *
- **/
-static void
-raptor_free_base_id_set(raptor_base_id_set *base) 
-{
-  if(base->tree)
-    raptor_free_avltree(base->tree);
-  if(base->uri)
-    raptor_free_uri(base->uri);
-  RAPTOR_FREE(raptor_base_id_set, base);
+  return set;
 }
 
 
@@ -134,20 +160,187 @@ raptor_free_base_id_set(raptor_base_id_set *base)
 void
 raptor_free_id_set(raptor_id_set *set) 
 {
-  raptor_base_id_set *base;
+  raptor_id_set_block *block;
+  unsigned int i;
 
   RAPTOR_ASSERT_OBJECT_POINTER_RETURN(set, raptor_id_set);
 
-  base = set->first;
-  while(base) {
-    raptor_base_id_set *next = base->next;
-    raptor_free_base_id_set(base);
-    base = next;
+  block = set->blocks;
+  while(block) {
+    raptor_id_set_block *next = block->next;
+    RAPTOR_FREE(raptor_id_set_block, block);
+    block = next;
   }
+
+  if(set->bases) {
+    for(i = 0; i < set->bases_count; i++)
+      raptor_free_uri(set->bases[i]);
+    RAPTOR_FREE(raptor_uri**, set->bases);
+  }
+
+  if(set->entries)
+    RAPTOR_FREE(raptor_id_set_entry*, set->entries);
+
   RAPTOR_FREE(raptor_id_set, set);
 }
 
 
+/*
+ * raptor_id_set_find_base:
+ * @set: #raptor_id_set
+ * @base_uri: base URI
+ *
+ * INTERNAL - Get the index of a base URI, adding it if not yet seen
+ *
+ * Return value: <0 on failure, otherwise the index
+ */
+static int
+raptor_id_set_find_base(raptor_id_set* set, raptor_uri *base_uri)
+{
+  unsigned int i;
+
+  /* Almost all IDs in a document share the same base */
+  if(set->bases_count &&
+     raptor_uri_equals(set->bases[set->last_base], base_uri))
+    return RAPTOR_GOOD_CAST(int, set->last_base);
+
+  for(i = 0; i < set->bases_count; i++) {
+    if(raptor_uri_equals(set->bases[i], base_uri)) {
+      set->last_base = i;
+      return RAPTOR_GOOD_CAST(int, i);
+    }
+  }
+
+  if(set->bases_count == set->bases_size) {
+    unsigned int new_size = set->bases_size ? (set->bases_size << 1) : 4;
+    raptor_uri** new_bases;
+
+    new_bases = RAPTOR_REALLOC(raptor_uri**, set->bases,
+                               new_size * sizeof(raptor_uri*));
+    if(!new_bases)
+      return -1;
+    set->bases = new_bases;
+    set->bases_size = new_size;
+  }
+
+  set->bases[set->bases_count] = raptor_uri_copy(base_uri);
+  set->last_base = set->bases_count++;
+
+  return RAPTOR_GOOD_CAST(int, set->last_base);
+}
+
+
+/*
+ * raptor_id_set_hash:
+ * @base: base URI index
+ * @id: identifier
+ * @id_len: length of identifier
+ *
+ * INTERNAL - Hash a (base, ID) pair
+ *
+ * Uses the DJ Bernstein hash as for namespace prefixes, then mixes
+ * the bits since the table index is taken from the low bits.
+ */
+static unsigned int
+raptor_id_set_hash(unsigned int base, const unsigned char *id, size_t id_len)
+{
+  unsigned int hash = 5381 + base;
+
+  while(id_len--)
+    hash = ((hash << 5) + hash) + *id++; /* hash * 33 + c */
+
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bU;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35U;
+  hash ^= hash >> 16;
+
+  return hash;
+}
+
+
+/*
+ * raptor_id_set_grow:
+ * @set: #raptor_id_set
+ *
+ * INTERNAL - Double the size of the hash table and rehash entries
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_id_set_grow(raptor_id_set* set)
+{
+  size_t new_size = set->size << 1;
+  size_t mask = new_size - 1;
+  raptor_id_set_entry* new_entries;
+  size_t i;
+
+  new_entries = RAPTOR_CALLOC(raptor_id_set_entry*, new_size,
+                              sizeof(raptor_id_set_entry));
+  if(!new_entries)
+    return 1;
+
+  for(i = 0; i < set->size; i++) {
+    raptor_id_set_entry* entry = &set->entries[i];
+    size_t j;
+
+    if(!entry->id)
+      continue;
+
+    for(j = entry->hash & mask; new_entries[j].id; j = (j + 1) & mask)
+      ;
+    new_entries[j] = *entry;
+  }
+
+  RAPTOR_FREE(raptor_id_set_entry*, set->entries);
+  set->entries = new_entries;
+  set->size = new_size;
+
+  return 0;
+}
+
+
+/*
+ * raptor_id_set_copy_id:
+ * @set: #raptor_id_set
+ * @id: identifier
+ * @id_len: length of identifier
+ *
+ * INTERNAL - Copy an ID string into the set's arena
+ *
+ * Return value: pointer to copy or NULL on failure
+ */
+static unsigned char*
+raptor_id_set_copy_id(raptor_id_set* set, const unsigned char *id,
+                      size_t id_len)
+{
+  raptor_id_set_block* block = set->blocks;
+  unsigned char* copy;
+
+  if(!block || block->size - block->used < id_len + 1) {
+    size_t size = RAPTOR_ID_SET_BLOCK_SIZE;
+
+    if(id_len + 1 > size)
+      size = id_len + 1;
+
+    block = (raptor_id_set_block*)RAPTOR_MALLOC(void*, sizeof(*block) + size);
+    if(!block)
+      return NULL;
+
+    block->size = size;
+    block->used = 0;
+    block->next = set->blocks;
+    set->blocks = block;
+  }
+
+  copy = (unsigned char*)(block + 1) + block->used;
+  memcpy(copy, id, id_len);
+  copy[id_len] = '\0';
+  block->used += id_len + 1;
+
+  return copy;
+}
+
 
 /**
  * raptor_id_set_add:
@@ -164,74 +357,56 @@ int
 raptor_id_set_add(raptor_id_set* set, raptor_uri *base_uri,
                   const unsigned char *id, size_t id_len)
 {
-  raptor_base_id_set *base;
-  char* item;
-  
+  raptor_id_set_entry* entry;
+  unsigned int base;
+  unsigned int hash;
+  size_t mask;
+  size_t i;
+  int rc;
+
   if(!base_uri || !id || !id_len)
     return -1;
 
-  base = set->first;
-  while(base) {
-    if(raptor_uri_equals(base->uri, base_uri))
-      break;
-    base = base->next;
-  }
+  rc = raptor_id_set_find_base(set, base_uri);
+  if(rc < 0)
+    return -1;
+  base = RAPTOR_GOOD_CAST(unsigned int, rc);
 
-  if(!base) {
-    /* a set for this base_uri not found */
-    base = RAPTOR_CALLOC(raptor_base_id_set*, 1, sizeof(*base));
-    if(!base)
+  /* keep the load factor at most 1/2 after this add */
+  if(((set->count + 1) << 1) > set->size) {
+    if(raptor_id_set_grow(set))
       return -1;
-
-    base->world = set->world;
-
-    base->uri = raptor_uri_copy(base_uri);
-
-    base->tree = raptor_new_avltree((raptor_data_compare_handler)strcmp,
-                                    free, 0);
-  
-    /* Add to the start of the list */
-    if(set->first)
-      set->first->prev = base;
-    /* base->prev = NULL; */
-    base->next = set->first;
-
-    set->first = base;
-  } else {
-    /* If not at the start of the list, move there */
-    if(base != set->first) {
-      /* remove from the list */
-      base->prev->next = base->next;
-      if(base->next)
-        base->next->prev = base->prev;
-      /* add at the start of the list */
-      set->first->prev = base;
-      base->prev = NULL;
-      base->next = set->first;
-    }
   }
-  
-  item = (char*)raptor_avltree_search(base->tree, id);
 
-  /* if already there, error */
-  if(item) {
+  hash = raptor_id_set_hash(base, id, id_len);
+  mask = set->size - 1;
+
+  for(i = hash & mask; set->entries[i].id; i = (i + 1) & mask) {
+    entry = &set->entries[i];
+    if(entry->hash == hash && entry->base == base &&
+       entry->id_len == id_len && !memcmp(entry->id, id, id_len)) {
+      /* if already there, error */
 #if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
-    set->misses++;
+      set->misses++;
 #endif
-    return 1;
+      return 1;
+    }
   }
-  
+
 #if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
   set->hits++;
 #endif
-  
-  item = RAPTOR_MALLOC(char*, id_len + 1);
-  if(!item)
-    return 1;
 
-  memcpy(item, id, id_len + 1);
+  entry = &set->entries[i];
+  entry->id = raptor_id_set_copy_id(set, id, id_len);
+  if(!entry->id)
+    return -1;
+  entry->id_len = id_len;
+  entry->hash = hash;
+  entry->base = base;
+  set->count++;
 
-  return raptor_avltree_add(base->tree, item);
+  return 0;
 }
 
 
@@ -251,6 +426,10 @@ raptor_id_set_stats_print(raptor_id_set* set, FILE *stream) {
 int main(int argc, char *argv[]);
 
 
+#define GENERATED_ITEMS_COUNT 10000
+#define LONG_ITEM_LEN 40000
+
+
 int
 main(int argc, char *argv[]) 
 {
@@ -259,6 +438,8 @@ main(int argc, char *argv[])
   const char *items[8] = { "ron", "amy", "jen", "bij", "jib", "daj", "jim", NULL };
   raptor_id_set *set;
   raptor_uri *base_uri;
+  raptor_uri *base_uri2;
+  unsigned char *long_item;
   int i = 0;
   
   world = raptor_new_world();
@@ -286,7 +467,7 @@ main(int argc, char *argv[])
 #endif
   
     rc = raptor_id_set_add(set, base_uri, (const unsigned char*)items[i], len);
-if(rc) {
+    if(rc) {
       fprintf(stderr, "%s: Adding set item %d '%s' failed, returning error %d\n",
               program, i, items[i], rc);
       exit(1);
@@ -309,6 +490,57 @@ if(rc) {
     }
   }
 
+  /* The same IDs with a different base URI are not duplicates */
+  base_uri2 = raptor_new_uri(world, (const unsigned char*)"http://example.org/base2#");
+  for(i = 0; items[i]; i++) {
+    size_t len = strlen(items[i]);
+    int rc;
+
+    rc = raptor_id_set_add(set, base_uri2, (const unsigned char*)items[i], len);
+    if(rc) {
+      fprintf(stderr, "%s: Adding set item %d '%s' with second base failed, returning error %d\n",
+              program, i, items[i], rc);
+      exit(1);
+    }
+  }
+
+#if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
+  fprintf(stderr, "%s: Adding %d generated set items\n", program,
+          GENERATED_ITEMS_COUNT);
+#endif
+
+  /* Enough items to grow the table several times; each is added
+   * twice and only the first add must succeed.
+   */
+  for(i = 0; i < GENERATED_ITEMS_COUNT * 2; i++) {
+    char buffer[20];
+    size_t len;
+    int rc;
+
+    len = RAPTOR_GOOD_CAST(size_t,
+                           sprintf(buffer, "id%d", i % GENERATED_ITEMS_COUNT));
+    rc = raptor_id_set_add(set, (i & 1) ? base_uri : base_uri2,
+                           (const unsigned char*)buffer, len);
+    if(rc != (i >= GENERATED_ITEMS_COUNT)) {
+      fprintf(stderr, "%s: Adding generated set item '%s' returned %d\n",
+              program, buffer, rc);
+      exit(1);
+    }
+  }
+
+  /* An ID longer than an arena block */
+  long_item = (unsigned char*)malloc(LONG_ITEM_LEN);
+  memset(long_item, 'x', LONG_ITEM_LEN);
+  for(i = 0; i < 2; i++) {
+    int rc = raptor_id_set_add(set, base_uri, long_item, LONG_ITEM_LEN);
+    if(rc != i) {
+      fprintf(stderr, "%s: Adding long set item returned %d, expected %d\n",
+              program, rc, i);
+      exit(1);
+    }
+  }
+  free(long_item);
+
 #if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
   raptor_id_set_stats_print(set, stderr);
 #endif
@@ -319,6 +551,7 @@ if(rc) {
   raptor_free_id_set(set);
 
   raptor_free_uri(base_uri);
+  raptor_free_uri(base_uri2);
   
   raptor_free_world(world);
   
@@ -44,27 +44,22 @@
 
 #ifndef STANDALONE
 
-struct raptor_stringbuffer_node_s
-{
-  struct raptor_stringbuffer_node_s* next;
-  unsigned char *string;
-  size_t length;
-};
-typedef struct raptor_stringbuffer_node_s raptor_stringbuffer_node;
+/* smallest buffer allocated when a stringbuffer first grows */
+#define RAPTOR_STRINGBUFFER_MIN_SIZE 64
 
 
 struct raptor_stringbuffer_s
 {
-  /* Pointing to the first item in the list of nodes */
-  raptor_stringbuffer_node* head;
-  /* and the last */
-  raptor_stringbuffer_node* tail;
-  
+  /* contiguous buffer of size bytes holding length bytes of string.
+   * When size > length, string[length] is kept as '\0'
+   */
+  unsigned char *string;
+
   /* total length of the string */
   size_t length;
 
-  /* frozen string if already calculated, or NULL if not present */
-  unsigned char *string;
+  /* allocated size of string buffer */
+  size_t size;
 };
 
 
@@ -104,19 +99,6 @@ raptor_free_stringbuffer(raptor_stringbuffer *stringbuffer)
   if(!stringbuffer)
     return;
 
-  if(stringbuffer->head) {
-    raptor_stringbuffer_node *node = stringbuffer->head;
-  
-    while(node) {
-      raptor_stringbuffer_node *next = node->next;
-      
-      if(node->string)
-        RAPTOR_FREE(char*, node->string);
-      RAPTOR_FREE(raptor_stringbuffer_node, node);
-      node = next;
-    }
-  }
-
   if(stringbuffer->string)
     RAPTOR_FREE(char*, stringbuffer->string);
 
@@ -124,6 +106,93 @@ raptor_free_stringbuffer(raptor_stringbuffer *stringbuffer)
 }
 
 
+/*
+ * raptor_stringbuffer_grow:
+ * @stringbuffer: raptor stringbuffer
+ * @size: minimum buffer size needed
+ *
+ * INTERNAL - Make the buffer at least @size bytes, growing geometrically
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_stringbuffer_grow(raptor_stringbuffer* stringbuffer, size_t size)
+{
+  unsigned char *string;
+  size_t new_size;
+
+  if(size <= stringbuffer->size)
+    return 0;
+
+  new_size = stringbuffer->size ? stringbuffer->size : RAPTOR_STRINGBUFFER_MIN_SIZE;
+  while(new_size < size) {
+    if(new_size > ((size_t)-1) / 2) {
+      new_size = size;
+      break;
+    }
+    new_size <<= 1;
+  }
+
+  string = RAPTOR_REALLOC(unsigned char*, stringbuffer->string, new_size);
+  if(!string)
+    return 1;
+
+  stringbuffer->string = string;
+  stringbuffer->size = new_size;
+
+  return 0;
+}
+
+
+/*
+ * raptor_stringbuffer_clear:
+ * @stringbuffer: raptor stringbuffer
+ *
+ * INTERNAL - Empty a stringbuffer keeping its storage for reuse
+ */
+void
+raptor_stringbuffer_clear(raptor_stringbuffer* stringbuffer)
+{
+  stringbuffer->length = 0;
+  if(stringbuffer->size)
+    stringbuffer->string[0] = '\0';
+}
+
+
+/**
+ * raptor_stringbuffer_reserve:
+ * @stringbuffer: raptor stringbuffer
+ * @length: expected total length of the string
+ *
+ * Pre-size a stringbuffer for a string of the given length.
+ *
+ * This is only a hint to avoid growing the buffer several times
+ * while appending; the stringbuffer still grows past @length if
+ * needed.
+ *
+ * Return value: non-0 on failure
+ **/
+int
+raptor_stringbuffer_reserve(raptor_stringbuffer* stringbuffer, size_t length)
+{
+  unsigned char *string;
+
+  /* room for the '\0' too */
+  if(length + 1 <= stringbuffer->size)
+    return 0;
+
+  /* exact size - the caller knows what is coming */
+  string = RAPTOR_REALLOC(unsigned char*, stringbuffer->string, length + 1);
+  if(!string)
+    return 1;
+
+  stringbuffer->string = string;
+  stringbuffer->size = length + 1;
+  stringbuffer->string[stringbuffer->length] = '\0';
+
+  return 0;
+}
+
 
 /**
  * raptor_stringbuffer_append_string_common:
@@ -150,43 +219,30 @@ raptor_stringbuffer_append_string_common(raptor_stringbuffer* stringbuffer,
                                          size_t length,
                                          int do_copy)
 {
-  raptor_stringbuffer_node *node;
-
   if(!string || !length)
     return 0;
-  
-  node = RAPTOR_MALLOC(raptor_stringbuffer_node*, sizeof(*node));
-  if(!node) {
+
+  if(!do_copy && !stringbuffer->size) {
+    /* empty: adopt the string as the buffer; it has no room for a
+     * '\0' so raptor_stringbuffer_as_string() will grow it */
+    stringbuffer->string = (unsigned char*)string;
+    stringbuffer->length = length;
+    stringbuffer->size = length;
+    return 0;
+  }
+
+  if(raptor_stringbuffer_grow(stringbuffer, stringbuffer->length + length + 1)) {
     if(!do_copy)
       RAPTOR_FREE(char*, string);
     return 1;
   }
 
-  if(do_copy) {
-    /* Note this copy does not include the \0 character - not needed  */
-    node->string = RAPTOR_MALLOC(unsigned char*, length);
-    if(!node->string) {
-      RAPTOR_FREE(raptor_stringbuffer_node, node);
-      return 1;
-    }
-    memcpy(node->string, string, length);
-  } else
-    node->string = (unsigned char*)string;
-  node->length = length;
-
-
-  if(stringbuffer->tail) {
-    stringbuffer->tail->next = node;
-    stringbuffer->tail = node;
-  } else
-    stringbuffer->head = stringbuffer->tail = node;
-  node->next = NULL;
-
-  if(stringbuffer->string) {
-    RAPTOR_FREE(char*, stringbuffer->string);
-    stringbuffer->string = NULL;
-  }
+  memcpy(stringbuffer->string + stringbuffer->length, string, length);
   stringbuffer->length += length;
+  stringbuffer->string[stringbuffer->length] = '\0';
+
+  if(!do_copy)
+    RAPTOR_FREE(char*, string);
 
   return 0;
 }
@@ -308,33 +364,30 @@ int
 raptor_stringbuffer_append_stringbuffer(raptor_stringbuffer* stringbuffer, 
                                         raptor_stringbuffer* append)
 {
-  raptor_stringbuffer_node *node = append->head;
-
-  if(!node)
+  if(!append->length)
     return 0;
 
-  /* move all append nodes to stringbuffer */
-  if(stringbuffer->tail) {
-    stringbuffer->tail->next = node;
-  } else
-    stringbuffer->head = node;
+  if(!stringbuffer->length) {
+    /* take over the buffer of append */
+    unsigned char *string = stringbuffer->string;
+    size_t size = stringbuffer->size;
 
-  stringbuffer->tail = append->tail;
+    stringbuffer->string = append->string;
+    stringbuffer->length = append->length;
+    stringbuffer->size = append->size;
 
-  /* adjust our length */
-  stringbuffer->length += append->length;
-  if(stringbuffer->string) {
-    RAPTOR_FREE(char*, stringbuffer->string);
-    stringbuffer->string = NULL;
+    append->string = string;
+    append->size = size;
+  } else {
+    if(raptor_stringbuffer_append_string_common(stringbuffer, append->string,
+                                                append->length, 1))
+      return 1;
   }
 
   /* zap append content */
-  append->head = append->tail = NULL;
   append->length = 0;
-  if(append->string) {
-    RAPTOR_FREE(char*, append->string);
-    append->string = NULL;
-  }
+  if(append->size)
+    append->string[0] = '\0';
   
   return 0;
 }
@@ -364,36 +417,26 @@ raptor_stringbuffer_prepend_string_common(raptor_stringbuffer* stringbuffer,
                                           const unsigned char *string, size_t length,
                                           int do_copy)
 {
-  raptor_stringbuffer_node *node;
+  if(!length) {
+    if(!do_copy && string)
+      RAPTOR_FREE(char*, string);
+    return 0;
+  }
 
-  node = RAPTOR_MALLOC(raptor_stringbuffer_node*, sizeof(*node));
-  if(!node)
+  if(raptor_stringbuffer_grow(stringbuffer, stringbuffer->length + length + 1)) {
+    if(!do_copy)
+      RAPTOR_FREE(char*, string);
     return 1;
-
-  if(do_copy) {
-    /* Note this copy does not include the \0 character - not needed  */
-    node->string = RAPTOR_MALLOC(unsigned char*, length);
-    if(!node->string) {
-      RAPTOR_FREE(raptor_stringbuffer_node, node);
-      return 1;
-    }
-    memcpy(node->string, string, length);
-  } else
-    node->string = (unsigned char*)string;
-  node->length = length;
-
-
-  node->next = stringbuffer->head;
-  if(stringbuffer->head)
-    stringbuffer->head = node;
-  else
-    stringbuffer->head = stringbuffer->tail = node;
-
-  if(stringbuffer->string) {
-    RAPTOR_FREE(char*, stringbuffer->string);
-    stringbuffer->string = NULL;
   }
+
+  memmove(stringbuffer->string + length, stringbuffer->string,
+          stringbuffer->length);
+  memcpy(stringbuffer->string, string, length);
   stringbuffer->length += length;
+  stringbuffer->string[stringbuffer->length] = '\0';
+
+  if(!do_copy)
+    RAPTOR_FREE(char*, string);
 
   return 0;
 }
@@ -470,7 +513,8 @@ raptor_stringbuffer_length(raptor_stringbuffer* stringbuffer)
  * Return the stringbuffer as a C string.
  * 
  * Note: the return value is a to a shared string that the stringbuffer
- * allocates and manages.
+ * allocates and manages.  It is only valid until the stringbuffer
+ * is next changed.
  *
  * Return value: NULL on failure or stringbuffer is empty, otherwise
  *   a pointer to a shared copy of the string.
@@ -478,30 +522,55 @@ raptor_stringbuffer_length(raptor_stringbuffer* stringbuffer)
 unsigned char *
 raptor_stringbuffer_as_string(raptor_stringbuffer* stringbuffer)
 {
-  raptor_stringbuffer_node *node;
-  unsigned char *p;
-  
   if(!stringbuffer->length)
     return NULL;
-  if(stringbuffer->string)
-    return stringbuffer->string;
-
-  stringbuffer->string = RAPTOR_MALLOC(unsigned char*, stringbuffer->length + 1);
-  if(!stringbuffer->string)
-    return NULL;
 
-  node = stringbuffer->head;
-  p = stringbuffer->string;
-  while(node) {
-    memcpy(p, node->string, node->length);
-    p+= node->length;
-    node = node->next;
+  /* only an adopted string has no room for the '\0' */
+  if(stringbuffer->length == stringbuffer->size) {
+    if(raptor_stringbuffer_grow(stringbuffer, stringbuffer->length + 1))
+      return NULL;
+    stringbuffer->string[stringbuffer->length] = '\0';
   }
-  *p='\0';
+
   return stringbuffer->string;
 }
 
 
+/**
+ * raptor_stringbuffer_as_string_detach:
+ * @stringbuffer: raptor stringbuffer
+ * @length_p: pointer to store length of string (or NULL)
+ *
+ * Take the string out of the stringbuffer without copying it.
+ *
+ * The stringbuffer is left empty and can be reused.  The returned
+ * string is owned by the caller and must be freed with
+ * raptor_free_memory().
+ *
+ * Return value: NULL on failure or stringbuffer is empty, otherwise
+ *   the string.
+ **/
+unsigned char *
+raptor_stringbuffer_as_string_detach(raptor_stringbuffer* stringbuffer,
+                                     size_t* length_p)
+{
+  unsigned char *string;
+
+  string = raptor_stringbuffer_as_string(stringbuffer);
+  if(!string)
+    return NULL;
+
+  if(length_p)
+    *length_p = stringbuffer->length;
+
+  stringbuffer->string = NULL;
+  stringbuffer->length = 0;
+  stringbuffer->size = 0;
+
+  return string;
+}
+
+
 /**
  * raptor_stringbuffer_copy_to_string:
  * @stringbuffer: raptor stringbuffer
@@ -519,26 +588,23 @@ int
 raptor_stringbuffer_copy_to_string(raptor_stringbuffer* stringbuffer,
                                    unsigned char *string, size_t length)
 {
-  raptor_stringbuffer_node *node;
-  unsigned char *p;
-  
   if(!string || length < 1)
     return 1;
 
-  if(!stringbuffer->length)
+  if(!stringbuffer->length) {
+    *string = '\0';
     return 0;
+  }
 
-  p = string;
-  for(node = stringbuffer->head; node; node = node->next) {
-    if(node->length > length) {
-      p[-1]='\0';
-      return 1;
-    }
-    memcpy(p, node->string, node->length);
-    p+= node->length;
-    length-= node->length;
+  if(stringbuffer->length > length) {
+    /* truncate */
+    memcpy(string, stringbuffer->string, length - 1);
+    string[length - 1] = '\0';
+    return 1;
   }
-  *p='\0';
+
+  memcpy(string, stringbuffer->string, stringbuffer->length);
+  string[stringbuffer->length] = '\0';
   return 0;
 }
 
@@ -887,7 +953,51 @@ main(int argc, char *argv[])
   }
   free(copy_string);
   
-  
+
+#if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
+  fprintf(stderr, "%s: Detaching string from string buffer\n", program);
+#endif
+
+  str = raptor_stringbuffer_as_string_detach(sb1, &len);
+  if(!str || len != strlen(test_append_results_total) ||
+     strcmp((const char*)str, test_append_results_total)) {
+    fprintf(stderr, "%s: detached string is '%s', expected '%s'\n",
+            program, str, test_append_results_total);
+    exit(1);
+  }
+  raptor_free_memory(str);
+
+  if(raptor_stringbuffer_length(sb1) || raptor_stringbuffer_as_string(sb1)) {
+    fprintf(stderr, "%s: string buffer not empty after detach\n", program);
+    exit(1);
+  }
+
+
+#if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
+  fprintf(stderr, "%s: Reserving and refilling string buffer\n", program);
+#endif
+
+  if(raptor_stringbuffer_reserve(sb1, 1000)) {
+    fprintf(stderr, "%s: reserving string buffer failed\n", program);
+    exit(1);
+  }
+  for(i = 0; i < 100; i++)
+    raptor_stringbuffer_append_counted_string(sb1,
+                                              (const unsigned char*)"0123456789",
+                                              10, 1);
+  len = raptor_stringbuffer_length(sb1);
+  if(len != 1000) {
+    fprintf(stderr, "%s: reserved string buffer is length %d, expected 1000\n",
+            program, (int)len);
+    exit(1);
+  }
+  str = raptor_stringbuffer_as_string(sb1);
+  if(str[999] != '9' || str[1000]) {
+    fprintf(stderr, "%s: reserved string buffer content is wrong\n", program);
+    exit(1);
+  }
+
+
 #if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
   fprintf(stderr, "%s: Freeing string buffers\n", program);
 #endif
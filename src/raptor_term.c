@@ -413,7 +413,8 @@ raptor_new_term_from_counted_string(raptor_world* world,
   locator.line = -1;
 
   bytes_read = raptor_ntriples_parse_term(world, &locator,
-                                          string, &length, &term, 1);
+                                          string, &length, &term,
+                                          RAPTOR_NTRIPLES_TERM_ALLOW_TURTLE);
 
   if(!bytes_read || length != 0) {
     if(term)
@@ -59,6 +59,11 @@ struct raptor_turtle_writer_s {
  
   raptor_uri* base_uri;
 
+  /* relative URI strings against base_uri; made on the second
+   * reference written so one-off writers do not pay for it */
+  raptor_uri_relative_cache* relative_cache;
+  int references_count;
+
   int my_nstack;
   raptor_namespace_stack *nstack;
   int nstack_depth;
@@ -235,6 +240,9 @@ raptor_free_turtle_writer(raptor_turtle_writer* turtle_writer)
   if(turtle_writer->nstack && turtle_writer->my_nstack)
     raptor_free_namespaces(turtle_writer->nstack);
 
+  if(turtle_writer->relative_cache)
+    raptor_free_uri_relative_cache(turtle_writer->relative_cache);
+
   RAPTOR_FREE(raptor_turtle_writer, turtle_writer);
 }
 
@@ -350,6 +358,16 @@ int
 raptor_turtle_writer_reference(raptor_turtle_writer* turtle_writer, 
                                raptor_uri* uri)
 {
+  if(turtle_writer->base_uri && turtle_writer->references_count++) {
+    if(!turtle_writer->relative_cache)
+      turtle_writer->relative_cache = raptor_new_uri_relative_cache(turtle_writer->base_uri);
+    if(turtle_writer->relative_cache)
+      return raptor_uri_relative_cache_escaped_write(turtle_writer->relative_cache,
+                                                     uri,
+                                                     RAPTOR_ESCAPED_WRITE_TURTLE_URI,
+                                                     turtle_writer->iostr);
+  }
+
   return raptor_uri_escaped_write(uri, turtle_writer->base_uri, 
                                   RAPTOR_ESCAPED_WRITE_TURTLE_URI,
                                   turtle_writer->iostr);
@@ -607,6 +625,9 @@ raptor_turtle_writer_set_option(raptor_turtle_writer *turtle_writer,
     case RAPTOR_OPTION_MICROFORMATS:
     case RAPTOR_OPTION_HTML_LINK:
     case RAPTOR_OPTION_WWW_TIMEOUT:
+    case RAPTOR_OPTION_GRDDL_CACHE_DIRECTORY:
+    case RAPTOR_OPTION_RSS_STREAMING:
+    case RAPTOR_OPTION_NTRIPLES_TRUSTED:
     case RAPTOR_OPTION_STRICT:
       
     /* Shared */
@@ -628,6 +649,8 @@ raptor_turtle_writer_set_option(raptor_turtle_writer *turtle_writer,
     /* JSON serializer options */
     case RAPTOR_OPTION_JSON_CALLBACK:
     case RAPTOR_OPTION_JSON_EXTRA_DATA:
+    case RAPTOR_OPTION_JSON_STREAMING:
+    case RAPTOR_OPTION_JSON_SORT_LIMIT:
     case RAPTOR_OPTION_RSS_TRIPLES:
     case RAPTOR_OPTION_ATOM_ENTRY_URI:
     case RAPTOR_OPTION_PREFIX_ELEMENTS:
@@ -635,6 +658,9 @@ raptor_turtle_writer_set_option(raptor_turtle_writer *turtle_writer,
     /* Turtle serializer option */
     case RAPTOR_OPTION_WRITE_BASE_URI:
 
+    /* N-Triples serializer option */
+    case RAPTOR_OPTION_WRITE_THREADS:
+
     /* WWW option */
     case RAPTOR_OPTION_WWW_HTTP_CACHE_CONTROL:
     case RAPTOR_OPTION_WWW_HTTP_USER_AGENT:
@@ -731,6 +757,9 @@ raptor_turtle_writer_get_option(raptor_turtle_writer *turtle_writer,
     case RAPTOR_OPTION_MICROFORMATS:
     case RAPTOR_OPTION_HTML_LINK:
     case RAPTOR_OPTION_WWW_TIMEOUT:
+    case RAPTOR_OPTION_GRDDL_CACHE_DIRECTORY:
+    case RAPTOR_OPTION_RSS_STREAMING:
+    case RAPTOR_OPTION_NTRIPLES_TRUSTED:
     case RAPTOR_OPTION_STRICT:
 
     /* Shared */
@@ -752,6 +781,8 @@ raptor_turtle_writer_get_option(raptor_turtle_writer *turtle_writer,
     /* JSON serializer options */
     case RAPTOR_OPTION_JSON_CALLBACK:
     case RAPTOR_OPTION_JSON_EXTRA_DATA:
+    case RAPTOR_OPTION_JSON_STREAMING:
+    case RAPTOR_OPTION_JSON_SORT_LIMIT:
     case RAPTOR_OPTION_RSS_TRIPLES:
     case RAPTOR_OPTION_ATOM_ENTRY_URI:
     case RAPTOR_OPTION_PREFIX_ELEMENTS:
@@ -759,6 +790,9 @@ raptor_turtle_writer_get_option(raptor_turtle_writer *turtle_writer,
     /* Turtle serializer option */
     case RAPTOR_OPTION_WRITE_BASE_URI:
 
+    /* N-Triples serializer option */
+    case RAPTOR_OPTION_WRITE_THREADS:
+
     /* WWW option */
     case RAPTOR_OPTION_WWW_HTTP_CACHE_CONTROL:
     case RAPTOR_OPTION_WWW_HTTP_USER_AGENT:
@@ -82,6 +82,11 @@ struct raptor_uri_s {
   unsigned int length;
   /* usage count */
   int usage;
+  /* N-Triples escaped form "<...>" - see raptor_uri_escaped_cache_add() */
+  unsigned char *escaped;
+  unsigned int escaped_length;
+  /* 0 not written yet, 1 written once, 2 escaped is set, <0 not kept */
+  int escaped_state;
 };
 
 
@@ -125,7 +130,7 @@ raptor_new_uri_from_counted_string(raptor_world* world,
     key.length = (unsigned int)length;
 
     /* if existing URI found in tree, return it */
-    new_uri = (raptor_uri*)raptor_avltree_search(world->uris_tree, &key);
+    new_uri = (raptor_uri*)raptor_bptree_search(world->uris_tree, &key);
     if(new_uri) {
 #if defined(RAPTOR_DEBUG) && RAPTOR_DEBUG > 1
       RAPTOR_DEBUG3("Found existing URI %s with current usage %d\n",
@@ -169,7 +174,7 @@ raptor_new_uri_from_counted_string(raptor_world* world,
 
   /* store in tree */
   if(world->uris_tree) {
-    if(raptor_avltree_add(world->uris_tree, new_uri)) {
+    if(raptor_bptree_add(world->uris_tree, new_uri)) {
       RAPTOR_FREE(char*, new_string);
       RAPTOR_FREE(raptor_uri, new_uri);
       new_uri = NULL;
@@ -497,7 +502,12 @@ raptor_free_uri(raptor_uri *uri)
 
   /* this does not free the uri */
   if(uri->world->uris_tree)
-    raptor_avltree_delete(uri->world->uris_tree, uri);
+    raptor_bptree_delete(uri->world->uris_tree, uri);
+
+  if(uri->escaped) {
+    uri->world->uri_escaped_cache_used -= uri->escaped_length;
+    RAPTOR_FREE(char*, uri->escaped);
+  }
 
   if(uri->string)
     RAPTOR_FREE(char*, uri->string);
@@ -1172,14 +1182,14 @@ int
 raptor_uri_init(raptor_world* world)
 {
   if(world->uri_interning && !world->uris_tree) {
-    world->uris_tree = raptor_new_avltree((raptor_data_compare_handler)raptor_uri_compare,
-                                          /* free */ NULL, 0);
+    world->uris_tree = raptor_new_bptree((raptor_data_compare_handler)raptor_uri_compare,
+                                         /* free */ NULL, 0);
     if(!world->uris_tree) {
 #ifdef RAPTOR_DEBUG
-      RAPTOR_FATAL1("Failed to create raptor URI avltree");
+      RAPTOR_FATAL1("Failed to create raptor URI tree");
 #else
       raptor_log_error(world, RAPTOR_LOG_LEVEL_ERROR, NULL,
-                       "Failed to create raptor URI avltree");
+                       "Failed to create raptor URI tree");
 #endif
     }
     
@@ -1193,7 +1203,7 @@ void
 raptor_uri_finish(raptor_world* world)
 {
   if(world->uris_tree) {
-    raptor_free_avltree(world->uris_tree);
+    raptor_free_bptree(world->uris_tree);
     world->uris_tree = NULL;
   }
 }
@@ -1343,31 +1353,30 @@ raptor_uri_path_make_relative_path(const unsigned char *from_path, size_t from_p
 }
 
 
-/**
- * raptor_uri_to_relative_counted_uri_string:
+/*
+ * raptor_uri_to_relative_counted_uri_string_detail:
  * @base_uri: The base absolute URI to resolve against (or NULL)
+ * @base_detail: The parsed @base_uri (or NULL if @base_uri is NULL)
  * @reference_uri: The reference absolute URI to use
  * @length_p: Location to store the length of the relative URI string or NULL
  *
- * Get the counted relative URI string of a URI against a base URI.
- * 
+ * INTERNAL - Get the counted relative URI string of a URI against a parsed base URI
+ *
  * Return value: A newly allocated relative URI string or NULL on failure
- **/
-
-unsigned char*
-raptor_uri_to_relative_counted_uri_string(raptor_uri *base_uri, 
-                                          raptor_uri *reference_uri,
-                                          size_t *length_p) {
-  raptor_uri_detail *base_detail = NULL, *reference_detail;
-  const unsigned char *base, *reference_str, *base_file, *reference_file;
+ */
+static unsigned char*
+raptor_uri_to_relative_counted_uri_string_detail(raptor_uri *base_uri,
+                                                 raptor_uri_detail *base_detail,
+                                                 raptor_uri *reference_uri,
+                                                 size_t *length_p)
+{
+  raptor_uri_detail *reference_detail;
+  const unsigned char *reference_str, *base_file, *reference_file;
   unsigned char *suffix, *cur_ptr;
-  size_t base_len, reference_len, reference_file_len, suffix_len;
+  size_t reference_len, reference_file_len, suffix_len;
   unsigned char *result = NULL;
   int suffix_is_result = 0;
   
-  if(!reference_uri)
-    return NULL;
-    
   if(length_p)
     *length_p=0;
 
@@ -1379,11 +1388,6 @@ raptor_uri_to_relative_counted_uri_string(raptor_uri *base_uri,
   if(!base_uri)
     goto buildresult;
   
-  base = raptor_uri_as_counted_string(base_uri, &base_len);
-  base_detail = raptor_new_uri_detail(base);
-  if(!base_detail)
-    goto err;
-  
   /* Check if the whole URIs are equal */
   if(raptor_uri_equals(base_uri, reference_uri)) {
     reference_len = 0;
@@ -1510,10 +1514,50 @@ raptor_uri_to_relative_counted_uri_string(raptor_uri *base_uri,
   }
   
   err:
+  if(reference_detail)
+    raptor_free_uri_detail(reference_detail);
+  
+  return result;
+}
+
+
+/**
+ * raptor_uri_to_relative_counted_uri_string:
+ * @base_uri: The base absolute URI to resolve against (or NULL)
+ * @reference_uri: The reference absolute URI to use
+ * @length_p: Location to store the length of the relative URI string or NULL
+ *
+ * Get the counted relative URI string of a URI against a base URI.
+ * 
+ * Return value: A newly allocated relative URI string or NULL on failure
+ **/
+
+unsigned char*
+raptor_uri_to_relative_counted_uri_string(raptor_uri *base_uri, 
+                                          raptor_uri *reference_uri,
+                                          size_t *length_p) {
+  raptor_uri_detail *base_detail = NULL;
+  unsigned char *result;
+  
+  if(!reference_uri)
+    return NULL;
+    
+  if(length_p)
+    *length_p=0;
+
+  if(base_uri) {
+    base_detail = raptor_new_uri_detail(raptor_uri_as_string(base_uri));
+    if(!base_detail)
+      return NULL;
+  }
+
+  result = raptor_uri_to_relative_counted_uri_string_detail(base_uri,
+                                                            base_detail,
+                                                            reference_uri,
+                                                            length_p);
   if(base_detail)
     raptor_free_uri_detail(base_detail);
-  raptor_free_uri_detail(reference_detail);
-  
+
   return result;
 }
 
@@ -1536,6 +1580,197 @@ raptor_uri_to_relative_uri_string(raptor_uri *base_uri,
 }
 
 
+/* Relative URI strings against one base URI, with the base parsed once */
+struct raptor_uri_relative_cache_s {
+  raptor_uri* base_uri;
+  raptor_uri_detail* base_detail;
+  /* tree of raptor_uri_relative_entry ordered by URI object */
+  raptor_bptree* entries;
+};
+
+typedef struct {
+  /* reference held so the object is not reused for another URI */
+  raptor_uri* uri;
+  unsigned char* string;
+  size_t length;
+} raptor_uri_relative_entry;
+
+
+static int
+raptor_uri_relative_entry_compare(const void* a, const void* b)
+{
+  const raptor_uri* uri_a = ((const raptor_uri_relative_entry*)a)->uri;
+  const raptor_uri* uri_b = ((const raptor_uri_relative_entry*)b)->uri;
+
+  return (uri_a > uri_b) - (uri_a < uri_b);
+}
+
+
+static void
+raptor_free_uri_relative_entry(void* data)
+{
+  raptor_uri_relative_entry* entry = (raptor_uri_relative_entry*)data;
+
+  raptor_free_uri(entry->uri);
+  RAPTOR_FREE(char*, entry->string);
+  RAPTOR_FREE(raptor_uri_relative_entry, entry);
+}
+
+
+/*
+ * raptor_new_uri_relative_cache:
+ * @base_uri: base URI
+ *
+ * INTERNAL - Constructor - create a cache of relative URI strings against a base URI
+ *
+ * Return value: new cache or NULL on failure
+ */
+raptor_uri_relative_cache*
+raptor_new_uri_relative_cache(raptor_uri* base_uri)
+{
+  raptor_uri_relative_cache* cache;
+
+  cache = RAPTOR_CALLOC(raptor_uri_relative_cache*, 1, sizeof(*cache));
+  if(!cache)
+    return NULL;
+
+  cache->base_uri = raptor_uri_copy(base_uri);
+  cache->base_detail = raptor_new_uri_detail(raptor_uri_as_string(base_uri));
+  cache->entries = raptor_new_bptree(raptor_uri_relative_entry_compare,
+                                     raptor_free_uri_relative_entry, 0);
+  if(!cache->base_detail || !cache->entries) {
+    raptor_free_uri_relative_cache(cache);
+    return NULL;
+  }
+
+  return cache;
+}
+
+
+/*
+ * raptor_free_uri_relative_cache:
+ * @cache: cache
+ *
+ * INTERNAL - Destructor - destroy a relative URI string cache
+ */
+void
+raptor_free_uri_relative_cache(raptor_uri_relative_cache* cache)
+{
+  if(!cache)
+    return;
+
+  if(cache->entries)
+    raptor_free_bptree(cache->entries);
+  if(cache->base_detail)
+    raptor_free_uri_detail(cache->base_detail);
+  raptor_free_uri(cache->base_uri);
+  RAPTOR_FREE(raptor_uri_relative_cache, cache);
+}
+
+
+/*
+ * raptor_uri_relative_cache_get:
+ * @cache: cache
+ * @uri: URI
+ * @length_p: Location to store the length of the relative URI string
+ *
+ * INTERNAL - Get the relative URI string of a URI against the cache base URI
+ *
+ * The string is computed the first time a URI object is seen and
+ * then returned again until the cache fills up
+ * (#RAPTOR_URI_RELATIVE_CACHE_SIZE entries) and is emptied.
+ *
+ * Return value: shared relative URI string or NULL on failure
+ */
+const unsigned char*
+raptor_uri_relative_cache_get(raptor_uri_relative_cache* cache,
+                              raptor_uri* uri, size_t* length_p)
+{
+  raptor_uri_relative_entry key;
+  raptor_uri_relative_entry* entry;
+  unsigned char* string;
+  size_t length = 0;
+
+  key.uri = uri;
+  entry = (raptor_uri_relative_entry*)raptor_bptree_search(cache->entries,
+                                                           &key);
+  if(entry) {
+    *length_p = entry->length;
+    return entry->string;
+  }
+
+  string = raptor_uri_to_relative_counted_uri_string_detail(cache->base_uri,
+                                                            cache->base_detail,
+                                                            uri, &length);
+  if(!string)
+    return NULL;
+
+  if(raptor_bptree_size(cache->entries) >= RAPTOR_URI_RELATIVE_CACHE_SIZE) {
+    raptor_bptree* entries;
+
+    entries = raptor_new_bptree(raptor_uri_relative_entry_compare,
+                                raptor_free_uri_relative_entry, 0);
+    if(!entries) {
+      RAPTOR_FREE(char*, string);
+      return NULL;
+    }
+    raptor_free_bptree(cache->entries);
+    cache->entries = entries;
+  }
+
+  entry = RAPTOR_CALLOC(raptor_uri_relative_entry*, 1, sizeof(*entry));
+  if(!entry) {
+    RAPTOR_FREE(char*, string);
+    return NULL;
+  }
+  entry->uri = raptor_uri_copy(uri);
+  entry->string = string;
+  entry->length = length;
+
+  /* on failure the entry is freed by the tree */
+  if(raptor_bptree_add(cache->entries, entry))
+    return NULL;
+
+  *length_p = length;
+  return string;
+}
+
+
+/*
+ * raptor_uri_relative_cache_escaped_write:
+ * @cache: cache
+ * @uri: uri to write
+ * @flags: bit flags - see #raptor_escaped_write_bitflags
+ * @iostr: raptor iostream
+ *
+ * INTERNAL - Write a URI relative to the cache base URI with escapes
+ *
+ * As raptor_uri_escaped_write() with the cache base URI.
+ *
+ * Return value: non-0 on failure
+ */
+int
+raptor_uri_relative_cache_escaped_write(raptor_uri_relative_cache* cache,
+                                        raptor_uri* uri, unsigned int flags,
+                                        raptor_iostream *iostr)
+{
+  const unsigned char* uri_str;
+  size_t len;
+
+  if(!uri)
+    return 1;
+
+  raptor_iostream_write_byte('<', iostr);
+  uri_str = raptor_uri_relative_cache_get(cache, uri, &len);
+  if(!uri_str)
+    return 1;
+  raptor_string_escaped_write(uri_str, len, '>', flags, iostr);
+  raptor_iostream_write_byte('>', iostr);
+
+  return 0;
+}
+
+
 /**
  * raptor_uri_print:
  * @uri: URI to print
@@ -1722,6 +1957,91 @@ raptor_uri_file_exists(raptor_uri* uri)
 
 
 
+/*
+ * raptor_uri_escaped_cache_add:
+ * @uri: URI
+ * @now: non-0 to keep the escaped form on this call
+ *
+ * INTERNAL - Note an N-Triples write of a URI by a serializer
+ *
+ * The N-Triples escaped "<...>" form of an interned URI is kept with
+ * it from the second write of the same URI object (or the first if
+ * @now is set), while the world total stays under the
+ * #RAPTOR_WORLD_FLAG_URI_ESCAPED_CACHE_SIZE limit.
+ * raptor_uri_escaped_write() then copies it instead of escaping.
+ *
+ * A URI passed with @now set does not change again until it is freed,
+ * so it can be written from other threads afterwards.
+ */
+void
+raptor_uri_escaped_cache_add(raptor_uri* uri, int now)
+{
+  raptor_world* world = uri->world;
+  unsigned char* string = NULL;
+  size_t len = 0;
+  unsigned int i;
+
+  if(uri->escaped_state > 1 || uri->escaped_state < 0 ||
+     !world->uris_tree || !world->uri_escaped_cache_size)
+    return;
+
+  if(!uri->escaped_state && !now) {
+    uri->escaped_state = 1;
+    return;
+  }
+
+  uri->escaped_state = -1;
+
+  /* escaping only ever makes the string longer */
+  if(world->uri_escaped_cache_used + uri->length + 2 > world->uri_escaped_cache_size)
+    return;
+
+  /* most URIs need no escapes at all */
+  for(i = 0; i < uri->length; i++) {
+    unsigned char c = uri->string[i];
+    if(c <= 0x20 || c >= 0x7f || strchr("<>\\\"{}|^`", c))
+      break;
+  }
+
+  if(i == uri->length) {
+    string = RAPTOR_MALLOC(unsigned char*, uri->length + 3);
+    if(!string)
+      return;
+    string[0] = '<';
+    memcpy(string + 1, uri->string, uri->length);
+    string[uri->length + 1] = '>';
+    string[uri->length + 2] = '\0';
+    len = uri->length + 2;
+  } else {
+    raptor_iostream* iostr;
+    void* escaped = NULL;
+
+    iostr = raptor_new_iostream_to_string(world, &escaped, &len, NULL);
+    if(!iostr)
+      return;
+    raptor_iostream_write_byte('<', iostr);
+    raptor_string_escaped_write(uri->string, uri->length, '>',
+                                RAPTOR_ESCAPED_WRITE_NTRIPLES_URI, iostr);
+    raptor_iostream_write_byte('>', iostr);
+    raptor_free_iostream(iostr);
+
+    if(!escaped)
+      return;
+    string = (unsigned char*)escaped;
+  }
+
+  if(world->uri_escaped_cache_used + len > world->uri_escaped_cache_size) {
+    RAPTOR_FREE(char*, string);
+    return;
+  }
+
+  uri->escaped = string;
+  uri->escaped_length = RAPTOR_BAD_CAST(unsigned int, len);
+  uri->escaped_state = 2;
+  world->uri_escaped_cache_used += len;
+}
+
+
 /**
  * raptor_uri_escaped_write:
  * @uri: uri to write
@@ -1746,6 +2066,11 @@ raptor_uri_escaped_write(raptor_uri* uri,
   if(!uri)
     return 1;
   
+  if(uri->escaped && !base_uri && flags == RAPTOR_ESCAPED_WRITE_NTRIPLES_URI) {
+    raptor_iostream_write_bytes(uri->escaped, 1, uri->escaped_length, iostr);
+    return 0;
+  }
+
   raptor_iostream_write_byte('<', iostr);
   if(base_uri) {
     uri_str = raptor_uri_to_relative_counted_uri_string(base_uri, uri, &len);
@@ -1913,10 +2238,113 @@ assert_uri_to_relative(raptor_world *world, const char *base, const char *uri, c
     return 1;
   }
   RAPTOR_FREE(char*, output);
+
+  if(base_uri) {
+    raptor_uri_relative_cache* cache;
+    const unsigned char* cached;
+    int i;
+
+    /* second lookup is answered from the cache */
+    cache = raptor_new_uri_relative_cache(base_uri);
+    for(i = 0; i < 2; i++) {
+      cached = cache ? raptor_uri_relative_cache_get(cache, reference_uri,
+                                                     &length) : NULL;
+      if(!cached || strcmp(relative, (const char*)cached) ||
+         length != strlen(relative)) {
+        fprintf(stderr,
+                "%s: raptor_uri_relative_cache_get FAILED: base='%s', uri='%s', expected='%s', got='%s'\n",
+                program, base, uri, relative, cached);
+        result = 1;
+        break;
+      }
+    }
+    raptor_free_uri_relative_cache(cache);
+  }
+
   if(base_uri)
     raptor_free_uri(base_uri);
   raptor_free_uri(reference_uri);
-  return 0;
+  return result;
+}
+
+
+/* Write @uri_string with N-Triples escapes to a new string */
+static unsigned char*
+uri_escaped_string(raptor_world *world, const char *uri_string, int direct,
+                   size_t* len_p)
+{
+  unsigned int flags = RAPTOR_ESCAPED_WRITE_NTRIPLES_URI;
+  raptor_iostream* iostr;
+  raptor_uri* uri;
+  void* string = NULL;
+
+  uri = raptor_new_uri(world, (const unsigned char*)uri_string);
+  iostr = raptor_new_iostream_to_string(world, &string, len_p, NULL);
+  if(uri && iostr) {
+    if(direct) {
+      raptor_iostream_write_byte('<', iostr);
+      raptor_string_escaped_write(uri->string, uri->length, '>', flags, iostr);
+      raptor_iostream_write_byte('>', iostr);
+    } else {
+      raptor_uri_escaped_cache_add(uri, 0);
+      raptor_uri_escaped_write(uri, NULL, flags, iostr);
+    }
+  }
+  if(iostr)
+    raptor_free_iostream(iostr);
+  if(uri)
+    raptor_free_uri(uri);
+
+  return (unsigned char*)string;
+}
+
+
+static int
+assert_uri_escaped_write(raptor_world *world, const char *uri_string,
+                         int expect_cached)
+{
+  raptor_uri* uri;
+  unsigned char* expected;
+  size_t expected_len = 0;
+  int i;
+  int failures = 0;
+
+  expected = uri_escaped_string(world, uri_string, 1, &expected_len);
+
+  /* hold a reference so the URI is the same object for every write */
+  uri = raptor_new_uri(world, (const unsigned char*)uri_string);
+
+  for(i = 0; i < 3; i++) {
+    unsigned char* output;
+    size_t len = 0;
+
+    output = uri_escaped_string(world, uri_string, 0, &len);
+    if(!expected || !output || len != expected_len ||
+       memcmp(output, expected, len)) {
+      fprintf(stderr,
+              "%s: raptor_uri_escaped_write(%s) FAILED on write %d giving %s != %s\n",
+              program, uri_string, i + 1, output, expected);
+      failures++;
+    }
+    if(output)
+      raptor_free_memory(output);
+  }
+
+  if(uri && (uri->escaped != NULL) != expect_cached) {
+    fprintf(stderr,
+            "%s: raptor_uri_escaped_write(%s) escaped form %s, expected %s\n",
+            program, uri_string,
+            uri->escaped ? "kept" : "not kept",
+            expect_cached ? "kept" : "not kept");
+    failures++;
+  }
+
+  if(uri)
+    raptor_free_uri(uri);
+  if(expected)
+    raptor_free_memory(expected);
+
+  return failures;
 }
 
 
@@ -2091,6 +2519,27 @@ main(int argc, char *argv[])
     raptor_free_uri(u2);
   }
 
+  failures += assert_uri_escaped_write(world, "http://example.org/a", 1);
+  failures += assert_uri_escaped_write(world, "http://example.org/caf\xc3\xa9?q=<x>&r=\"y\"", 1);
+  failures += assert_uri_escaped_write(world, "http://example.org/\x01\t\\", 1);
+
+  raptor_free_world(world);
+
+  /* over the escaped form size limit */
+  world = raptor_new_world();
+  if(!world ||
+     raptor_world_set_flag(world, RAPTOR_WORLD_FLAG_URI_ESCAPED_CACHE_SIZE, 23) ||
+     raptor_world_open(world))
+    exit(1);
+
+  failures += assert_uri_escaped_write(world, "http://example.org/a", 1);
+  failures += assert_uri_escaped_write(world, "http://example.org/abc", 0);
+  if(world->uri_escaped_cache_used) {
+    fprintf(stderr, "%s: %d bytes of escaped URIs left after freeing URIs\n",
+            program, (int)world->uri_escaped_cache_used);
+    failures++;
+  }
+
   raptor_free_world(world);
 
   return failures ;
@@ -189,8 +189,11 @@ void
 raptor_xml_element_set_attributes(raptor_xml_element* xml_element,
                                    raptor_qname **attributes, int count)
 {
+  /* an array compacted in place keeps its allocated size */
+  if(attributes != xml_element->attributes)
+    xml_element->attributes_size = RAPTOR_GOOD_CAST(unsigned int, count);
   xml_element->attributes = attributes;
-  xml_element->attribute_count = count;
+  xml_element->attribute_count = RAPTOR_GOOD_CAST(unsigned int, count);
 }
 
 
@@ -208,7 +211,8 @@ raptor_xml_element_set_attributes(raptor_xml_element* xml_element,
 raptor_qname**
 raptor_xml_element_get_attributes(raptor_xml_element* xml_element)
 {
-  return xml_element->attributes;
+  /* a reused element may keep an empty array */
+  return xml_element->attribute_count ? xml_element->attributes : NULL;
 }
 
 
@@ -1090,6 +1094,39 @@ main(int argc, char *argv[])
     fprintf(stderr, "%s: raptor_xml_escape_string all tests OK\n", program);
 #endif
 
+  /* elements released at end tags are reused by later start tags */
+  if(1) {
+    const char *doc = "<a><b c='1'/><b c='2'/><b c='3'/></a>";
+    raptor_locator locator;
+    raptor_uri *base_uri;
+    raptor_sax2 *sax2;
+    unsigned long avoided;
+
+    memset(&locator, '\0', sizeof(locator));
+    base_uri = raptor_new_uri(world, (const unsigned char*)"http://example.org/");
+    sax2 = raptor_new_sax2(world, &locator, NULL);
+
+    raptor_sax2_parse_start(sax2, base_uri);
+    raptor_sax2_parse_chunk(sax2, (const unsigned char*)doc, strlen(doc), 1);
+    avoided = raptor_sax2_get_pool_allocations_avoided(sax2);
+    if(!avoided) {
+      fprintf(stderr, "%s: raptor_sax2 reused no allocations\n", program);
+      failures++;
+    }
+
+    raptor_sax2_parse_start(sax2, base_uri);
+    avoided = raptor_sax2_get_pool_allocations_avoided(sax2);
+    if(avoided) {
+      fprintf(stderr,
+              "%s: raptor_sax2 reuse count is %lu at parse start, expected 0\n",
+              program, avoided);
+      failures++;
+    }
+
+    raptor_free_sax2(sax2);
+    raptor_free_uri(base_uri);
+  }
+
   raptor_free_world(world);
 
   return failures;
@@ -0,0 +1,2427 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * raptor_xmltok.c - Raptor native XML tokenizer for SAX2
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ * An incremental XML 1.0 tokenizer that calls the raptor_sax2_*
+ * event functions directly, used when raptor is configured with the
+ * native XML parser instead of libxml2.
+ *
+ * Input chunks are appended to one growable buffer after converting
+ * to UTF-8 and normalizing line ends.  Only complete tokens are
+ * processed; names and attribute values are NUL terminated in place
+ * in that buffer and handed to raptor_sax2_start_element() without
+ * further copies.  Attribute values are only copied when they
+ * reference a user-declared entity.  The attribute pointer array,
+ * scratch space and open element name stack are reused for the whole
+ * document.
+ *
+ * Supported: UTF-8, US-ASCII and ISO-8859-1 input, the XML
+ * declaration, comments, CDATA sections, processing instructions
+ * (ignored), character references, the predefined entities and
+ * internal general entities declared in the DOCTYPE internal subset.
+ * External DTDs and external parsed entities are never loaded; a
+ * reference to an external parsed entity expands to nothing, as with
+ * libxml2 when loading external entities is disabled.  There is no
+ * validation.
+ *
+ * Namespace processing is done by raptor_sax2_start_element() on the
+ * qualified names given to it, as with the libxml2 backend.
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+/* Raptor includes */
+#include "raptor2.h"
+#include "raptor_internal.h"
+
+
+#ifdef RAPTOR_XML_NATIVE
+
+#ifndef STANDALONE
+
+/* Limit on nested entity references */
+#define RAPTOR_XMLTOK_MAX_ENTITY_DEPTH 16
+
+/* Limit on total bytes produced by entity expansion in one document */
+#define RAPTOR_XMLTOK_MAX_ENTITY_EXPANSION (16 * 1024 * 1024)
+
+/* Initial size of the input buffer */
+#define RAPTOR_XMLTOK_BUFFER_SIZE 8192
+
+
+typedef struct raptor_xmltok_entity_s
+{
+  struct raptor_xmltok_entity_s* next;
+
+  unsigned char* name;
+
+  /* replacement text (character references already expanded) or
+   * NULL for an external parsed entity
+   */
+  unsigned char* value;
+  size_t value_len;
+
+  /* non-0 while this entity is being expanded - detects loops */
+  int expanding;
+} raptor_xmltok_entity;
+
+
+typedef enum {
+  /* before the XML declaration has been looked for */
+  RAPTOR_XMLTOK_STATE_START,
+  /* before the root element */
+  RAPTOR_XMLTOK_STATE_PROLOG,
+  /* inside the root element */
+  RAPTOR_XMLTOK_STATE_CONTENT,
+  /* after the root element */
+  RAPTOR_XMLTOK_STATE_EPILOG
+} raptor_xmltok_state;
+
+
+typedef enum {
+  RAPTOR_XMLTOK_ENCODING_UTF8,
+  RAPTOR_XMLTOK_ENCODING_LATIN1
+} raptor_xmltok_encoding;
+
+
+struct raptor_xmltok_s
+{
+  raptor_sax2* sax2;
+
+  raptor_xmltok_state state;
+  raptor_xmltok_encoding encoding;
+
+  /* non-0 after a well-formedness error: nothing more is parsed */
+  int failed;
+
+  /* non-0 if the last input byte was CR - for CR LF normalization
+   * across chunk boundaries
+   */
+  int last_was_cr;
+
+  /* non-0 once a DOCTYPE has been seen */
+  int seen_doctype;
+
+  /* input not yet tokenized: UTF-8 with line ends normalized to LF
+   * (except in START state when it holds the raw bytes)
+   */
+  unsigned char* buffer;
+  size_t buffer_len;
+  size_t buffer_size;
+
+  /* length of buffer prefix checked to be well-formed UTF-8 */
+  size_t valid_len;
+
+  /* line number of the current position */
+  int line;
+
+  /* NULL terminated (name, value) pointer array for start tags */
+  unsigned char** atts;
+  /* offset into scratch for values stored there or (size_t)-1 */
+  size_t* atts_offsets;
+  int atts_size;
+
+  /* scratch space for attribute values that expand entities */
+  unsigned char* scratch;
+  size_t scratch_len;
+  size_t scratch_size;
+
+  /* names of open elements, NUL separated, for matching end tags */
+  unsigned char* names;
+  size_t names_len;
+  size_t names_size;
+  size_t* name_offsets;
+  int depth;
+  int depth_size;
+
+  /* general entities declared in the internal subset */
+  raptor_xmltok_entity* entities;
+  int entity_depth;
+  size_t entity_expanded_len;
+};
+
+
+static const char* const xmltok_error_prefix = "XML parser error: ";
+
+static int raptor_xmltok_parse_buffer(raptor_xmltok* xt, unsigned char* buf, size_t len, int is_end, int in_entity, size_t* used_p);
+static void raptor_xmltok_error(raptor_xmltok* xt, const char *message, ...) RAPTOR_PRINTF_FORMAT(2, 3);
+
+
+/*
+ * raptor_xmltok_error:
+ * @xt: tokenizer
+ * @message: format string
+ *
+ * INTERNAL - Report a fatal well-formedness error and stop parsing
+ */
+static void
+raptor_xmltok_error(raptor_xmltok* xt, const char *message, ...)
+{
+  raptor_sax2* sax2 = xt->sax2;
+  size_t prefix_length = strlen(xmltok_error_prefix);
+  size_t msg_len = strlen(message);
+  char *nmsg;
+  va_list arguments;
+
+  if(xt->failed)
+    return;
+  xt->failed = 1;
+
+  raptor_xmltok_update_document_locator(xt, sax2->locator);
+
+  nmsg = RAPTOR_MALLOC(char*, prefix_length + msg_len + 1);
+  if(nmsg) {
+    memcpy(nmsg, xmltok_error_prefix, prefix_length); /* Do not copy NUL */
+    memcpy(nmsg + prefix_length, message, msg_len + 1); /* Copy NUL */
+  }
+
+  va_start(arguments, message);
+  PRAGMA_IGNORE_WARNING_FORMAT_NONLITERAL_START
+  raptor_log_error_varargs(sax2->world, RAPTOR_LOG_LEVEL_ERROR,
+                           sax2->locator,
+                           nmsg ? nmsg : message,
+                           arguments);
+  PRAGMA_IGNORE_WARNING_END
+  va_end(arguments);
+
+  if(nmsg)
+    RAPTOR_FREE(char*, nmsg);
+}
+
+
+/*
+ * raptor_new_xmltok:
+ * @sax2: SAX2 object to send events to
+ *
+ * INTERNAL - Constructor - create a tokenizer for one document
+ *
+ * Return value: new tokenizer or NULL on failure
+ */
+raptor_xmltok*
+raptor_new_xmltok(raptor_sax2* sax2)
+{
+  raptor_xmltok* xt;
+
+  xt = RAPTOR_CALLOC(raptor_xmltok*, 1, sizeof(*xt));
+  if(!xt)
+    return NULL;
+
+  xt->sax2 = sax2;
+  xt->state = RAPTOR_XMLTOK_STATE_START;
+  xt->encoding = RAPTOR_XMLTOK_ENCODING_UTF8;
+  xt->line = 1;
+
+  return xt;
+}
+
+
+/*
+ * raptor_free_xmltok:
+ * @xt: tokenizer
+ *
+ * INTERNAL - Destructor - free a tokenizer
+ */
+void
+raptor_free_xmltok(raptor_xmltok* xt)
+{
+  raptor_xmltok_entity* entity;
+
+  if(!xt)
+    return;
+
+  entity = xt->entities;
+  while(entity) {
+    raptor_xmltok_entity* next = entity->next;
+
+    RAPTOR_FREE(char*, entity->name);
+    if(entity->value)
+      RAPTOR_FREE(char*, entity->value);
+    RAPTOR_FREE(raptor_xmltok_entity, entity);
+    entity = next;
+  }
+
+  if(xt->buffer)
+    RAPTOR_FREE(char*, xt->buffer);
+  if(xt->atts)
+    RAPTOR_FREE(cstringpointer, xt->atts);
+  if(xt->atts_offsets)
+    RAPTOR_FREE(size_t*, xt->atts_offsets);
+  if(xt->scratch)
+    RAPTOR_FREE(char*, xt->scratch);
+  if(xt->names)
+    RAPTOR_FREE(char*, xt->names);
+  if(xt->name_offsets)
+    RAPTOR_FREE(size_t*, xt->name_offsets);
+
+  RAPTOR_FREE(raptor_xmltok, xt);
+}
+
+
+/*
+ * raptor_xmltok_update_document_locator:
+ * @xt: tokenizer
+ * @locator: locator to update
+ *
+ * INTERNAL - Set the locator line from the tokenizer position
+ *
+ * As with libxml2, the line is that of the end of the current token
+ * and no column is given.
+ */
+void
+raptor_xmltok_update_document_locator(raptor_xmltok* xt,
+                                      raptor_locator* locator)
+{
+  if(!locator)
+    return;
+
+  locator->line = xt ? xt->line : -1;
+  locator->column = -1;
+}
+
+
+/* Count lines in consumed input */
+static void
+raptor_xmltok_count_lines(raptor_xmltok* xt, const unsigned char* p,
+                          const unsigned char* end)
+{
+  while(p < end) {
+    p = (const unsigned char*)memchr(p, '\n', RAPTOR_GOOD_CAST(size_t, end - p));
+    if(!p)
+      break;
+    xt->line++;
+    p++;
+  }
+}
+
+
+static int
+raptor_xmltok_ensure_buffer(raptor_xmltok* xt, size_t extra)
+{
+  size_t new_size;
+  unsigned char* new_buffer;
+
+  if(xt->buffer_len + extra <= xt->buffer_size)
+    return 0;
+
+  new_size = xt->buffer_size ? xt->buffer_size : RAPTOR_XMLTOK_BUFFER_SIZE;
+  while(new_size < xt->buffer_len + extra)
+    new_size <<= 1;
+
+  new_buffer = RAPTOR_REALLOC(unsigned char*, xt->buffer, new_size);
+  if(!new_buffer)
+    return 1;
+
+  xt->buffer = new_buffer;
+  xt->buffer_size = new_size;
+  return 0;
+}
+
+
+/*
+ * raptor_xmltok_append:
+ * @xt: tokenizer
+ * @s: input bytes in the document encoding
+ * @len: length of input
+ *
+ * INTERNAL - Append input to the buffer as UTF-8 with LF line ends
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_xmltok_append(raptor_xmltok* xt, const unsigned char* s, size_t len)
+{
+  unsigned char* dst;
+  size_t i;
+
+  if(!len)
+    return 0;
+
+  if(raptor_xmltok_ensure_buffer(xt, (xt->encoding == RAPTOR_XMLTOK_ENCODING_LATIN1) ? len << 1 : len))
+    return 1;
+
+  dst = xt->buffer + xt->buffer_len;
+
+  /* Fast path: UTF-8 with no CR to normalize */
+  if(xt->encoding == RAPTOR_XMLTOK_ENCODING_UTF8 && !xt->last_was_cr &&
+     !memchr(s, '\r', len)) {
+    memcpy(dst, s, len);
+    xt->buffer_len += len;
+    return 0;
+  }
+
+  for(i = 0; i < len; i++) {
+    unsigned char c = s[i];
+
+    if(c == '\r') {
+      *dst++ = '\n';
+      xt->last_was_cr = 1;
+      continue;
+    }
+
+    if(c == '\n' && xt->last_was_cr) {
+      /* CR LF: LF already written */
+      xt->last_was_cr = 0;
+      continue;
+    }
+    xt->last_was_cr = 0;
+
+    if(c >= 0x80 && xt->encoding == RAPTOR_XMLTOK_ENCODING_LATIN1) {
+      *dst++ = RAPTOR_GOOD_CAST(unsigned char, 0xc0 | (c >> 6));
+      *dst++ = RAPTOR_GOOD_CAST(unsigned char, 0x80 | (c & 0x3f));
+    } else
+      *dst++ = c;
+  }
+
+  xt->buffer_len = RAPTOR_GOOD_CAST(size_t, dst - xt->buffer);
+  return 0;
+}
+
+
+static int
+raptor_xmltok_is_space(unsigned char c)
+{
+  return (c == 0x20 || c == 0x09 || c == 0x0a || c == 0x0d);
+}
+
+
+static int
+raptor_xmltok_is_name_start(unsigned char c)
+{
+  return ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+          c == '_' || c == ':' || c >= 0x80);
+}
+
+
+static int
+raptor_xmltok_is_name_char(unsigned char c)
+{
+  return (raptor_xmltok_is_name_start(c) || (c >= '0' && c <= '9') ||
+          c == '-' || c == '.');
+}
+
+
+/*
+ * raptor_xmltok_scan_name:
+ * @p: start of name
+ * @end: end of input
+ *
+ * INTERNAL - Find the end of an XML name
+ *
+ * Non-ASCII name characters are checked with raptor_xml_name_check()
+ *
+ * Return value: pointer after the name or NULL if there is no legal name
+ */
+static unsigned char*
+raptor_xmltok_scan_name(unsigned char* p, unsigned char* end)
+{
+  unsigned char* start = p;
+  int non_ascii = 0;
+
+  if(p >= end || !raptor_xmltok_is_name_start(*p))
+    return NULL;
+
+  while(p < end && raptor_xmltok_is_name_char(*p)) {
+    if(*p >= 0x80)
+      non_ascii = 1;
+    p++;
+  }
+
+  if(non_ascii &&
+     !raptor_xml_name_check(start, RAPTOR_GOOD_CAST(size_t, p - start), 10))
+    return NULL;
+
+  return p;
+}
+
+
+static unsigned char*
+raptor_xmltok_skip_space(unsigned char* p, unsigned char* end)
+{
+  while(p < end && raptor_xmltok_is_space(*p))
+    p++;
+  return p;
+}
+
+
+/* Find a NUL-free terminator string in [p, end) */
+static unsigned char*
+raptor_xmltok_find(unsigned char* p, unsigned char* end,
+                   const char* terminator, size_t terminator_len)
+{
+  while(p + terminator_len <= end) {
+    p = (unsigned char*)memchr(p, terminator[0],
+                               RAPTOR_GOOD_CAST(size_t, end - p));
+    if(!p || p + terminator_len > end)
+      return NULL;
+    if(!memcmp(p, terminator, terminator_len))
+      return p;
+    p++;
+  }
+  return NULL;
+}
+
+
+/*
+ * raptor_xmltok_prefix_match:
+ *
+ * INTERNAL - Check if [p, end) starts with a prefix
+ *
+ * Return value: 1 if matched, 0 if not, -1 if the input so far
+ *   matches but is too short to tell
+ */
+static int
+raptor_xmltok_prefix_match(const unsigned char* p, const unsigned char* end,
+                           const char* prefix, size_t prefix_len)
+{
+  size_t avail = RAPTOR_GOOD_CAST(size_t, end - p);
+
+  if(avail < prefix_len)
+    return memcmp(p, prefix, avail) ? 0 : -1;
+  return !memcmp(p, prefix, prefix_len);
+}
+
+
+static raptor_xmltok_entity*
+raptor_xmltok_find_entity(raptor_xmltok* xt, const unsigned char* name,
+                          size_t name_len)
+{
+  raptor_xmltok_entity* entity;
+
+  for(entity = xt->entities; entity; entity = entity->next) {
+    if(!strncmp((const char*)entity->name, (const char*)name, name_len) &&
+       !entity->name[name_len])
+      return entity;
+  }
+  return NULL;
+}
+
+
+/*
+ * raptor_xmltok_char_ref:
+ * @xt: tokenizer
+ * @p: reference text after "&#" up to but not including ';'
+ * @len: length
+ * @output: buffer of at least 4 bytes
+ *
+ * INTERNAL - Decode a character reference to UTF-8
+ *
+ * Return value: number of bytes written or 0 on error
+ */
+static size_t
+raptor_xmltok_char_ref(raptor_xmltok* xt, const unsigned char* p, size_t len,
+                       unsigned char* output)
+{
+  unsigned long c = 0;
+  int hex = 0;
+  size_t i = 0;
+  int rc;
+
+  if(len && *p == 'x') {
+    hex = 1;
+    i++;
+  }
+
+  if(i == len)
+    goto bad;
+
+  for(; i < len; i++) {
+    unsigned char d = p[i];
+    int v;
+
+    if(d >= '0' && d <= '9')
+      v = d - '0';
+    else if(hex && d >= 'a' && d <= 'f')
+      v = d - 'a' + 10;
+    else if(hex && d >= 'A' && d <= 'F')
+      v = d - 'A' + 10;
+    else
+      goto bad;
+
+    c = c * (hex ? 16 : 10) + RAPTOR_GOOD_CAST(unsigned long, v);
+    if(c > 0x10ffff)
+      goto bad;
+  }
+
+  /* XML 1.0 Char production */
+  if((c < 0x20 && c != 0x09 && c != 0x0a && c != 0x0d) ||
+     (c >= 0xd800 && c <= 0xdfff) || c == 0xfffe || c == 0xffff)
+    goto bad;
+
+  rc = raptor_unicode_utf8_string_put_char(RAPTOR_GOOD_CAST(raptor_unichar, c),
+                                           output, 4);
+  if(rc > 0)
+    return RAPTOR_GOOD_CAST(size_t, rc);
+
+  bad:
+  raptor_xmltok_error(xt, "Invalid character reference &#%.*s;",
+                      RAPTOR_BAD_CAST(int, len), (const char*)p);
+  return 0;
+}
+
+
+/*
+ * raptor_xmltok_predefined_entity:
+ *
+ * INTERNAL - Get the character for a predefined entity name
+ *
+ * Return value: character or 0 if not a predefined entity
+ */
+static unsigned char
+raptor_xmltok_predefined_entity(const unsigned char* name, size_t len)
+{
+  if(len == 2 && name[1] == 't') {
+    if(name[0] == 'l')
+      return '<';
+    if(name[0] == 'g')
+      return '>';
+  } else if(len == 3 && !memcmp(name, "amp", 3))
+    return '&';
+  else if(len == 4) {
+    if(!memcmp(name, "apos", 4))
+      return '\'';
+    if(!memcmp(name, "quot", 4))
+      return '"';
+  }
+  return 0;
+}
+
+
+static int
+raptor_xmltok_ensure_scratch(raptor_xmltok* xt, size_t extra)
+{
+  size_t new_size;
+  unsigned char* new_scratch;
+
+  if(xt->scratch_len + extra <= xt->scratch_size)
+    return 0;
+
+  new_size = xt->scratch_size ? xt->scratch_size : 256;
+  while(new_size < xt->scratch_len + extra)
+    new_size <<= 1;
+
+  new_scratch = RAPTOR_REALLOC(unsigned char*, xt->scratch, new_size);
+  if(!new_scratch)
+    return 1;
+
+  xt->scratch = new_scratch;
+  xt->scratch_size = new_size;
+  return 0;
+}
+
+
+/*
+ * raptor_xmltok_expand_attribute:
+ * @xt: tokenizer
+ * @p: attribute value text
+ * @len: length of value
+ *
+ * INTERNAL - Append an attribute value to scratch, expanding references
+ *
+ * Literal whitespace becomes a space as XML attribute-value
+ * normalization requires.  Entity replacement text is expanded
+ * recursively.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_xmltok_expand_attribute(raptor_xmltok* xt, const unsigned char* p,
+                               size_t len)
+{
+  const unsigned char* end = p + len;
+
+  while(p < end) {
+    const unsigned char* amp;
+    const unsigned char* semi;
+    const unsigned char* name;
+    size_t name_len;
+    raptor_xmltok_entity* entity;
+    unsigned char c;
+    int rc;
+
+    amp = (const unsigned char*)memchr(p, '&', RAPTOR_GOOD_CAST(size_t, end - p));
+    if(!amp)
+      amp = end;
+
+    if(amp > p) {
+      size_t n = RAPTOR_GOOD_CAST(size_t, amp - p);
+      unsigned char* dst;
+
+      if(raptor_xmltok_ensure_scratch(xt, n))
+        goto oom;
+      dst = xt->scratch + xt->scratch_len;
+      while(p < amp) {
+        c = *p++;
+        if(c == '<') {
+          raptor_xmltok_error(xt, "Unescaped '<' not allowed in attributes values");
+          return 1;
+        }
+        *dst++ = raptor_xmltok_is_space(c) ? ' ' : c;
+      }
+      xt->scratch_len += n;
+    }
+
+    if(amp == end)
+      break;
+
+    semi = (const unsigned char*)memchr(amp, ';', RAPTOR_GOOD_CAST(size_t, end - amp));
+    if(!semi) {
+      raptor_xmltok_error(xt, "EntityRef: expecting ';'");
+      return 1;
+    }
+    name = amp + 1;
+    name_len = RAPTOR_GOOD_CAST(size_t, semi - name);
+    p = semi + 1;
+
+    if(raptor_xmltok_ensure_scratch(xt, 4))
+      goto oom;
+
+    if(name_len && *name == '#') {
+      size_t n = raptor_xmltok_char_ref(xt, name + 1, name_len - 1,
+                                        xt->scratch + xt->scratch_len);
+      if(!n)
+        return 1;
+      xt->scratch_len += n;
+      continue;
+    }
+
+    c = raptor_xmltok_predefined_entity(name, name_len);
+    if(c) {
+      xt->scratch[xt->scratch_len++] = c;
+      continue;
+    }
+
+    entity = raptor_xmltok_find_entity(xt, name, name_len);
+    if(!entity) {
+      raptor_xmltok_error(xt, "Entity '%.*s' not defined",
+                          RAPTOR_BAD_CAST(int, name_len), (const char*)name);
+      return 1;
+    }
+    if(!entity->value) {
+      raptor_xmltok_error(xt, "Attribute references external entity '%s'",
+                          (const char*)entity->name);
+      return 1;
+    }
+    if(entity->expanding ||
+       xt->entity_depth >= RAPTOR_XMLTOK_MAX_ENTITY_DEPTH) {
+      raptor_xmltok_error(xt, "Detected an entity reference loop");
+      return 1;
+    }
+    xt->entity_expanded_len += entity->value_len;
+    if(xt->entity_expanded_len > RAPTOR_XMLTOK_MAX_ENTITY_EXPANSION) {
+      raptor_xmltok_error(xt, "Maximum entity amplification exceeded");
+      return 1;
+    }
+
+    entity->expanding = 1;
+    xt->entity_depth++;
+    rc = raptor_xmltok_expand_attribute(xt, entity->value, entity->value_len);
+    xt->entity_depth--;
+    entity->expanding = 0;
+    if(rc)
+      return 1;
+  }
+
+  return 0;
+
+  oom:
+  raptor_log_error(xt->sax2->world, RAPTOR_LOG_LEVEL_FATAL,
+                   xt->sax2->locator, "Out of memory");
+  xt->failed = 1;
+  return 1;
+}
+
+
+/*
+ * raptor_xmltok_decode_attribute:
+ * @xt: tokenizer
+ * @p: attribute value text
+ * @len: length of value
+ * @len_p: pointer to store decoded length
+ *
+ * INTERNAL - Decode an attribute value in place
+ *
+ * Only for values without user-defined entity references: the
+ * decoded value is never longer than the source.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_xmltok_decode_attribute(raptor_xmltok* xt, unsigned char* p,
+                               size_t len, size_t* len_p)
+{
+  unsigned char* src = p;
+  unsigned char* dst = p;
+  unsigned char* end = p + len;
+
+  while(src < end) {
+    unsigned char c = *src;
+
+    if(c == '&') {
+      unsigned char* semi;
+      unsigned char* name = src + 1;
+      size_t name_len;
+
+      semi = (unsigned char*)memchr(src, ';', RAPTOR_GOOD_CAST(size_t, end - src));
+      if(!semi) {
+        raptor_xmltok_error(xt, "EntityRef: expecting ';'");
+        return 1;
+      }
+      name_len = RAPTOR_GOOD_CAST(size_t, semi - name);
+      src = semi + 1;
+
+      if(name_len && *name == '#') {
+        unsigned char utf8[4];
+        size_t n = raptor_xmltok_char_ref(xt, name + 1, name_len - 1, utf8);
+        if(!n)
+          return 1;
+        memcpy(dst, utf8, n);
+        dst += n;
+      } else {
+        /* caller checked this is a predefined entity */
+        *dst++ = raptor_xmltok_predefined_entity(name, name_len);
+      }
+    } else if(c == '<') {
+      raptor_xmltok_error(xt, "Unescaped '<' not allowed in attributes values");
+      return 1;
+    } else {
+      *dst++ = raptor_xmltok_is_space(c) ? ' ' : c;
+      src++;
+    }
+  }
+
+  *len_p = RAPTOR_GOOD_CAST(size_t, dst - p);
+  return 0;
+}
+
+
+/*
+ * raptor_xmltok_needs_expansion:
+ *
+ * INTERNAL - Check if an attribute value refers to a non-predefined entity
+ */
+static int
+raptor_xmltok_needs_expansion(const unsigned char* p, size_t len)
+{
+  const unsigned char* end = p + len;
+
+  while(p < end) {
+    const unsigned char* semi;
+
+    p = (const unsigned char*)memchr(p, '&', RAPTOR_GOOD_CAST(size_t, end - p));
+    if(!p)
+      return 0;
+    p++;
+    semi = (const unsigned char*)memchr(p, ';', RAPTOR_GOOD_CAST(size_t, end - p));
+    if(!semi)
+      return 0; /* error reported when decoding */
+    if(*p != '#' &&
+       !raptor_xmltok_predefined_entity(p, RAPTOR_GOOD_CAST(size_t, semi - p)))
+      return 1;
+    p = semi + 1;
+  }
+  return 0;
+}
+
+
+/*
+ * raptor_xmltok_collapse_space:
+ * @value: NUL terminated value
+ *
+ * INTERNAL - Collapse whitespace runs and trim ends in place
+ *
+ * This is the same normalization raptor_sax2_start_element() applies
+ * to attribute values from libxml2.
+ */
+static void
+raptor_xmltok_collapse_space(unsigned char* value)
+{
+  unsigned char *src = value;
+  unsigned char *dst = value;
+
+  while(raptor_xmltok_is_space(*src))
+    src++;
+  while(*src) {
+    if(raptor_xmltok_is_space(*src)) {
+      while(raptor_xmltok_is_space(*src))
+        src++;
+      if(*src)
+        *dst++ = 0x20;
+    } else
+      *dst++ = *src++;
+  }
+  *dst = '\0';
+}
+
+
+static int
+raptor_xmltok_ensure_atts(raptor_xmltok* xt, int count)
+{
+  unsigned char** new_atts;
+  size_t* new_offsets;
+  int new_size;
+
+  if(count <= xt->atts_size)
+    return 0;
+
+  new_size = xt->atts_size ? xt->atts_size : 16;
+  while(new_size < count)
+    new_size <<= 1;
+
+  new_atts = RAPTOR_REALLOC(unsigned char**, xt->atts,
+                            RAPTOR_GOOD_CAST(size_t, new_size) * sizeof(unsigned char*));
+  if(!new_atts)
+    return 1;
+  xt->atts = new_atts;
+
+  new_offsets = RAPTOR_REALLOC(size_t*, xt->atts_offsets,
+                               RAPTOR_GOOD_CAST(size_t, new_size) * sizeof(size_t));
+  if(!new_offsets)
+    return 1;
+  xt->atts_offsets = new_offsets;
+
+  xt->atts_size = new_size;
+  return 0;
+}
+
+
+static int
+raptor_xmltok_push_name(raptor_xmltok* xt, const unsigned char* name,
+                        size_t len)
+{
+  if(xt->depth == xt->depth_size) {
+    int new_size = xt->depth_size ? (xt->depth_size << 1) : 32;
+    size_t* new_offsets;
+
+    new_offsets = RAPTOR_REALLOC(size_t*, xt->name_offsets,
+                                 RAPTOR_GOOD_CAST(size_t, new_size) * sizeof(size_t));
+    if(!new_offsets)
+      return 1;
+    xt->name_offsets = new_offsets;
+    xt->depth_size = new_size;
+  }
+
+  if(xt->names_len + len + 1 > xt->names_size) {
+    size_t new_size = xt->names_size ? xt->names_size : 512;
+    unsigned char* new_names;
+
+    while(new_size < xt->names_len + len + 1)
+      new_size <<= 1;
+    new_names = RAPTOR_REALLOC(unsigned char*, xt->names, new_size);
+    if(!new_names)
+      return 1;
+    xt->names = new_names;
+    xt->names_size = new_size;
+  }
+
+  xt->name_offsets[xt->depth++] = xt->names_len;
+  memcpy(xt->names + xt->names_len, name, len + 1);
+  xt->names_len += len + 1;
+
+  return 0;
+}
+
+
+static void
+raptor_xmltok_pop_name(raptor_xmltok* xt)
+{
+  xt->names_len = xt->name_offsets[--xt->depth];
+}
+
+
+/*
+ * raptor_xmltok_end_element:
+ *
+ * INTERNAL - Close the current element
+ */
+static void
+raptor_xmltok_end_element(raptor_xmltok* xt, const unsigned char* name,
+                          int in_entity)
+{
+  raptor_sax2_end_element(xt->sax2, name);
+  raptor_xmltok_pop_name(xt);
+
+  if(!xt->depth && !in_entity)
+    xt->state = RAPTOR_XMLTOK_STATE_EPILOG;
+}
+
+
+/*
+ * raptor_xmltok_start_tag:
+ * @xt: tokenizer
+ * @p: start of tag '<'
+ * @end: the closing '>'
+ * @in_entity: non-0 if inside entity replacement text
+ *
+ * INTERNAL - Handle a start tag or empty element tag
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_xmltok_start_tag(raptor_xmltok* xt, unsigned char* p,
+                        unsigned char* end, int in_entity)
+{
+  unsigned char* name = p + 1;
+  unsigned char* name_end;
+  unsigned char* limit = end;
+  unsigned char* q;
+  int empty = 0;
+  int count = 0;
+  int need_scratch = 0;
+  int i;
+
+  if(xt->state == RAPTOR_XMLTOK_STATE_EPILOG) {
+    raptor_xmltok_error(xt, "Extra content at the end of the document");
+    return 1;
+  }
+
+  if(end[-1] == '/' && end - 1 > name) {
+    empty = 1;
+    limit = end - 1;
+  }
+
+  name_end = raptor_xmltok_scan_name(name, limit);
+  if(!name_end) {
+    raptor_xmltok_error(xt, "StartTag: invalid element name");
+    return 1;
+  }
+
+  xt->scratch_len = 0;
+  q = name_end;
+  while(1) {
+    unsigned char* att_name;
+    unsigned char* att_name_end;
+    unsigned char* value;
+    unsigned char quote;
+    unsigned char* close;
+    size_t value_len;
+
+    att_name = raptor_xmltok_skip_space(q, limit);
+    if(att_name == limit)
+      break;
+    if(att_name == q) {
+      raptor_xmltok_error(xt, "attributes construct error");
+      return 1;
+    }
+
+    att_name_end = raptor_xmltok_scan_name(att_name, limit);
+    if(!att_name_end) {
+      raptor_xmltok_error(xt, "error parsing attribute name");
+      return 1;
+    }
+
+    q = raptor_xmltok_skip_space(att_name_end, limit);
+    if(q == limit || *q != '=') {
+      raptor_xmltok_error(xt, "Specification mandates value for attribute %.*s",
+                          RAPTOR_BAD_CAST(int, att_name_end - att_name),
+                          (const char*)att_name);
+      return 1;
+    }
+    q = raptor_xmltok_skip_space(q + 1, limit);
+    if(q == limit || (*q != '"' && *q != '\'')) {
+      raptor_xmltok_error(xt, "AttValue: \" or ' expected");
+      return 1;
+    }
+    quote = *q;
+    value = q + 1;
+    close = (unsigned char*)memchr(value, quote,
+                                   RAPTOR_GOOD_CAST(size_t, limit - value));
+    if(!close) {
+      raptor_xmltok_error(xt, "AttValue: ' expected");
+      return 1;
+    }
+    q = close + 1;
+
+    /* terminate name (it may end at the '=') after using it */
+    *att_name_end = '\0';
+
+    for(i = 0; i < count; i++) {
+      if(!strcmp((const char*)xt->atts[i << 1], (const char*)att_name)) {
+        raptor_xmltok_error(xt, "Attribute %s redefined",
+                            (const char*)att_name);
+        return 1;
+      }
+    }
+
+    if(raptor_xmltok_ensure_atts(xt, (count + 1) << 1 | 1))
+      goto oom;
+
+    value_len = RAPTOR_GOOD_CAST(size_t, close - value);
+    xt->atts[count << 1] = att_name;
+    if(raptor_xmltok_needs_expansion(value, value_len)) {
+      /* user entity: the expansion may be longer than the source */
+      xt->atts_offsets[count] = xt->scratch_len;
+      if(raptor_xmltok_expand_attribute(xt, value, value_len))
+        return 1;
+      if(raptor_xmltok_ensure_scratch(xt, 1))
+        goto oom;
+      xt->scratch[xt->scratch_len++] = '\0';
+      xt->atts[(count << 1) + 1] = NULL;
+      need_scratch = 1;
+    } else {
+      if(raptor_xmltok_decode_attribute(xt, value, value_len, &value_len))
+        return 1;
+      value[value_len] = '\0';
+      xt->atts_offsets[count] = (size_t)-1;
+      xt->atts[(count << 1) + 1] = value;
+    }
+    count++;
+  }
+
+  *name_end = '\0';
+
+  if(count) {
+    /* scratch may have moved while values were added */
+    for(i = 0; i < count; i++) {
+      unsigned char* value;
+
+      if(need_scratch && xt->atts_offsets[i] != (size_t)-1)
+        xt->atts[(i << 1) + 1] = xt->scratch + xt->atts_offsets[i];
+      value = xt->atts[(i << 1) + 1];
+      raptor_xmltok_collapse_space(value);
+    }
+    xt->atts[count << 1] = NULL;
+  }
+
+  if(raptor_xmltok_push_name(xt, name, RAPTOR_GOOD_CAST(size_t, name_end - name)))
+    goto oom;
+
+  if(xt->state == RAPTOR_XMLTOK_STATE_PROLOG)
+    xt->state = RAPTOR_XMLTOK_STATE_CONTENT;
+
+  raptor_sax2_start_element(xt->sax2, name,
+                            count ? (const unsigned char**)xt->atts : NULL);
+
+  if(empty)
+    raptor_xmltok_end_element(xt, name, in_entity);
+
+  return 0;
+
+  oom:
+  raptor_log_error(xt->sax2->world, RAPTOR_LOG_LEVEL_FATAL,
+                   xt->sax2->locator, "Out of memory");
+  xt->failed = 1;
+  return 1;
+}
+
+
+/*
+ * raptor_xmltok_end_tag:
+ * @xt: tokenizer
+ * @p: start of tag '<'
+ * @end: the closing '>'
+ * @in_entity: non-0 if inside entity replacement text
+ * @entity_depth: element depth at start of entity expansion
+ *
+ * INTERNAL - Handle an end tag
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_xmltok_end_tag(raptor_xmltok* xt, unsigned char* p, unsigned char* end,
+                      int in_entity, int entity_depth)
+{
+  unsigned char* name = p + 2;
+  unsigned char* name_end;
+  const unsigned char* open_name;
+
+  name_end = raptor_xmltok_scan_name(name, end);
+  if(!name_end || raptor_xmltok_skip_space(name_end, end) != end) {
+    raptor_xmltok_error(xt, "expected '>'");
+    return 1;
+  }
+  *name_end = '\0';
+
+  if(xt->depth <= entity_depth) {
+    raptor_xmltok_error(xt, "Unexpected end tag : %s", (const char*)name);
+    return 1;
+  }
+
+  open_name = xt->names + xt->name_offsets[xt->depth - 1];
+  if(strcmp((const char*)open_name, (const char*)name)) {
+    raptor_xmltok_error(xt, "Opening and ending tag mismatch: %s and %s",
+                        (const char*)open_name, (const char*)name);
+    return 1;
+  }
+
+  raptor_xmltok_end_element(xt, name, in_entity);
+  return 0;
+}
+
+
+/*
+ * raptor_xmltok_entity_ref:
+ * @xt: tokenizer
+ * @name: entity name
+ * @name_len: length of name
+ *
+ * INTERNAL - Expand a user-defined entity reference in content
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_xmltok_entity_ref(raptor_xmltok* xt, const unsigned char* name,
+                         size_t name_len)
+{
+  raptor_xmltok_entity* entity;
+  unsigned char* copy;
+  size_t used = 0;
+  int start_depth;
+  int rc;
+
+  entity = raptor_xmltok_find_entity(xt, name, name_len);
+  if(!entity) {
+    raptor_xmltok_error(xt, "Entity '%.*s' not defined",
+                        RAPTOR_BAD_CAST(int, name_len), (const char*)name);
+    return 1;
+  }
+
+  /* External parsed entities are never loaded */
+  if(!entity->value || !entity->value_len)
+    return 0;
+
+  if(entity->expanding ||
+     xt->entity_depth >= RAPTOR_XMLTOK_MAX_ENTITY_DEPTH) {
+    raptor_xmltok_error(xt, "Detected an entity reference loop");
+    return 1;
+  }
+
+  xt->entity_expanded_len += entity->value_len;
+  if(xt->entity_expanded_len > RAPTOR_XMLTOK_MAX_ENTITY_EXPANSION) {
+    raptor_xmltok_error(xt, "Maximum entity amplification exceeded");
+    return 1;
+  }
+
+  /* The tokenizer writes into the text it parses so use a copy */
+  copy = RAPTOR_MALLOC(unsigned char*, entity->value_len + 1);
+  if(!copy) {
+    raptor_log_error(xt->sax2->world, RAPTOR_LOG_LEVEL_FATAL,
+                     xt->sax2->locator, "Out of memory");
+    xt->failed = 1;
+    return 1;
+  }
+  memcpy(copy, entity->value, entity->value_len + 1);
+
+  start_depth = xt->depth;
+  entity->expanding = 1;
+  xt->entity_depth++;
+
+  rc = raptor_xmltok_parse_buffer(xt, copy, entity->value_len, 1, start_depth,
+                                  &used);
+
+  xt->entity_depth--;
+  entity->expanding = 0;
+  RAPTOR_FREE(char*, copy);
+
+  if(!rc && xt->depth != start_depth) {
+    raptor_xmltok_error(xt, "Entity '%s' failed to parse: unbalanced elements",
+                        (const char*)entity->name);
+    rc = 1;
+  }
+
+  return rc;
+}
+
+
+/*
+ * raptor_xmltok_text:
+ * @xt: tokenizer
+ * @p: text
+ * @len: length of text (does not end inside a reference)
+ * @in_entity: non-0 if inside entity replacement text
+ *
+ * INTERNAL - Handle character data and references
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_xmltok_text(raptor_xmltok* xt, unsigned char* p, size_t len,
+                   int in_entity)
+{
+  unsigned char* end = p + len;
+
+  if(!xt->depth) {
+    /* Only whitespace is allowed outside the root element */
+    for(; p < end; p++) {
+      if(!raptor_xmltok_is_space(*p)) {
+        if(xt->state == RAPTOR_XMLTOK_STATE_EPILOG)
+          raptor_xmltok_error(xt, "Extra content at the end of the document");
+        else
+          raptor_xmltok_error(xt, "Start tag expected, '<' not found");
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+  while(p < end && !xt->failed) {
+    unsigned char* amp;
+    unsigned char* semi;
+    unsigned char* name;
+    size_t name_len;
+    unsigned char c;
+
+    amp = (unsigned char*)memchr(p, '&', RAPTOR_GOOD_CAST(size_t, end - p));
+    if(!amp)
+      amp = end;
+
+    if(amp > p)
+      raptor_sax2_characters(xt->sax2, p, RAPTOR_BAD_CAST(int, amp - p));
+
+    if(amp == end)
+      break;
+
+    semi = (unsigned char*)memchr(amp, ';', RAPTOR_GOOD_CAST(size_t, end - amp));
+    if(!semi) {
+      raptor_xmltok_error(xt, "EntityRef: expecting ';'");
+      return 1;
+    }
+    name = amp + 1;
+    name_len = RAPTOR_GOOD_CAST(size_t, semi - name);
+    p = semi + 1;
+
+    if(name_len && *name == '#') {
+      unsigned char utf8[4];
+      size_t n = raptor_xmltok_char_ref(xt, name + 1, name_len - 1, utf8);
+      if(!n)
+        return 1;
+      raptor_sax2_characters(xt->sax2, utf8, RAPTOR_BAD_CAST(int, n));
+      continue;
+    }
+
+    c = raptor_xmltok_predefined_entity(name, name_len);
+    if(c) {
+      raptor_sax2_characters(xt->sax2, &c, 1);
+      continue;
+    }
+
+    if(!name_len || !raptor_xmltok_is_name_start(*name)) {
+      raptor_xmltok_error(xt, "EntityRef: expecting name");
+      return 1;
+    }
+
+    if(raptor_xmltok_entity_ref(xt, name, name_len))
+      return 1;
+  }
+
+  return xt->failed;
+}
+
+
+/*
+ * raptor_xmltok_parse_literal:
+ *
+ * INTERNAL - Parse a quoted literal in a declaration
+ *
+ * Return value: pointer after the closing quote or NULL on failure
+ */
+static unsigned char*
+raptor_xmltok_parse_literal(unsigned char* p, unsigned char* end,
+                            unsigned char** value_p, size_t* len_p)
+{
+  unsigned char* close;
+
+  if(p >= end || (*p != '"' && *p != '\''))
+    return NULL;
+
+  close = (unsigned char*)memchr(p + 1, *p, RAPTOR_GOOD_CAST(size_t, end - p - 1));
+  if(!close)
+    return NULL;
+
+  *value_p = p + 1;
+  *len_p = RAPTOR_GOOD_CAST(size_t, close - p - 1);
+  return close + 1;
+}
+
+
+/*
+ * raptor_xmltok_entity_decl:
+ * @xt: tokenizer
+ * @p: text after "<!ENTITY"
+ * @end: the closing '>'
+ *
+ * INTERNAL - Handle an entity declaration in the internal subset
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_xmltok_entity_decl(raptor_xmltok* xt, unsigned char* p,
+                          unsigned char* end)
+{
+  unsigned char* name;
+  unsigned char* name_end;
+  unsigned char* value = NULL;
+  size_t value_len = 0;
+  unsigned char* system_id = NULL;
+  size_t system_id_len = 0;
+  unsigned char* public_id = NULL;
+  size_t public_id_len = 0;
+  unsigned char* notation = NULL;
+  unsigned char* notation_end = NULL;
+  raptor_xmltok_entity* entity;
+  int is_parameter = 0;
+
+  p = raptor_xmltok_skip_space(p, end);
+  if(p < end && *p == '%') {
+    is_parameter = 1;
+    p = raptor_xmltok_skip_space(p + 1, end);
+  }
+
+  name = p;
+  name_end = raptor_xmltok_scan_name(p, end);
+  if(!name_end)
+    goto bad;
+  p = raptor_xmltok_skip_space(name_end, end);
+
+  if(p < end && (*p == '"' || *p == '\'')) {
+    p = raptor_xmltok_parse_literal(p, end, &value, &value_len);
+  } else if(end - p > 6 && !memcmp(p, "SYSTEM", 6)) {
+    p = raptor_xmltok_skip_space(p + 6, end);
+    p = raptor_xmltok_parse_literal(p, end, &system_id, &system_id_len);
+  } else if(end - p > 6 && !memcmp(p, "PUBLIC", 6)) {
+    p = raptor_xmltok_skip_space(p + 6, end);
+    p = raptor_xmltok_parse_literal(p, end, &public_id, &public_id_len);
+    if(p) {
+      p = raptor_xmltok_skip_space(p, end);
+      p = raptor_xmltok_parse_literal(p, end, &system_id, &system_id_len);
+    }
+  } else
+    p = NULL;
+  if(!p)
+    goto bad;
+
+  p = raptor_xmltok_skip_space(p, end);
+  if(!value && end - p > 5 && !memcmp(p, "NDATA", 5)) {
+    notation = raptor_xmltok_skip_space(p + 5, end);
+    notation_end = raptor_xmltok_scan_name(notation, end);
+    if(!notation_end)
+      goto bad;
+    p = raptor_xmltok_skip_space(notation_end, end);
+  }
+  if(p != end)
+    goto bad;
+
+  /* Parameter entities are only used inside the DTD, which is not
+   * interpreted beyond entity declarations
+   */
+  if(is_parameter)
+    return 0;
+
+  *name_end = '\0';
+
+  if(notation) {
+    *notation_end = '\0';
+    if(system_id)
+      system_id[system_id_len] = '\0';
+    if(public_id)
+      public_id[public_id_len] = '\0';
+    raptor_sax2_unparsed_entity_decl(xt->sax2, name, NULL, system_id,
+                                     public_id, notation);
+    return 0;
+  }
+
+  /* The first declaration is binding */
+  if(raptor_xmltok_find_entity(xt, name, RAPTOR_GOOD_CAST(size_t, name_end - name)))
+    return 0;
+
+  entity = RAPTOR_CALLOC(raptor_xmltok_entity*, 1, sizeof(*entity));
+  if(!entity)
+    goto oom;
+  entity->next = xt->entities;
+  xt->entities = entity;
+
+  entity->name = RAPTOR_MALLOC(unsigned char*,
+                               RAPTOR_GOOD_CAST(size_t, name_end - name) + 1);
+  if(!entity->name)
+    goto oom;
+  memcpy(entity->name, name, RAPTOR_GOOD_CAST(size_t, name_end - name) + 1);
+
+  if(value) {
+    /* Expand character references now; entity references are
+     * expanded when the entity is used
+     */
+    unsigned char* src = value;
+    unsigned char* src_end = value + value_len;
+    unsigned char* dst;
+
+    entity->value = RAPTOR_MALLOC(unsigned char*, value_len + 1);
+    if(!entity->value)
+      goto oom;
+    dst = entity->value;
+
+    while(src < src_end) {
+      if(*src == '&' && src + 1 < src_end && src[1] == '#') {
+        unsigned char* semi;
+        size_t n;
+
+        semi = (unsigned char*)memchr(src, ';', RAPTOR_GOOD_CAST(size_t, src_end - src));
+        if(!semi) {
+          raptor_xmltok_error(xt, "CharRef: invalid decimal value");
+          return 1;
+        }
+        n = raptor_xmltok_char_ref(xt, src + 2,
+                                   RAPTOR_GOOD_CAST(size_t, semi - src - 2),
+                                   dst);
+        if(!n)
+          return 1;
+        dst += n;
+        src = semi + 1;
+      } else
+        *dst++ = *src++;
+    }
+    *dst = '\0';
+    entity->value_len = RAPTOR_GOOD_CAST(size_t, dst - entity->value);
+  }
+
+  return 0;
+
+  bad:
+  raptor_xmltok_error(xt, "Malformed entity declaration");
+  return 1;
+
+  oom:
+  raptor_log_error(xt->sax2->world, RAPTOR_LOG_LEVEL_FATAL,
+                   xt->sax2->locator, "Out of memory");
+  xt->failed = 1;
+  return 1;
+}
+
+
+/*
+ * raptor_xmltok_find_decl_end:
+ * @p: start of text after '<!' or '<!DOCTYPE'
+ * @end: end of input
+ *
+ * INTERNAL - Find the '>' ending a declaration
+ *
+ * Skips quoted literals, comments and a bracketed internal subset.
+ *
+ * Return value: pointer to the '>' or NULL if not found yet
+ */
+static unsigned char*
+raptor_xmltok_find_decl_end(unsigned char* p, unsigned char* end)
+{
+  int in_subset = 0;
+
+  while(p < end) {
+    unsigned char c = *p;
+
+    if(c == '"' || c == '\'') {
+      p = (unsigned char*)memchr(p + 1, c, RAPTOR_GOOD_CAST(size_t, end - p - 1));
+      if(!p)
+        return NULL;
+    } else if(in_subset && c == '<') {
+      int m = raptor_xmltok_prefix_match(p, end, "<!--", 4);
+
+      if(m < 0)
+        return NULL;
+      if(m > 0) {
+        p = raptor_xmltok_find(p + 4, end, "-->", 3);
+        if(!p)
+          return NULL;
+        p += 2;
+      }
+    } else if(c == '[')
+      in_subset = 1;
+    else if(c == ']')
+      in_subset = 0;
+    else if(c == '>' && !in_subset)
+      return p;
+
+    p++;
+  }
+
+  return NULL;
+}
+
+
+/*
+ * raptor_xmltok_doctype:
+ * @xt: tokenizer
+ * @p: text after "<!DOCTYPE"
+ * @end: the closing '>'
+ *
+ * INTERNAL - Handle a document type declaration
+ *
+ * Only entity declarations in the internal subset are used.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_xmltok_doctype(raptor_xmltok* xt, unsigned char* p, unsigned char* end)
+{
+  unsigned char* subset;
+  unsigned char* subset_end;
+
+  if(xt->state != RAPTOR_XMLTOK_STATE_PROLOG || xt->seen_doctype) {
+    raptor_xmltok_error(xt, "DOCTYPE improperly terminated");
+    return 1;
+  }
+  xt->seen_doctype = 1;
+
+  subset = (unsigned char*)memchr(p, '[', RAPTOR_GOOD_CAST(size_t, end - p));
+  if(!subset)
+    return 0;
+
+  /* find the matching ']' - the last one before the end */
+  for(subset_end = end; subset_end > subset && *subset_end != ']'; subset_end--)
+    ;
+  if(subset_end == subset) {
+    raptor_xmltok_error(xt, "DOCTYPE internal subset not terminated");
+    return 1;
+  }
+
+  p = subset + 1;
+  while(1) {
+    unsigned char* decl_end;
+
+    p = raptor_xmltok_skip_space(p, subset_end);
+    if(p == subset_end)
+      break;
+
+    if(*p == '%') {
+      /* parameter entity reference - ignored */
+      p = (unsigned char*)memchr(p, ';', RAPTOR_GOOD_CAST(size_t, subset_end - p));
+      if(!p)
+        goto bad;
+      p++;
+      continue;
+    }
+
+    if(raptor_xmltok_prefix_match(p, subset_end, "<!--", 4) > 0) {
+      p = raptor_xmltok_find(p + 4, subset_end, "-->", 3);
+      if(!p)
+        goto bad;
+      p += 3;
+      continue;
+    }
+
+    if(raptor_xmltok_prefix_match(p, subset_end, "<?", 2) > 0) {
+      p = raptor_xmltok_find(p + 2, subset_end, "?>", 2);
+      if(!p)
+        goto bad;
+      p += 2;
+      continue;
+    }
+
+    if(raptor_xmltok_prefix_match(p, subset_end, "<!", 2) <= 0)
+      goto bad;
+
+    decl_end = raptor_xmltok_find_decl_end(p + 2, subset_end);
+    if(!decl_end)
+      goto bad;
+
+    if(raptor_xmltok_prefix_match(p, decl_end, "<!ENTITY", 8) > 0 &&
+       p + 8 < decl_end && raptor_xmltok_is_space(p[8])) {
+      if(raptor_xmltok_entity_decl(xt, p + 8, decl_end))
+        return 1;
+    }
+    /* ELEMENT, ATTLIST and NOTATION declarations are not used */
+
+    p = decl_end + 1;
+  }
+
+  return 0;
+
+  bad:
+  raptor_xmltok_error(xt, "Malformed DOCTYPE internal subset");
+  return 1;
+}
+
+
+/*
+ * raptor_xmltok_parse_buffer:
+ * @xt: tokenizer
+ * @buf: UTF-8 text; modified in place
+ * @len: length of text
+ * @is_end: non-0 if no more text follows
+ * @entity_depth: element depth at start of entity expansion or -1 for
+ *   the document itself
+ * @used_p: pointer to store number of bytes consumed
+ *
+ * INTERNAL - Tokenize as much of a buffer as possible
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_xmltok_parse_buffer(raptor_xmltok* xt, unsigned char* buf, size_t len,
+                           int is_end, int entity_depth, size_t* used_p)
+{
+  unsigned char* p = buf;
+  unsigned char* end = buf + len;
+  int in_entity = (entity_depth >= 0);
+  int min_depth = in_entity ? entity_depth : 0;
+
+  while(p < end && !xt->failed) {
+    unsigned char* token_end;
+    int m;
+
+    if(*p != '<') {
+      unsigned char* text_end;
+
+      text_end = (unsigned char*)memchr(p, '<', RAPTOR_GOOD_CAST(size_t, end - p));
+      if(!text_end) {
+        text_end = end;
+        if(!is_end) {
+          /* Hold back a reference that may continue in the next chunk */
+          unsigned char* amp = text_end;
+
+          while(amp > p && amp[-1] != '&' && amp[-1] != ';')
+            amp--;
+          if(amp > p && amp[-1] == '&')
+            text_end = amp - 1;
+        }
+      }
+      if(text_end == p)
+        break;
+
+      if(!in_entity)
+        raptor_xmltok_count_lines(xt, p, text_end);
+      if(raptor_xmltok_text(xt, p, RAPTOR_GOOD_CAST(size_t, text_end - p),
+                            in_entity))
+        break;
+      p = text_end;
+      continue;
+    }
+
+    if(end - p < 2) {
+      if(is_end)
+        raptor_xmltok_error(xt, "StartTag: invalid element name");
+      break;
+    }
+
+    token_end = NULL;
+    if(p[1] == '/') {
+      token_end = (unsigned char*)memchr(p, '>', RAPTOR_GOOD_CAST(size_t, end - p));
+      if(!token_end)
+        goto incomplete;
+      if(!in_entity)
+        raptor_xmltok_count_lines(xt, p, token_end);
+      if(raptor_xmltok_end_tag(xt, p, token_end, in_entity, min_depth))
+        break;
+      p = token_end + 1;
+
+    } else if(p[1] == '?') {
+      unsigned char* target_end;
+
+      token_end = raptor_xmltok_find(p + 2, end, "?>", 2);
+      if(!token_end)
+        goto incomplete;
+      if(!in_entity)
+        raptor_xmltok_count_lines(xt, p, token_end);
+      target_end = raptor_xmltok_scan_name(p + 2, token_end);
+      if(!target_end) {
+        raptor_xmltok_error(xt, "xmlParsePI : no target name");
+        break;
+      }
+      if(target_end - p == 5 &&
+         (p[2] == 'x' || p[2] == 'X') && (p[3] == 'm' || p[3] == 'M') &&
+         (p[4] == 'l' || p[4] == 'L')) {
+        raptor_xmltok_error(xt, "XML declaration allowed only at the start of the document");
+        break;
+      }
+      /* processing instructions are ignored */
+      p = token_end + 2;
+
+    } else if(p[1] == '!') {
+      m = raptor_xmltok_prefix_match(p, end, "<!--", 4);
+      if(m < 0)
+        goto incomplete;
+      if(m > 0) {
+        unsigned char* dashes;
+
+        token_end = raptor_xmltok_find(p + 4, end, "-->", 3);
+        if(!token_end)
+          goto incomplete;
+        if(!in_entity)
+          raptor_xmltok_count_lines(xt, p, token_end);
+        dashes = raptor_xmltok_find(p + 4, token_end + 2, "--", 2);
+        if(dashes != token_end) {
+          raptor_xmltok_error(xt, "Double hyphen within comment");
+          break;
+        }
+        *token_end = '\0';
+        raptor_sax2_comment(xt->sax2, p + 4);
+        p = token_end + 3;
+        continue;
+      }
+
+      m = raptor_xmltok_prefix_match(p, end, "<![CDATA[", 9);
+      if(m < 0)
+        goto incomplete;
+      if(m > 0) {
+        token_end = raptor_xmltok_find(p + 9, end, "]]>", 3);
+        if(!token_end)
+          goto incomplete;
+        if(!in_entity)
+          raptor_xmltok_count_lines(xt, p, token_end);
+        if(xt->depth <= min_depth && !in_entity) {
+          raptor_xmltok_error(xt, "Extra content at the end of the document");
+          break;
+        }
+        if(token_end > p + 9)
+          raptor_sax2_cdata(xt->sax2, p + 9,
+                            RAPTOR_BAD_CAST(int, token_end - (p + 9)));
+        p = token_end + 3;
+        continue;
+      }
+
+      m = raptor_xmltok_prefix_match(p, end, "<!DOCTYPE", 9);
+      if(m < 0)
+        goto incomplete;
+      if(m > 0 && !in_entity) {
+        token_end = raptor_xmltok_find_decl_end(p + 9, end);
+        if(!token_end)
+          goto incomplete;
+        raptor_xmltok_count_lines(xt, p, token_end);
+        if(raptor_xmltok_doctype(xt, p + 9, token_end))
+          break;
+        p = token_end + 1;
+        continue;
+      }
+
+      raptor_xmltok_error(xt, "StartTag: invalid element name");
+      break;
+
+    } else {
+      /* start tag: find the '>' outside attribute values */
+      unsigned char* q = p + 1;
+
+      while(q < end && *q != '>') {
+        if(*q == '"' || *q == '\'') {
+          q = (unsigned char*)memchr(q + 1, *q, RAPTOR_GOOD_CAST(size_t, end - q - 1));
+          if(!q)
+            break;
+        } else if(*q == '<') {
+          raptor_xmltok_error(xt, "Couldn't find end of Start Tag");
+          break;
+        }
+        q++;
+      }
+      if(xt->failed)
+        break;
+      if(!q || q == end)
+        goto incomplete;
+      token_end = q;
+      if(!in_entity)
+        raptor_xmltok_count_lines(xt, p, token_end);
+      if(raptor_xmltok_start_tag(xt, p, token_end, in_entity))
+        break;
+      p = token_end + 1;
+    }
+    continue;
+
+    incomplete:
+    if(is_end) {
+      if(!in_entity)
+        raptor_xmltok_count_lines(xt, p, end);
+      raptor_xmltok_error(xt, "Premature end of data in tag");
+    }
+    break;
+  }
+
+  *used_p = RAPTOR_GOOD_CAST(size_t, p - buf);
+  return xt->failed;
+}
+
+
+/*
+ * raptor_xmltok_encoding_from_name:
+ *
+ * INTERNAL - Map an XML declaration encoding name
+ *
+ * Return value: 0 on success, non-0 if the encoding is unsupported
+ */
+static int
+raptor_xmltok_encoding_from_name(raptor_xmltok* xt,
+                                 const unsigned char* name, size_t len)
+{
+  static const char* const utf8_names[] = {
+    "UTF-8", "UTF8", "US-ASCII", "ASCII", NULL
+  };
+  static const char* const latin1_names[] = {
+    "ISO-8859-1", "ISO_8859-1", "ISO8859-1", "LATIN1", "ISO-LATIN-1", NULL
+  };
+  int i;
+
+  for(i = 0; utf8_names[i]; i++) {
+    if(strlen(utf8_names[i]) == len &&
+       !raptor_strncasecmp((const char*)name, utf8_names[i], len)) {
+      xt->encoding = RAPTOR_XMLTOK_ENCODING_UTF8;
+      return 0;
+    }
+  }
+
+  for(i = 0; latin1_names[i]; i++) {
+    if(strlen(latin1_names[i]) == len &&
+       !raptor_strncasecmp((const char*)name, latin1_names[i], len)) {
+      xt->encoding = RAPTOR_XMLTOK_ENCODING_LATIN1;
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+
+/*
+ * raptor_xmltok_start:
+ * @xt: tokenizer
+ * @is_end: non-0 if no more input follows
+ *
+ * INTERNAL - Handle a byte order mark and XML declaration
+ *
+ * In START state the buffer holds raw input.  Once the encoding is
+ * known the rest of the raw input is converted.
+ *
+ * Return value: <0 on failure, 0 if more input is needed, >0 when done
+ */
+static int
+raptor_xmltok_start(raptor_xmltok* xt, int is_end)
+{
+  unsigned char* p = xt->buffer;
+  unsigned char* end = xt->buffer + xt->buffer_len;
+  unsigned char* rest;
+  unsigned char* rest_copy = NULL;
+  size_t rest_len;
+  int m;
+
+  if(xt->buffer_len < 4 && !is_end)
+    return 0;
+
+  if(xt->buffer_len >= 2 &&
+     ((p[0] == 0xfe && p[1] == 0xff) || (p[0] == 0xff && p[1] == 0xfe) ||
+      (p[0] == '<' && p[1] == 0) || (p[0] == 0 && p[1] == '<'))) {
+    raptor_xmltok_error(xt, "Unsupported encoding UTF-16");
+    return -1;
+  }
+
+  /* UTF-8 byte order mark */
+  if(xt->buffer_len >= 3 && p[0] == 0xef && p[1] == 0xbb && p[2] == 0xbf)
+    p += 3;
+
+  rest = p;
+  m = raptor_xmltok_prefix_match(p, end, "<?xml", 5);
+  if((m < 0 || (m > 0 && p + 5 == end)) && !is_end)
+    return 0;
+  if(m > 0 && p + 5 < end && raptor_xmltok_is_space(p[5])) {
+    unsigned char* decl_end;
+    unsigned char* q;
+    int seen_version = 0;
+
+    decl_end = raptor_xmltok_find(p + 5, end, "?>", 2);
+    if(!decl_end) {
+      if(!is_end)
+        return 0;
+      raptor_xmltok_error(xt, "parsing XML declaration: '?>' expected");
+      return -1;
+    }
+
+    /* pseudo-attributes: version, encoding, standalone */
+    q = p + 5;
+    while(1) {
+      unsigned char* name;
+      unsigned char* name_end;
+      unsigned char* value;
+      size_t value_len;
+
+      name = raptor_xmltok_skip_space(q, decl_end);
+      if(name == decl_end)
+        break;
+      name_end = raptor_xmltok_scan_name(name, decl_end);
+      if(!name_end)
+        goto bad_decl;
+      q = raptor_xmltok_skip_space(name_end, decl_end);
+      if(q == decl_end || *q != '=')
+        goto bad_decl;
+      q = raptor_xmltok_skip_space(q + 1, decl_end);
+      q = raptor_xmltok_parse_literal(q, decl_end, &value, &value_len);
+      if(!q)
+        goto bad_decl;
+
+      if(name_end - name == 7 && !memcmp(name, "version", 7)) {
+        size_t i;
+
+        /* VersionNum ::= '1.' [0-9]+ */
+        if(value_len < 3 || value[0] != '1' || value[1] != '.')
+          goto bad_decl;
+        for(i = 2; i < value_len; i++) {
+          if(value[i] < '0' || value[i] > '9')
+            goto bad_decl;
+        }
+        seen_version = 1;
+      }
+      else if(name_end - name == 8 && !memcmp(name, "encoding", 8)) {
+        if(raptor_xmltok_encoding_from_name(xt, value, value_len)) {
+          raptor_xmltok_error(xt, "Unsupported encoding %.*s",
+                              RAPTOR_BAD_CAST(int, value_len),
+                              (const char*)value);
+          return -1;
+        }
+      }
+    }
+
+    if(!seen_version) {
+      bad_decl:
+      raptor_xmltok_error(xt, "Malformed declaration expecting version");
+      return -1;
+    }
+
+    raptor_xmltok_count_lines(xt, p, decl_end);
+    rest = decl_end + 2;
+  }
+
+  /* Convert the remaining raw input */
+  rest_len = RAPTOR_GOOD_CAST(size_t, end - rest);
+  if(rest_len) {
+    rest_copy = RAPTOR_MALLOC(unsigned char*, rest_len);
+    if(!rest_copy)
+      goto oom;
+    memcpy(rest_copy, rest, rest_len);
+  }
+
+  xt->buffer_len = 0;
+  xt->state = RAPTOR_XMLTOK_STATE_PROLOG;
+
+  if(rest_copy) {
+    int rc = raptor_xmltok_append(xt, rest_copy, rest_len);
+    RAPTOR_FREE(char*, rest_copy);
+    if(rc)
+      goto oom;
+  }
+
+  return 1;
+
+  oom:
+  raptor_log_error(xt->sax2->world, RAPTOR_LOG_LEVEL_FATAL,
+                   xt->sax2->locator, "Out of memory");
+  xt->failed = 1;
+  return -1;
+}
+
+
+/*
+ * raptor_xmltok_validate:
+ * @xt: tokenizer
+ * @is_end: non-0 if no more input follows
+ *
+ * INTERNAL - Check new buffer content is UTF-8 of XML 1.0 characters
+ *
+ * A multi-byte sequence split across chunks is left for the next call.
+ *
+ * Return value: non-0 on failure
+ */
+static int
+raptor_xmltok_validate(raptor_xmltok* xt, int is_end)
+{
+  unsigned char* p = xt->buffer + xt->valid_len;
+  unsigned char* end = xt->buffer + xt->buffer_len;
+
+  while(p < end) {
+    unsigned char c = *p;
+    unsigned long uc;
+    size_t n;
+    size_t i;
+
+    if(c >= 0x20 && c < 0x80) {
+      p++;
+      continue;
+    }
+
+    if(c < 0x20) {
+      if(c == 0x09 || c == 0x0a) {
+        p++;
+        continue;
+      }
+      raptor_xmltok_count_lines(xt, xt->buffer + xt->valid_len, p);
+      raptor_xmltok_error(xt, "Char 0x%X out of allowed range", c);
+      return 1;
+    }
+
+    if((c & 0xe0) == 0xc0) {
+      n = 2;
+      uc = c & 0x1f;
+    } else if((c & 0xf0) == 0xe0) {
+      n = 3;
+      uc = c & 0x0f;
+    } else if((c & 0xf8) == 0xf0) {
+      n = 4;
+      uc = c & 0x07;
+    } else
+      goto bad;
+
+    if(p + n > end) {
+      if(is_end)
+        goto bad;
+      break;
+    }
+
+    for(i = 1; i < n; i++) {
+      if((p[i] & 0xc0) != 0x80)
+        goto bad;
+      uc = (uc << 6) | (p[i] & 0x3f);
+    }
+
+    /* overlong forms, surrogates and non-characters */
+    if((n == 2 && uc < 0x80) || (n == 3 && uc < 0x800) ||
+       (n == 4 && uc < 0x10000) || uc > 0x10ffff ||
+       (uc >= 0xd800 && uc <= 0xdfff) || uc == 0xfffe || uc == 0xffff)
+      goto bad;
+
+    p += n;
+  }
+
+  xt->valid_len = RAPTOR_GOOD_CAST(size_t, p - xt->buffer);
+  return 0;
+
+  bad:
+  raptor_xmltok_count_lines(xt, xt->buffer + xt->valid_len, p);
+  raptor_xmltok_error(xt, "Input is not proper UTF-8, indicate encoding !");
+  return 1;
+}
+
+
+/*
+ * raptor_xmltok_parse_chunk:
+ * @xt: tokenizer
+ * @buffer: input buffer
+ * @len: input buffer length
+ * @is_end: non-0 if end of data
+ *
+ * INTERNAL - Parse a chunk of XML generating SAX2 events
+ *
+ * Return value: non-0 on failure
+ */
+int
+raptor_xmltok_parse_chunk(raptor_xmltok* xt, const unsigned char *buffer,
+                          size_t len, int is_end)
+{
+  size_t used = 0;
+
+  if(xt->failed)
+    return 1;
+
+  if(xt->state == RAPTOR_XMLTOK_STATE_START) {
+    int rc;
+
+    /* raw bytes until the encoding is known */
+    if(len) {
+      if(raptor_xmltok_ensure_buffer(xt, len)) {
+        raptor_log_error(xt->sax2->world, RAPTOR_LOG_LEVEL_FATAL,
+                         xt->sax2->locator, "Out of memory");
+        xt->failed = 1;
+        return 1;
+      }
+      memcpy(xt->buffer + xt->buffer_len, buffer, len);
+      xt->buffer_len += len;
+    }
+
+    rc = raptor_xmltok_start(xt, is_end);
+    if(rc < 0)
+      return 1;
+    if(!rc)
+      return 0;
+  } else if(raptor_xmltok_append(xt, buffer, len)) {
+    raptor_log_error(xt->sax2->world, RAPTOR_LOG_LEVEL_FATAL,
+                     xt->sax2->locator, "Out of memory");
+    xt->failed = 1;
+    return 1;
+  }
+
+  if(raptor_xmltok_validate(xt, is_end))
+    return 1;
+
+  raptor_xmltok_parse_buffer(xt, xt->buffer, xt->valid_len, is_end, -1,
+                             &used);
+  if(xt->failed)
+    return 1;
+
+  /* keep the unprocessed tail for the next chunk */
+  if(used) {
+    xt->buffer_len -= used;
+    xt->valid_len -= used;
+    if(xt->buffer_len)
+      memmove(xt->buffer, xt->buffer + used, xt->buffer_len);
+  }
+
+  if(is_end) {
+    if(xt->depth) {
+      raptor_xmltok_error(xt, "Premature end of data in tag %s",
+                          (const char*)(xt->names +
+                                        xt->name_offsets[xt->depth - 1]));
+      return 1;
+    }
+    if(xt->state != RAPTOR_XMLTOK_STATE_EPILOG) {
+      raptor_xmltok_error(xt, "Document is empty");
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+#endif /* STANDALONE */
+
+
+
+#ifdef STANDALONE
+
+/* one more prototype */
+int main(int argc, char *argv[]);
+
+
+typedef struct
+{
+  raptor_stringbuffer* sb;
+  int errors;
+} xmltok_test_state;
+
+
+static void
+xmltok_test_start(void *user_data, raptor_xml_element *xml_element)
+{
+  xmltok_test_state* state = (xmltok_test_state*)user_data;
+  raptor_qname** attrs = raptor_xml_element_get_attributes(xml_element);
+  int count = raptor_xml_element_get_attributes_count(xml_element);
+  int i;
+
+  raptor_stringbuffer_append_string(state->sb, (const unsigned char*)"<", 1);
+  raptor_stringbuffer_append_string(state->sb, raptor_qname_get_local_name(raptor_xml_element_get_name(xml_element)), 1);
+  for(i = 0; i < count; i++) {
+    raptor_stringbuffer_append_string(state->sb, (const unsigned char*)" ", 1);
+    raptor_stringbuffer_append_string(state->sb, raptor_qname_get_local_name(attrs[i]), 1);
+    raptor_stringbuffer_append_string(state->sb, (const unsigned char*)"=|", 1);
+    raptor_stringbuffer_append_string(state->sb, raptor_qname_get_value(attrs[i]), 1);
+    raptor_stringbuffer_append_string(state->sb, (const unsigned char*)"|", 1);
+  }
+  raptor_stringbuffer_append_string(state->sb, (const unsigned char*)">", 1);
+}
+
+
+static void
+xmltok_test_end(void *user_data, raptor_xml_element *xml_element)
+{
+  xmltok_test_state* state = (xmltok_test_state*)user_data;
+
+  raptor_stringbuffer_append_string(state->sb, (const unsigned char*)"</", 1);
+  raptor_stringbuffer_append_string(state->sb, raptor_qname_get_local_name(raptor_xml_element_get_name(xml_element)), 1);
+  raptor_stringbuffer_append_string(state->sb, (const unsigned char*)">", 1);
+}
+
+
+static void
+xmltok_test_characters(void *user_data, raptor_xml_element* xml_element,
+                       const unsigned char *s, int len)
+{
+  xmltok_test_state* state = (xmltok_test_state*)user_data;
+
+  raptor_stringbuffer_append_counted_string(state->sb, s, RAPTOR_GOOD_CAST(size_t, len), 1);
+}
+
+
+static void
+xmltok_test_comment(void *user_data, raptor_xml_element* xml_element,
+                    const unsigned char *s)
+{
+  xmltok_test_state* state = (xmltok_test_state*)user_data;
+
+  raptor_stringbuffer_append_string(state->sb, (const unsigned char*)"{", 1);
+  raptor_stringbuffer_append_string(state->sb, s, 1);
+  raptor_stringbuffer_append_string(state->sb, (const unsigned char*)"}", 1);
+}
+
+
+static void
+xmltok_test_log(void *user_data, raptor_log_message *message)
+{
+  xmltok_test_state* state = (xmltok_test_state*)user_data;
+
+  if(message->level >= RAPTOR_LOG_LEVEL_ERROR)
+    state->errors++;
+}
+
+
+static const struct {
+  const char* xml;
+  /* expected events or NULL if the document is not well-formed */
+  const char* expected;
+} xmltok_tests[] = {
+  { "<a/>",
+    "<a></a>" },
+  { "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<a>x<b c='1' d=\"2\">y</b>z</a>\n",
+    "<a>x<b c=|1| d=|2|>y</b>z</a>" },
+  { "\xef\xbb\xbf<a>bom</a>",
+    "<a>bom</a>" },
+  { "<a>&lt;&gt;&amp;&apos;&quot;&#65;&#x42;&#xe9;</a>",
+    "<a><>&'\"AB\xc3\xa9</a>" },
+  { "<a b=\"  x \t\r\n y  &#32; \"/>",
+    "<a b=|x y|></a>" },
+  { "<a>\r\nx\ry\r\n</a>",
+    "<a>\nx\ny\n</a>" },
+  { "<a><!-- note --><![CDATA[<not> &markup;]]></a>",
+    "<a>{ note }<not> &markup;</a>" },
+  { "<?xml version=\"1.0\"?><?pi data?><a><?pi more?>t</a><!-- end -->",
+    "<a>t</a>{ end }" },
+  { "<!DOCTYPE a [\n<!ENTITY e \"ent&#33;\">\n<!ENTITY f \"[&e;]\">\n<!ENTITY g \"<b>&f;</b>\">\n<!ELEMENT a ANY>\n]>\n<a x=\"&f;\">&g;</a>",
+    "<a x=|[ent!]|><b>[ent!]</b></a>" },
+  { "<?xml version='1.0' encoding='ISO-8859-1'?><a b='\xe9'>caf\xe9</a>",
+    "<a b=|\xc3\xa9|>caf\xc3\xa9</a>" },
+  { "<a t='\xe2\x82\xac'>\xc3\xa9\xf0\x9f\x98\x80</a>",
+    "<a t=|\xe2\x82\xac|>\xc3\xa9\xf0\x9f\x98\x80</a>" },
+  { "<a xmlns='http://example.org/' xmlns:p='http://example.org/p#' p:q='v'><p:b/></a>",
+    "<a q=|v|><b></b></a>" },
+  /* errors */
+  { "<a><b></a>", NULL },
+  { "<a></a><b/>", NULL },
+  { "text<a/>", NULL },
+  { "<a>", NULL },
+  { "<a b='1' b='2'/>", NULL },
+  { "<a b='<'/>", NULL },
+  { "<a>&undefined;</a>", NULL },
+  { "<a>&#0;</a>", NULL },
+  { "<a><!-- x -- y --></a>", NULL },
+  { "<!DOCTYPE a [<!ENTITY e \"&e;\">]><a>&e;</a>", NULL },
+  { "<?xml version='1.0' encoding='EBCDIC'?><a/>", NULL },
+  { "<a/><?xml version='1.0'?>", NULL },
+  { "<a>\xff</a>", NULL },
+  { "<a>\xc3</a>", NULL },
+  { "<a>\x01</a>", NULL },
+  { NULL, NULL }
+};
+
+
+static int
+xmltok_test_parse(raptor_world* world, const char* xml, size_t chunk_size,
+                  xmltok_test_state* state)
+{
+  raptor_locator locator;
+  raptor_sax2* sax2;
+  size_t len = strlen(xml);
+  size_t offset = 0;
+
+  memset(&locator, '\0', sizeof(locator));
+  sax2 = raptor_new_sax2(world, &locator, state);
+  if(!sax2)
+    return 1;
+
+  raptor_sax2_set_start_element_handler(sax2, xmltok_test_start);
+  raptor_sax2_set_end_element_handler(sax2, xmltok_test_end);
+  raptor_sax2_set_characters_handler(sax2, xmltok_test_characters);
+  raptor_sax2_set_cdata_handler(sax2, xmltok_test_characters);
+  raptor_sax2_set_comment_handler(sax2, xmltok_test_comment);
+
+  raptor_sax2_parse_start(sax2, NULL);
+
+  while(1) {
+    size_t n = len - offset;
+    int is_end;
+
+    if(n > chunk_size)
+      n = chunk_size;
+    is_end = (offset + n == len);
+    if(raptor_sax2_parse_chunk(sax2, (const unsigned char*)xml + offset, n,
+                               is_end))
+      break;
+    offset += n;
+    if(is_end)
+      break;
+  }
+
+  raptor_free_sax2(sax2);
+  return 0;
+}
+
+
+int
+main(int argc, char *argv[]) 
+{
+  raptor_world *world;
+  const char *program = raptor_basename(argv[0]);
+  xmltok_test_state state;
+  int failures = 0;
+  int i;
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+
+  raptor_world_set_log_handler(world, &state, xmltok_test_log);
+
+  for(i = 0; xmltok_tests[i].xml; i++) {
+    const char* xml = xmltok_tests[i].xml;
+    const char* expected = xmltok_tests[i].expected;
+    size_t len = strlen(xml);
+    size_t chunk_size;
+
+    /* every chunk size exercises every token split point */
+    for(chunk_size = 1; chunk_size <= len; chunk_size++) {
+      const char* result;
+
+      state.sb = raptor_new_stringbuffer();
+      state.errors = 0;
+      if(!state.sb || xmltok_test_parse(world, xml, chunk_size, &state)) {
+        fprintf(stderr, "%s: Failed to create parser\n", program);
+        exit(1);
+      }
+
+      result = (const char*)raptor_stringbuffer_as_string(state.sb);
+      if(!result)
+        result = "";
+
+      if(expected) {
+        if(state.errors || strcmp(result, expected)) {
+          fprintf(stderr,
+                  "%s: Test %d chunk size %d FAILED with %d errors - got '%s' expected '%s'\n",
+                  program, i, (int)chunk_size, state.errors, result, expected);
+          failures++;
+        }
+      } else if(!state.errors) {
+        fprintf(stderr,
+                "%s: Test %d chunk size %d FAILED - expected an error, got '%s'\n",
+                program, i, (int)chunk_size, result);
+        failures++;
+      }
+
+      raptor_free_stringbuffer(state.sb);
+
+      if(failures)
+        break;
+    }
+  }
+
+  raptor_free_world(world);
+
+  return failures;
+}
+
+#endif /* STANDALONE */
+
+#endif /* RAPTOR_XML_NATIVE */
@@ -1812,9 +1812,18 @@ raptor_turtle_parse_start(raptor_parser *rdf_parser)
 }
 
 
+/* strings looked for by raptor_turtle_parse_recognise_syntax() and
+ * raptor_trig_parse_recognise_syntax() */
+static const char* const turtle_recognise_patterns[3] = {
+  "@prefix ",
+  ": <http://www.w3.org/1999/02/22-rdf-syntax-ns#>",
+  NULL
+};
+
 static int
 raptor_turtle_parse_recognise_syntax(raptor_parser_factory* factory, 
                                      const unsigned char *buffer, size_t len,
+                                     unsigned int patterns,
                                      const unsigned char *identifier, 
                                      const unsigned char *suffix, 
                                      const char *mime_type)
@@ -1837,9 +1846,9 @@ raptor_turtle_parse_recognise_syntax(raptor_parser_factory* factory,
 
   /* Do this as long as N3 is not supported since it shares the same syntax */
   if(buffer && len) {
-#define  HAS_TURTLE_PREFIX (raptor_memstr((const char*)buffer, len, "@prefix ") != NULL)
+#define  HAS_TURTLE_PREFIX RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 0)
 /* The following could also be found with N-Triples but not with @prefix */
-#define  HAS_TURTLE_RDF_URI (raptor_memstr((const char*)buffer, len, ": <http://www.w3.org/1999/02/22-rdf-syntax-ns#>") != NULL)
+#define  HAS_TURTLE_RDF_URI RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 1)
 
     if(HAS_TURTLE_PREFIX) {
       score = 6;
@@ -1869,6 +1878,7 @@ raptor_turtle_get_graph(raptor_parser* rdf_parser)
 static int
 raptor_trig_parse_recognise_syntax(raptor_parser_factory* factory, 
                                    const unsigned char *buffer, size_t len,
+                                   unsigned int patterns,
                                    const unsigned char *identifier, 
                                    const unsigned char *suffix, 
                                    const char *mime_type)
@@ -1900,9 +1910,9 @@ raptor_trig_parse_recognise_syntax(raptor_parser_factory* factory,
 #ifndef RAPTOR_PARSER_TURTLE
   /* Do this as long as N3 is not supported since it shares the same syntax */
   if(buffer && len) {
-#define  HAS_TRIG_PREFIX (raptor_memstr((const char*)buffer, len, "@prefix ") != NULL)
+#define  HAS_TRIG_PREFIX RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 0)
 /* The following could also be found with N-Triples but not with @prefix */
-#define  HAS_TRIG_RDF_URI (raptor_memstr((const char*)buffer, len, ": <http://www.w3.org/1999/02/22-rdf-syntax-ns#>") != NULL)
+#define  HAS_TRIG_RDF_URI RAPTOR_RECOGNISE_HAS_PATTERN(patterns, 1)
 
     if(HAS_TRIG_PREFIX) {
       score = 6;
@@ -1959,6 +1969,7 @@ raptor_turtle_parser_register_factory(raptor_parser_factory *factory)
   factory->start     = raptor_turtle_parse_start;
   factory->chunk     = raptor_turtle_parse_chunk;
   factory->recognise_syntax = raptor_turtle_parse_recognise_syntax;
+  factory->recognise_patterns = turtle_recognise_patterns;
   factory->get_graph = raptor_turtle_get_graph;
 
   return rc;
@@ -2002,6 +2013,7 @@ raptor_trig_parser_register_factory(raptor_parser_factory *factory)
   factory->start     = raptor_turtle_parse_start;
   factory->chunk     = raptor_turtle_parse_chunk;
   factory->recognise_syntax = raptor_trig_parse_recognise_syntax;
+  factory->recognise_patterns = turtle_recognise_patterns;
   factory->get_graph = raptor_turtle_get_graph;
 
   return rc;
@@ -0,0 +1,14 @@
+<?xml version="1.0"?>
+<xsl:stylesheet version="1.0"
+  xmlns:xsl="http://www.w3.org/1999/XSL/Transform"
+  xmlns:h="http://www.w3.org/1999/xhtml"
+  xmlns:rdf="http://www.w3.org/1999/02/22-rdf-syntax-ns#">
+<xsl:output method="xml" />
+<xsl:template match="/">
+<rdf:RDF>
+  <rdf:Description>
+    <rdf:value><xsl:value-of select="/h:html/h:head/h:title" /></rdf:value>
+  </rdf:Description>
+</rdf:RDF>
+</xsl:template>
+</xsl:stylesheet>
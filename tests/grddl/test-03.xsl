@@ -0,0 +1,31 @@
+<?xml version="1.0"?>
+<xsl:stylesheet version="1.0"
+  xmlns:xsl="http://www.w3.org/1999/XSL/Transform"
+  xmlns:h="http://www.w3.org/1999/xhtml"
+  xmlns:rdf="http://www.w3.org/1999/02/22-rdf-syntax-ns#"
+  xmlns:dc="http://purl.org/dc/elements/1.1/"
+  xmlns:ex="http://example.org/ns#"
+  exclude-result-prefixes="h">
+<xsl:output method="xml" />
+<xsl:template match="/">
+<rdf:RDF xml:base="http://example.org/base/">
+  <rdf:Description rdf:about="doc">
+    <xsl:attribute name="xml:lang">
+      <xsl:value-of select="/h:html/@xml:lang" />
+    </xsl:attribute>
+    <dc:title><xsl:value-of select="/h:html/h:head/h:title" /></dc:title>
+    <dc:title xml:lang="fr">titre</dc:title>
+    <dc:title xml:lang="">untagged</dc:title>
+    <ex:link rdf:resource="other" />
+    <ex:part>
+      <ex:Thing rdf:ID="thing" xml:base="http://example.org/sub/dir/"
+                xml:lang="de">
+        <ex:label>Ding</ex:label>
+        <ex:see rdf:resource="../up" />
+      </ex:Thing>
+    </ex:part>
+    <ex:markup rdf:parseType="Literal"><q:b xmlns:q="http://example.org/q#" q:a="1">bold <ex:i>and</ex:i></q:b></ex:markup>
+  </rdf:Description>
+</rdf:RDF>
+</xsl:template>
+</xsl:stylesheet>
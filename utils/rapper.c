@@ -50,6 +50,12 @@
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
 
 
 
@@ -88,6 +94,52 @@ static int report_namespace = 0;
 
 static int report_graph = 0;
 
+/* parse and serialize on separate threads */
+static int pipelined = 0;
+
+/* indexed by raptor_compression */
+static const char* const compression_names[RAPTOR_COMPRESSION_LAST + 2] = {
+  "none", "auto", "gzip", "zstd", NULL
+};
+
+
+static int
+rapper_compression_from_name(const char* name, raptor_compression* compression_p)
+{
+  int i;
+
+  for(i = 0; compression_names[i]; i++) {
+    if(!strcmp(compression_names[i], name)) {
+      if(!raptor_compression_is_supported((raptor_compression)i)) {
+        fprintf(stderr, "%s: %s compression is not supported\n",
+                program, name);
+        return 1;
+      }
+      *compression_p = (raptor_compression)i;
+      return 0;
+    }
+  }
+
+  fprintf(stderr, "%s: invalid compression `%s' - valid ones are: none, auto, gzip, zstd\n",
+          program, name);
+  return 1;
+}
+
+
+/* replace newlines with spaces if object is a literal string */
+static void
+rapper_replace_newlines(raptor_statement *triple)
+{
+  char *s;
+
+  if(triple->object->type != RAPTOR_TERM_TYPE_LITERAL)
+    return;
+
+  for(s = (char*)triple->object->value.literal.string; *s; s++)
+    if(*s == '\n')
+      *s = ' ';
+}
+
 
 static
 void print_triples(void *user_data, raptor_statement *triple) 
@@ -105,14 +157,8 @@ void print_triples(void *user_data, raptor_statement *triple)
   if(count)
     return;
 
-  /* replace newlines with spaces if object is a literal string */
-  if(replace_newlines && 
-     triple->object->type == RAPTOR_TERM_TYPE_LITERAL) {
-    char *s;
-    for(s = (char*)triple->object->value.literal.string; *s; s++)
-      if(*s == '\n')
-        *s=' ';
-  }
+  if(replace_newlines)
+    rapper_replace_newlines(triple);
 
   raptor_serializer_serialize_statement(serializer, triple);
   return;
@@ -184,11 +230,13 @@ relay_namespaces(void* user_data, raptor_namespace *nspace)
 #endif
 
 
-#define GETOPT_STRING "cef:ghi:I:o:O:qrtvw"
+#define GETOPT_STRING "cef:ghi:I:j:o:O:pqrtvw"
 
 #ifdef HAVE_GETOPT_LONG
 #define SHOW_NAMESPACES_FLAG 0x100
 #define SHOW_GRAPHS_FLAG 0x200
+#define INPUT_COMPRESSION_FLAG 0x300
+#define OUTPUT_COMPRESSION_FLAG 0x400
 
 static const struct option long_options[] =
 {
@@ -200,8 +248,12 @@ static const struct option long_options[] =
   {"help", 0, 0, 'h'},
   {"input", 1, 0, 'i'},
   {"input-uri", 1, 0, 'I'},
+  {"input-compression", 1, 0, INPUT_COMPRESSION_FLAG},
+  {"jobs", 1, 0, 'j'},
   {"output", 1, 0, 'o'},
   {"output-uri", 1, 0, 'O'},
+  {"output-compression", 1, 0, OUTPUT_COMPRESSION_FLAG},
+  {"pipeline", 0, 0, 'p'},
   {"quiet", 0, 0, 'q'},
   {"replace-newlines", 0, 0, 'r'},
   {"show-graphs", 0, 0, SHOW_GRAPHS_FLAG},
@@ -294,6 +346,499 @@ rapper_uri_trace(void *user_data, raptor_uri* uri)
 }
 
 
+#ifdef HAVE_PTHREAD
+/*
+ * Pipelined mode (-p)
+ *
+ * Raptor worlds are not thread safe so the parser and the serializer
+ * each get their own world.  The parser thread writes statements with
+ * the binary serializer into a ring of chunks and the serializer
+ * thread reads them back with the binary parser in its world and
+ * serializes them.  The ring is bounded: the parser thread waits when
+ * every chunk is full and the serializer thread waits when all are
+ * empty.  Namespaces are sent with the chunk offset they were declared
+ * at so they reach the serializer in order with the statements.  The
+ * binary stream is restarted every PIPELINE_STREAM_STATEMENTS
+ * statements so neither world holds on to more than that many
+ * statements' terms.
+ */
+
+/* bytes per chunk and number of chunks in the ring */
+#define PIPELINE_CHUNK_SIZE (64 * 1024)
+#define PIPELINE_CHUNKS 4
+#define PIPELINE_STREAM_STATEMENTS (1 << 16)
+
+/* namespace declared after @offset bytes of a chunk */
+typedef struct
+{
+  size_t offset;
+  /* either may be NULL; allocated with the struct */
+  unsigned char *prefix;
+  unsigned char *uri_string;
+} pipeline_namespace;
+
+typedef struct
+{
+  unsigned char buffer[PIPELINE_CHUNK_SIZE];
+  size_t len;
+  /* sequence of pipeline_namespace in offset order */
+  raptor_sequence* namespaces;
+} pipeline_chunk;
+
+typedef struct
+{
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t chunk_queued;
+  pthread_cond_t chunk_done;
+
+  pipeline_chunk chunks[PIPELINE_CHUNKS];
+  /* chunk being filled by the parser thread */
+  int fill;
+  /* next chunk for the serializer thread */
+  int take;
+  /* chunks queued, including one being serialized */
+  int queued;
+  /* set when the parser thread has queued the last chunk */
+  int finished;
+  /* set when the serializer thread failed; chunks are then dropped */
+  int failed;
+
+  /* parser thread */
+  raptor_parser* rdf_parser;
+  raptor_serializer* binary_serializer;
+  raptor_iostream* iostr;
+  int stream_statements;
+  unsigned long parser_waits;
+
+  /* serializer thread */
+  raptor_world* world;
+  raptor_parser* binary_parser;
+  raptor_serializer* serializer;
+  unsigned long serializer_waits;
+  int error_count;
+  int warning_count;
+
+#ifdef HAVE_GETTIMEOFDAY
+  struct timeval start_time;
+#endif
+} rapper_pipeline;
+
+
+static void
+rapper_pipeline_log_handler(void *data, raptor_log_message *message)
+{
+  rapper_pipeline* pipeline = (rapper_pipeline*)data;
+
+  switch(message->level) {
+    case RAPTOR_LOG_LEVEL_FATAL:
+    case RAPTOR_LOG_LEVEL_ERROR:
+      if(!ignore_errors) {
+        fprintf(stderr, "%s: Error - ", program);
+        raptor_locator_print(message->locator, stderr);
+        fprintf(stderr, " - %s\n", message->text);
+      }
+
+      pipeline->error_count++;
+      break;
+
+    case RAPTOR_LOG_LEVEL_WARN:
+      if(!ignore_warnings) {
+        fprintf(stderr, "%s: Warning - ", program);
+        raptor_locator_print(message->locator, stderr);
+        fprintf(stderr, " - %s\n", message->text);
+      }
+
+      pipeline->warning_count++;
+      break;
+
+    case RAPTOR_LOG_LEVEL_NONE:
+    case RAPTOR_LOG_LEVEL_TRACE:
+    case RAPTOR_LOG_LEVEL_DEBUG:
+    case RAPTOR_LOG_LEVEL_INFO:
+
+      fprintf(stderr, "%s: Unexpected %s message - ", program,
+              raptor_log_level_get_label(message->level));
+      raptor_locator_print(message->locator, stderr);
+      fprintf(stderr, " - %s\n", message->text);
+      break;
+  }
+}
+
+
+static void
+rapper_pipeline_serialize_statement(void *user_data,
+                                    raptor_statement *statement)
+{
+  rapper_pipeline* pipeline = (rapper_pipeline*)user_data;
+
+  raptor_serializer_serialize_statement(pipeline->serializer, statement);
+}
+
+
+/*
+ * serializer thread: serialize one chunk or only empty it after a
+ * failure; returns non-0 on failure
+ */
+static int
+rapper_pipeline_serialize_chunk(rapper_pipeline* pipeline,
+                                pipeline_chunk* chunk, int failed)
+{
+  int rc = failed;
+  size_t offset = 0;
+  pipeline_namespace* ns;
+
+  while((ns = (pipeline_namespace*)raptor_sequence_unshift(chunk->namespaces))) {
+    if(!rc) {
+      raptor_uri *ns_uri = NULL;
+
+      if(ns->offset > offset)
+        rc = raptor_parser_parse_chunk(pipeline->binary_parser,
+                                       chunk->buffer + offset,
+                                       ns->offset - offset, 0);
+      offset = ns->offset;
+
+      if(ns->uri_string)
+        ns_uri = raptor_new_uri(pipeline->world, ns->uri_string);
+      raptor_serializer_set_namespace(pipeline->serializer, ns_uri,
+                                      ns->prefix);
+      if(ns_uri)
+        raptor_free_uri(ns_uri);
+    }
+    raptor_free_memory(ns);
+  }
+
+  if(!rc && chunk->len > offset)
+    rc = raptor_parser_parse_chunk(pipeline->binary_parser,
+                                   chunk->buffer + offset,
+                                   chunk->len - offset, 0);
+
+  chunk->len = 0;
+
+  return rc;
+}
+
+
+static void*
+rapper_pipeline_run(void* arg)
+{
+  rapper_pipeline* pipeline = (rapper_pipeline*)arg;
+  int failed = 0;
+
+  while(1) {
+    pipeline_chunk* chunk;
+
+    pthread_mutex_lock(&pipeline->lock);
+    while(!pipeline->queued && !pipeline->finished) {
+      pipeline->serializer_waits++;
+      pthread_cond_wait(&pipeline->chunk_queued, &pipeline->lock);
+    }
+    if(!pipeline->queued) {
+      pthread_mutex_unlock(&pipeline->lock);
+      break;
+    }
+    chunk = &pipeline->chunks[pipeline->take];
+    pthread_mutex_unlock(&pipeline->lock);
+
+    failed = rapper_pipeline_serialize_chunk(pipeline, chunk, failed);
+
+    pthread_mutex_lock(&pipeline->lock);
+    if(failed)
+      pipeline->failed = 1;
+    pipeline->take = (pipeline->take + 1) % PIPELINE_CHUNKS;
+    pipeline->queued--;
+    pthread_cond_signal(&pipeline->chunk_done);
+    pthread_mutex_unlock(&pipeline->lock);
+  }
+
+  if(!failed)
+    raptor_parser_parse_chunk(pipeline->binary_parser, NULL, 0, 1);
+  raptor_serializer_serialize_end(pipeline->serializer);
+
+  return NULL;
+}
+
+
+/* parser thread: queue the chunk being filled and wait for a free one */
+static int
+rapper_pipeline_queue_chunk(rapper_pipeline* pipeline)
+{
+  int failed;
+
+  pthread_mutex_lock(&pipeline->lock);
+  pipeline->queued++;
+  pthread_cond_signal(&pipeline->chunk_queued);
+  while(pipeline->queued == PIPELINE_CHUNKS) {
+    pipeline->parser_waits++;
+    pthread_cond_wait(&pipeline->chunk_done, &pipeline->lock);
+  }
+  failed = pipeline->failed;
+  pipeline->fill = (pipeline->fill + 1) % PIPELINE_CHUNKS;
+  pthread_mutex_unlock(&pipeline->lock);
+
+  return failed;
+}
+
+
+static int
+rapper_pipeline_write_bytes(void *context, const void *ptr,
+                            size_t size, size_t nmemb)
+{
+  rapper_pipeline* pipeline = (rapper_pipeline*)context;
+  const unsigned char* p = (const unsigned char*)ptr;
+  size_t len = size * nmemb;
+
+  while(len) {
+    pipeline_chunk* chunk = &pipeline->chunks[pipeline->fill];
+    size_t n = PIPELINE_CHUNK_SIZE - chunk->len;
+
+    if(n > len)
+      n = len;
+    memcpy(chunk->buffer + chunk->len, p, n);
+    chunk->len += n;
+    p += n;
+    len -= n;
+
+    if(chunk->len == PIPELINE_CHUNK_SIZE &&
+       rapper_pipeline_queue_chunk(pipeline))
+      return 0;
+  }
+
+  return (int)(size * nmemb);
+}
+
+
+static int
+rapper_pipeline_write_byte(void *context, const int byte)
+{
+  unsigned char c = (unsigned char)byte;
+
+  return rapper_pipeline_write_bytes(context, &c, 1, 1) != 1;
+}
+
+
+static const raptor_iostream_handler rapper_pipeline_iostream_handler = {
+  /* .version     = */ 2,
+  /* .init        = */ NULL,
+  /* .finish      = */ NULL,
+  /* .write_byte  = */ rapper_pipeline_write_byte,
+  /* .write_bytes = */ rapper_pipeline_write_bytes,
+  /* .write_end   = */ NULL,
+  /* .read_bytes  = */ NULL,
+  /* .read_eof    = */ NULL
+};
+
+
+/* parser thread: send a statement and restart the stream when due */
+static void
+rapper_pipeline_print_triples(void *user_data, raptor_statement *statement)
+{
+  rapper_pipeline* pipeline = (rapper_pipeline*)user_data;
+
+  print_triples(pipeline->rdf_parser, statement);
+
+  if(++pipeline->stream_statements == PIPELINE_STREAM_STATEMENTS) {
+    raptor_serializer_serialize_end(pipeline->binary_serializer);
+    raptor_serializer_start_to_iostream(pipeline->binary_serializer, NULL,
+                                        pipeline->iostr);
+    pipeline->stream_statements = 0;
+  }
+}
+
+
+/* parser thread: send a namespace after the statements written so far */
+static void
+rapper_pipeline_relay_namespaces(void* user_data, raptor_namespace *nspace)
+{
+  rapper_pipeline* pipeline = (rapper_pipeline*)user_data;
+  pipeline_namespace* ns;
+  raptor_uri* ns_uri;
+  const unsigned char* prefix;
+  const unsigned char* uri_str = NULL;
+  size_t prefix_len = 0;
+  size_t uri_len = 0;
+  unsigned char* p;
+
+  if(report_namespace)
+    print_namespaces(user_data, nspace);
+
+  /* write out the statements declared before the namespace */
+  raptor_serializer_flush(pipeline->binary_serializer);
+
+  prefix = raptor_namespace_get_prefix(nspace);
+  if(prefix)
+    prefix_len = strlen((const char*)prefix) + 1;
+  ns_uri = raptor_namespace_get_uri(nspace);
+  if(ns_uri) {
+    uri_str = raptor_uri_as_counted_string(ns_uri, &uri_len);
+    uri_len++;
+  }
+
+  ns = (pipeline_namespace*)raptor_alloc_memory(sizeof(*ns) + prefix_len +
+                                                uri_len);
+  if(!ns)
+    return;
+
+  p = (unsigned char*)(ns + 1);
+  ns->offset = pipeline->chunks[pipeline->fill].len;
+  ns->prefix = prefix ? p : NULL;
+  if(prefix)
+    memcpy(p, prefix, prefix_len);
+  ns->uri_string = uri_str ? p + prefix_len : NULL;
+  if(uri_str)
+    memcpy(p + prefix_len, uri_str, uri_len);
+
+  raptor_sequence_push(pipeline->chunks[pipeline->fill].namespaces, ns);
+}
+
+
+/*
+ * Start the serializer thread running the global serializer, which
+ * must be in @output_world.  The statement and namespace handlers of
+ * @rdf_parser are pointed at the pipeline and the global serializer
+ * becomes the binary serializer writing into it.
+ */
+static rapper_pipeline*
+rapper_new_pipeline(raptor_world* world, raptor_parser* rdf_parser,
+                    raptor_world* output_world)
+{
+  rapper_pipeline* pipeline;
+  int i;
+
+  pipeline = (rapper_pipeline*)raptor_calloc_memory(sizeof(*pipeline), 1);
+  if(!pipeline)
+    return NULL;
+
+  pipeline->world = output_world;
+  pipeline->serializer = serializer;
+  pipeline->rdf_parser = rdf_parser;
+  raptor_world_set_log_handler(output_world, pipeline,
+                               rapper_pipeline_log_handler);
+
+  pipeline->binary_parser = raptor_new_parser(output_world, "binary");
+  pipeline->binary_serializer = raptor_new_serializer(world, "binary");
+  pipeline->iostr = raptor_new_iostream_from_handler(world, pipeline,
+                                                     &rapper_pipeline_iostream_handler);
+  if(!pipeline->binary_parser || !pipeline->binary_serializer ||
+     !pipeline->iostr)
+    goto failed;
+
+  for(i = 0; i < PIPELINE_CHUNKS; i++) {
+    pipeline->chunks[i].namespaces = raptor_new_sequence(raptor_free_memory,
+                                                         NULL);
+    if(!pipeline->chunks[i].namespaces)
+      goto failed;
+  }
+
+  raptor_parser_set_statement_handler(pipeline->binary_parser, pipeline,
+                                      rapper_pipeline_serialize_statement);
+  if(raptor_parser_parse_start(pipeline->binary_parser, NULL) ||
+     raptor_serializer_start_to_iostream(pipeline->binary_serializer, NULL,
+                                         pipeline->iostr))
+    goto failed;
+
+#ifdef HAVE_GETTIMEOFDAY
+  gettimeofday(&pipeline->start_time, NULL);
+#endif
+
+  pthread_mutex_init(&pipeline->lock, NULL);
+  pthread_cond_init(&pipeline->chunk_queued, NULL);
+  pthread_cond_init(&pipeline->chunk_done, NULL);
+  if(pthread_create(&pipeline->thread, NULL, rapper_pipeline_run, pipeline)) {
+    pthread_cond_destroy(&pipeline->chunk_done);
+    pthread_cond_destroy(&pipeline->chunk_queued);
+    pthread_mutex_destroy(&pipeline->lock);
+    goto failed;
+  }
+
+  serializer = pipeline->binary_serializer;
+  raptor_parser_set_statement_handler(rdf_parser, pipeline,
+                                      rapper_pipeline_print_triples);
+  if(!report_namespace)
+    raptor_parser_set_namespace_handler(rdf_parser, pipeline,
+                                        rapper_pipeline_relay_namespaces);
+
+  return pipeline;
+
+  failed:
+  for(i = 0; i < PIPELINE_CHUNKS; i++) {
+    if(pipeline->chunks[i].namespaces)
+      raptor_free_sequence(pipeline->chunks[i].namespaces);
+  }
+  if(pipeline->iostr)
+    raptor_free_iostream(pipeline->iostr);
+  if(pipeline->binary_serializer)
+    raptor_free_serializer(pipeline->binary_serializer);
+  if(pipeline->binary_parser)
+    raptor_free_parser(pipeline->binary_parser);
+  raptor_free_memory(pipeline);
+  return NULL;
+}
+
+
+/*
+ * Send the last statements, wait for the serializer thread to end the
+ * serialization, report the throughput and free the pipeline.  The
+ * global serializer is restored for the caller to free.
+ */
+static void
+rapper_free_pipeline(rapper_pipeline* pipeline)
+{
+  int i;
+
+  raptor_serializer_serialize_end(pipeline->binary_serializer);
+
+  pthread_mutex_lock(&pipeline->lock);
+  if(pipeline->chunks[pipeline->fill].len ||
+     raptor_sequence_size(pipeline->chunks[pipeline->fill].namespaces))
+    pipeline->queued++;
+  pipeline->finished = 1;
+  pthread_cond_signal(&pipeline->chunk_queued);
+  pthread_mutex_unlock(&pipeline->lock);
+
+  pthread_join(pipeline->thread, NULL);
+
+  if(!quiet) {
+#ifdef HAVE_GETTIMEOFDAY
+    struct timeval end_time;
+    double seconds;
+
+    gettimeofday(&end_time, NULL);
+    seconds = (double)(end_time.tv_sec - pipeline->start_time.tv_sec) +
+      (double)(end_time.tv_usec - pipeline->start_time.tv_usec) / 1000000.0;
+    fprintf(stderr, "%s: Pipelined %ld triples in %.3f seconds",
+            program, triple_count, seconds);
+    if(seconds > 0.0)
+      fprintf(stderr, " (%.0f triples/second)", (double)triple_count / seconds);
+    fputc('\n', stderr);
+#endif
+    fprintf(stderr,
+            "%s: Parser waited for the serializer %lu times, serializer waited for the parser %lu times\n",
+            program, pipeline->parser_waits, pipeline->serializer_waits);
+  }
+
+  pthread_cond_destroy(&pipeline->chunk_done);
+  pthread_cond_destroy(&pipeline->chunk_queued);
+  pthread_mutex_destroy(&pipeline->lock);
+
+  for(i = 0; i < PIPELINE_CHUNKS; i++)
+    raptor_free_sequence(pipeline->chunks[i].namespaces);
+
+  raptor_free_serializer(pipeline->binary_serializer);
+  raptor_free_iostream(pipeline->iostr);
+  raptor_free_parser(pipeline->binary_parser);
+
+  error_count += pipeline->error_count;
+  warning_count += pipeline->warning_count;
+
+  serializer = pipeline->serializer;
+  raptor_world_set_log_handler(pipeline->world, NULL, NULL);
+
+  raptor_free_memory(pipeline);
+}
+#endif
+
+
 typedef struct
 {
   raptor_option option;
@@ -302,6 +847,561 @@ typedef struct
 } option_value;
 
 
+/*
+ * Multiple input mode (-j)
+ *
+ * Every remaining argument is an input.  Each worker owns a world and
+ * a parser that it reuses for the inputs it takes; an input is
+ * serialized into a string in the worker's world and the main thread
+ * writes the strings out in argument order.  Workers take inputs
+ * from a window of twice the number of workers past the last one
+ * written so finished output waiting for an earlier slow input stays
+ * bounded.  With one worker, or without threads, the inputs are
+ * processed in turn on the main thread.
+ */
+
+/* settings shared read-only by all workers */
+typedef struct
+{
+  const char* syntax_name;
+  const char* serializer_syntax_name;
+  const unsigned char* base_uri_string;
+  const unsigned char* output_base_uri_string;
+  raptor_sequence* parser_options;
+  raptor_sequence* serializer_options;
+  raptor_sequence* namespace_declarations;
+  raptor_compression input_compression;
+  int trace;
+} rapper_jobs_settings;
+
+/* one input and its results */
+typedef struct
+{
+  const char* input;
+  /* position of the input in the arguments, from 0 */
+  int index;
+  unsigned char* output;
+  size_t output_len;
+  long triple_count;
+  int error_count;
+  int warning_count;
+  int failed;
+  /* parser name when guessing */
+  char* parser_name;
+  int done;
+} rapper_job;
+
+typedef struct rapper_jobs_s rapper_jobs;
+
+typedef struct
+{
+  rapper_jobs* jobs;
+  raptor_world* world;
+  raptor_parser* rdf_parser;
+  raptor_serializer* serializer;
+  rapper_job* job;
+#ifdef HAVE_PTHREAD
+  pthread_t thread;
+#endif
+} rapper_worker;
+
+struct rapper_jobs_s
+{
+  const rapper_jobs_settings* settings;
+  rapper_job* jobs;
+  int jobs_count;
+  rapper_worker* workers;
+  int workers_count;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t lock;
+  pthread_cond_t job_done;
+  pthread_cond_t job_written;
+  /* next job to take */
+  int next;
+  /* jobs written by the main thread */
+  int written;
+#endif
+};
+
+
+static void
+rapper_worker_log_handler(void *data, raptor_log_message *message)
+{
+  rapper_worker* worker = (rapper_worker*)data;
+  rapper_job* job = worker->job;
+
+#ifdef HAVE_PTHREAD
+  flockfile(stderr);
+#endif
+  switch(message->level) {
+    case RAPTOR_LOG_LEVEL_FATAL:
+    case RAPTOR_LOG_LEVEL_ERROR:
+      if(!ignore_errors) {
+        fprintf(stderr, "%s: Error - ", program);
+        raptor_locator_print(message->locator, stderr);
+        fprintf(stderr, " - %s\n", message->text);
+
+        raptor_parser_parse_abort(worker->rdf_parser);
+      }
+
+      if(job)
+        job->error_count++;
+      break;
+
+    case RAPTOR_LOG_LEVEL_WARN:
+      if(!ignore_warnings) {
+        fprintf(stderr, "%s: Warning - ", program);
+        raptor_locator_print(message->locator, stderr);
+        fprintf(stderr, " - %s\n", message->text);
+      }
+
+      if(job)
+        job->warning_count++;
+      break;
+
+    case RAPTOR_LOG_LEVEL_NONE:
+    case RAPTOR_LOG_LEVEL_TRACE:
+    case RAPTOR_LOG_LEVEL_DEBUG:
+    case RAPTOR_LOG_LEVEL_INFO:
+
+      fprintf(stderr, "%s: Unexpected %s message - ", program,
+              raptor_log_level_get_label(message->level));
+      raptor_locator_print(message->locator, stderr);
+      fprintf(stderr, " - %s\n", message->text);
+      break;
+  }
+#ifdef HAVE_PTHREAD
+  funlockfile(stderr);
+#endif
+}
+
+
+static void
+rapper_worker_print_triples(void *user_data, raptor_statement *triple)
+{
+  rapper_worker* worker = (rapper_worker*)user_data;
+
+  worker->job->triple_count++;
+
+  if(!worker->serializer)
+    return;
+
+  if(replace_newlines)
+    rapper_replace_newlines(triple);
+
+  raptor_serializer_serialize_statement(worker->serializer, triple);
+}
+
+
+/* Create the world and parser of @worker; returns non-0 on failure */
+static int
+rapper_worker_init(rapper_worker* worker, rapper_jobs* jobs)
+{
+  const rapper_jobs_settings* settings = jobs->settings;
+  int i;
+
+  worker->jobs = jobs;
+
+  worker->world = raptor_new_world();
+  if(!worker->world || raptor_world_open(worker->world))
+    return 1;
+
+  raptor_world_set_log_handler(worker->world, worker,
+                               rapper_worker_log_handler);
+
+  worker->rdf_parser = raptor_new_parser(worker->world, settings->syntax_name);
+  if(!worker->rdf_parser)
+    return 1;
+
+  if(settings->parser_options) {
+    for(i = 0; i < raptor_sequence_size(settings->parser_options); i++) {
+      option_value *fv;
+
+      fv = (option_value*)raptor_sequence_get_at(settings->parser_options, i);
+      raptor_parser_set_option(worker->rdf_parser, fv->option,
+                               fv->s_value, fv->i_value);
+    }
+  }
+
+  if(settings->trace)
+    raptor_parser_set_uri_filter(worker->rdf_parser, rapper_uri_trace,
+                                 worker->rdf_parser);
+
+  raptor_parser_set_statement_handler(worker->rdf_parser, worker,
+                                      rapper_worker_print_triples);
+  if(report_graph)
+    raptor_parser_set_graph_mark_handler(worker->rdf_parser, worker,
+                                         print_graph);
+  if(report_namespace)
+    raptor_parser_set_namespace_handler(worker->rdf_parser, worker,
+                                        print_namespaces);
+
+  return 0;
+}
+
+
+static void
+rapper_worker_clear(rapper_worker* worker)
+{
+  if(worker->rdf_parser)
+    raptor_free_parser(worker->rdf_parser);
+  if(worker->world)
+    raptor_free_world(worker->world);
+}
+
+
+/* Create the serializer for the current job writing to its output */
+static int
+rapper_worker_start_serializer(rapper_worker* worker, raptor_uri* base_uri)
+{
+  const rapper_jobs_settings* settings = worker->jobs->settings;
+  raptor_uri* output_base_uri = NULL;
+  int i;
+  int rc;
+
+  worker->serializer = raptor_new_serializer(worker->world,
+                                             settings->serializer_syntax_name);
+  if(!worker->serializer)
+    return 1;
+
+  if(settings->namespace_declarations) {
+    for(i = 0; i < raptor_sequence_size(settings->namespace_declarations); i++) {
+      struct namespace_decl *nd;
+      raptor_uri *ns_uri = NULL;
+
+      nd = (struct namespace_decl*)raptor_sequence_get_at(settings->namespace_declarations, i);
+      if(nd->uri_string)
+        ns_uri = raptor_new_uri(worker->world, nd->uri_string);
+
+      raptor_serializer_set_namespace(worker->serializer, ns_uri, nd->prefix);
+      if(ns_uri)
+        raptor_free_uri(ns_uri);
+    }
+  }
+
+  if(settings->serializer_options) {
+    for(i = 0; i < raptor_sequence_size(settings->serializer_options); i++) {
+      option_value *fv;
+
+      fv = (option_value*)raptor_sequence_get_at(settings->serializer_options, i);
+      raptor_serializer_set_option(worker->serializer, fv->option,
+                                   fv->s_value, fv->i_value);
+    }
+  }
+
+  if(!settings->output_base_uri_string) {
+    if(base_uri)
+      output_base_uri = raptor_uri_copy(base_uri);
+  } else if(strcmp((const char*)settings->output_base_uri_string, "-"))
+    output_base_uri = raptor_new_uri(worker->world,
+                                     settings->output_base_uri_string);
+
+  rc = raptor_serializer_start_to_string(worker->serializer, output_base_uri,
+                                         (void**)&worker->job->output,
+                                         &worker->job->output_len);
+  if(output_base_uri)
+    raptor_free_uri(output_base_uri);
+
+  if(!rc && !report_namespace)
+    raptor_parser_set_namespace_handler(worker->rdf_parser,
+                                        worker->serializer, relay_namespaces);
+
+  return rc;
+}
+
+
+/* Parse and serialize one input with @worker */
+static void
+rapper_worker_run_job(rapper_worker* worker, rapper_job* job)
+{
+  const rapper_jobs_settings* settings = worker->jobs->settings;
+  const char* filename = NULL;
+  unsigned char* uri_string;
+  raptor_uri* uri = NULL;
+  raptor_uri* base_uri = NULL;
+  char bnodeid_prefix[32];
+  int rc = 1;
+
+  worker->job = job;
+  job->parser_name = NULL;
+
+  /* generate the same blank node IDs whichever worker parses the
+   * input, with a prefix per input so they are distinct across inputs */
+  sprintf(bnodeid_prefix, "in%dgenid", job->index + 1);
+  raptor_world_set_generate_bnodeid_parameters(worker->world,
+                                               bnodeid_prefix, 1);
+
+  if(!access(job->input, R_OK)) {
+    filename = job->input;
+    uri_string = raptor_uri_filename_to_uri_string(filename);
+  } else
+    uri_string = (unsigned char*)job->input;
+
+  if(uri_string)
+    uri = raptor_new_uri(worker->world, uri_string);
+  if(!uri) {
+    fprintf(stderr, "%s: Failed to create URI for %s\n",
+            program, job->input);
+    goto tidy;
+  }
+
+  if(settings->base_uri_string &&
+     strcmp((const char*)settings->base_uri_string, "-"))
+    base_uri = raptor_new_uri(worker->world, settings->base_uri_string);
+
+  if(settings->serializer_syntax_name &&
+     rapper_worker_start_serializer(worker, base_uri)) {
+    fprintf(stderr, "%s: Failed to create raptor serializer type %s\n",
+            program, settings->serializer_syntax_name);
+    goto tidy;
+  }
+
+  if(filename && settings->input_compression != RAPTOR_COMPRESSION_AUTO) {
+    raptor_iostream *iostr;
+
+    iostr = raptor_new_iostream_from_filename_compressed(worker->world,
+                                                         filename,
+                                                         settings->input_compression);
+    rc = !iostr ||
+      raptor_parser_parse_iostream(worker->rdf_parser, iostr,
+                                   base_uri ? base_uri : uri);
+    if(iostr)
+      raptor_free_iostream(iostr);
+  } else if(filename)
+    rc = raptor_parser_parse_file(worker->rdf_parser, uri, base_uri);
+  else
+    rc = raptor_parser_parse_uri(worker->rdf_parser, uri, base_uri);
+
+  if(rc)
+    fprintf(stderr, "%s: Failed to parse %s %s content\n",
+            program, job->input, settings->syntax_name);
+
+  /* as for a single input, only name a guessed parser that returned
+   * triples for this input */
+  if(guess && job->triple_count) {
+    const char* name = raptor_parser_get_name(worker->rdf_parser);
+    size_t len = strlen(name) + 1;
+
+    job->parser_name = (char*)raptor_alloc_memory(len);
+    if(job->parser_name)
+      memcpy(job->parser_name, name, len);
+  }
+
+  tidy:
+  if(worker->serializer) {
+    raptor_serializer_serialize_end(worker->serializer);
+    raptor_free_serializer(worker->serializer);
+    worker->serializer = NULL;
+  }
+  if(!report_namespace)
+    raptor_parser_set_namespace_handler(worker->rdf_parser, NULL, NULL);
+
+  if(base_uri)
+    raptor_free_uri(base_uri);
+  if(uri)
+    raptor_free_uri(uri);
+  if(filename && uri_string)
+    raptor_free_memory(uri_string);
+
+  job->failed = rc;
+  worker->job = NULL;
+}
+
+
+#ifdef HAVE_PTHREAD
+static void*
+rapper_worker_run(void* arg)
+{
+  rapper_worker* worker = (rapper_worker*)arg;
+  rapper_jobs* jobs = worker->jobs;
+
+  while(1) {
+    rapper_job* job;
+
+    pthread_mutex_lock(&jobs->lock);
+    while(jobs->next < jobs->jobs_count &&
+          jobs->next >= jobs->written + 2 * jobs->workers_count)
+      pthread_cond_wait(&jobs->job_written, &jobs->lock);
+    if(jobs->next == jobs->jobs_count) {
+      pthread_mutex_unlock(&jobs->lock);
+      break;
+    }
+    job = &jobs->jobs[jobs->next++];
+    pthread_mutex_unlock(&jobs->lock);
+
+    rapper_worker_run_job(worker, job);
+
+    pthread_mutex_lock(&jobs->lock);
+    job->done = 1;
+    pthread_cond_broadcast(&jobs->job_done);
+    pthread_mutex_unlock(&jobs->lock);
+  }
+
+  return NULL;
+}
+#endif
+
+
+/*
+ * Parse the @inputs_count inputs with up to @workers_count workers,
+ * writing the serialized output of each in turn to @output_iostr or
+ * stdout; returns non-0 if any input failed to parse
+ */
+static int
+rapper_run_jobs(const rapper_jobs_settings* settings,
+                char** inputs, int inputs_count, int workers_count,
+                raptor_iostream* output_iostr)
+{
+  rapper_jobs jobs;
+  int files_count = 0;
+  int failed = 0;
+#ifdef HAVE_PTHREAD
+  /* number of worker threads started */
+  int threaded = 0;
+#endif
+  int i;
+
+  if(workers_count > inputs_count)
+    workers_count = inputs_count;
+#ifndef HAVE_PTHREAD
+  if(workers_count > 1) {
+    fprintf(stderr, "%s: Parallel jobs need threads - parsing one input at a time\n",
+            program);
+    workers_count = 1;
+  }
+#endif
+
+  memset(&jobs, 0, sizeof(jobs));
+  jobs.settings = settings;
+  jobs.jobs_count = inputs_count;
+  jobs.jobs = (rapper_job*)raptor_calloc_memory(sizeof(rapper_job),
+                                                (size_t)inputs_count);
+  jobs.workers = (rapper_worker*)raptor_calloc_memory(sizeof(rapper_worker),
+                                                      (size_t)workers_count);
+  if(!jobs.jobs || !jobs.workers) {
+    failed = 1;
+    goto tidy;
+  }
+
+  for(i = 0; i < inputs_count; i++) {
+    jobs.jobs[i].input = inputs[i];
+    jobs.jobs[i].index = i;
+  }
+
+  for(i = 0; i < workers_count; i++) {
+    if(rapper_worker_init(&jobs.workers[i], &jobs)) {
+      fprintf(stderr, "%s: Failed to create raptor parser type %s\n",
+              program, settings->syntax_name);
+      failed = 1;
+      goto tidy;
+    }
+    jobs.workers_count++;
+  }
+
+#ifdef HAVE_PTHREAD
+  if(workers_count > 1) {
+    pthread_mutex_init(&jobs.lock, NULL);
+    pthread_cond_init(&jobs.job_done, NULL);
+    pthread_cond_init(&jobs.job_written, NULL);
+
+    for(i = 0; i < workers_count; i++) {
+      if(pthread_create(&jobs.workers[i].thread, NULL, rapper_worker_run,
+                        &jobs.workers[i])) {
+        fprintf(stderr, "%s: Failed to start parsing thread\n", program);
+        /* the started workers take every job */
+        break;
+      }
+    }
+    threaded = i;
+    if(!threaded) {
+      pthread_cond_destroy(&jobs.job_written);
+      pthread_cond_destroy(&jobs.job_done);
+      pthread_mutex_destroy(&jobs.lock);
+    }
+  }
+#endif
+
+  for(i = 0; i < inputs_count; i++) {
+    rapper_job* job = &jobs.jobs[i];
+
+#ifdef HAVE_PTHREAD
+    if(threaded) {
+      pthread_mutex_lock(&jobs.lock);
+      while(!job->done)
+        pthread_cond_wait(&jobs.job_done, &jobs.lock);
+      pthread_mutex_unlock(&jobs.lock);
+    } else
+#endif
+      rapper_worker_run_job(&jobs.workers[0], job);
+
+    if(job->output) {
+      if(output_iostr)
+        raptor_iostream_write_bytes(job->output, 1, job->output_len,
+                                    output_iostr);
+      else
+        fwrite(job->output, 1, job->output_len, stdout);
+      raptor_free_memory(job->output);
+      job->output = NULL;
+    }
+
+    if(!quiet) {
+      if(job->parser_name)
+        fprintf(stderr, "%s: %s: %ld triples with parser %s\n",
+                program, job->input, job->triple_count, job->parser_name);
+      else
+        fprintf(stderr, "%s: %s: %ld triples\n",
+                program, job->input, job->triple_count);
+    }
+    if(job->parser_name) {
+      raptor_free_memory(job->parser_name);
+      job->parser_name = NULL;
+    }
+
+    triple_count += job->triple_count;
+    error_count += job->error_count;
+    warning_count += job->warning_count;
+    if(job->failed)
+      failed = 1;
+    if(!job->failed && !job->error_count)
+      files_count++;
+
+#ifdef HAVE_PTHREAD
+    if(threaded) {
+      pthread_mutex_lock(&jobs.lock);
+      jobs.written = i + 1;
+      pthread_cond_broadcast(&jobs.job_written);
+      pthread_mutex_unlock(&jobs.lock);
+    }
+#endif
+  }
+
+#ifdef HAVE_PTHREAD
+  if(threaded) {
+    for(i = 0; i < threaded; i++)
+      pthread_join(jobs.workers[i].thread, NULL);
+    pthread_cond_destroy(&jobs.job_written);
+    pthread_cond_destroy(&jobs.job_done);
+    pthread_mutex_destroy(&jobs.lock);
+  }
+#endif
+
+  if(!quiet)
+    fprintf(stderr, "%s: Parsed %d of %d inputs without errors using %d jobs\n",
+            program, files_count, inputs_count, workers_count);
+
+  tidy:
+  if(jobs.workers) {
+    for(i = 0; i < jobs.workers_count; i++)
+      rapper_worker_clear(&jobs.workers[i]);
+    raptor_free_memory(jobs.workers);
+  }
+  if(jobs.jobs)
+    raptor_free_memory(jobs.jobs);
+
+  return failed;
+}
+
+
 
 int
 main(int argc, char *argv[]) 
@@ -311,6 +1411,7 @@ main(int argc, char *argv[])
    * or if NULL, stdin.  Base URI in 'base_uri_string' is required for stdin.
    */
   raptor_world* world = NULL;
+  raptor_world* output_world = NULL;
   raptor_parser* rdf_parser = NULL;
   char *filename = NULL;
 #define FILENAME_LABEL(name) ((name) ? (name) : "<stdin>")
@@ -330,6 +1431,14 @@ main(int argc, char *argv[])
   raptor_uri *output_base_uri = NULL;
   raptor_sequence* serializer_options = NULL;
   raptor_sequence *namespace_declarations = NULL;
+  raptor_iostream *output_iostr = NULL;
+  raptor_compression input_compression = RAPTOR_COMPRESSION_AUTO;
+  raptor_compression output_compression = RAPTOR_COMPRESSION_NONE;
+#ifdef HAVE_PTHREAD
+  rapper_pipeline* pipeline = NULL;
+#endif
+  /* number of workers for multiple inputs or 0 for one input */
+  int jobs_count = 0;
 
   /* other variables */
   int rc;
@@ -530,6 +1639,10 @@ main(int argc, char *argv[])
         trace = 1;
         break;
 
+      case 'p':
+        pipelined = 1;
+        break;
+
       case 'q':
         quiet = 1;
         break;
@@ -597,6 +1710,17 @@ main(int argc, char *argv[])
         if(optarg)
           base_uri_string = (unsigned char*)optarg;
         break;
+
+      case 'j':
+        if(optarg) {
+          jobs_count = atoi(optarg);
+          if(jobs_count < 1) {
+            fprintf(stderr, "%s: invalid argument `%s' for `" HELP_ARG(j, jobs) "'\n",
+                    program, optarg);
+            usage = 1;
+          }
+        }
+        break;
         
       case 'w':
         ignore_warnings = 1;
@@ -625,11 +1749,26 @@ main(int argc, char *argv[])
         break;
 #endif
 
+#ifdef INPUT_COMPRESSION_FLAG
+      case INPUT_COMPRESSION_FLAG:
+        if(optarg && rapper_compression_from_name(optarg, &input_compression))
+          usage = 1;
+        break;
+
+      case OUTPUT_COMPRESSION_FLAG:
+        if(optarg && rapper_compression_from_name(optarg, &output_compression))
+          usage = 1;
+        break;
+#endif
+
     } /* end switch */
 
   }
 
-  if(optind != argc-1 && optind != argc-2 && !help && !usage) {
+  if(jobs_count) {
+    if(optind == argc && !help && !usage)
+      usage = 2; /* Title and usage */
+  } else if(optind != argc-1 && optind != argc-2 && !help && !usage) {
     usage = 2; /* Title and usage */
   }
 
@@ -657,7 +1796,8 @@ main(int argc, char *argv[])
     
     puts(title_string); putchar(' '); puts(raptor_version_string); putchar('\n');
     puts("Parse RDF syntax from a source into serialized RDF triples.");
-    printf("Usage: %s [OPTIONS] INPUT-URI [INPUT-BASE-URI]\n\n", program);
+    printf("Usage: %s [OPTIONS] INPUT-URI [INPUT-BASE-URI]\n", program);
+    printf("       %s [OPTIONS] " HELP_ARG(j, jobs) " N INPUT-URI...\n\n", program);
 
     fputs(raptor_copyright_string, stdout);
     fputs("\nLicense: ", stdout);
@@ -685,6 +1825,9 @@ main(int argc, char *argv[])
         putchar('\n');
     }
     puts(HELP_TEXT("I URI", "input-uri URI   ", "Set the input/parser base URI. '-' for none.") HELP_PAD "    Default is INPUT-BASE-URI argument value.");
+#ifdef INPUT_COMPRESSION_FLAG
+    puts(HELP_TEXT_LONG("input-compression TYPE", HELP_PAD "Set the file input compression to one of none, auto, gzip or zstd" HELP_PAD "    Default is auto - detect gzip and zstd content."));
+#endif
     putchar('\n');
 
     puts(HELP_TEXT("o FORMAT", "output FORMAT", "Set the output format/serializer to one of:"));
@@ -700,6 +1843,9 @@ main(int argc, char *argv[])
         putchar('\n');
     }
     puts(HELP_TEXT("O URI", "output-uri URI  ", "Set the output/serializer base URI. '-' for none.")  HELP_PAD "    Default is input/parser base URI.");
+#ifdef OUTPUT_COMPRESSION_FLAG
+    puts(HELP_TEXT_LONG("output-compression TYPE", HELP_PAD "Compress the output with one of none, gzip or zstd" HELP_PAD "    Default is none."));
+#endif
     putchar('\n');
 
     puts("General options:");
@@ -708,6 +1854,8 @@ main(int argc, char *argv[])
     puts(HELP_TEXT("f OPTION(=VALUE)", "feature OPTION(=VALUE)", HELP_PAD "Set parser or serializer options" HELP_PAD "Use `-f help' for a list of valid options"));
     puts(HELP_TEXT("g", "guess           ", "Guess the input syntax (same as -i guess)"));
     puts(HELP_TEXT("h", "help            ", "Print this help, then exit"));
+    puts(HELP_TEXT("j N", "jobs N          ", "Parse every INPUT-URI argument with N parsers" HELP_PAD "    Output is written in argument order"));
+    puts(HELP_TEXT("p", "pipeline        ", "Parse and serialize on separate threads"));
     puts(HELP_TEXT("q", "quiet           ", "No extra information messages"));
     puts(HELP_TEXT("r", "replace-newlines", "Replace newlines with spaces in literals"));
 #ifdef SHOW_GRAPHS_FLAG
@@ -726,6 +1874,80 @@ main(int argc, char *argv[])
   }
 
 
+  if(jobs_count) {
+    rapper_jobs_settings settings;
+
+    for(rc = optind; rc < argc; rc++) {
+      if(!strcmp(argv[rc], "-")) {
+        fprintf(stderr,
+                "%s: Standard input cannot be one of several inputs.\n",
+                program);
+        return(1);
+      }
+    }
+
+    if(pipelined)
+      fprintf(stderr, "%s: Pipelining is not used with multiple inputs\n",
+              program);
+
+    if(guess)
+      syntax_name = "guess";
+
+    settings.syntax_name = syntax_name;
+    settings.serializer_syntax_name = serializer_syntax_name;
+    settings.base_uri_string = base_uri_string;
+    settings.output_base_uri_string = output_base_uri_string;
+    settings.parser_options = parser_options;
+    settings.serializer_options = serializer_options;
+    settings.namespace_declarations = namespace_declarations;
+    settings.input_compression = input_compression;
+    settings.trace = trace;
+
+    if(serializer_syntax_name &&
+       output_compression != RAPTOR_COMPRESSION_NONE) {
+      output_iostr = raptor_new_iostream_to_file_handle_compressed(world,
+                                                                   stdout,
+                                                                   output_compression);
+      if(!output_iostr) {
+        fprintf(stderr, "%s: Failed to create %s compressed output\n",
+                program, compression_names[output_compression]);
+        return(1);
+      }
+    }
+
+    rc = rapper_run_jobs(&settings, &argv[optind], argc - optind,
+                         jobs_count, output_iostr);
+
+    if(output_iostr)
+      raptor_free_iostream(output_iostr);
+
+    if(!quiet) {
+      if(triple_count == 1)
+        fprintf(stderr, "%s: Parsing returned 1 triple\n",
+                program);
+      else
+        fprintf(stderr, "%s: Parsing returned %ld triples\n",
+                program, triple_count);
+    }
+
+    if(namespace_declarations)
+      raptor_free_sequence(namespace_declarations);
+    if(parser_options)
+      raptor_free_sequence(parser_options);
+    if(serializer_options)
+      raptor_free_sequence(serializer_options);
+
+    raptor_free_world(world);
+
+    if(error_count && !ignore_errors)
+      return 1;
+
+    if(warning_count && !ignore_warnings)
+      return 2;
+
+    return(rc);
+  }
+
   if(optind == argc-1)
     uri_string = (unsigned char*)argv[optind];
   else {
@@ -777,15 +1999,43 @@ main(int argc, char *argv[])
   }
 
 
+  /* Serializing in pipelined mode uses a second world since the
+   * serializer runs on another thread.
+   */
+  output_world = world;
+  if(pipelined && serializer_syntax_name) {
+#ifdef HAVE_PTHREAD
+    if(!raptor_world_is_parser_name(world, "binary") ||
+       !raptor_world_is_serializer_name(world, "binary")) {
+      fprintf(stderr, "%s: Pipelining needs binary RDF support - serializing on one thread\n",
+              program);
+    } else {
+      output_world = raptor_new_world();
+      if(!output_world || raptor_world_open(output_world)) {
+        fprintf(stderr, "%s: Failed to create serializer world\n", program);
+        return(1);
+      }
+    }
+#else
+    fprintf(stderr, "%s: Pipelining needs threads - serializing on one thread\n",
+            program);
+#endif
+  }
+
   /* Set the output/serializer base URI from the argument if explicitly
    * set, otherwise default to the input base URI if present.
    */
   if(!output_base_uri_string) {
-    if(base_uri)
-      output_base_uri = raptor_uri_copy(base_uri);
+    if(base_uri) {
+      if(output_world == world)
+        output_base_uri = raptor_uri_copy(base_uri);
+      else
+        output_base_uri = raptor_new_uri(output_world,
+                                         raptor_uri_as_string(base_uri));
+    }
   } else {
     if(strcmp((const char*)output_base_uri_string, "-")) {
-      output_base_uri = raptor_new_uri(world, output_base_uri_string);
+      output_base_uri = raptor_new_uri(output_world, output_base_uri_string);
       if(!output_base_uri) {
         fprintf(stderr, "%s: Failed to create output base URI for %s\n",
                 program, output_base_uri_string);
@@ -863,7 +2113,7 @@ main(int argc, char *argv[])
                 program, serializer_syntax_name);
     }
 
-    serializer = raptor_new_serializer(world, serializer_syntax_name);
+    serializer = raptor_new_serializer(output_world, serializer_syntax_name);
     if(!serializer) {
       fprintf(stderr, 
               "%s: Failed to create raptor serializer type %s\n", program,
@@ -879,7 +2129,7 @@ main(int argc, char *argv[])
 
         nd = (struct namespace_decl*)raptor_sequence_get_at(namespace_declarations, i);
         if(nd->uri_string)
-          ns_uri = raptor_new_uri(world, nd->uri_string);
+          ns_uri = raptor_new_uri(output_world, nd->uri_string);
         
         raptor_serializer_set_namespace(serializer, ns_uri, nd->prefix);
         if(ns_uri)
@@ -900,9 +2150,31 @@ main(int argc, char *argv[])
       serializer_options = NULL;
     }
 
-    raptor_serializer_start_to_file_handle(serializer, 
-                                          output_base_uri, stdout);
-
+    if(output_compression != RAPTOR_COMPRESSION_NONE) {
+      output_iostr = raptor_new_iostream_to_file_handle_compressed(output_world,
+                                                                   stdout,
+                                                                   output_compression);
+      if(!output_iostr) {
+        fprintf(stderr, "%s: Failed to create %s compressed output\n",
+                program, compression_names[output_compression]);
+        return(1);
+      }
+      raptor_serializer_start_to_iostream(serializer, output_base_uri,
+                                          output_iostr);
+    } else
+      raptor_serializer_start_to_file_handle(serializer, 
+                                            output_base_uri, stdout);
+
+#ifdef HAVE_PTHREAD
+    if(output_world != world) {
+      pipeline = rapper_new_pipeline(world, rdf_parser, output_world);
+      if(!pipeline) {
+        fprintf(stderr, "%s: Failed to start pipelined serializing\n",
+                program);
+        return(1);
+      }
+    } else
+#endif
     if(!report_namespace)
       raptor_parser_set_namespace_handler(rdf_parser, serializer,
                                           relay_namespaces);
@@ -913,7 +2185,26 @@ main(int argc, char *argv[])
    * sending it to serializer via callback print_triples()
    */
   rc = 0;
-  if(!uri || filename) {
+  if((!uri || filename) && input_compression != RAPTOR_COMPRESSION_AUTO) {
+    /* explicit compression so parse from a decompressing iostream */
+    raptor_iostream *iostr;
+
+    if(filename)
+      iostr = raptor_new_iostream_from_filename_compressed(world, filename,
+                                                           input_compression);
+    else
+      iostr = raptor_new_iostream_from_file_handle_compressed(world, stdin,
+                                                              input_compression);
+    if(!iostr ||
+       raptor_parser_parse_iostream(rdf_parser, iostr,
+                                    base_uri ? base_uri : uri)) {
+      fprintf(stderr, "%s: Failed to parse file %s %s content\n",
+              program, FILENAME_LABEL(filename), syntax_name);
+      rc = 1;
+    }
+    if(iostr)
+      raptor_free_iostream(iostr);
+  } else if(!uri || filename) {
     if(raptor_parser_parse_file(rdf_parser, uri, base_uri)) {
       fprintf(stderr, "%s: Failed to parse file %s %s content\n",
               program, FILENAME_LABEL(filename), syntax_name);
@@ -929,10 +2220,19 @@ main(int argc, char *argv[])
 
   raptor_free_parser(rdf_parser);
 
+#ifdef HAVE_PTHREAD
+  if(pipeline)
+    rapper_free_pipeline(pipeline);
+#endif
+
   if(serializer) {
-    raptor_serializer_serialize_end(serializer);
+    /* a pipeline ends the serialization on its own thread */
+    if(output_world == world)
+      raptor_serializer_serialize_end(serializer);
     raptor_free_serializer(serializer);
   }
+  if(output_iostr)
+    raptor_free_iostream(output_iostr);
   
 
   if(!quiet) {
@@ -960,6 +2260,8 @@ main(int argc, char *argv[])
   if(serializer_options)
     raptor_free_sequence(serializer_options);
 
+  if(output_world != world)
+    raptor_free_world(output_world);
   raptor_free_world(world);
 
   if(error_count && !ignore_errors)
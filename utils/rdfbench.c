@@ -0,0 +1,1182 @@
+/* -*- Mode: c; c-basic-offset: 2 -*-
+ *
+ * rdfbench.c - Raptor parser and serializer throughput benchmark
+ *
+ * Copyright (C) 2026, David Beckett http://www.dajobe.org/
+ *
+ * This package is Free Software and part of Redland http://librdf.org/
+ *
+ * It is licensed under the following three licenses as alternatives:
+ *   1. GNU Lesser General Public License (LGPL) V2.1 or any newer version
+ *   2. GNU General Public License (GPL) V2 or any newer version
+ *   3. Apache License, V2.0 or any newer version
+ *
+ * You may not use this file except in compliance with at least one of
+ * the above three licenses.
+ *
+ * See LICENSE.html or LICENSE.txt at the top of this package for the
+ * complete terms and further detail along with the license texts for
+ * the licenses in COPYING.LIB, COPYING and LICENSE-2.0.txt respectively.
+ *
+ *
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <raptor_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+/* Raptor includes */
+#include <raptor2.h>
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+/* many places for getopt */
+#ifdef HAVE_GETOPT_H
+#include <getopt.h>
+#else
+#include <raptor_getopt.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/wait.h>
+#endif
+
+/* measure each parser and serializer in a new process */
+#if defined(HAVE_FORK) && defined(HAVE_SYS_WAIT_H) && defined(HAVE_UNISTD_H)
+#define RDFBENCH_USE_FORK 1
+#endif
+
+
+#ifdef NEED_OPTIND_DECLARATION
+extern int optind;
+extern char *optarg;
+#endif
+
+int main(int argc, char *argv[]);
+
+
+static char *program = NULL;
+
+/* no progress table */
+static int quiet = 0;
+
+
+/*
+ * Allocation counting
+ *
+ * With glibc the allocation functions are wrapped so every malloc,
+ * calloc and realloc made by the library is counted.  Elsewhere, or
+ * when a sanitizer provides its own allocator, the count is reported
+ * as unknown.
+ */
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define RDFBENCH_COUNT_ALLOCATIONS 1
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static unsigned long allocations_count = 0;
+
+void*
+malloc(size_t size)
+{
+  __sync_fetch_and_add(&allocations_count, 1);
+  return __libc_malloc(size);
+}
+
+void*
+calloc(size_t nmemb, size_t size)
+{
+  __sync_fetch_and_add(&allocations_count, 1);
+  return __libc_calloc(nmemb, size);
+}
+
+void*
+realloc(void *ptr, size_t size)
+{
+  __sync_fetch_and_add(&allocations_count, 1);
+  return __libc_realloc(ptr, size);
+}
+#endif
+
+
+/* synthetic data settings */
+typedef struct
+{
+  int triples;
+  int literal_length;
+  double bnode_ratio;
+  int prefixes;
+  double unicode_share;
+  int graphs;
+  unsigned long seed;
+} rdfbench_settings;
+
+
+/* one measurement */
+typedef struct
+{
+  const char* parser_name;
+  const char* serializer_name;
+  long triples;
+  size_t bytes;
+  double seconds;
+  long peak_rss_kb;
+  long allocations;
+  int errors;
+} rdfbench_result;
+
+
+typedef struct
+{
+  raptor_world* world;
+  const rdfbench_settings* settings;
+  raptor_uri* base_uri;
+
+  /* generated statements */
+  raptor_statement** statements;
+  int statements_count;
+  /* namespace URIs used by the statements */
+  raptor_uri** namespaces;
+
+  /* current parse */
+  raptor_serializer* serializer;
+  long triples;
+  int errors;
+
+  int repeat;
+  raptor_sequence* results;
+  /* non-0 once a measurement has run in this process */
+  int measured;
+} rdfbench;
+
+
+#define RDFBENCH_BASE_URI "http://example.org/base/"
+#define RDFBENCH_NS_URI_FORMAT "http://example.org/vocab%d/"
+#define RDFBENCH_PREDICATES 16
+#define RDFBENCH_CHUNK_SIZE (64 * 1024)
+
+
+/* xorshift64* so the generated data is the same everywhere */
+static unsigned long long rdfbench_random_state;
+
+static unsigned long long
+rdfbench_random(void)
+{
+  rdfbench_random_state ^= rdfbench_random_state >> 12;
+  rdfbench_random_state ^= rdfbench_random_state << 25;
+  rdfbench_random_state ^= rdfbench_random_state >> 27;
+  return rdfbench_random_state * 0x2545F4914F6CDD1DULL;
+}
+
+
+/* random number in 0..@n-1 */
+static int
+rdfbench_random_below(int n)
+{
+  return (int)((rdfbench_random() >> 11) % (unsigned long long)n);
+}
+
+
+/* random fraction in [0, 1) */
+static double
+rdfbench_random_fraction(void)
+{
+  return (double)(rdfbench_random() >> 11) / 9007199254740992.0;
+}
+
+
+static double
+rdfbench_now(void)
+{
+#ifdef HAVE_GETTIMEOFDAY
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+#else
+  return (double)clock() / (double)CLOCKS_PER_SEC;
+#endif
+}
+
+
+/* Start a new peak RSS measurement where the system allows it */
+static void
+rdfbench_reset_peak_rss(void)
+{
+#ifdef __linux__
+  FILE* fh = fopen("/proc/self/clear_refs", "w");
+
+  if(fh) {
+    fputs("5", fh);
+    fclose(fh);
+  }
+#endif
+}
+
+
+/* Peak resident set size in kilobytes or -1 if unknown */
+static long
+rdfbench_peak_rss(void)
+{
+  long kb = -1;
+#ifdef __linux__
+  FILE* fh = fopen("/proc/self/status", "r");
+
+  if(fh) {
+    char line[128];
+
+    while(fgets(line, sizeof(line), fh)) {
+      if(!strncmp(line, "VmHWM:", 6)) {
+        kb = atol(line + 6);
+        break;
+      }
+    }
+    fclose(fh);
+  }
+#endif
+#ifdef HAVE_GETRUSAGE
+  if(kb < 0) {
+    struct rusage usage;
+
+    if(!getrusage(RUSAGE_SELF, &usage))
+      kb = usage.ru_maxrss;
+  }
+#endif
+
+  return kb;
+}
+
+
+static long
+rdfbench_allocations(void)
+{
+#ifdef RDFBENCH_COUNT_ALLOCATIONS
+  return (long)allocations_count;
+#else
+  return -1;
+#endif
+}
+
+
+static void
+rdfbench_log_handler(void *data, raptor_log_message *message)
+{
+  rdfbench* bench = (rdfbench*)data;
+
+  if(message->level >= RAPTOR_LOG_LEVEL_ERROR)
+    bench->errors++;
+}
+
+
+/* Append a literal string of the configured length to @sb */
+static void
+rdfbench_generate_literal(rdfbench* bench, raptor_stringbuffer* sb)
+{
+  /* UTF-8 sequences of 2, 3 and 4 bytes */
+  static const char* const non_ascii[] = {
+    "\xc3\xa9", "\xc3\x9f", "\xce\xbb", "\xe4\xb8\xad", "\xe2\x82\xac",
+    "\xf0\x9f\x98\x80"
+  };
+  /* characters that must be escaped in most syntaxes */
+  static const char escapes[] = "\"\\\n\t<>&";
+  int i;
+
+  for(i = 0; i < bench->settings->literal_length; i++) {
+    if(bench->settings->unicode_share > 0.0 &&
+       rdfbench_random_fraction() < bench->settings->unicode_share) {
+      const char* s = non_ascii[rdfbench_random_below(6)];
+      raptor_stringbuffer_append_string(sb, (const unsigned char*)s, 1);
+    } else if(!rdfbench_random_below(64)) {
+      raptor_stringbuffer_append_counted_string(sb, (const unsigned char*)&escapes[rdfbench_random_below(sizeof(escapes) - 1)], 1, 1);
+    } else {
+      unsigned char c = (unsigned char)('a' + rdfbench_random_below(27));
+      if(c > 'z')
+        c = ' ';
+      raptor_stringbuffer_append_counted_string(sb, &c, 1, 1);
+    }
+  }
+}
+
+
+static raptor_term*
+rdfbench_new_uri_term(rdfbench* bench, int ns, const char* format, int n)
+{
+  char local[32];
+  raptor_uri* uri;
+  raptor_term* term;
+
+  sprintf(local, format, n);
+  uri = raptor_new_uri_from_uri_local_name(bench->world,
+                                           bench->namespaces[ns],
+                                           (const unsigned char*)local);
+  term = raptor_new_term_from_uri(bench->world, uri);
+  raptor_free_uri(uri);
+
+  return term;
+}
+
+
+static raptor_term*
+rdfbench_new_blank_term(rdfbench* bench, int n)
+{
+  char id[32];
+
+  sprintf(id, "b%d", n);
+  return raptor_new_term_from_blank(bench->world, (const unsigned char*)id);
+}
+
+
+/* Create the synthetic statements; returns non-0 on failure */
+static int
+rdfbench_generate(rdfbench* bench)
+{
+  const rdfbench_settings* settings = bench->settings;
+  raptor_uri* xsd_integer_uri;
+  raptor_term** graphs = NULL;
+  int i;
+
+  rdfbench_random_state = settings->seed ? settings->seed : 1;
+
+  bench->namespaces = (raptor_uri**)calloc((size_t)settings->prefixes,
+                                           sizeof(raptor_uri*));
+  bench->statements = (raptor_statement**)calloc((size_t)settings->triples,
+                                                 sizeof(raptor_statement*));
+  if(!bench->namespaces || !bench->statements)
+    return 1;
+
+  for(i = 0; i < settings->prefixes; i++) {
+    char ns[64];
+
+    sprintf(ns, RDFBENCH_NS_URI_FORMAT, i);
+    bench->namespaces[i] = raptor_new_uri(bench->world,
+                                          (const unsigned char*)ns);
+    if(!bench->namespaces[i])
+      return 1;
+  }
+
+  if(settings->graphs) {
+    graphs = (raptor_term**)calloc((size_t)settings->graphs,
+                                   sizeof(raptor_term*));
+    if(!graphs)
+      return 1;
+    for(i = 0; i < settings->graphs; i++)
+      graphs[i] = rdfbench_new_uri_term(bench, i % settings->prefixes,
+                                        "graph%d", i);
+  }
+
+  xsd_integer_uri = raptor_new_uri(bench->world, (const unsigned char*)"http://www.w3.org/2001/XMLSchema#integer");
+
+  for(i = 0; i < settings->triples; i++) {
+    raptor_term *subject, *predicate, *object;
+    raptor_term *graph = NULL;
+    int kind;
+
+    /* about 4 statements per subject */
+    if(rdfbench_random_fraction() < settings->bnode_ratio)
+      subject = rdfbench_new_blank_term(bench, i / 4);
+    else
+      subject = rdfbench_new_uri_term(bench,
+                                      rdfbench_random_below(settings->prefixes),
+                                      "s%d", i / 4);
+
+    predicate = rdfbench_new_uri_term(bench,
+                                      rdfbench_random_below(settings->prefixes),
+                                      "p%d",
+                                      rdfbench_random_below(RDFBENCH_PREDICATES));
+
+    kind = rdfbench_random_below(100);
+    if(rdfbench_random_fraction() < settings->bnode_ratio)
+      object = rdfbench_new_blank_term(bench, rdfbench_random_below(i / 4 + 1));
+    else if(kind < 30)
+      object = rdfbench_new_uri_term(bench,
+                                     rdfbench_random_below(settings->prefixes),
+                                     "s%d", rdfbench_random_below(i / 4 + 1));
+    else if(kind < 45) {
+      char value[32];
+
+      sprintf(value, "%d", rdfbench_random_below(1000000));
+      object = raptor_new_term_from_literal(bench->world,
+                                            (const unsigned char*)value,
+                                            xsd_integer_uri, NULL);
+    } else {
+      raptor_stringbuffer* sb = raptor_new_stringbuffer();
+
+      rdfbench_generate_literal(bench, sb);
+      object = raptor_new_term_from_counted_literal(bench->world,
+                                                    raptor_stringbuffer_as_string(sb),
+                                                    raptor_stringbuffer_length(sb),
+                                                    NULL,
+                                                    (kind < 60) ? (const unsigned char*)"en" : NULL,
+                                                    (kind < 60) ? 2 : 0);
+      raptor_free_stringbuffer(sb);
+    }
+
+    if(graphs)
+      graph = raptor_term_copy(graphs[rdfbench_random_below(settings->graphs)]);
+
+    bench->statements[i] = raptor_new_statement_from_nodes(bench->world,
+                                                           subject, predicate,
+                                                           object, graph);
+    if(!bench->statements[i])
+      break;
+    bench->statements_count++;
+  }
+
+  raptor_free_uri(xsd_integer_uri);
+  if(graphs) {
+    for(i = 0; i < settings->graphs; i++)
+      raptor_free_term(graphs[i]);
+    free(graphs);
+  }
+
+  return bench->statements_count != settings->triples;
+}
+
+
+static void
+rdfbench_free(rdfbench* bench)
+{
+  int i;
+
+  if(bench->statements) {
+    for(i = 0; i < bench->statements_count; i++)
+      raptor_free_statement(bench->statements[i]);
+    free(bench->statements);
+  }
+  if(bench->namespaces) {
+    for(i = 0; i < bench->settings->prefixes; i++) {
+      if(bench->namespaces[i])
+        raptor_free_uri(bench->namespaces[i]);
+    }
+    free(bench->namespaces);
+  }
+}
+
+
+/* Create a serializer writing to a string with the namespaces declared */
+static raptor_serializer*
+rdfbench_new_serializer(rdfbench* bench, const char* name,
+                        void** string_p, size_t* length_p)
+{
+  raptor_serializer* serializer;
+  int i;
+
+  serializer = raptor_new_serializer(bench->world, name);
+  if(!serializer)
+    return NULL;
+
+  for(i = 0; i < bench->settings->prefixes; i++) {
+    char prefix[16];
+
+    sprintf(prefix, "v%d", i);
+    raptor_serializer_set_namespace(serializer, bench->namespaces[i],
+                                    (const unsigned char*)prefix);
+  }
+
+  if(raptor_serializer_start_to_string(serializer, bench->base_uri,
+                                       string_p, length_p)) {
+    raptor_free_serializer(serializer);
+    return NULL;
+  }
+
+  return serializer;
+}
+
+
+/* Serialize the generated statements with @name into a new string */
+static unsigned char*
+rdfbench_serialize(rdfbench* bench, const char* name, size_t* length_p)
+{
+  raptor_serializer* serializer;
+  void* string = NULL;
+  int i;
+
+  bench->errors = 0;
+  serializer = rdfbench_new_serializer(bench, name, &string, length_p);
+  if(!serializer)
+    return NULL;
+
+  for(i = 0; i < bench->statements_count; i++)
+    raptor_serializer_serialize_statement(serializer, bench->statements[i]);
+
+  raptor_serializer_serialize_end(serializer);
+  raptor_free_serializer(serializer);
+
+  /* feed serializers reject statements that are not shaped like a feed */
+  if(bench->errors && string) {
+    raptor_free_memory(string);
+    string = NULL;
+  }
+
+  return (unsigned char*)string;
+}
+
+
+/* Name of a serializer whose output @parser_name parses or NULL */
+static const char*
+rdfbench_input_syntax(rdfbench* bench, const char* parser_name)
+{
+  static const char* const inputs[][2] = {
+    { "rss-tag-soup", "rss-1.0" },
+    { "guess",        "ntriples" },
+    { NULL, NULL }
+  };
+  int i;
+
+  for(i = 0; inputs[i][0]; i++) {
+    if(!strcmp(inputs[i][0], parser_name))
+      return inputs[i][1];
+  }
+
+  if(raptor_world_is_serializer_name(bench->world, parser_name))
+    return parser_name;
+
+  return NULL;
+}
+
+
+static void
+rdfbench_count_statement(void *user_data, raptor_statement *statement)
+{
+  rdfbench* bench = (rdfbench*)user_data;
+
+  bench->triples++;
+}
+
+
+static void
+rdfbench_serialize_statement(void *user_data, raptor_statement *statement)
+{
+  rdfbench* bench = (rdfbench*)user_data;
+
+  bench->triples++;
+  raptor_serializer_serialize_statement(bench->serializer, statement);
+}
+
+
+/* Parse @input with @rdf_parser in chunks; returns non-0 on failure */
+static int
+rdfbench_parse(rdfbench* bench, raptor_parser* rdf_parser,
+               const unsigned char* input, size_t input_len)
+{
+  size_t offset = 0;
+
+  if(raptor_parser_parse_start(rdf_parser, bench->base_uri))
+    return 1;
+
+  while(offset < input_len) {
+    size_t len = input_len - offset;
+
+    if(len > RDFBENCH_CHUNK_SIZE)
+      len = RDFBENCH_CHUNK_SIZE;
+    if(raptor_parser_parse_chunk(rdf_parser, input + offset, len, 0))
+      return 1;
+    offset += len;
+  }
+
+  return raptor_parser_parse_chunk(rdf_parser, NULL, 0, 1);
+}
+
+
+static rdfbench_result*
+rdfbench_new_result(rdfbench* bench, const char* parser_name,
+                    const char* serializer_name)
+{
+  rdfbench_result* result;
+
+  result = (rdfbench_result*)calloc(1, sizeof(*result));
+  if(!result)
+    return NULL;
+
+  result->parser_name = parser_name;
+  result->serializer_name = serializer_name;
+  result->seconds = -1.0;
+  raptor_sequence_push(bench->results, result);
+
+  return result;
+}
+
+
+/*
+ * Run one measurement @bench->repeat times keeping the fastest.
+ * Either name may be NULL: a parser alone counts the statements, a
+ * serializer alone serializes the generated statements.
+ */
+static void
+rdfbench_run(rdfbench* bench, rdfbench_result* result,
+             const char* parser_name, const char* serializer_name,
+             const unsigned char* input, size_t input_len)
+{
+  long allocations;
+  int i;
+
+  rdfbench_reset_peak_rss();
+  allocations = rdfbench_allocations();
+
+  for(i = 0; i < bench->repeat; i++) {
+    raptor_parser* rdf_parser = NULL;
+    void* output = NULL;
+    size_t output_len = 0;
+    double start;
+    double seconds;
+
+    bench->triples = 0;
+    bench->errors = 0;
+    bench->serializer = NULL;
+
+    start = rdfbench_now();
+
+    if(serializer_name) {
+      bench->serializer = rdfbench_new_serializer(bench, serializer_name,
+                                                  &output, &output_len);
+      if(!bench->serializer)
+        bench->errors++;
+    }
+
+    if(parser_name) {
+      rdf_parser = raptor_new_parser(bench->world, parser_name);
+      if(rdf_parser) {
+        raptor_parser_set_statement_handler(rdf_parser, bench,
+                                            bench->serializer ?
+                                            rdfbench_serialize_statement :
+                                            rdfbench_count_statement);
+        if(rdfbench_parse(bench, rdf_parser, input, input_len))
+          bench->errors++;
+        raptor_free_parser(rdf_parser);
+      } else
+        bench->errors++;
+    } else if(bench->serializer) {
+      int j;
+
+      for(j = 0; j < bench->statements_count; j++)
+        raptor_serializer_serialize_statement(bench->serializer,
+                                              bench->statements[j]);
+      bench->triples = bench->statements_count;
+    }
+
+    if(bench->serializer) {
+      raptor_serializer_serialize_end(bench->serializer);
+      raptor_free_serializer(bench->serializer);
+      bench->serializer = NULL;
+    }
+
+    seconds = rdfbench_now() - start;
+
+    if(output)
+      raptor_free_memory(output);
+
+    if(!i) {
+      if(allocations >= 0)
+        result->allocations = rdfbench_allocations() - allocations;
+      else
+        result->allocations = -1;
+    }
+
+    result->triples = bench->triples;
+    /* parsers are measured by input size, serializers by output size */
+    result->bytes = parser_name ? input_len : output_len;
+    result->errors = bench->errors;
+    if(result->seconds < 0.0 || seconds < result->seconds)
+      result->seconds = seconds;
+  }
+
+  /* Memory kept by the allocator from an earlier measurement in this
+   * process stays resident even when the peak is reset, so only the
+   * first is known */
+  if(!bench->measured)
+    result->peak_rss_kb = rdfbench_peak_rss();
+  else
+    result->peak_rss_kb = -1;
+  bench->measured = 1;
+}
+
+
+#ifdef RDFBENCH_USE_FORK
+/*
+ * Run one measurement in a child process so that its peak RSS is not
+ * raised by memory the allocator kept from earlier measurements.
+ * Returns <0 if no child could be started, >0 if the child failed.
+ */
+static int
+rdfbench_run_child(rdfbench* bench, rdfbench_result* result,
+                   const char* parser_name, const char* serializer_name,
+                   const unsigned char* input, size_t input_len)
+{
+  rdfbench_result child_result;
+  int fds[2];
+  pid_t pid;
+  int status;
+  size_t offset = 0;
+
+  if(pipe(fds))
+    return -1;
+
+  fflush(stdout);
+  fflush(stderr);
+
+  pid = fork();
+  if(pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    return -1;
+  }
+
+  if(!pid) {
+    /* the result is a copy at the same address as in the parent */
+    close(fds[0]);
+    rdfbench_run(bench, result, parser_name, serializer_name,
+                 input, input_len);
+    _exit(write(fds[1], result, sizeof(*result)) != (ssize_t)sizeof(*result));
+  }
+
+  close(fds[1]);
+  while(offset < sizeof(child_result)) {
+    ssize_t len = read(fds[0], (char*)&child_result + offset,
+                       sizeof(child_result) - offset);
+    if(len <= 0)
+      break;
+    offset += (size_t)len;
+  }
+  close(fds[0]);
+
+  if(waitpid(pid, &status, 0) != pid ||
+     !WIFEXITED(status) || WEXITSTATUS(status) ||
+     offset != sizeof(child_result))
+    return 1;
+
+  *result = child_result;
+  return 0;
+}
+#endif
+
+
+static void
+rdfbench_measure(rdfbench* bench, const char* parser_name,
+                 const char* serializer_name,
+                 const unsigned char* input, size_t input_len)
+{
+  rdfbench_result* result;
+  int rc = -1;
+
+  result = rdfbench_new_result(bench, parser_name, serializer_name);
+  if(!result)
+    return;
+
+#ifdef RDFBENCH_USE_FORK
+  rc = rdfbench_run_child(bench, result, parser_name, serializer_name,
+                          input, input_len);
+  if(rc > 0) {
+    /* the child crashed or could not report */
+    result->peak_rss_kb = -1;
+    result->allocations = -1;
+    result->errors++;
+  }
+#endif
+  if(rc < 0)
+    rdfbench_run(bench, result, parser_name, serializer_name,
+                 input, input_len);
+
+  if(!quiet) {
+    double seconds = result->seconds > 0.0 ? result->seconds : 1e-9;
+    char peak[32];
+
+    if(result->peak_rss_kb >= 0)
+      sprintf(peak, "%8ld kB", result->peak_rss_kb);
+    else
+      strcpy(peak, "     n/a kB");
+
+    fprintf(stderr, "%-14s %-14s %8ld triples %10.0f triples/s %8.2f MB/s %s %10ld allocs%s\n",
+            parser_name ? parser_name : "-",
+            serializer_name ? serializer_name : "-",
+            result->triples, (double)result->triples / seconds,
+            (double)result->bytes / seconds / 1000000.0,
+            peak, result->allocations,
+            result->errors ? " ERRORS" : "");
+  }
+}
+
+
+static void
+rdfbench_write_json_string(FILE* fh, const char* s)
+{
+  if(!s) {
+    fputs("null", fh);
+    return;
+  }
+
+  fputc('"', fh);
+  for(; *s; s++) {
+    if(*s == '"' || *s == '\\')
+      fprintf(fh, "\\%c", *s);
+    else if((unsigned char)*s < 0x20)
+      fprintf(fh, "\\u%04x", (unsigned char)*s);
+    else
+      fputc(*s, fh);
+  }
+  fputc('"', fh);
+}
+
+
+static void
+rdfbench_write_json(rdfbench* bench, FILE* fh)
+{
+  const rdfbench_settings* settings = bench->settings;
+  int i;
+
+  fputs("{\n  \"raptor_version\": ", fh);
+  rdfbench_write_json_string(fh, raptor_version_string);
+  fprintf(fh, ",\n  \"settings\": {\n"
+          "    \"triples\": %d,\n"
+          "    \"literal_length\": %d,\n"
+          "    \"bnode_ratio\": %g,\n"
+          "    \"prefixes\": %d,\n"
+          "    \"unicode_share\": %g,\n"
+          "    \"graphs\": %d,\n"
+          "    \"seed\": %lu,\n"
+          "    \"repeat\": %d\n"
+          "  },\n  \"results\": [",
+          settings->triples, settings->literal_length, settings->bnode_ratio,
+          settings->prefixes, settings->unicode_share, settings->graphs,
+          settings->seed, bench->repeat);
+
+  for(i = 0; i < raptor_sequence_size(bench->results); i++) {
+    rdfbench_result* result;
+    double seconds;
+
+    result = (rdfbench_result*)raptor_sequence_get_at(bench->results, i);
+    seconds = result->seconds > 0.0 ? result->seconds : 1e-9;
+
+    fputs(i ? ",\n    {" : "\n    {", fh);
+    fputs("\"parser\": ", fh);
+    rdfbench_write_json_string(fh, result->parser_name);
+    fputs(", \"serializer\": ", fh);
+    rdfbench_write_json_string(fh, result->serializer_name);
+    fprintf(fh, ", \"triples\": %ld, \"bytes\": %lu, \"seconds\": %.6f, "
+            "\"triples_per_second\": %.1f, \"mb_per_second\": %.3f, ",
+            result->triples, (unsigned long)result->bytes, result->seconds,
+            (double)result->triples / seconds,
+            (double)result->bytes / seconds / 1000000.0);
+    if(result->peak_rss_kb >= 0)
+      fprintf(fh, "\"peak_rss_kb\": %ld, ", result->peak_rss_kb);
+    else
+      fputs("\"peak_rss_kb\": null, ", fh);
+    if(result->allocations >= 0)
+      fprintf(fh, "\"allocations\": %ld, ", result->allocations);
+    else
+      fputs("\"allocations\": null, ", fh);
+    fprintf(fh, "\"errors\": %d}", result->errors);
+  }
+
+  fputs("\n  ]\n}\n", fh);
+}
+
+
+#ifdef HAVE_GETOPT_LONG
+#define HELP_TEXT(short, long, description) "  -" short ", --" long "  " description
+#define HELP_ARG(short, long) "--" #long
+#else
+#define HELP_TEXT(short, long, description) "  -" short "  " description
+#define HELP_ARG(short, long) "-" #short
+#endif
+
+
+#define GETOPT_STRING "b:g:hl:n:o:p:P:qr:s:S:u:"
+
+#ifdef HAVE_GETOPT_LONG
+static const struct option long_options[] =
+{
+  /* name, has_arg, flag, val */
+  {"bnode-ratio", 1, 0, 'b'},
+  {"graphs", 1, 0, 'g'},
+  {"help", 0, 0, 'h'},
+  {"literal-length", 1, 0, 'l'},
+  {"triples", 1, 0, 'n'},
+  {"output", 1, 0, 'o'},
+  {"prefixes", 1, 0, 'p'},
+  {"parser", 1, 0, 'P'},
+  {"quiet", 0, 0, 'q'},
+  {"repeat", 1, 0, 'r'},
+  {"seed", 1, 0, 's'},
+  {"serializer", 1, 0, 'S'},
+  {"unicode-share", 1, 0, 'u'},
+  {NULL, 0, 0, 0}
+};
+#endif
+
+
+static const char * const title_string =
+  "Raptor parser and serializer throughput benchmark";
+
+
+int
+main(int argc, char *argv[])
+{
+  raptor_world* world;
+  rdfbench bench;
+  rdfbench_settings settings;
+  const char* only_parser = NULL;
+  const char* only_serializer = NULL;
+  const char* output_filename = NULL;
+  raptor_sequence* inputs = NULL;
+  int usage = 0;
+  int help = 0;
+  int rc = 0;
+  unsigned int i;
+  unsigned int j;
+  char *p;
+
+  program = argv[0];
+  if((p = strrchr(program, '/')))
+    program = p + 1;
+  else if((p = strrchr(program, '\\')))
+    program = p + 1;
+  argv[0] = program;
+
+  memset(&settings, 0, sizeof(settings));
+  settings.triples = 10000;
+  settings.literal_length = 32;
+  settings.bnode_ratio = 0.1;
+  settings.prefixes = 4;
+  settings.unicode_share = 0.1;
+  settings.graphs = 0;
+  settings.seed = 1;
+
+  memset(&bench, 0, sizeof(bench));
+  bench.settings = &settings;
+  bench.repeat = 3;
+
+  while(!usage && !help)
+  {
+    int c;
+#ifdef HAVE_GETOPT_LONG
+    int option_index = 0;
+
+    c = getopt_long (argc, argv, GETOPT_STRING, long_options, &option_index);
+#else
+    c = getopt (argc, argv, GETOPT_STRING);
+#endif
+    if(c == -1)
+      break;
+
+    switch (c) {
+      case 0:
+      case '?': /* getopt() - unknown option */
+        usage = 1;
+        break;
+
+      case 'b':
+        settings.bnode_ratio = atof(optarg);
+        if(settings.bnode_ratio < 0.0 || settings.bnode_ratio > 1.0)
+          usage = 1;
+        break;
+
+      case 'g':
+        settings.graphs = atoi(optarg);
+        if(settings.graphs < 0)
+          usage = 1;
+        break;
+
+      case 'h':
+        help = 1;
+        break;
+
+      case 'l':
+        settings.literal_length = atoi(optarg);
+        if(settings.literal_length < 0)
+          usage = 1;
+        break;
+
+      case 'n':
+        settings.triples = atoi(optarg);
+        if(settings.triples < 1)
+          usage = 1;
+        break;
+
+      case 'o':
+        output_filename = optarg;
+        break;
+
+      case 'p':
+        settings.prefixes = atoi(optarg);
+        if(settings.prefixes < 1)
+          usage = 1;
+        break;
+
+      case 'P':
+        only_parser = optarg;
+        break;
+
+      case 'q':
+        quiet = 1;
+        break;
+
+      case 'r':
+        bench.repeat = atoi(optarg);
+        if(bench.repeat < 1)
+          usage = 1;
+        break;
+
+      case 's':
+        settings.seed = strtoul(optarg, NULL, 10);
+        break;
+
+      case 'S':
+        only_serializer = optarg;
+        break;
+
+      case 'u':
+        settings.unicode_share = atof(optarg);
+        if(settings.unicode_share < 0.0 || settings.unicode_share > 1.0)
+          usage = 1;
+        break;
+    }
+  }
+
+  if(optind != argc && !help)
+    usage = 1;
+
+  if(usage) {
+    fprintf(stderr, "Try `%s " HELP_ARG(h, help) "' for more information.\n",
+            program);
+    exit(1);
+  }
+
+  if(help) {
+    puts(title_string); putchar(' '); puts(raptor_version_string); putchar('\n');
+    printf("Usage: %s [OPTIONS]\n\n", program);
+    puts("Parse and serialize deterministic synthetic RDF with every parser,");
+    puts("serializer and parser to serializer pair, writing JSON results.");
+    puts("Each measurement runs in its own process where the system allows");
+    puts("it; otherwise peak memory is only given for the first one.\n");
+    puts(HELP_TEXT("n N", "triples N         ", "Number of triples (default 10000)"));
+    puts(HELP_TEXT("l N", "literal-length N  ", "Characters per literal (default 32)"));
+    puts(HELP_TEXT("b R", "bnode-ratio R     ", "Share of blank node terms from 0 to 1 (default 0.1)"));
+    puts(HELP_TEXT("p N", "prefixes N        ", "Number of namespaces (default 4)"));
+    puts(HELP_TEXT("u R", "unicode-share R   ", "Share of non-ASCII literal characters (default 0.1)"));
+    puts(HELP_TEXT("g N", "graphs N          ", "Number of named graphs; 0 for none (default 0)"));
+    puts(HELP_TEXT("s N", "seed N            ", "Random seed (default 1)"));
+    puts(HELP_TEXT("r N", "repeat N          ", "Runs per measurement, the fastest is kept (default 3)"));
+    puts(HELP_TEXT("P NAME", "parser NAME    ", "Only measure this parser"));
+    puts(HELP_TEXT("S NAME", "serializer NAME", "Only measure this serializer"));
+    puts(HELP_TEXT("o FILE", "output FILE    ", "Write JSON results to FILE (default stdout)"));
+    puts(HELP_TEXT("q", "quiet               ", "Do not print each result as it is measured"));
+    puts(HELP_TEXT("h", "help                ", "Print this help, then exit"));
+    exit(0);
+  }
+
+  world = raptor_new_world();
+  if(!world || raptor_world_open(world))
+    exit(1);
+  raptor_world_set_log_handler(world, &bench, rdfbench_log_handler);
+
+  bench.world = world;
+  bench.base_uri = raptor_new_uri(world, (const unsigned char*)RDFBENCH_BASE_URI);
+  bench.results = raptor_new_sequence(free, NULL);
+  inputs = raptor_new_sequence(raptor_free_memory, NULL);
+  if(!bench.base_uri || !bench.results || !inputs ||
+     rdfbench_generate(&bench)) {
+    fprintf(stderr, "%s: Failed to generate %d triples\n", program,
+            settings.triples);
+    rc = 1;
+    goto tidy;
+  }
+
+  /* serializers on their own */
+  for(j = 0; 1; j++) {
+    const raptor_syntax_description* sd;
+
+    sd = raptor_world_get_serializer_description(world, j);
+    if(!sd)
+      break;
+    if(only_serializer && strcmp(only_serializer, sd->names[0]))
+      continue;
+    rdfbench_measure(&bench, NULL, sd->names[0], NULL, 0);
+  }
+
+  /* parsers on their own and then into every serializer */
+  for(i = 0; 1; i++) {
+    const raptor_syntax_description* sd;
+    const char* input_syntax;
+    unsigned char* input;
+    size_t input_len = 0;
+
+    sd = raptor_world_get_parser_description(world, i);
+    if(!sd)
+      break;
+    if(only_parser && strcmp(only_parser, sd->names[0]))
+      continue;
+
+    input_syntax = rdfbench_input_syntax(&bench, sd->names[0]);
+    if(!input_syntax) {
+      if(!quiet)
+        fprintf(stderr, "%s: No serializer writes input for parser %s - skipped\n",
+                program, sd->names[0]);
+      continue;
+    }
+
+    input = rdfbench_serialize(&bench, input_syntax, &input_len);
+    if(!input) {
+      if(!quiet)
+        fprintf(stderr, "%s: Serializer %s cannot write the generated statements for parser %s - skipped\n",
+                program, input_syntax, sd->names[0]);
+      continue;
+    }
+    /* keep the input while results refer to the parser name */
+    raptor_sequence_push(inputs, input);
+
+    rdfbench_measure(&bench, sd->names[0], NULL, input, input_len);
+
+    for(j = 0; 1; j++) {
+      const raptor_syntax_description* ssd;
+
+      ssd = raptor_world_get_serializer_description(world, j);
+      if(!ssd)
+        break;
+      if(only_serializer && strcmp(only_serializer, ssd->names[0]))
+        continue;
+      rdfbench_measure(&bench, sd->names[0], ssd->names[0], input, input_len);
+    }
+  }
+
+  if(output_filename) {
+    FILE* fh = fopen(output_filename, "w");
+
+    if(!fh) {
+      fprintf(stderr, "%s: Failed to open %s for writing\n", program,
+              output_filename);
+      rc = 1;
+      goto tidy;
+    }
+    rdfbench_write_json(&bench, fh);
+    fclose(fh);
+  } else
+    rdfbench_write_json(&bench, stdout);
+
+  tidy:
+  rdfbench_free(&bench);
+  if(inputs)
+    raptor_free_sequence(inputs);
+  if(bench.results)
+    raptor_free_sequence(bench.results);
+  if(bench.base_uri)
+    raptor_free_uri(bench.base_uri);
+  raptor_free_world(world);
+
+  return rc;
+}